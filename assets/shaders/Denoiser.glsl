@@ -0,0 +1,144 @@
+// Resources and helpers shared by the SVGF denoiser compute passes.
+// The descriptor set layout and the push constants must match Vulkan/RayTracing/Denoiser.cpp.
+//
+// Every pass is also compiled in two reduced precision variants (see Denoiser::Precision and assets/CMakeLists.txt):
+// DENOISER_FLOAT16_STORAGE keeps the history, moments and filter images in half floats, DENOISER_FLOAT16 additionally
+// runs the a-trous color arithmetic in half floats, which needs the shaderFloat16 device feature.
+
+#ifdef DENOISER_FLOAT16
+#extension GL_EXT_shader_explicit_arithmetic_types_float16 : require
+#define DENOISER_FLOAT16_STORAGE
+#define real float16_t
+#define real3 f16vec3
+#define real4 f16vec4
+#else
+#define real float
+#define real3 vec3
+#define real4 vec4
+#endif
+
+#ifdef DENOISER_FLOAT16_STORAGE
+#define FILTER_FORMAT rgba16f
+#else
+#define FILTER_FORMAT rgba32f
+#endif
+
+#include "Gradient.glsl"
+#include "Octahedral.glsl"
+
+layout(binding = 0, rgba32f) uniform image2D NoisyImage;
+layout(binding = 1, r32f) uniform image2D GBufferDepth;
+layout(binding = 2, rgba16f) uniform image2D GBufferNormalMotion;
+layout(binding = 3, rgba32f) uniform image2D GuideCurrent;
+layout(binding = 4, rgba32f) uniform image2D GuidePrevious;
+layout(binding = 5, FILTER_FORMAT) uniform image2D ColorHistoryPrevious;
+layout(binding = 6, FILTER_FORMAT) uniform image2D MomentsPrevious;
+layout(binding = 7, FILTER_FORMAT) uniform image2D ColorHistoryCurrent;
+layout(binding = 8, FILTER_FORMAT) uniform image2D MomentsCurrent;
+layout(binding = 9, FILTER_FORMAT) uniform image2D IlluminationImage;
+layout(binding = 10, FILTER_FORMAT) uniform image2D FilterSource;
+layout(binding = 11, FILTER_FORMAT) uniform image2D FilterTarget;
+layout(binding = 12, rgba8) uniform image2D OutputImage;
+layout(binding = 13, r32ui) uniform uimage2D GBufferInstanceId;
+layout(binding = 14, r32ui) uniform uimage2D InstanceCurrent;
+layout(binding = 15, r32ui) uniform uimage2D InstancePrevious;
+layout(binding = 16, rgba8) uniform image2D GBufferAlbedo;
+layout(binding = 17, rgba32f) uniform image2D SpecularNoisyImage;
+layout(binding = 18, FILTER_FORMAT) uniform image2D SpecularFilterTarget;
+layout(binding = 19, r32ui) uniform uimage2D SampleCountMap;
+layout(binding = 20, std430) buffer SampleWeightSumBuffer { uint SampleWeightSum; };
+layout(binding = 21, rgba16f) uniform image2D GBufferGradient;
+layout(binding = 22, rgba16f) uniform image2D GradientSource;
+layout(binding = 23, rgba16f) uniform image2D GradientTarget;
+layout(binding = 24, std430) buffer TileDispatchBuffer { uvec4 TileDispatches[]; };
+layout(binding = 25, std430) buffer TileIterationBuffer { uint TileIterations[]; };
+layout(binding = 26, std430) buffer TileListBuffer { uint TileList[]; };
+
+layout(push_constant) uniform DenoiserConstants
+{
+	ivec2 Extent;
+	float PhiColor;
+	float PhiNormal;
+	float PhiDepth;
+	float ColorAlpha;
+	float MomentsAlpha;
+	int StepSize;
+	uint SampleBudget;
+	uint ATrousIterations;
+	float TileThreshold;
+	uint TileListOffset;
+} Constants;
+
+// Pass permutations, each combination is a separate pipeline created on first use (see Denoiser::Pipeline()).
+layout(constant_id = 0) const bool WriteHistory = false;
+layout(constant_id = 1) const bool Bypass = false;
+layout(constant_id = 2) const bool ResetHistory = false;
+layout(constant_id = 3) const bool TemporalGradient = false;
+layout(constant_id = 4) const bool IndirectTiles = false;
+
+// Adaptive sampling weights are stored in the sample count map as fixed point before being turned into counts.
+// Their sum over the frame is accumulated as the fixed point average of each workgroup of the weight pass.
+const float SampleWeightScale = 1024.0;
+const float MaxSampleWeight = 16.0;
+const uint SampleWeightGroupSize = 16 * 16;
+
+// Adaptive a-trous iterations: tiles of ClassificationTileSize pixels get their own iteration count, the iterations
+// after the first only dispatch the workgroups listed for them (24-26). Must match Denoiser.cpp.
+const int ClassificationTileSize = 16;
+const uint MaxATrousIterations = 8;
+
+// The listed workgroups are dispatched in rows of this many, the spec minimum of maxComputeWorkGroupCount is 65535.
+// Each indirect dispatch keeps the workgroup count of its list in its last (w) component.
+const uint TileListRowLength = 32768;
+
+// The G-buffer written by the ray generation shader holds the linear view depth of the primary hit (zero on misses),
+// its octahedral encoded world space normal and its NDC motion since the previous frame.
+// The guide image stores the normal (xy), the linear depth (z) and its screen space gradient (w).
+// A linear depth of zero marks background pixels. The instance images keep the G-buffer instance of both frames.
+// The noisy, history and filter images hold one of the illumination signals (diffuse or specular) with the first
+// hit albedo divided out, the same passes run on both. Only the composite pass reads the other signal (17, 18).
+// The gradient images (21-23) hold one texel per stratum of GradientStratumSize pixels, shared by both signals.
+
+float Luminance(const vec3 color)
+{
+	return dot(color, vec3(0.2126, 0.7152, 0.0722));
+}
+
+#ifdef DENOISER_FLOAT16
+float16_t Luminance(const f16vec3 color)
+{
+	return dot(color, f16vec3(0.2126, 0.7152, 0.0722));
+}
+#endif
+
+// Values written to the filter images, clamped to the largest half float so that bright outliers do not turn
+// into infinities that would spread through the filter.
+vec4 FilterValue(const vec4 value)
+{
+#ifdef DENOISER_FLOAT16_STORAGE
+	return min(value, vec4(65504.0));
+#else
+	return value;
+#endif
+}
+
+bool IsInside(const ivec2 pixel, const ivec2 size)
+{
+	return all(greaterThanEqual(pixel, ivec2(0))) && all(lessThan(pixel, size));
+}
+
+ivec2 TileCount(const ivec2 size)
+{
+	return (size + ClassificationTileSize - 1) / ClassificationTileSize;
+}
+
+// Invocation index within the workgroup, used to spread the loads of a shared memory tile over all invocations.
+uint LocalIndex()
+{
+	return gl_LocalInvocationID.y * gl_WorkGroupSize.x + gl_LocalInvocationID.x;
+}
+
+uint LocalCount()
+{
+	return gl_WorkGroupSize.x * gl_WorkGroupSize.y;
+}
@@ -0,0 +1,27 @@
+// Temporal gradient samples (A-SVGF). One pixel per stratum of GradientStratumSize x GradientStratumSize pixels,
+// chosen anew every frame, traces its first path with the random seed that the previous frame used for the same
+// surface. Both paths then see the same noise, the change of their luminance comes from the lighting alone.
+// The ray generation shader writes these sparse gradients, the denoiser reconstructs a dense gradient from them
+// and shortens the temporal history where the illumination changed. Must match GBuffer::GradientStratumSize.
+
+const int GradientStratumSize = 3;
+
+uint GradientHash(uint x)
+{
+	x ^= x >> 16;
+	x *= 0x7feb352du;
+	x ^= x >> 15;
+	x *= 0x846ca68bu;
+	x ^= x >> 16;
+	return x;
+}
+
+// The gradient pixel of the stratum for the given frame, strata on the right and bottom borders may be partial.
+ivec2 GradientSamplePixel(const ivec2 stratum, const ivec2 size, const uint frame)
+{
+	const uint hash = GradientHash((uint(stratum.x) | (uint(stratum.y) << 16)) ^ GradientHash(frame));
+	const ivec2 origin = stratum * GradientStratumSize;
+	const uvec2 extent = uvec2(min(ivec2(GradientStratumSize), size - origin));
+
+	return origin + ivec2(hash % extent.x, (hash / GradientStratumSize) % extent.y);
+}
@@ -8,32 +8,23 @@
 layout(binding = 0) readonly uniform UniformBufferObjectStruct { UniformBufferObject Camera; };
 layout(binding = 1) readonly buffer MaterialArray { Material[] Materials; };
 layout(binding = 2) uniform sampler2D[] TextureSamplers;
-layout (binding = 3) uniform sampler2D prevDepthSampler;
 
 layout(location = 0) in vec3 FragColor;
 layout(location = 1) in vec3 FragNormal;
 layout(location = 2) in vec2 FragTexCoord;
 layout(location = 3) in flat int FragMaterialIndex;
 layout(location = 4) in vec4 FragClipPosition;
+layout(location = 5) in vec4 FragPreviousClipPosition;
 
 layout(location = 0) out vec4 OutColor;
 layout(location = 1) out vec2 MotionVector;
 
 void main() 
 {
-	//motion vector----------------------------------------
-	vec2 screenCoord = FragClipPosition.xy / FragClipPosition.w;
-
-	float depth = texture(prevDepthSampler, 0.5 * (screenCoord + 1.0)).r;
-	vec4 clipCoord = vec4(screenCoord * depth * 2.0 - vec2(depth), depth, 1.0);
-	vec4 viewCoord = Camera.ProjectionInverse * clipCoord;
-	viewCoord /= viewCoord.w;
-
-	vec4 lastClipCoord = Camera.LastFrameProjection * Camera.LastFrameModelView * viewCoord;
-	vec2 lastScreenCoord = lastClipCoord.xy / lastClipCoord.w;
-
-	vec2 motionVector = screenCoord - lastScreenCoord;
-	//----------------------------------------------------------
+	// Motion vector: NDC displacement of this fragment since the previous frame.
+	const vec2 screenCoord = FragClipPosition.xy / FragClipPosition.w;
+	const vec2 lastScreenCoord = FragPreviousClipPosition.xy / FragPreviousClipPosition.w;
+	const vec2 motionVector = screenCoord - lastScreenCoord;
 
 	const int textureId = Materials[FragMaterialIndex].DiffuseTextureId;
 	const vec3 lightVector = normalize(vec3(5, 4, 3));
@@ -17,6 +17,7 @@ layout(location = 1) out vec3 FragNormal;
 layout(location = 2) out vec2 FragTexCoord;
 layout(location = 3) out flat int FragMaterialIndex;
 layout(location = 4) out vec4 FragClipPosition;
+layout(location = 5) out vec4 FragPreviousClipPosition;
 
 out gl_PerVertex
 {
@@ -33,4 +34,5 @@ void main()
 	FragTexCoord = InTexCoord;
 	FragMaterialIndex = InMaterialIndex;
 	FragClipPosition = gl_Position;
+	FragPreviousClipPosition = Camera.LastFrameProjection * Camera.LastFrameModelView * vec4(InPosition, 1.0);
 }
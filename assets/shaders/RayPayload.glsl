@@ -2,6 +2,7 @@
 struct RayPayload
 {
 	vec4 ColorAndDistance; // rgb + t
-	vec4 ScatterDirection; // xyz + w (is scatter needed)
+	vec4 ScatterDirection; // xyz + w (scatter lobe: 0 none, 1 diffuse, 2 specular)
 	uint RandomSeed;
+	vec4 NormalAndInstance; // world space shading normal + w instance index, used for the primary hit G-buffer
 };
@@ -3,6 +3,11 @@
 #include "Random.glsl"
 #include "RayPayload.glsl"
 
+// Scatter lobe stored in ScatterDirection.w, zero when the ray is absorbed or emitted.
+const float ScatterNone = 0;
+const float ScatterDiffuse = 1;
+const float ScatterSpecular = 2;
+
 // Polynomial approximation by Christophe Schlick
 float Schlick(const float cosine, const float refractionIndex)
 {
@@ -17,9 +22,9 @@ RayPayload ScatterLambertian(const Material m, const vec3 direction, const vec3
 	const bool isScattered = dot(direction, normal) < 0;
 	const vec4 texColor = m.DiffuseTextureId >= 0 ? texture(TextureSamplers[nonuniformEXT(m.DiffuseTextureId)], texCoord) : vec4(1);
 	const vec4 colorAndDistance = vec4(m.Diffuse.rgb * texColor.rgb, t);
-	const vec4 scatter = vec4(normal + RandomInUnitSphere(seed), isScattered ? 1 : 0);
+	const vec4 scatter = vec4(normal + RandomInUnitSphere(seed), isScattered ? ScatterDiffuse : ScatterNone);
 
-	return RayPayload(colorAndDistance, scatter, seed);
+	return RayPayload(colorAndDistance, scatter, seed, vec4(normal, 0));
 }
 
 // Metallic
@@ -30,9 +35,9 @@ RayPayload ScatterMetallic(const Material m, const vec3 direction, const vec3 no
 
 	const vec4 texColor = m.DiffuseTextureId >= 0 ? texture(TextureSamplers[nonuniformEXT(m.DiffuseTextureId)], texCoord) : vec4(1);
 	const vec4 colorAndDistance = vec4(m.Diffuse.rgb * texColor.rgb, t);
-	const vec4 scatter = vec4(reflected + m.Fuzziness*RandomInUnitSphere(seed), isScattered ? 1 : 0);
+	const vec4 scatter = vec4(reflected + m.Fuzziness*RandomInUnitSphere(seed), isScattered ? ScatterSpecular : ScatterNone);
 
-	return RayPayload(colorAndDistance, scatter, seed);
+	return RayPayload(colorAndDistance, scatter, seed, vec4(normal, 0));
 }
 
 // Dielectric
@@ -49,17 +54,17 @@ RayPayload ScatterDieletric(const Material m, const vec3 direction, const vec3 n
 	const vec4 texColor = m.DiffuseTextureId >= 0 ? texture(TextureSamplers[nonuniformEXT(m.DiffuseTextureId)], texCoord) : vec4(1);
 	
 	return RandomFloat(seed) < reflectProb
-		? RayPayload(vec4(texColor.rgb, t), vec4(reflect(direction, normal), 1), seed)
-		: RayPayload(vec4(texColor.rgb, t), vec4(refracted, 1), seed);
+		? RayPayload(vec4(texColor.rgb, t), vec4(reflect(direction, normal), ScatterSpecular), seed, vec4(normal, 0))
+		: RayPayload(vec4(texColor.rgb, t), vec4(refracted, ScatterSpecular), seed, vec4(normal, 0));
 }
 
 // Diffuse Light
-RayPayload ScatterDiffuseLight(const Material m, const float t, inout uint seed)
+RayPayload ScatterDiffuseLight(const Material m, const vec3 normal, const float t, inout uint seed)
 {
 	const vec4 colorAndDistance = vec4(m.Diffuse.rgb, t);
-	const vec4 scatter = vec4(1, 0, 0, 0);
+	const vec4 scatter = vec4(1, 0, 0, ScatterNone);
 
-	return RayPayload(colorAndDistance, scatter, seed);
+	return RayPayload(colorAndDistance, scatter, seed, vec4(normal, 0));
 }
 
 RayPayload Scatter(const Material m, const vec3 direction, const vec3 normal, const vec2 texCoord, const float t, inout uint seed)
@@ -75,7 +80,7 @@ RayPayload Scatter(const Material m, const vec3 direction, const vec3 normal, co
 	case MaterialDielectric:
 		return ScatterDieletric(m, normDirection, normal, texCoord, t, seed);
 	case MaterialDiffuseLight:
-		return ScatterDiffuseLight(m, t, seed);
+		return ScatterDiffuseLight(m, normal, t, seed);
 	}
 }
 
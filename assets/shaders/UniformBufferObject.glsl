@@ -18,7 +18,11 @@ struct UniformBufferObject
 	bool HasSky;//Ƿգڹ׷ʱжǷɫ
 	bool ShowHeatmap;//ǷʾͼڵԺŻ׷ٵܡͼÿصȾʱɫȾʱԽɫԽ
 	uint FrameCounter;//֡
+	bool AdaptiveSampling;//G-bufferеĲͼΪÿط
+	uint Padding0;
 
 	mat4 LastFrameModelView;//һ֡mvڷͶӰmotion vector
 	mat4 LastFrameProjection;//һ֡ͶӰڷͶӰmotion vector
+
+	vec2 Jitter;//֡һ·ĵƫƣΧ[-0.5, 0.5]ʱϲʹ
 };
@@ -6,13 +6,13 @@
 #include "Vulkan/BufferUtil.hpp"
 #include "Vulkan/ImageView.hpp"
 #include "Vulkan/Sampler.hpp"
+#include "Vulkan/Uploader.hpp"
 #include "Utilities/Exception.hpp"
-#include "Vulkan/SingleTimeCommands.hpp"
 
 
 namespace Assets {
 
-Scene::Scene(Vulkan::CommandPool& commandPool, std::vector<Model>&& models, std::vector<Texture>&& textures) :
+Scene::Scene(Vulkan::Uploader& uploader, std::vector<Model>&& models, std::vector<Texture>&& textures) :
 	models_(std::move(models)),
 	textures_(std::move(textures))
 {
@@ -61,13 +61,13 @@ Scene::Scene(Vulkan::CommandPool& commandPool, std::vector<Model>&& models, std:
 
 	constexpr auto flags = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
 
-	Vulkan::BufferUtil::CreateDeviceBuffer(commandPool, "Vertices", VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR | flags, vertices, vertexBuffer_, vertexBufferMemory_);
-	Vulkan::BufferUtil::CreateDeviceBuffer(commandPool, "Indices", VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR | flags, indices, indexBuffer_, indexBufferMemory_);
-	Vulkan::BufferUtil::CreateDeviceBuffer(commandPool, "Materials", flags, materials, materialBuffer_, materialBufferMemory_);
-	Vulkan::BufferUtil::CreateDeviceBuffer(commandPool, "Offsets", flags, offsets, offsetBuffer_, offsetBufferMemory_);
+	Vulkan::BufferUtil::CreateDeviceBuffer(uploader, "Vertices", VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR | flags, vertices, vertexBuffer_, vertexBufferMemory_);
+	Vulkan::BufferUtil::CreateDeviceBuffer(uploader, "Indices", VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR | flags, indices, indexBuffer_, indexBufferMemory_);
+	Vulkan::BufferUtil::CreateDeviceBuffer(uploader, "Materials", flags, materials, materialBuffer_, materialBufferMemory_);
+	Vulkan::BufferUtil::CreateDeviceBuffer(uploader, "Offsets", flags, offsets, offsetBuffer_, offsetBufferMemory_);
 
-	Vulkan::BufferUtil::CreateDeviceBuffer(commandPool, "AABBs", VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR | flags, aabbs, aabbBuffer_, aabbBufferMemory_);
-	Vulkan::BufferUtil::CreateDeviceBuffer(commandPool, "Procedurals", flags, procedurals, proceduralBuffer_, proceduralBufferMemory_);
+	Vulkan::BufferUtil::CreateDeviceBuffer(uploader, "AABBs", VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR | flags, aabbs, aabbBuffer_, aabbBufferMemory_);
+	Vulkan::BufferUtil::CreateDeviceBuffer(uploader, "Procedurals", flags, procedurals, proceduralBuffer_, proceduralBufferMemory_);
 
 	
 	// Upload all textures
@@ -77,10 +77,14 @@ Scene::Scene(Vulkan::CommandPool& commandPool, std::vector<Model>&& models, std:
 
 	for (size_t i = 0; i != textures_.size(); ++i)
 	{
-	   textureImages_.emplace_back(new TextureImage(commandPool, textures_[i]));
+	   textureImages_.emplace_back(new TextureImage(uploader, textures_[i]));
 	   textureImageViewHandles_[i] = textureImages_[i]->ImageView().Handle();
 	   textureSamplerHandles_[i] = textureImages_[i]->Sampler().Handle();
 	}
+
+	// Submit the buffer and texture copies recorded above. The host does not wait for them, the graphics queue
+	// submissions that follow see their results (see Vulkan::Uploader).
+	uploader.Submit();
 }
 
 Scene::~Scene()
@@ -7,7 +7,7 @@
 namespace Vulkan
 {
 	class Buffer;
-	class CommandPool;
+	class Uploader;
 	class DeviceMemory;
 	class Image;
 }
@@ -27,7 +27,7 @@ namespace Assets
 		Scene& operator = (const Scene&) = delete;
 		Scene& operator = (Scene&&) = delete;
 
-		Scene(Vulkan::CommandPool& commandPool, std::vector<Model>&& models, std::vector<Texture>&& textures);
+		Scene(Vulkan::Uploader& uploader, std::vector<Model>&& models, std::vector<Texture>&& textures);
 		~Scene();
 
 		const std::vector<Model>& Models() const { return models_; }
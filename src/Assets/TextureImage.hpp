@@ -4,11 +4,11 @@
 
 namespace Vulkan
 {
-	class CommandPool;
 	class DeviceMemory;
 	class Image;
 	class ImageView;
 	class Sampler;
+	class Uploader;
 }
 
 namespace Assets
@@ -24,7 +24,8 @@ namespace Assets
 		TextureImage& operator = (const TextureImage&) = delete;
 		TextureImage& operator = (TextureImage&&) = delete;
 
-		TextureImage(Vulkan::CommandPool& commandPool, const Texture& texture);
+		// The texels are on the device once the uploader has been flushed.
+		TextureImage(Vulkan::Uploader& uploader, const Texture& texture);
 		~TextureImage();
 
 		const Vulkan::ImageView& ImageView() const { return *imageView_; }
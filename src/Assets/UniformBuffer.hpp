@@ -1,14 +1,6 @@
 #pragma once
 
 #include "Utilities/Glm.hpp"
-#include <memory>
-
-namespace Vulkan
-{
-	class Buffer;
-	class Device;
-	class DeviceMemory;
-}
 
 namespace Assets
 {
@@ -33,31 +25,13 @@ namespace Assets
 		uint32_t HasSky; // bool
 		uint32_t ShowHeatmap; // bool
 		uint32_t FrameCounter; // ӵ֡
+		uint32_t AdaptiveSampling; // bool
+		uint32_t Padding0; // std140 aligns the following matrices on 16 bytes
 
 		glm::mat4 LastFrameModelView;
 		glm::mat4 LastFrameProjection;
-	};
-
-	class UniformBuffer
-	{
-	public:
-
-		UniformBuffer(const UniformBuffer&) = delete;
-		UniformBuffer& operator = (const UniformBuffer&) = delete;
-		UniformBuffer& operator = (UniformBuffer&&) = delete;
-
-		explicit UniformBuffer(const Vulkan::Device& device);
-		UniformBuffer(UniformBuffer&& other) noexcept;
-		~UniformBuffer();
-
-		const Vulkan::Buffer& Buffer() const { return *buffer_; }
-
-		void SetValue(const UniformBufferObject& ubo);
-
-	private:
 
-		std::unique_ptr<Vulkan::Buffer> buffer_;
-		std::unique_ptr<Vulkan::DeviceMemory> memory_;
+		glm::vec2 Jitter; // Sub-pixel offset of the first path of each pixel from the pixel center, in [-0.5, 0.5]
 	};
 
 }
\ No newline at end of file
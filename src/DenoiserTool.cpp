@@ -0,0 +1,290 @@
+#include "Utilities/DenoiserConfig.hpp"
+#include "Utilities/DenoiserFrame.hpp"
+#include "Utilities/DenoiserTuner.hpp"
+#include "Utilities/Exception.hpp"
+#include "Utilities/ImageMetrics.hpp"
+#include "Utilities/ReferenceDenoiser.hpp"
+#include "DenoiserToolOptions.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+
+namespace
+{
+	// The CPU and the GPU evaluate the same math, up to the exp/log approximations of the vectorized a-trous pass and the
+	// order of a few sums, which moves some of the 8 bit output values by a level or two once rounded. A few more may
+	// differ where an edge-stopping weight underflows on one side only.
+	const int CheckTolerance = 2;
+	const double CheckOutlierFraction = 0.001;
+
+	Utilities::DenoiserParameters GetFilterParameters(const DenoiserToolOptions& options);
+	void RunDenoiserCheck(const DenoiserToolOptions& options);
+	void RunReferenceDenoiserBenchmark(const DenoiserToolOptions& options);
+	void RunDenoiserTuner(const DenoiserToolOptions& options);
+	void RunImageComparison(const DenoiserToolOptions& options);
+}
+
+int main(int argc, const char* argv[]) noexcept
+{
+	try
+	{
+		const DenoiserToolOptions options(argc, argv);
+
+		if (!options.CheckDenoiserFrames.empty())
+		{
+			RunDenoiserCheck(options);
+		}
+
+		if (options.ReferenceDenoiserBenchmark)
+		{
+			RunReferenceDenoiserBenchmark(options);
+		}
+
+		if (!options.TuneDenoiser.empty())
+		{
+			RunDenoiserTuner(options);
+		}
+
+		if (!options.CompareImages.empty())
+		{
+			RunImageComparison(options);
+		}
+
+		return EXIT_SUCCESS;
+	}
+
+	catch (const DenoiserToolOptions::Help&)
+	{
+		return EXIT_SUCCESS;
+	}
+
+	catch (const std::exception& exception)
+	{
+		const auto stacktrace = boost::get_error_info<traced>(exception);
+
+		std::cerr << "FATAL: " << exception.what() << std::endl;
+
+		if (stacktrace)
+		{
+			std::cerr << '\n' << *stacktrace << '\n';
+		}
+	}
+
+	catch (...)
+	{
+		std::cerr << "FATAL: caught unhandled exception" << std::endl;
+	}
+
+	return EXIT_FAILURE;
+}
+
+namespace
+{
+
+	Utilities::DenoiserParameters GetFilterParameters(const DenoiserToolOptions& options)
+	{
+		// Same defaults as the RayTracer application.
+		Utilities::DenoiserParameters parameters = {};
+		parameters.Enabled = true;
+		parameters.ATrousIterations = options.ATrousIterations;
+		parameters.PhiColor = 4.0f;
+		parameters.PhiNormal = 128.0f;
+		parameters.PhiDepth = 1.0f;
+		parameters.ColorAlpha = 0.2f;
+		parameters.MomentsAlpha = 0.2f;
+
+		if (!options.DenoiserConfig.empty())
+		{
+			Utilities::DenoiserConfig::Load(options.DenoiserConfig, parameters);
+		}
+
+		return parameters;
+	}
+
+	std::string FrameFilename(const std::string& directory, const uint32_t index, const char* const suffix)
+	{
+		char name[48];
+		std::snprintf(name, sizeof(name), "frame-%04u%s", index, suffix);
+
+		return directory + "/" + name;
+	}
+
+	void RunDenoiserCheck(const DenoiserToolOptions& options)
+	{
+		const auto& directory = options.CheckDenoiserFrames;
+		const std::string config = directory + "/denoiser-frames.cfg";
+		auto parameters = GetFilterParameters(options);
+
+		// The filter parameters the GPU used, written by the dump.
+		if (std::ifstream(config).good())
+		{
+			Utilities::DenoiserConfig::Load(config, parameters);
+		}
+
+		std::cout << "Denoiser Check: '" << directory << "', at most " << CheckOutlierFraction * 100 << "% of the channel values more than "
+			<< CheckTolerance << "/255 away from the GPU output" << std::endl;
+
+		std::unique_ptr<Utilities::ReferenceDenoiser> denoiser;
+		std::vector<float> output;
+		uint32_t frameCount = 0;
+		uint32_t failedCount = 0;
+
+		for (; std::ifstream(FrameFilename(directory, frameCount, ".svgf")).good(); ++frameCount)
+		{
+			const auto frame = Utilities::DenoiserFrame::Load(FrameFilename(directory, frameCount, ".svgf"));
+			const auto denoisedFilename = FrameFilename(directory, frameCount, "-denoised.png");
+
+			uint32_t width = 0;
+			uint32_t height = 0;
+			const auto gpuOutput = Utilities::ImageMetrics::ReadImage(denoisedFilename, width, height);
+
+			if (width != frame.Width || height != frame.Height || (denoiser && (width != denoiser->Width() || height != denoiser->Height())))
+			{
+				Throw(std::runtime_error("'" + denoisedFilename + "' does not match the size of the denoiser frames"));
+			}
+
+			// The history carries over from frame to frame, as on the GPU.
+			if (!denoiser)
+			{
+				denoiser.reset(new Utilities::ReferenceDenoiser(width, height, options.Threads, static_cast<Utilities::Simd::InstructionSet>(options.InstructionSet)));
+				output.resize(4 * static_cast<size_t>(width) * height);
+			}
+
+			denoiser->Denoise(frame.View(), parameters, output.data());
+
+			// Both converted to 8 bits like the GPU output image, alpha aside.
+			int maxDifference = 0;
+			size_t differenceSum = 0;
+			size_t outlierCount = 0;
+
+			for (size_t i = 0; i != output.size(); ++i)
+			{
+				if (i % 4 == 3)
+				{
+					continue;
+				}
+
+				const long cpu = std::lround(std::clamp(output[i], 0.0f, 1.0f) * 255.0f);
+				const long gpu = std::lround(gpuOutput[i] * 255.0f);
+				const int difference = static_cast<int>(std::abs(cpu - gpu));
+
+				maxDifference = std::max(maxDifference, difference);
+				differenceSum += difference;
+				outlierCount += difference > CheckTolerance ? 1 : 0;
+			}
+
+			const size_t valueCount = 3 * output.size() / 4;
+			const double outlierFraction = static_cast<double>(outlierCount) / valueCount;
+			const bool passed = outlierFraction <= CheckOutlierFraction;
+
+			failedCount += passed ? 0 : 1;
+
+			std::cout << "Denoiser Check: frame " << frameCount << ", max difference " << maxDifference << "/255, mean "
+				<< static_cast<double>(differenceSum) / valueCount << "/255, " << outlierFraction * 100 << "% over "
+				<< CheckTolerance << "/255: " << (passed ? "passed" : "FAILED") << std::endl;
+		}
+
+		if (frameCount == 0)
+		{
+			Throw(std::runtime_error("no denoiser frames in '" + directory + "'"));
+		}
+
+		if (failedCount != 0)
+		{
+			Throw(std::runtime_error("the CPU reference denoiser differs from the GPU output in " + std::to_string(failedCount) + " of " + std::to_string(frameCount) + " frames"));
+		}
+	}
+
+	void RunReferenceDenoiserBenchmark(const DenoiserToolOptions& options)
+	{
+		// The first frames reset the history and take the spatial variance path, keep them out of the measurement.
+		const uint32_t warmUpFrameCount = 4;
+
+		const auto parameters = GetFilterParameters(options);
+		const auto instructionSet = static_cast<Utilities::Simd::InstructionSet>(options.InstructionSet);
+
+		for (const auto extent : options.BenchmarkExtents)
+		{
+			// Same synthetic inputs as the GPU benchmark: a mid grey surface facing the camera ten units away with no motion.
+			const size_t pixelCount = static_cast<size_t>(extent.Width) * extent.Height;
+			// Both illumination signals read the same noisy image, under a white albedo.
+			const std::vector<float> noisy(4 * pixelCount, 0.5f);
+			const std::vector<float> albedo(4 * pixelCount, 1.0f);
+			const std::vector<float> depth(pixelCount, 10.0f);
+			const std::vector<float> normalMotion(4 * pixelCount, 0.0f);
+			const std::vector<uint32_t> instanceId(pixelCount, 1);
+			std::vector<float> output(4 * pixelCount);
+
+			Utilities::ReferenceDenoiser denoiser(extent.Width, extent.Height, options.Threads, instructionSet);
+			const Utilities::ReferenceDenoiser::Frame frame = { noisy.data(), noisy.data(), albedo.data(), depth.data(), normalMotion.data(), instanceId.data() };
+
+			for (uint32_t i = 0; i != warmUpFrameCount; ++i)
+			{
+				denoiser.Denoise(frame, parameters, output.data());
+			}
+
+			const auto start = std::chrono::high_resolution_clock::now();
+
+			for (uint32_t i = 0; i != options.BenchmarkFrames; ++i)
+			{
+				denoiser.Denoise(frame, parameters, output.data());
+			}
+
+			const std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+
+			std::cout << "Reference Denoiser Benchmark: " << extent.Width << "x" << extent.Height << ", "
+				<< parameters.ATrousIterations << " a-trous iterations, "
+				<< denoiser.ThreadCount() << " threads (" << Utilities::Simd::Name(denoiser.InstructionSet()) << "): "
+				<< elapsed.count() / options.BenchmarkFrames << " ms" << std::endl;
+		}
+	}
+
+	void RunDenoiserTuner(const DenoiserToolOptions& options)
+	{
+		const Utilities::DenoiserTuner tuner(options.TuneDenoiser);
+		const auto base = GetFilterParameters(options);
+		const auto grid = options.TuneGrid.empty()
+			? Utilities::DenoiserTuner::DefaultGrid(base)
+			: Utilities::DenoiserConfig::LoadGrid(options.TuneGrid, base);
+
+		auto results = tuner.Run(grid);
+		Utilities::DenoiserTuner::WriteReport(options.TuneOutput, results);
+	}
+
+	void RunImageComparison(const DenoiserToolOptions& options)
+	{
+		const auto& imageFilename = options.CompareImages[0];
+		const auto& referenceFilename = options.CompareImages[1];
+
+		uint32_t width = 0;
+		uint32_t height = 0;
+		uint32_t referenceWidth = 0;
+		uint32_t referenceHeight = 0;
+		const auto image = Utilities::ImageMetrics::ReadImage(imageFilename, width, height);
+		const auto reference = Utilities::ImageMetrics::ReadImage(referenceFilename, referenceWidth, referenceHeight);
+
+		if (width != referenceWidth || height != referenceHeight)
+		{
+			Throw(std::runtime_error("'" + imageFilename + "' and '" + referenceFilename + "' have different sizes"));
+		}
+
+		const Utilities::ImageMetrics metrics(options.Threads, static_cast<Utilities::Simd::InstructionSet>(options.InstructionSet));
+		const auto start = std::chrono::high_resolution_clock::now();
+		const auto scores = metrics.Compare({ image.data(), width, height, 4 }, { reference.data(), width, height, 4 });
+		const std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+
+		std::cout << "Image Comparison: " << imageFilename << " against " << referenceFilename << ", " << width << "x" << height << std::endl;
+		std::cout << "- MSE: " << scores.Mse << std::endl;
+		std::cout << "- PSNR: " << scores.Psnr << " dB" << std::endl;
+		std::cout << "- SSIM: " << scores.Ssim << std::endl;
+		std::cout << "- FLIP: " << scores.Flip << std::endl;
+		std::cout << "- " << elapsed.count() << " ms on " << metrics.ThreadCount() << " threads (" << Utilities::Simd::Name(metrics.InstructionSet()) << ")" << std::endl;
+	}
+
+}
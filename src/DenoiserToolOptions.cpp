@@ -0,0 +1,120 @@
+#include "DenoiserToolOptions.hpp"
+#include "Utilities/DenoiserParameters.hpp"
+#include "Utilities/Exception.hpp"
+#include <boost/program_options.hpp>
+#include <cstdio>
+#include <iostream>
+
+using namespace boost::program_options;
+
+namespace
+{
+	DenoiserToolOptions::Extent ParseExtent(const std::string& extent)
+	{
+		unsigned width = 0;
+		unsigned height = 0;
+		char trailing = 0;
+
+		if (std::sscanf(extent.c_str(), "%ux%u%c", &width, &height, &trailing) != 2 || width == 0 || height == 0 || width > 16384 || height > 16384)
+		{
+			Throw(std::out_of_range("invalid benchmark extent '" + extent + "', expected WIDTHxHEIGHT"));
+		}
+
+		return { width, height };
+	}
+}
+
+DenoiserToolOptions::DenoiserToolOptions(const int argc, const char* argv[])
+{
+	const int lineLength = 120;
+	std::vector<std::string> benchmarkExtents;
+
+	options_description modes("Modes (no GPU required)", lineLength);
+	modes.add_options()
+		("check-denoiser-frames", value<std::string>(&CheckDenoiserFrames), "Filter the frames dumped to a directory by RayTracer --dump-denoiser-frames with the CPU reference denoiser and check its output against the GPU output dumped with them.")
+		("compare-images", value<std::vector<std::string>>(&CompareImages)->multitoken(), "Print the MSE, PSNR, SSIM and FLIP error of an image against a reference image (EXR or PNG).")
+		("reference-denoiser-benchmark", bool_switch(&ReferenceDenoiserBenchmark)->default_value(false), "Time the CPU reference denoiser at several resolutions.")
+		("tune-denoiser", value<std::vector<std::string>>(&TuneDenoiser), "Sweep the denoiser parameters over the frames dumped to a directory by RayTracer --dump-denoiser-frames with the CPU reference denoiser (can be repeated).")
+		;
+
+	options_description benchmark("Benchmark options", lineLength);
+	benchmark.add_options()
+		("benchmark-extent", value<std::vector<std::string>>(&benchmarkExtents), "A resolution timed by --reference-denoiser-benchmark, as WIDTHxHEIGHT (can be repeated, default: 1280x720 to 3840x2160).")
+		("benchmark-frames", value<uint32_t>(&BenchmarkFrames)->default_value(8), "The number of timed frames per resolution, after the history warm-up.")
+		;
+
+	options_description denoiser("Denoiser options", lineLength);
+	denoiser.add_options()
+		("atrous-iterations", value<uint32_t>(&ATrousIterations)->default_value(5), "The number of a-trous wavelet filter iterations.")
+		("denoiser-config", value<std::string>(&DenoiserConfig), "Load the denoiser filter parameters from a config file, such as the one recommended by --tune-denoiser.")
+		;
+
+	options_description tuning("Denoiser tuning options", lineLength);
+	tuning.add_options()
+		("tune-grid", value<std::string>(&TuneGrid), "The parameter grid swept by --tune-denoiser, comma separated values in the denoiser config format (default: built-in grid).")
+		("tune-output", value<std::string>(&TuneOutput)->default_value("."), "The existing directory the tuning report and the recommended denoiser config are written to.")
+		;
+
+	options_description cpu("CPU options", lineLength);
+	cpu.add_options()
+		("threads", value<uint32_t>(&Threads)->default_value(0), "The number of worker threads of the benchmark, the comparison and the check (0 = all the hardware threads).")
+		("instruction-set", value<uint32_t>(&InstructionSet)->default_value(2), "The best instruction set of the benchmark, the comparison and the check, lowered to what the CPU supports (0 = scalar, 1 = SSE2, 2 = AVX2).")
+		;
+
+	options_description desc("Application options", lineLength);
+	desc.add_options()
+		("help", "Display help message.")
+		;
+
+	desc.add(modes);
+	desc.add(benchmark);
+	desc.add(denoiser);
+	desc.add(tuning);
+	desc.add(cpu);
+
+	const positional_options_description positional;
+	variables_map vm;
+	store(command_line_parser(argc, argv).options(desc).positional(positional).run(), vm);
+	notify(vm);
+
+	if (vm.count("help"))
+	{
+		std::cout << desc << std::endl;
+		Throw(Help());
+	}
+
+	if (!CheckDenoiserFrames.empty() + !CompareImages.empty() + ReferenceDenoiserBenchmark + !TuneDenoiser.empty() != 1)
+	{
+		Throw(std::invalid_argument("expected one of --check-denoiser-frames, --compare-images, --reference-denoiser-benchmark or --tune-denoiser (see --help)"));
+	}
+
+	if (!CompareImages.empty() && CompareImages.size() != 2)
+	{
+		Throw(std::out_of_range("--compare-images expects an image and a reference image"));
+	}
+
+	if (ATrousIterations < 1 || ATrousIterations > Utilities::DenoiserParameters::MaxATrousIterations)
+	{
+		Throw(std::out_of_range("invalid number of a-trous iterations"));
+	}
+
+	if (BenchmarkFrames < 1)
+	{
+		Throw(std::out_of_range("invalid number of benchmark frames"));
+	}
+
+	if (InstructionSet > 2)
+	{
+		Throw(std::out_of_range("invalid instruction set"));
+	}
+
+	for (const auto& extent : benchmarkExtents)
+	{
+		BenchmarkExtents.push_back(ParseExtent(extent));
+	}
+
+	if (BenchmarkExtents.empty())
+	{
+		BenchmarkExtents = { {1280, 720}, {1920, 1080}, {2560, 1440}, {3840, 2160} };
+	}
+}
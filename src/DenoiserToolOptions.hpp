@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <exception>
+#include <string>
+#include <vector>
+
+// Command line of the DenoiserTool executable, the CPU denoiser modes that run without a GPU nor the Vulkan SDK.
+class DenoiserToolOptions final
+{
+public:
+
+	class Help : public std::exception
+	{
+	public:
+
+		Help() = default;
+		~Help() = default;
+	};
+
+	// Width and height of a reference denoiser benchmark run.
+	struct Extent
+	{
+		uint32_t Width;
+		uint32_t Height;
+	};
+
+	DenoiserToolOptions(int argc, const char* argv[]);
+	~DenoiserToolOptions() = default;
+
+	// Modes, exactly one of them is run.
+	std::string CheckDenoiserFrames{};
+	std::vector<std::string> CompareImages{};
+	bool ReferenceDenoiserBenchmark{};
+	std::vector<std::string> TuneDenoiser{};
+
+	// Benchmark options.
+	std::vector<Extent> BenchmarkExtents{};
+	uint32_t BenchmarkFrames{};
+
+	// Denoiser options.
+	uint32_t ATrousIterations{};
+	std::string DenoiserConfig{};
+
+	// Denoiser tuning options.
+	std::string TuneGrid{};
+	std::string TuneOutput{};
+
+	// CPU options.
+	uint32_t Threads{};
+	uint32_t InstructionSet{};
+};
@@ -14,13 +14,39 @@ Options::Options(const int argc, const char* argv[])
 	benchmark.add_options()
 		("next-scenes", bool_switch(&BenchmarkNextScenes)->default_value(false), "Load the next scene once the sample or time limit is reached.")
 		("max-time", value<uint32_t>(&BenchmarkMaxTime)->default_value(60), "The benchmark time limit per scene (in seconds).")
+		("compare-async-compute", bool_switch(&BenchmarkAsyncCompute)->default_value(false), "Run each scene without then with async compute and compare their frame times.")
 		;
 
 	options_description renderer("Renderer options", lineLength);
 	renderer.add_options()
-		("samples", value<uint32_t>(&Samples)->default_value(8), "The number of ray samples per pixel.")
+		("samples", value<uint32_t>(&Samples)->default_value(1), "The number of ray samples per pixel.")
 		("bounces", value<uint32_t>(&Bounces)->default_value(16), "The maximum number of bounces per ray.")
 		("max-samples", value<uint32_t>(&MaxSamples)->default_value(64 * 1024), "The maximum number of accumulated ray samples per pixel.")
+		("no-idle", bool_switch(&NoIdle)->default_value(false), "Keep tracing once the image has converged instead of presenting it again on input only.")
+		("convergence-threshold", value<float>(&ConvergenceThreshold)->default_value(0.0f), "The denoiser error estimate under which the image counts as converged (0 = maximum number of samples only).")
+		("render-scale", value<float>(&RenderScale)->default_value(1.0f), "The fraction of the display resolution that is traced, upscaled temporally to the display below 1 (0.5 to 1).")
+		("transfer-queue", bool_switch(&TransferQueue)->default_value(false), "Upload the scenes on a dedicated transfer queue when the device has one, instead of the graphics queue.")
+		("memory-budget", value<float>(&MemoryBudget)->default_value(0.9f), "The fraction of the device local memory budget over which a warning is printed (0 to 1).")
+		("budget-render-scale", bool_switch(&BudgetRenderScale)->default_value(false), "Lower the render scale, down to 0.5, while the device local memory usage is over the --memory-budget fraction.")
+		;
+
+	options_description denoiser("Denoiser options", lineLength);
+	denoiser.add_options()
+		("no-denoiser", bool_switch(&NoDenoiser)->default_value(false), "Disable the SVGF denoiser.")
+		("atrous-iterations", value<uint32_t>(&ATrousIterations)->default_value(5), "The number of a-trous wavelet filter iterations.")
+		("atrous-tile-threshold", value<float>(&ATrousTileThreshold)->default_value(0.05f), "Relative standard deviation under which a 16x16 tile skips the remaining a-trous iterations (0 = filter all the tiles).")
+		("denoiser-benchmark", bool_switch(&DenoiserBenchmark)->default_value(false), "Time the denoiser alone at several resolutions and exit.")
+		("async-compute", bool_switch(&AsyncCompute)->default_value(false), "Run the denoiser on the async compute queue, overlapped with the next frame's ray tracing.")
+		("adaptive-sampling", bool_switch(&AdaptiveSampling)->default_value(false), "Spread the ray samples per pixel where the denoiser estimates the most variance, at the same total.")
+		("denoiser-fp16", bool_switch(&DenoiserFp16)->default_value(false), "Store the denoiser history and filter images in half floats, also using half float arithmetic where supported.")
+		("no-temporal-gradient", bool_switch(&NoTemporalGradient)->default_value(false), "Disable the temporal gradients that shorten the denoiser history where the lighting changes.")
+		("denoiser-config", value<std::string>(&DenoiserConfig), "Load the denoiser filter parameters from a config file, such as the one recommended by DenoiserTool --tune-denoiser.")
+		;
+
+	options_description tuning("Denoiser tuning options", lineLength);
+	tuning.add_options()
+		("dump-denoiser-frames", value<std::string>(&DumpDenoiserFrames), "Write the denoiser inputs and outputs of the first frames of the scene and the inputs of its converged image (up to --max-samples) to an existing directory and exit.")
+		("dump-frame-count", value<uint32_t>(&DumpFrameCount)->default_value(16), "The number of noisy frames written by --dump-denoiser-frames.")
 		;
 
 	options_description scene("Scene options", lineLength);
@@ -31,6 +57,7 @@ Options::Options(const int argc, const char* argv[])
 	options_description vulkan("Vulkan options", lineLength);
 	vulkan.add_options()
 		("visible-device", value<std::vector<uint32_t>>(&VisibleDevices), "Explicitly set which Vulkan device ID is visible (can be repeated for multiple devices). If unspecified, all devices are visible.")
+		("frames-in-flight", value<uint32_t>(&FramesInFlight)->default_value(2), "The number of frames the CPU can record ahead of the GPU (1 to 4).")
 		;
 
 	options_description window("Window options", lineLength);
@@ -49,6 +76,8 @@ Options::Options(const int argc, const char* argv[])
 
 	desc.add(benchmark);
 	desc.add(renderer);
+	desc.add(denoiser);
+	desc.add(tuning);
 	desc.add(scene);
 	desc.add(vulkan);
 	desc.add(window);
@@ -69,6 +98,31 @@ Options::Options(const int argc, const char* argv[])
 		Throw(std::out_of_range("scene index is too large"));
 	}
 
+	if (ATrousIterations < 1 || ATrousIterations > 8)
+	{
+		Throw(std::out_of_range("invalid number of a-trous iterations"));
+	}
+
+	if (RenderScale < 0.5f || RenderScale > 1.0f)
+	{
+		Throw(std::out_of_range("invalid render scale"));
+	}
+
+	if (MemoryBudget <= 0.0f || MemoryBudget > 1.0f)
+	{
+		Throw(std::out_of_range("invalid memory budget"));
+	}
+
+	if (!DumpDenoiserFrames.empty() && (DumpFrameCount < 1 || Benchmark))
+	{
+		Throw(std::out_of_range("invalid denoiser frame dump"));
+	}
+
+	if (FramesInFlight < 1 || FramesInFlight > 4)
+	{
+		Throw(std::out_of_range("invalid number of frames in flight"));
+	}
+
 	if (PresentMode > 3)
 	{
 		Throw(std::out_of_range("invalid present mode"));
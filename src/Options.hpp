@@ -2,6 +2,7 @@
 
 #include <cstdint>
 #include <exception>
+#include <string>
 #include <vector>
 
 class Options final
@@ -25,17 +26,40 @@ public:
 	// Benchmark options.
 	bool BenchmarkNextScenes{};
 	uint32_t BenchmarkMaxTime{};
+	bool BenchmarkAsyncCompute{};
 
 	// Renderer options.
 	uint32_t Samples{};
 	uint32_t Bounces{};
 	uint32_t MaxSamples{};
+	bool NoIdle{};
+	float ConvergenceThreshold{};
+	float RenderScale{};
+	bool TransferQueue{};
+	float MemoryBudget{};
+	bool BudgetRenderScale{};
+
+	// Denoiser options.
+	bool NoDenoiser{};
+	uint32_t ATrousIterations{};
+	float ATrousTileThreshold{};
+	bool DenoiserBenchmark{};
+	bool AsyncCompute{};
+	bool AdaptiveSampling{};
+	bool DenoiserFp16{};
+	bool NoTemporalGradient{};
+	std::string DenoiserConfig{};
+
+	// Denoiser tuning options.
+	std::string DumpDenoiserFrames{};
+	uint32_t DumpFrameCount{};
 
 	// Scene options.
 	uint32_t SceneIndex{};
 
 	// Vulkan options
 	std::vector<uint32_t> VisibleDevices{};
+	uint32_t FramesInFlight{};
 
 	// Window options
 	uint32_t Width{};
@@ -5,11 +5,17 @@
 #include "Assets/Scene.hpp"
 #include "Assets/Texture.hpp"
 #include "Assets/UniformBuffer.hpp"
+#include "Utilities/Console.hpp"
+#include "Utilities/DenoiserConfig.hpp"
 #include "Utilities/Exception.hpp"
 #include "Utilities/Glm.hpp"
+#include "Utilities/StbImage.hpp"
 #include "Vulkan/Device.hpp"
+#include "Vulkan/MemoryAllocator.hpp"
 #include "Vulkan/SwapChain.hpp"
 #include "Vulkan/Window.hpp"
+#include <algorithm>
+#include <cstdio>
 #include <iostream>
 #include <sstream>
 
@@ -21,10 +27,26 @@ namespace
 #else
 		true;
 #endif
+
+	// Frames traced after a change before the image may count as converged, letting the denoiser history settle.
+	const uint32_t SettleFrameCount = 8;
+
+	// Idle frames drawn before waiting for events, so that the user interface catches up with the last input.
+	const uint32_t UserInterfaceFrameCount = 2;
+
+	// Frames left for the memory budget to reflect a render scale change before lowering it again.
+	const uint32_t BudgetSettleFrameCount = 30;
+	const float BudgetRenderScaleStep = 0.125f;
+	const float MinRenderScale = 0.5f;
+
+	double ToMebibytes(const VkDeviceSize bytes)
+	{
+		return static_cast<double>(bytes) / (1024 * 1024);
+	}
 }
 
-RayTracer::RayTracer(const UserSettings& userSettings, const Vulkan::WindowConfig& windowConfig, const VkPresentModeKHR presentMode) :
-	Application(windowConfig, presentMode, EnableValidationLayers),
+RayTracer::RayTracer(const UserSettings& userSettings, const Vulkan::WindowConfig& windowConfig, const VkPresentModeKHR presentMode, const uint32_t framesInFlight) :
+	Application(windowConfig, presentMode, framesInFlight, EnableValidationLayers),
 	userSettings_(userSettings)
 {
 	CheckFramebufferSize();
@@ -41,8 +63,7 @@ Assets::UniformBufferObject RayTracer::GetUniformBufferObject(const VkExtent2D e
 
 	Assets::UniformBufferObject ubo = {};
 	ubo.ModelView = modelViewController_.ModelView();
-	ubo.Projection = glm::perspective(glm::radians(userSettings_.FieldOfView), extent.width / static_cast<float>(extent.height), 0.1f, 10000.0f);
-	ubo.Projection[1][1] *= -1; // Inverting Y for Vulkan, https://matthewwellings.com/blog/the-new-vulkan-coordinate-system/
+	ubo.Projection = GetProjection(extent);
 	ubo.ModelViewInverse = glm::inverse(ubo.ModelView);
 	ubo.ProjectionInverse = glm::inverse(ubo.Projection);
 	ubo.Aperture = userSettings_.Aperture;
@@ -55,10 +76,49 @@ Assets::UniformBufferObject RayTracer::GetUniformBufferObject(const VkExtent2D e
 	ubo.ShowHeatmap = userSettings_.ShowHeatmap;
 	ubo.HeatmapScale = userSettings_.HeatmapScale;
 	ubo.FrameCounter = this->FrameCounter;
+	ubo.AdaptiveSampling = GetDenoiserParameters(extent).AdaptiveSampling;
+	ubo.Jitter = PixelJitter();
 
 	return ubo;
 }
 
+Vulkan::RayTracing::Denoiser::Parameters RayTracer::GetDenoiserParameters(const VkExtent2D extent) const
+{
+	Vulkan::RayTracing::Denoiser::Parameters parameters = {};
+	parameters.Enabled = userSettings_.Denoise && !userSettings_.ShowHeatmap;
+	parameters.ATrousIterations = userSettings_.ATrousIterations;
+	parameters.PhiColor = userSettings_.PhiColor;
+	parameters.PhiNormal = userSettings_.PhiNormal;
+	parameters.PhiDepth = userSettings_.PhiDepth;
+	parameters.ColorAlpha = userSettings_.ColorAlpha;
+	parameters.MomentsAlpha = userSettings_.MomentsAlpha;
+	parameters.AdaptiveSampling = parameters.Enabled && userSettings_.AdaptiveSampling;
+	parameters.TemporalGradient = parameters.Enabled && userSettings_.TemporalGradient;
+	parameters.EstimateError = parameters.Enabled && userSettings_.IdleWhenConverged && userSettings_.ConvergenceThreshold > 0;
+	parameters.SampleBudget = numberOfSamples_;
+	parameters.ATrousTileThreshold = userSettings_.ATrousTileThreshold;
+
+	return parameters;
+}
+
+Vulkan::RayTracing::RayTracingPipeline::Permutation RayTracer::GetRayTracingPermutation() const
+{
+	Vulkan::RayTracing::RayTracingPipeline::Permutation permutation = {};
+	permutation.ShowHeatmap = userSettings_.ShowHeatmap;
+	permutation.AdaptiveSampling = GetDenoiserParameters(SwapChain().Extent()).AdaptiveSampling;
+	permutation.TemporalGradient = GetDenoiserParameters(SwapChain().Extent()).TemporalGradient;
+
+	return permutation;
+}
+
+glm::mat4 RayTracer::GetProjection(const VkExtent2D extent) const
+{
+	glm::mat4 projection = glm::perspective(glm::radians(userSettings_.FieldOfView), extent.width / static_cast<float>(extent.height), 0.1f, 10000.0f);
+	projection[1][1] *= -1; // Inverting Y for Vulkan, https://matthewwellings.com/blog/the-new-vulkan-coordinate-system/
+
+	return projection;
+}
+
 void RayTracer::SetPhysicalDevice(
 	VkPhysicalDevice physicalDevice, 
 	std::vector<const char*>& requiredExtensions,
@@ -125,23 +185,60 @@ void RayTracer::DrawFrame()
 	}
 
 	// Check if the accumulation buffer needs to be reset.
-	if (resetAccumulation_ || 
-		userSettings_.RequiresAccumulationReset(previousSettings_) || 
-		!userSettings_.AccumulateRays)
+	const bool resetAccumulation =
+		resetAccumulation_ ||
+		userSettings_.RequiresAccumulationReset(previousSettings_) ||
+		!userSettings_.AccumulateRays;
+
+	if (resetAccumulation)
 	{
 		totalNumberOfSamples_ = 0;
 		resetAccumulation_ = false;
 	}
 
+	if (resetAccumulation || userSettings_.RequiresFrameUpdate(previousSettings_))
+	{
+		framesSinceChange_ = 0;
+	}
+
+	// Lowering the render scale here recreates the render targets in this frame already.
+	memoryStatistics_ = Device().Allocator().GetStatistics();
+	CheckMemoryBudget();
+
 	previousSettings_ = userSettings_;
-	 
+
+	// Stop tracing once converged, only the cached image is presented until something changes.
+	idle_ = framesSinceChange_ >= SettleFrameCount && IsConverged();
+
 	// Keep track of our sample count.
-	numberOfSamples_ = glm::clamp(userSettings_.MaxNumberOfSamples - totalNumberOfSamples_, 0u, userSettings_.NumberOfSamples);
+	numberOfSamples_ = idle_ ? 0 : glm::clamp(userSettings_.MaxNumberOfSamples - totalNumberOfSamples_, 0u, userSettings_.NumberOfSamples);
 	totalNumberOfSamples_ += numberOfSamples_;
 
 	Application::DrawFrame();
 	
 	FrameCounter++;
+
+	if (!userSettings_.DumpDenoiserFrames.empty())
+	{
+		DumpDenoiserFrame();
+	}
+
+	if (!idle_)
+	{
+		framesSinceChange_++;
+		idleFrames_ = 0;
+		return;
+	}
+
+	// A camera motion or a swap chain recreation during the frame must be drawn without waiting.
+	if (++idleFrames_ > UserInterfaceFrameCount && !resetAccumulation_)
+	{
+		Window().WaitForEvents();
+
+		// Do not let the camera catch up with the time spent waiting.
+		time_ = Window().GetTime();
+		idleFrames_ = 0;
+	}
 }
 
 void RayTracer::Render(VkCommandBuffer commandBuffer, const uint32_t imageIndex)
@@ -149,10 +246,10 @@ void RayTracer::Render(VkCommandBuffer commandBuffer, const uint32_t imageIndex)
 	// Record delta time between calls to Render.
 	const auto prevTime = time_;
 	time_ = Window().GetTime();
-	const auto timeDelta = time_ - prevTime;
+	timeDelta_ = time_ - prevTime;
 
 	// Update the camera position / angle.
-	resetAccumulation_ = modelViewController_.UpdateCamera(cameraInitialSate_.ControlSpeed, timeDelta);
+	resetAccumulation_ = modelViewController_.UpdateCamera(cameraInitialSate_.ControlSpeed, timeDelta_);
 
 	// Check the current state of the benchmark, update it for the new frame.
 	CheckAndUpdateBenchmarkState(prevTime);
@@ -162,30 +259,24 @@ void RayTracer::Render(VkCommandBuffer commandBuffer, const uint32_t imageIndex)
 	//	? Vulkan::RayTracing::Application::Render(commandBuffer, imageIndex)
 	//	: Vulkan::Application::Render(commandBuffer, imageIndex);
 
+	// The ray generation shader writes its own G-buffer, the raster pass only runs when not ray tracing.
 	if (userSettings_.IsRayTraced) {
-		Vulkan::Application::Render(commandBuffer, imageIndex);
 		Vulkan::RayTracing::Application::Render(commandBuffer, imageIndex);
 	}
 	else
 		Vulkan::Application::Render(commandBuffer, imageIndex);
 
-	// Render the UI
-	Statistics stats = {};
-	stats.FramebufferSize = Window().FramebufferSize();
-	stats.FrameRate = static_cast<float>(1 / timeDelta);
-
-	if (userSettings_.IsRayTraced)
+	// With async compute the swap chain image is only written when presenting the previous frame.
+	if (!AsyncCompute())
 	{
-		const auto extent = SwapChain().Extent();
-
-		stats.RayRate = static_cast<float>(
-			double(extent.width*extent.height)*numberOfSamples_
-			/ (timeDelta * 1000000000));
-
-		stats.TotalSamples = totalNumberOfSamples_;
+		RenderUserInterface(commandBuffer, imageIndex);
 	}
+}
 
-	userInterface_->Render(commandBuffer, SwapChainFrameBuffer(imageIndex), stats);
+void RayTracer::RenderPresent(VkCommandBuffer commandBuffer, const uint32_t imageIndex)
+{
+	Application::RenderPresent(commandBuffer, imageIndex);
+	RenderUserInterface(commandBuffer, imageIndex);
 }
 
 void RayTracer::OnKey(int key, int scancode, int action, int mods)
@@ -280,7 +371,7 @@ void RayTracer::LoadScene(const uint32_t sceneIndex)
 		textures.push_back(Assets::Texture::LoadTexture("../assets/textures/white.png", Vulkan::SamplerConfig()));
 	}
 	
-	scene_.reset(new Assets::Scene(CommandPool(), std::move(models), std::move(textures)));
+	scene_.reset(new Assets::Scene(Uploader(), std::move(models), std::move(textures)));
 	sceneIndex_ = sceneIndex;
 
 	userSettings_.FieldOfView = cameraInitialSate_.FieldOfView;
@@ -304,9 +395,11 @@ void RayTracer::CheckAndUpdateBenchmarkState(double prevTime)
 	if (periodTotalFrames_ == 0)
 	{
 		std::cout << std::endl;
-		std::cout << "Benchmark: Start scene #" << sceneIndex_ << " '" << SceneList::AllScenes[sceneIndex_].first << "'" << std::endl;
+		std::cout << "Benchmark: Start scene #" << sceneIndex_ << " '" << SceneList::AllScenes[sceneIndex_].first << "'"
+			<< (userSettings_.BenchmarkAsyncCompute ? (userSettings_.AsyncCompute ? " with async compute" : " without async compute") : "") << std::endl;
 		sceneInitialTime_ = time_;
 		periodInitialTime_ = time_;
+		sceneTotalFrames_ = 0;
 	}
 
 	// Print out the frame rate at regular intervals.
@@ -323,6 +416,7 @@ void RayTracer::CheckAndUpdateBenchmarkState(double prevTime)
 		}
 
 		periodTotalFrames_++;
+		sceneTotalFrames_++;
 	}
 
 	// If in benchmark mode, bail out from the scene if we've reached the time or sample limit.
@@ -332,6 +426,39 @@ void RayTracer::CheckAndUpdateBenchmarkState(double prevTime)
 
 		if (timeLimitReached || sampleLimitReached)
 		{
+			// End-to-end frame time over the whole scene run, CPU recording and presentation included.
+			const double frameTime = 1000 * (time_ - sceneInitialTime_) / sceneTotalFrames_;
+
+			if (userSettings_.BenchmarkAsyncCompute)
+			{
+				if (!userSettings_.AsyncCompute)
+				{
+					// Run the scene again, this time with the denoiser overlapping the next frame's ray tracing.
+					syncFrameTime_ = frameTime;
+					userSettings_.AsyncCompute = true;
+					periodTotalFrames_ = 0;
+					resetAccumulation_ = true;
+					return;
+				}
+
+				std::cout << "Benchmark: frame time " << syncFrameTime_ << " ms without async compute, "
+					<< frameTime << " ms with async compute (" << syncFrameTime_ / frameTime << "x)" << std::endl;
+
+				userSettings_.AsyncCompute = false;
+			}
+
+			const auto& memory = memoryStatistics_;
+
+			std::cout << "Benchmark: device local memory " << ToMebibytes(memory.DeviceLocalUsage) << "/" << ToMebibytes(memory.DeviceLocalBudget) << " MiB";
+
+			for (uint32_t i = 0; i != Vulkan::MemoryAllocator::CategoryCount; ++i)
+			{
+				std::cout << (i == 0 ? " (" : ", ") << Vulkan::MemoryAllocator::CategoryName(static_cast<Vulkan::MemoryAllocator::Category>(i))
+					<< " " << ToMebibytes(memory.CategoryBytes[i]) << " MiB";
+			}
+
+			std::cout << ")" << std::endl;
+
 			if (!userSettings_.BenchmarkNextScenes || static_cast<size_t>(userSettings_.SceneIndex) == SceneList::AllScenes.size() - 1)
 			{
 				Window().Close();
@@ -343,6 +470,136 @@ void RayTracer::CheckAndUpdateBenchmarkState(double prevTime)
 	}
 }
 
+void RayTracer::RenderUserInterface(VkCommandBuffer commandBuffer, const uint32_t imageIndex)
+{
+	Statistics stats = {};
+	stats.FramebufferSize = Window().FramebufferSize();
+	stats.FrameRate = static_cast<float>(1 / timeDelta_);
+
+	if (userSettings_.IsRayTraced)
+	{
+		const auto extent = RenderExtent();
+
+		stats.RayRate = static_cast<float>(
+			double(extent.width*extent.height)*numberOfSamples_
+			/ (timeDelta_ * 1000000000));
+
+		stats.TotalSamples = totalNumberOfSamples_;
+		stats.ErrorEstimate = ErrorEstimate();
+		stats.ATrousTiles = ATrousTileCounts();
+		stats.Idle = idle_;
+	}
+	else
+	{
+		stats.ErrorEstimate = -1;
+	}
+
+	stats.Memory = memoryStatistics_;
+
+	userInterface_->Render(commandBuffer, SwapChainFrameBuffer(imageIndex), stats);
+}
+
+void RayTracer::CheckMemoryBudget()
+{
+	const auto& memory = memoryStatistics_;
+	const bool overBudget = memory.DeviceLocalUsage > userSettings_.MemoryBudget * memory.DeviceLocalBudget;
+
+	if (overBudget && !overMemoryBudget_)
+	{
+		Utilities::Console::Write(Utilities::Severity::Warning, [this, &memory]()
+		{
+			std::cerr << "WARNING: device local memory usage (" << ToMebibytes(memory.DeviceLocalUsage) << " MiB) is over "
+				<< 100 * userSettings_.MemoryBudget << "% of the budget (" << ToMebibytes(memory.DeviceLocalBudget) << " MiB)" << std::endl;
+		});
+	}
+
+	overMemoryBudget_ = overBudget;
+	framesSinceBudgetChange_++;
+
+	// Trade resolution for memory instead of running out of it, the smaller render targets come with the swap chain recreation.
+	if (!overBudget || !userSettings_.BudgetRenderScale || !userSettings_.IsRayTraced ||
+		userSettings_.RenderScale <= MinRenderScale || framesSinceBudgetChange_ < BudgetSettleFrameCount)
+	{
+		return;
+	}
+
+	userSettings_.RenderScale = std::max(userSettings_.RenderScale - BudgetRenderScaleStep, MinRenderScale);
+	framesSinceBudgetChange_ = 0;
+
+	Utilities::Console::Write(Utilities::Severity::Warning, [this]()
+	{
+		std::cerr << "WARNING: lowering the render scale to " << userSettings_.RenderScale << " to fit the memory budget" << std::endl;
+	});
+}
+
+bool RayTracer::IsConverged() const
+{
+	if (!userSettings_.IdleWhenConverged || !userSettings_.IsRayTraced || userSettings_.Benchmark)
+	{
+		return false;
+	}
+
+	if (totalNumberOfSamples_ >= userSettings_.MaxNumberOfSamples)
+	{
+		return true;
+	}
+
+	// The estimate lags a few frames behind, it must not predate the last change.
+	if (userSettings_.ConvergenceThreshold <= 0 || framesSinceChange_ <= FrameContexts().size())
+	{
+		return false;
+	}
+
+	const float errorEstimate = ErrorEstimate();
+	return errorEstimate >= 0 && errorEstimate < userSettings_.ConvergenceThreshold;
+}
+
+void RayTracer::DumpDenoiserFrame()
+{
+	const auto& directory = userSettings_.DumpDenoiserFrames;
+
+	// First the noisy frames, traced without accumulation, then the same view accumulated up to the sample limit.
+	// The GPU denoiser output of each noisy frame and its filter parameters go along, to check the CPU reference denoiser.
+	if (dumpedFrames_ != userSettings_.DumpFrameCount)
+	{
+		const auto extent = RenderExtent();
+		char name[32];
+
+		if (dumpedFrames_ == 0)
+		{
+			Utilities::DenoiserConfig::Save(directory + "/denoiser-frames.cfg", GetDenoiserParameters(extent), "Filter parameters of the dumped denoiser frames");
+		}
+
+		std::snprintf(name, sizeof(name), "/frame-%04u.svgf", dumpedFrames_);
+		ReadDenoiserInputs().Save(directory + name);
+
+		std::snprintf(name, sizeof(name), "/frame-%04u-denoised.png", dumpedFrames_);
+		const auto denoised = ReadDenoisedOutput();
+
+		if (!stbi_write_png((directory + name).c_str(), static_cast<int>(extent.width), static_cast<int>(extent.height), 4, denoised.data(), static_cast<int>(4 * extent.width)))
+		{
+			Throw(std::runtime_error("cannot write '" + directory + name + "'"));
+		}
+
+		if (++dumpedFrames_ == userSettings_.DumpFrameCount)
+		{
+			userSettings_.AccumulateRays = true;
+		}
+
+		return;
+	}
+
+	if (numberOfSamples_ != 0 && totalNumberOfSamples_ >= userSettings_.MaxNumberOfSamples)
+	{
+		ReadDenoiserInputs().Save(directory + "/reference.svgf");
+
+		std::cout << "Denoiser frames: wrote " << dumpedFrames_ << " frames and a " << totalNumberOfSamples_
+			<< " samples reference to '" << directory << "'" << std::endl;
+
+		Window().Close();
+	}
+}
+
 void RayTracer::CheckFramebufferSize() const
 {
 	// Check the framebuffer size when requesting a fullscreen window, as it's not guaranteed to match.
@@ -3,6 +3,7 @@
 #include "ModelViewController.hpp"
 #include "SceneList.hpp"
 #include "UserSettings.hpp"
+#include "Vulkan/MemoryAllocator.hpp"
 #include "Vulkan/RayTracing/Application.hpp"
 
 class RayTracer final : public Vulkan::RayTracing::Application
@@ -11,13 +12,18 @@ public:
 
 	VULKAN_NON_COPIABLE(RayTracer)
 
-	RayTracer(const UserSettings& userSettings, const Vulkan::WindowConfig& windowConfig, VkPresentModeKHR presentMode);
+	RayTracer(const UserSettings& userSettings, const Vulkan::WindowConfig& windowConfig, VkPresentModeKHR presentMode, uint32_t framesInFlight);
 	~RayTracer();
 
 protected:
 
 	const Assets::Scene& GetScene() const override { return *scene_; }
 	Assets::UniformBufferObject GetUniformBufferObject(VkExtent2D extent) const override;
+	Vulkan::RayTracing::Denoiser::Parameters GetDenoiserParameters(VkExtent2D extent) const override;
+	Vulkan::RayTracing::RayTracingPipeline::Permutation GetRayTracingPermutation() const override;
+	bool UseHalfPrecisionDenoiser() const override { return userSettings_.HalfPrecisionDenoiser; }
+	float GetRenderScale() const override { return userSettings_.RenderScale; }
+	bool IsIdle() const override { return idle_; }
 
 	void SetPhysicalDevice(
 		VkPhysicalDevice physicalDevice, 
@@ -30,6 +36,9 @@ protected:
 	void DeleteSwapChain() override;
 	void DrawFrame() override;
 	void Render(VkCommandBuffer commandBuffer, uint32_t imageIndex) override;
+	void RenderPresent(VkCommandBuffer commandBuffer, uint32_t imageIndex) override;
+	bool UseDedicatedTransferQueue() const override { return userSettings_.TransferQueue; }
+	bool UseAsyncCompute() const override { return userSettings_.IsRayTraced && userSettings_.AsyncCompute && userSettings_.DumpDenoiserFrames.empty(); }
 
 	void OnKey(int key, int scancode, int action, int mods) override;
 	void OnCursorPosition(double xpos, double ypos) override;
@@ -38,9 +47,14 @@ protected:
 
 private:
 
+	glm::mat4 GetProjection(VkExtent2D extent) const;
 	void LoadScene(uint32_t sceneIndex);
 	void CheckAndUpdateBenchmarkState(double prevTime);
+	void CheckMemoryBudget();
 	void CheckFramebufferSize() const;
+	bool IsConverged() const;
+	void DumpDenoiserFrame();
+	void RenderUserInterface(VkCommandBuffer commandBuffer, uint32_t imageIndex);
 
 	uint32_t sceneIndex_{};
 	UserSettings userSettings_{};
@@ -52,15 +66,31 @@ private:
 	std::unique_ptr<class UserInterface> userInterface_;
 
 	double time_{};
+	double timeDelta_{};
 
 	uint32_t totalNumberOfSamples_{};
 	uint32_t numberOfSamples_{};
 	bool resetAccumulation_{};
 
+	// Once converged, the last image is presented again and the window waits for events between frames.
+	bool idle_{};
+	uint32_t framesSinceChange_{};
+	uint32_t idleFrames_{};
+
+	// Noisy frames written so far by the denoiser frame dump.
+	uint32_t dumpedFrames_{};
+
+	// Device memory figures, queried once per frame.
+	Vulkan::MemoryAllocator::Statistics memoryStatistics_{};
+	bool overMemoryBudget_{};
+	uint32_t framesSinceBudgetChange_{};
+
 	// Benchmark stats
 	double sceneInitialTime_{};
 	double periodInitialTime_{};
 	uint32_t periodTotalFrames_{};
+	uint32_t sceneTotalFrames_{};
+	double syncFrameTime_{};
 
 	uint32_t FrameCounter = 0;
 };
@@ -17,6 +17,7 @@
 #include "ImGui/imgui_impl_glfw.h"
 #include "ImGui/imgui_impl_vulkan.h"
 
+#include <algorithm>
 #include <array>
 
 namespace
@@ -211,6 +212,26 @@ void UserInterface::DrawSettings()
 		ImGui::SliderScalar("Samples", ImGuiDataType_U32, &Settings().NumberOfSamples, &min, &max);
 		min = 1, max = 32;
 		ImGui::SliderScalar("Bounces", ImGuiDataType_U32, &Settings().NumberOfBounces, &min, &max);
+		ImGui::Checkbox("Idle when converged", &Settings().IdleWhenConverged);
+		ImGui::SliderFloat("Convergence", &Settings().ConvergenceThreshold, 0.0f, 0.1f, "%.3f");
+		ImGui::SliderFloat("Render scale", &Settings().RenderScale, 0.5f, 1.0f, "%.2f");
+		ImGui::NewLine();
+
+		ImGui::Text("Denoiser");
+		ImGui::Separator();
+		ImGui::Checkbox("Enable SVGF denoiser", &Settings().Denoise);
+		ImGui::Checkbox("Async compute", &Settings().AsyncCompute);
+		ImGui::Checkbox("Adaptive sampling", &Settings().AdaptiveSampling);
+		ImGui::Checkbox("Half precision", &Settings().HalfPrecisionDenoiser);
+		ImGui::Checkbox("Temporal gradients", &Settings().TemporalGradient);
+		min = 1, max = 8;
+		ImGui::SliderScalar("A-trous iterations", ImGuiDataType_U32, &Settings().ATrousIterations, &min, &max);
+		ImGui::SliderFloat("Phi color", &Settings().PhiColor, 0.1f, 64.0f, "%.1f", ImGuiSliderFlags_Logarithmic);
+		ImGui::SliderFloat("Phi normal", &Settings().PhiNormal, 1.0f, 256.0f, "%.0f", ImGuiSliderFlags_Logarithmic);
+		ImGui::SliderFloat("Phi depth", &Settings().PhiDepth, 0.1f, 16.0f, "%.1f", ImGuiSliderFlags_Logarithmic);
+		ImGui::SliderFloat("Color alpha", &Settings().ColorAlpha, 0.01f, 1.0f, "%.2f");
+		ImGui::SliderFloat("Moments alpha", &Settings().MomentsAlpha, 0.01f, 1.0f, "%.2f");
+		ImGui::SliderFloat("Tile threshold", &Settings().ATrousTileThreshold, 0.0f, 0.5f, "%.3f");
 		ImGui::NewLine();
 
 		ImGui::Text("Camera");
@@ -258,6 +279,37 @@ void UserInterface::DrawOverlay(const Statistics& statistics)
 		ImGui::Text("Frame rate: %.1f fps", statistics.FrameRate);
 		ImGui::Text("Primary ray rate: %.2f Gr/s", statistics.RayRate);
 		ImGui::Text("Accumulated samples:  %u", statistics.TotalSamples);
+
+		if (statistics.ErrorEstimate >= 0)
+		{
+			ImGui::Text("Error estimate: %.4f", statistics.ErrorEstimate);
+		}
+
+		for (size_t i = 0; i != statistics.ATrousTiles.size(); ++i)
+		{
+			const auto& tiles = statistics.ATrousTiles[i];
+			ImGui::Text("A-trous #%zu tiles: %u/%u (%.0f%%)", i, tiles.first, tiles.second, 100.0f * tiles.first / std::max(tiles.second, 1u));
+		}
+
+		if (statistics.Idle)
+		{
+			ImGui::Text("Converged, idle");
+		}
+
+		const auto& memory = statistics.Memory;
+		const float mebibyte = 1024.0f * 1024.0f;
+
+		ImGui::Separator();
+		ImGui::Text("Device memory: %.0f/%.0f MiB", memory.AllocatedBytes / mebibyte, (memory.BlockBytes + memory.DedicatedBytes) / mebibyte);
+		ImGui::Text("Allocations: %u in %u blocks, %u dedicated", memory.AllocationCount, memory.BlockCount, memory.DedicatedCount);
+		ImGui::Text("Memory objects: %u (%u allocated)", memory.MemoryObjectCount, memory.AllocateCallCount);
+		ImGui::Text("Device local: %.0f/%.0f MiB budget", memory.DeviceLocalUsage / mebibyte, memory.DeviceLocalBudget / mebibyte);
+
+		for (uint32_t i = 0; i != Vulkan::MemoryAllocator::CategoryCount; ++i)
+		{
+			const auto name = Vulkan::MemoryAllocator::CategoryName(static_cast<Vulkan::MemoryAllocator::Category>(i));
+			ImGui::Text(" %s: %.1f MiB", name, memory.CategoryBytes[i] / mebibyte);
+		}
 	}
 	ImGui::End();
 }
@@ -1,6 +1,9 @@
 #pragma once
 #include "Vulkan/Vulkan.hpp"
+#include "Vulkan/MemoryAllocator.hpp"
 #include <memory>
+#include <utility>
+#include <vector>
 
 namespace Vulkan
 {
@@ -20,6 +23,10 @@ struct Statistics final
 	float FrameRate;
 	float RayRate;
 	uint32_t TotalSamples;
+	float ErrorEstimate;
+	std::vector<std::pair<uint32_t, uint32_t>> ATrousTiles; // Processed and total tiles of each a-trous iteration.
+	bool Idle;
+	Vulkan::MemoryAllocator::Statistics Memory;
 };
 
 class UserInterface final
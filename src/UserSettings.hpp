@@ -1,5 +1,7 @@
 #pragma once
 
+#include <string>
+
 struct UserSettings final
 {
 	// Application
@@ -8,6 +10,7 @@ struct UserSettings final
 	// Benchmark
 	bool BenchmarkNextScenes{};
 	uint32_t BenchmarkMaxTime{};
+	bool BenchmarkAsyncCompute{};
 	
 	// Scene
 	int SceneIndex;
@@ -18,6 +21,30 @@ struct UserSettings final
 	uint32_t NumberOfSamples;
 	uint32_t NumberOfBounces;
 	uint32_t MaxNumberOfSamples;
+	bool IdleWhenConverged;
+	float ConvergenceThreshold; // Error estimate under which the image counts as converged, zero to rely on the sample cap only.
+	float RenderScale; // Fraction of the display resolution that is traced, upscaled temporally below one.
+	bool TransferQueue; // Uploads on a dedicated transfer queue, read once on device creation.
+	float MemoryBudget; // Fraction of the device local memory budget treated as a soft limit.
+	bool BudgetRenderScale; // Lowers the render scale while over the soft limit.
+
+	// Denoiser
+	bool Denoise;
+	bool AsyncCompute;
+	bool AdaptiveSampling;
+	bool HalfPrecisionDenoiser;
+	bool TemporalGradient;
+	uint32_t ATrousIterations;
+	float PhiColor;
+	float PhiNormal;
+	float PhiDepth;
+	float ColorAlpha;
+	float MomentsAlpha;
+	float ATrousTileThreshold;
+
+	// Denoiser frame dump, disabled when the directory is empty.
+	std::string DumpDenoiserFrames;
+	uint32_t DumpFrameCount;
 
 	// Camera
 	float FieldOfView;
@@ -45,4 +72,27 @@ struct UserSettings final
 			Aperture != prev.Aperture ||
 			FocusDistance != prev.FocusDistance;
 	}
+
+	// Whether the presented image must be rendered again, even if the accumulation carries on.
+	bool RequiresFrameUpdate(const UserSettings& prev) const
+	{
+		return
+			RequiresAccumulationReset(prev) ||
+			IdleWhenConverged != prev.IdleWhenConverged ||
+			ConvergenceThreshold != prev.ConvergenceThreshold ||
+			RenderScale != prev.RenderScale ||
+			Denoise != prev.Denoise ||
+			AdaptiveSampling != prev.AdaptiveSampling ||
+			HalfPrecisionDenoiser != prev.HalfPrecisionDenoiser ||
+			TemporalGradient != prev.TemporalGradient ||
+			ATrousIterations != prev.ATrousIterations ||
+			PhiColor != prev.PhiColor ||
+			PhiNormal != prev.PhiNormal ||
+			PhiDepth != prev.PhiDepth ||
+			ColorAlpha != prev.ColorAlpha ||
+			MomentsAlpha != prev.MomentsAlpha ||
+			ATrousTileThreshold != prev.ATrousTileThreshold ||
+			ShowHeatmap != prev.ShowHeatmap ||
+			HeatmapScale != prev.HeatmapScale;
+	}
 };
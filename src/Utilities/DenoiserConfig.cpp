@@ -0,0 +1,192 @@
+#include "DenoiserConfig.hpp"
+#include "Exception.hpp"
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+namespace Utilities::DenoiserConfig {
+
+namespace
+{
+	using Parameters = DenoiserParameters;
+
+	// Setter and getter of a stored parameter, in file order. Values are checked against the valid range of the
+	// parameter when parsed, the setter only sees valid ones.
+	struct Field
+	{
+		const char* Name;
+		const char* Expected;
+		bool (*IsValid)(float value);
+		void (*Set)(Parameters& parameters, float value);
+		float (*Get)(const Parameters& parameters);
+	};
+
+	bool IsIterationCount(const float value)
+	{
+		return value >= 1.0f && value <= static_cast<float>(Parameters::MaxATrousIterations) && value == std::floor(value);
+	}
+
+	bool IsPositive(const float value)
+	{
+		return value > 0.0f && std::isfinite(value);
+	}
+
+	bool IsBlendFactor(const float value)
+	{
+		return value > 0.0f && value <= 1.0f;
+	}
+
+	const Field Fields[] =
+	{
+		{ "ATrousIterations", "an integer from 1 to 8", IsIterationCount, [](Parameters& p, float v) { p.ATrousIterations = static_cast<uint32_t>(v); }, [](const Parameters& p) { return static_cast<float>(p.ATrousIterations); } },
+		{ "PhiColor", "a positive number", IsPositive, [](Parameters& p, float v) { p.PhiColor = v; }, [](const Parameters& p) { return p.PhiColor; } },
+		{ "PhiNormal", "a positive number", IsPositive, [](Parameters& p, float v) { p.PhiNormal = v; }, [](const Parameters& p) { return p.PhiNormal; } },
+		{ "PhiDepth", "a positive number", IsPositive, [](Parameters& p, float v) { p.PhiDepth = v; }, [](const Parameters& p) { return p.PhiDepth; } },
+		{ "ColorAlpha", "a number in (0, 1]", IsBlendFactor, [](Parameters& p, float v) { p.ColorAlpha = v; }, [](const Parameters& p) { return p.ColorAlpha; } },
+		{ "MomentsAlpha", "a number in (0, 1]", IsBlendFactor, [](Parameters& p, float v) { p.MomentsAlpha = v; }, [](const Parameters& p) { return p.MomentsAlpha; } },
+	};
+
+	static_assert(Parameters::MaxATrousIterations == 8, "update the expected ATrousIterations values");
+
+	const Field& FindField(const std::string& name, const std::string& filename)
+	{
+		for (const auto& field : Fields)
+		{
+			if (name == field.Name)
+			{
+				return field;
+			}
+		}
+
+		Throw(std::runtime_error("unknown denoiser parameter '" + name + "' in '" + filename + "'"));
+	}
+
+	std::string Trim(const std::string& text)
+	{
+		const auto first = text.find_first_not_of(" \t\r");
+		const auto last = text.find_last_not_of(" \t\r");
+
+		return first == std::string::npos ? std::string() : text.substr(first, last - first + 1);
+	}
+
+	// Parses the lines into the values of each name, in file order.
+	std::vector<std::pair<const Field*, std::vector<float>>> Parse(const std::string& filename)
+	{
+		std::ifstream file(filename);
+
+		if (!file)
+		{
+			Throw(std::runtime_error("cannot open denoiser config '" + filename + "'"));
+		}
+
+		std::vector<std::pair<const Field*, std::vector<float>>> entries;
+		std::string line;
+
+		while (std::getline(file, line))
+		{
+			line = Trim(line.substr(0, line.find('#')));
+
+			if (line.empty())
+			{
+				continue;
+			}
+
+			const auto separator = line.find('=');
+
+			if (separator == std::string::npos)
+			{
+				Throw(std::runtime_error("invalid line '" + line + "' in '" + filename + "'"));
+			}
+
+			const Field& field = FindField(Trim(line.substr(0, separator)), filename);
+			std::istringstream values(line.substr(separator + 1));
+			std::vector<float> parsed;
+			std::string value;
+
+			while (std::getline(values, value, ','))
+			{
+				try
+				{
+					parsed.push_back(std::stof(Trim(value)));
+				}
+				catch (const std::exception&)
+				{
+					Throw(std::runtime_error("invalid value for '" + std::string(field.Name) + "' in '" + filename + "'"));
+				}
+
+				if (!field.IsValid(parsed.back()))
+				{
+					Throw(std::out_of_range("invalid value '" + Trim(value) + "' for '" + field.Name + "' in '" + filename + "', expected " + field.Expected));
+				}
+			}
+
+			if (parsed.empty())
+			{
+				Throw(std::runtime_error("missing value for '" + std::string(field.Name) + "' in '" + filename + "'"));
+			}
+
+			entries.emplace_back(&field, std::move(parsed));
+		}
+
+		return entries;
+	}
+}
+
+void Load(const std::string& filename, Parameters& parameters)
+{
+	for (const auto& entry : Parse(filename))
+	{
+		if (entry.second.size() != 1)
+		{
+			Throw(std::runtime_error("'" + std::string(entry.first->Name) + "' takes a single value in '" + filename + "'"));
+		}
+
+		entry.first->Set(parameters, entry.second.front());
+	}
+}
+
+void Save(const std::string& filename, const Parameters& parameters, const std::string& comment)
+{
+	std::ofstream file(filename);
+
+	if (!comment.empty())
+	{
+		file << "# " << comment << '\n';
+	}
+
+	for (const auto& field : Fields)
+	{
+		file << field.Name << " = " << field.Get(parameters) << '\n';
+	}
+
+	if (!file)
+	{
+		Throw(std::runtime_error("cannot write denoiser config '" + filename + "'"));
+	}
+}
+
+std::vector<Parameters> LoadGrid(const std::string& filename, const Parameters& base)
+{
+	std::vector<Parameters> grid = { base };
+
+	for (const auto& entry : Parse(filename))
+	{
+		std::vector<Parameters> expanded;
+		expanded.reserve(grid.size() * entry.second.size());
+
+		for (const auto& parameters : grid)
+		{
+			for (const float value : entry.second)
+			{
+				expanded.push_back(parameters);
+				entry.first->Set(expanded.back(), value);
+			}
+		}
+
+		grid = std::move(expanded);
+	}
+
+	return grid;
+}
+
+}
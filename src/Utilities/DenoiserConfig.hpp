@@ -0,0 +1,24 @@
+#pragma once
+
+#include "DenoiserParameters.hpp"
+#include <string>
+#include <vector>
+
+namespace Utilities
+{
+	// Denoiser filter parameters stored as "Name = value" lines, '#' starts a comment. Only the filter weights and
+	// the iteration count are stored, the feature switches stay with the command line. Written by the denoiser
+	// tuner and loaded by the application with --denoiser-config.
+	namespace DenoiserConfig
+	{
+		// Overrides the parameters found in the file, the others keep their value. Values outside the valid range of
+		// their parameter (iteration counts that are not integers, non-positive weights, blend factors outside (0, 1])
+		// are rejected.
+		void Load(const std::string& filename, DenoiserParameters& parameters);
+		void Save(const std::string& filename, const DenoiserParameters& parameters, const std::string& comment);
+
+		// Parameter grid in the same format, each name followed by a comma separated list of values. The grid spans
+		// all the combinations, names missing from the file keep the value of the base parameters.
+		std::vector<DenoiserParameters> LoadGrid(const std::string& filename, const DenoiserParameters& base);
+	}
+}
@@ -0,0 +1,131 @@
+#include "DenoiserFrame.hpp"
+#include "Exception.hpp"
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+
+namespace Utilities {
+
+namespace
+{
+	const char Magic[4] = { 'S', 'V', 'G', 'F' };
+	const uint32_t Version = 1;
+
+	// Largest width or height of a frame, the largest image dimension the Vulkan implementations support.
+	const uint32_t MaxExtent = 16384;
+
+	// RGBA diffuse, specular, albedo and normal/motion, then depth and instance id.
+	const size_t BytesPerPixel = 4 * 4 * sizeof(float) + sizeof(float) + sizeof(uint32_t);
+
+	template <class T>
+	void Read(std::ifstream& file, std::vector<T>& values)
+	{
+		file.read(reinterpret_cast<char*>(values.data()), static_cast<std::streamsize>(values.size() * sizeof(T)));
+	}
+
+	template <class T>
+	void Write(std::ofstream& file, const std::vector<T>& values)
+	{
+		file.write(reinterpret_cast<const char*>(values.data()), static_cast<std::streamsize>(values.size() * sizeof(T)));
+	}
+}
+
+void DenoiserFrame::Resize(const uint32_t width, const uint32_t height)
+{
+	const size_t pixelCount = static_cast<size_t>(width) * height;
+
+	Width = width;
+	Height = height;
+	Diffuse.resize(4 * pixelCount);
+	Specular.resize(4 * pixelCount);
+	Albedo.resize(4 * pixelCount);
+	Depth.resize(pixelCount);
+	NormalMotion.resize(4 * pixelCount);
+	InstanceId.resize(pixelCount);
+}
+
+ReferenceDenoiser::Frame DenoiserFrame::View() const
+{
+	return { Diffuse.data(), Specular.data(), Albedo.data(), Depth.data(), NormalMotion.data(), InstanceId.data() };
+}
+
+DenoiserFrame DenoiserFrame::Load(const std::string& filename)
+{
+	std::ifstream file(filename, std::ios::binary);
+
+	if (!file)
+	{
+		Throw(std::runtime_error("cannot open denoiser frame '" + filename + "'"));
+	}
+
+	file.seekg(0, std::ios::end);
+	const auto fileSize = static_cast<uint64_t>(file.tellg());
+	file.seekg(0, std::ios::beg);
+
+	char magic[4] = {};
+	uint32_t header[3] = {};
+
+	file.read(magic, sizeof(magic));
+	file.read(reinterpret_cast<char*>(header), sizeof(header));
+
+	if (!file || !std::equal(std::begin(magic), std::end(magic), std::begin(Magic)) || header[0] != Version)
+	{
+		Throw(std::runtime_error("'" + filename + "' is not a denoiser frame"));
+	}
+
+	const uint32_t width = header[1];
+	const uint32_t height = header[2];
+
+	if (width == 0 || height == 0 || width > MaxExtent || height > MaxExtent)
+	{
+		Throw(std::runtime_error("denoiser frame '" + filename + "' has an invalid size of " + std::to_string(width) + "x" + std::to_string(height)));
+	}
+
+	// Check the size before allocating the planes, so that a corrupt header cannot ask for gigabytes.
+	const uint64_t expectedSize = sizeof(Magic) + sizeof(header) + static_cast<uint64_t>(width) * height * BytesPerPixel;
+
+	if (fileSize != expectedSize)
+	{
+		Throw(std::runtime_error("denoiser frame '" + filename + "' is " + std::to_string(fileSize) + " bytes, expected " + std::to_string(expectedSize)));
+	}
+
+	DenoiserFrame frame;
+	frame.Resize(width, height);
+
+	Read(file, frame.Diffuse);
+	Read(file, frame.Specular);
+	Read(file, frame.Albedo);
+	Read(file, frame.Depth);
+	Read(file, frame.NormalMotion);
+	Read(file, frame.InstanceId);
+
+	if (!file)
+	{
+		Throw(std::runtime_error("denoiser frame '" + filename + "' is truncated"));
+	}
+
+	return frame;
+}
+
+void DenoiserFrame::Save(const std::string& filename) const
+{
+	std::ofstream file(filename, std::ios::binary);
+	const uint32_t header[3] = { Version, Width, Height };
+
+	file.write(Magic, sizeof(Magic));
+	file.write(reinterpret_cast<const char*>(header), sizeof(header));
+
+	Write(file, Diffuse);
+	Write(file, Specular);
+	Write(file, Albedo);
+	Write(file, Depth);
+	Write(file, NormalMotion);
+	Write(file, InstanceId);
+
+	if (!file)
+	{
+		Throw(std::runtime_error("cannot write denoiser frame '" + filename + "'"));
+	}
+}
+
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "ReferenceDenoiser.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Utilities
+{
+	// Denoiser inputs of one frame read back from the GPU, in the layout of ReferenceDenoiser::Frame, so that
+	// the filter can be run and tuned offline. A converged frame (accumulated up to the sample limit) has the
+	// same inputs, its bypassed composite serves as the reference of the noisy frames of the same view.
+	// Stored in a small binary file: a header (magic, version, width, height) followed by the planes in order.
+	struct DenoiserFrame final
+	{
+		uint32_t Width{};
+		uint32_t Height{};
+
+		std::vector<float> Diffuse;
+		std::vector<float> Specular;
+		std::vector<float> Albedo;
+		std::vector<float> Depth;
+		std::vector<float> NormalMotion;
+		std::vector<uint32_t> InstanceId;
+
+		// Allocates the planes for the given size.
+		void Resize(uint32_t width, uint32_t height);
+
+		ReferenceDenoiser::Frame View() const;
+
+		static DenoiserFrame Load(const std::string& filename);
+		void Save(const std::string& filename) const;
+	};
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+
+namespace Utilities
+{
+	// Filter parameters of Vulkan::RayTracing::Denoiser, kept free of Vulkan so that the CPU reference denoiser,
+	// the tuner and the config files build without it.
+	struct DenoiserParameters
+	{
+		// Iterations above this are clamped, the tile lists are sized for it.
+		static constexpr uint32_t MaxATrousIterations = 8;
+
+		bool Enabled;
+		uint32_t ATrousIterations;
+		float PhiColor;
+		float PhiNormal;
+		float PhiDepth;
+		float ColorAlpha;
+		float MomentsAlpha;
+		bool AdaptiveSampling;
+		bool TemporalGradient; // Shortens the history where the gradients traced by the ray generation shader show a lighting change.
+		bool EstimateError;
+		uint32_t SampleBudget; // Average paths per pixel spread by the sample count map.
+		float ATrousTileThreshold; // Relative standard deviation under which a tile stops iterating, zero to filter all the tiles.
+	};
+}
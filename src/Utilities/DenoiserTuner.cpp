@@ -0,0 +1,262 @@
+#include "DenoiserTuner.hpp"
+#include "DenoiserConfig.hpp"
+#include "Exception.hpp"
+#include "ImageMetrics.hpp"
+#include "ReferenceDenoiser.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+namespace Utilities {
+
+namespace
+{
+	bool FileExists(const std::string& filename)
+	{
+		return std::ifstream(filename).good();
+	}
+
+	std::string FrameFilename(const std::string& directory, const uint32_t index)
+	{
+		char name[32];
+		std::snprintf(name, sizeof(name), "frame-%04u.svgf", index);
+
+		return directory + "/" + name;
+	}
+
+	void Clamp(std::vector<float>& image)
+	{
+		for (auto& value : image)
+		{
+			value = std::clamp(value, 0.0f, 1.0f);
+		}
+	}
+
+	std::string Describe(const DenoiserTuner::Parameters& parameters)
+	{
+		std::ostringstream out;
+		out << "iterations " << parameters.ATrousIterations
+			<< ", phi color " << parameters.PhiColor
+			<< ", phi normal " << parameters.PhiNormal
+			<< ", phi depth " << parameters.PhiDepth
+			<< ", color alpha " << parameters.ColorAlpha
+			<< ", moments alpha " << parameters.MomentsAlpha;
+
+		return out.str();
+	}
+}
+
+DenoiserTuner::DenoiserTuner(const std::vector<std::string>& directories)
+{
+	for (const auto& directory : directories)
+	{
+		Sequence sequence;
+		sequence.Directory = directory;
+
+		for (uint32_t i = 0; FileExists(FrameFilename(directory, i)); ++i)
+		{
+			sequence.Frames.push_back(DenoiserFrame::Load(FrameFilename(directory, i)));
+		}
+
+		if (sequence.Frames.empty())
+		{
+			Throw(std::runtime_error("no denoiser frames in '" + directory + "'"));
+		}
+
+		const auto reference = DenoiserFrame::Load(directory + "/reference.svgf");
+
+		for (const auto& frame : sequence.Frames)
+		{
+			if (frame.Width != reference.Width || frame.Height != reference.Height)
+			{
+				Throw(std::runtime_error("denoiser frame sizes differ in '" + directory + "'"));
+			}
+		}
+
+		// The converged frame only goes through the composite, which remodulates the albedo like the filtered frames.
+		Parameters bypass = {};
+		bypass.ATrousIterations = 1;
+
+		ReferenceDenoiser denoiser(reference.Width, reference.Height);
+		sequence.Reference.resize(4 * static_cast<size_t>(reference.Width) * reference.Height);
+		denoiser.Denoise(reference.View(), bypass, sequence.Reference.data());
+		Clamp(sequence.Reference);
+
+		std::cout << "Denoiser Tuner: '" << directory << "', " << sequence.Frames.size() << " frames of "
+			<< reference.Width << "x" << reference.Height << std::endl;
+
+		sequences_.push_back(std::move(sequence));
+	}
+}
+
+std::vector<DenoiserTuner::Parameters> DenoiserTuner::DefaultGrid(const Parameters& base)
+{
+	std::vector<Parameters> grid;
+
+	for (const uint32_t iterations : { 3u, 4u, 5u })
+	{
+		for (const float phiColor : { 2.0f, 4.0f, 8.0f, 16.0f })
+		{
+			for (const float phiNormal : { 64.0f, 128.0f })
+			{
+				for (const float phiDepth : { 0.5f, 1.0f, 2.0f })
+				{
+					for (const float colorAlpha : { 0.1f, 0.2f })
+					{
+						Parameters parameters = base;
+						parameters.ATrousIterations = iterations;
+						parameters.PhiColor = phiColor;
+						parameters.PhiNormal = phiNormal;
+						parameters.PhiDepth = phiDepth;
+						parameters.ColorAlpha = colorAlpha;
+
+						grid.push_back(parameters);
+					}
+				}
+			}
+		}
+	}
+
+	return grid;
+}
+
+std::vector<DenoiserTuner::Result> DenoiserTuner::Run(const std::vector<Parameters>& grid) const
+{
+	const ImageMetrics metrics;
+	std::vector<Result> results;
+
+	for (size_t i = 0; i != grid.size(); ++i)
+	{
+		Result result = {};
+		result.Filter = grid[i];
+		result.Filter.Enabled = true;
+
+		uint32_t frameCount = 0;
+		double milliseconds = 0;
+
+		for (const auto& sequence : sequences_)
+		{
+			const auto& first = sequence.Frames.front();
+			ReferenceDenoiser denoiser(first.Width, first.Height);
+			std::vector<float> output(sequence.Reference.size());
+
+			for (const auto& frame : sequence.Frames)
+			{
+				const auto start = std::chrono::high_resolution_clock::now();
+				denoiser.Denoise(frame.View(), result.Filter, output.data());
+				const std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+
+				Clamp(output);
+
+				const auto scores = metrics.Compare(
+					{ output.data(), frame.Width, frame.Height, 4 },
+					{ sequence.Reference.data(), frame.Width, frame.Height, 4 });
+
+				result.Mse += scores.Mse;
+				result.Psnr += scores.Psnr;
+				result.Ssim += scores.Ssim;
+				result.Flip += scores.Flip;
+				milliseconds += elapsed.count();
+				frameCount++;
+			}
+		}
+
+		result.Mse /= frameCount;
+		result.Psnr /= frameCount;
+		result.Ssim /= frameCount;
+		result.Flip /= frameCount;
+		result.Milliseconds = milliseconds / frameCount;
+
+		std::cout << "Denoiser Tuner: [" << i + 1 << "/" << grid.size() << "] " << Describe(result.Filter) << ": "
+			<< result.Psnr << " dB, SSIM " << result.Ssim << ", FLIP " << result.Flip << ", " << result.Milliseconds << " ms" << std::endl;
+
+		results.push_back(result);
+	}
+
+	return results;
+}
+
+void DenoiserTuner::WriteReport(const std::string& directory, std::vector<Result>& results)
+{
+	if (results.empty())
+	{
+		Throw(std::runtime_error("empty denoiser parameter grid"));
+	}
+
+	std::vector<Result*> sorted;
+
+	for (auto& result : results)
+	{
+		sorted.push_back(&result);
+	}
+
+	std::sort(sorted.begin(), sorted.end(), [](const Result* a, const Result* b)
+	{
+		return a->Milliseconds != b->Milliseconds ? a->Milliseconds < b->Milliseconds : a->Psnr > b->Psnr;
+	});
+
+	// Walking from the fastest, a result is on the front when it beats the PSNR of all the faster ones.
+	std::vector<const Result*> front;
+	double bestPsnr = -1;
+
+	for (auto* result : sorted)
+	{
+		result->Pareto = result->Psnr > bestPsnr;
+
+		if (result->Pareto)
+		{
+			front.push_back(result);
+			bestPsnr = result->Psnr;
+		}
+	}
+
+	const auto recommended = *std::find_if(front.begin(), front.end(), [bestPsnr](const Result* result)
+	{
+		return result->Psnr >= bestPsnr - PsnrTolerance;
+	});
+
+	std::ofstream csv(directory + "/denoiser-tuning.csv");
+	csv << "ATrousIterations,PhiColor,PhiNormal,PhiDepth,ColorAlpha,MomentsAlpha,MSE,PSNR,SSIM,FLIP,Milliseconds,Pareto\n";
+
+	for (const auto& result : results)
+	{
+		const auto& p = result.Filter;
+		csv << p.ATrousIterations << ',' << p.PhiColor << ',' << p.PhiNormal << ',' << p.PhiDepth << ','
+			<< p.ColorAlpha << ',' << p.MomentsAlpha << ',' << result.Mse << ',' << result.Psnr << ','
+			<< result.Ssim << ',' << result.Flip << ',' << result.Milliseconds << ',' << (result.Pareto ? 1 : 0) << '\n';
+	}
+
+	std::ostringstream report;
+	report << "Pareto front of " << results.size() << " denoiser parameter sets, from the fastest:\n";
+
+	for (const auto* result : front)
+	{
+		report << (result == recommended ? "* " : "  ")
+			<< std::fixed << std::setprecision(3) << std::setw(9) << result->Milliseconds << " ms, "
+			<< std::setprecision(2) << std::setw(6) << result->Psnr << " dB, SSIM "
+			<< std::setprecision(4) << result->Ssim << ", FLIP " << result->Flip << std::defaultfloat << ": " << Describe(result->Filter) << '\n';
+	}
+
+	report << "* recommended: the fastest within " << PsnrTolerance << " dB of the best PSNR\n";
+
+	std::ofstream pareto(directory + "/denoiser-pareto.txt");
+	pareto << report.str();
+
+	if (!csv || !pareto)
+	{
+		Throw(std::runtime_error("cannot write the denoiser tuning report to '" + directory + "'"));
+	}
+
+	std::ostringstream comment;
+	comment << "Recommended by the denoiser tuner: " << recommended->Psnr << " dB, SSIM " << recommended->Ssim << ", " << recommended->Milliseconds << " ms per frame on the CPU";
+
+	DenoiserConfig::Save(directory + "/denoiser.cfg", recommended->Filter, comment.str());
+
+	std::cout << std::endl << report.str() << "Denoiser Tuner: wrote '" << directory << "/denoiser.cfg'" << std::endl;
+}
+
+}
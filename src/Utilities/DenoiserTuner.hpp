@@ -0,0 +1,65 @@
+#pragma once
+
+#include "DenoiserFrame.hpp"
+#include "DenoiserParameters.hpp"
+#include <string>
+#include <vector>
+
+namespace Utilities
+{
+	// Sweeps a grid of denoiser parameters over sequences of dumped frames, filtering them with the CPU reference
+	// denoiser so that it runs without a GPU. Each sequence is a directory of noisy frames (frame-0000.svgf,
+	// frame-0001.svgf, ...) of a static view and its converged reference (reference.svgf), as written by
+	// --dump-denoiser-frames. Every filtered frame is compared to the reference composite (MSE, PSNR, SSIM and
+	// FLIP of the [0, 1] clamped output, see ImageMetrics) and the filter is timed per frame.
+	class DenoiserTuner final
+	{
+	public:
+
+		using Parameters = DenoiserParameters;
+
+		// Error and time of one parameter set, averaged over all the frames of all the sequences.
+		struct Result
+		{
+			Parameters Filter;
+			double Mse;
+			double Psnr;
+			double Ssim;
+			double Flip;
+			double Milliseconds;
+			bool Pareto; // Not both slower and of a lower PSNR than another result.
+		};
+
+		DenoiserTuner(const DenoiserTuner&) = delete;
+		DenoiserTuner(DenoiserTuner&&) = delete;
+		DenoiserTuner& operator = (const DenoiserTuner&) = delete;
+		DenoiserTuner& operator = (DenoiserTuner&&) = delete;
+
+		explicit DenoiserTuner(const std::vector<std::string>& directories);
+		~DenoiserTuner() = default;
+
+		// The grid swept without a grid file, around the given parameters.
+		static std::vector<Parameters> DefaultGrid(const Parameters& base);
+
+		// Filters all the sequences with each parameter set, printing the progress.
+		std::vector<Result> Run(const std::vector<Parameters>& grid) const;
+
+		// Marks the Pareto front of the time and PSNR trade-off, writes all the results (denoiser-tuning.csv), the
+		// front (denoiser-pareto.txt) and the recommended config (denoiser.cfg) to the directory and prints the front.
+		// The recommendation is the fastest parameter set of the front within PsnrTolerance of the best PSNR.
+		static void WriteReport(const std::string& directory, std::vector<Result>& results);
+
+		static constexpr double PsnrTolerance = 0.1;
+
+	private:
+
+		struct Sequence
+		{
+			std::string Directory;
+			std::vector<DenoiserFrame> Frames;
+			std::vector<float> Reference; // Unfiltered composite of the converged frame, clamped.
+		};
+
+		std::vector<Sequence> sequences_;
+	};
+}
@@ -0,0 +1,610 @@
+#include "ImageMetrics.hpp"
+#include "Exception.hpp"
+#include "ImageMetricsKernels.hpp"
+#include "StbImage.hpp"
+#include <tinyexr.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <numeric>
+#include <thread>
+
+namespace Utilities {
+
+namespace
+{
+	using Image = ImageMetrics::Image;
+	using namespace MetricsVectors;
+
+	// Rows handed to a worker thread at a time, the filters recompute a halo of rows around each band.
+	const uint32_t BandRows = 64;
+
+	// PSNR of identical images.
+	const double MaxPsnr = 100.0;
+
+	// SSIM window and stabilizing constants for a dynamic range of one.
+	const float SsimSigma = 1.5f;
+	const float SsimC1 = 0.01f * 0.01f;
+	const float SsimC2 = 0.03f * 0.03f;
+
+	// Standard deviations in pixels of the Gaussians standing for the FLIP contrast sensitivity filters of the achromatic,
+	// red-green and blue-yellow channels and of its feature detectors, at 67 pixels per degree.
+	const float AchromaticSigma = 1.03f;
+	const float RedGreenSigma = 1.10f;
+	const float BlueYellowSigma = 2.81f;
+	const float FeatureSigma = 2.75f;
+
+	// Separable filter taps, from -Radius to +Radius.
+	struct Kernel
+	{
+		int Radius;
+		std::vector<float> Weights;
+	};
+
+	// Gaussian (order 0) or its first or second derivative. The Gaussian sums to one, the positive and negative
+	// weights of the derivatives sum to one and minus one, as the FLIP feature detectors are normalized.
+	Kernel MakeKernel(const float sigma, const int order)
+	{
+		Kernel kernel;
+		kernel.Radius = static_cast<int>(std::ceil(3.0f * sigma));
+
+		float positive = 0;
+		float negative = 0;
+
+		for (int x = -kernel.Radius; x <= kernel.Radius; ++x)
+		{
+			const float t = x / sigma;
+			const float gaussian = std::exp(-0.5f * t * t);
+			const float weight = order == 0 ? gaussian : order == 1 ? -t * gaussian : (t * t - 1.0f) * gaussian;
+
+			kernel.Weights.push_back(weight);
+			(weight > 0 ? positive : negative) += weight;
+		}
+
+		for (auto& weight : kernel.Weights)
+		{
+			weight = weight > 0 ? weight / positive : negative < 0 ? weight / -negative : 0.0f;
+		}
+
+		return kernel;
+	}
+
+	template <size_t N>
+	std::array<const float*, N> KernelWeights(const std::array<const Kernel*, N>& kernels)
+	{
+		std::array<const float*, N> weights;
+
+		for (size_t n = 0; n != N; ++n)
+		{
+			weights[n] = kernels[n]->Weights.data();
+		}
+
+		return weights;
+	}
+
+	// Horizontal convolution of a row with N kernels of the same radius, clamped to the image edges.
+	// The kernels share the loads of the taps.
+	template <size_t N>
+	void ConvolveRow(const ImageMetricsKernels* vectors, const float* in, const std::array<float*, N>& out, const std::array<const Kernel*, N>& kernels, const int width)
+	{
+		const int radius = kernels[0]->Radius;
+
+		const auto filterPixel = [&](const int x)
+		{
+			std::array<float, N> sums{};
+
+			for (int k = -radius; k <= radius; ++k)
+			{
+				const float tap = in[std::clamp(x + k, 0, width - 1)];
+
+				for (size_t n = 0; n != N; ++n)
+				{
+					sums[n] += kernels[n]->Weights[k + radius] * tap;
+				}
+			}
+
+			for (size_t n = 0; n != N; ++n)
+			{
+				out[n][x] = sums[n];
+			}
+		};
+
+		int x = 0;
+
+		if (vectors != nullptr)
+		{
+			// Lanes whose taps all fall inside the row are filtered together, the borders by the scalar path.
+			const int first = std::min(radius, width);
+
+			for (; x < first; ++x)
+			{
+				filterPixel(x);
+			}
+
+			x = vectors->ConvolveRow[N - 1](in, out.data(), KernelWeights(kernels).data(), radius, x, width - radius);
+		}
+
+		for (; x < width; ++x)
+		{
+			filterPixel(x);
+		}
+	}
+
+	// Vertical convolution into one row with N kernels of the same radius, the taps are the 2 * Radius + 1 rows
+	// stride floats apart starting at in.
+	template <size_t N>
+	void ConvolveColumn(const ImageMetricsKernels* vectors, const float* in, const size_t stride, const std::array<float*, N>& out, const std::array<const Kernel*, N>& kernels, const int width)
+	{
+		const int tapCount = 2 * kernels[0]->Radius + 1;
+		int x = vectors != nullptr ? vectors->ConvolveColumn[N - 1](in, stride, out.data(), KernelWeights(kernels).data(), tapCount, width) : 0;
+
+		for (; x < width; ++x)
+		{
+			std::array<float, N> sums{};
+
+			for (int t = 0; t != tapCount; ++t)
+			{
+				const float tap = in[t * stride + x];
+
+				for (size_t n = 0; n != N; ++n)
+				{
+					sums[n] += kernels[n]->Weights[t] * tap;
+				}
+			}
+
+			for (size_t n = 0; n != N; ++n)
+			{
+				out[n][x] = sums[n];
+			}
+		}
+	}
+
+	// Pixels of the image row, clamped so that the halo of a band repeats the edge rows.
+	const float* ImageRow(const Image& image, const int y)
+	{
+		const int row = std::clamp(y, 0, static_cast<int>(image.Height) - 1);
+		return image.Pixels + static_cast<size_t>(row) * image.Width * image.Channels;
+	}
+
+	float Luminance(const float* rgb)
+	{
+		return rgb[0] * 0.2126f + rgb[1] * 0.7152f + rgb[2] * 0.0722f;
+	}
+
+	float LinearToSrgb(const float value)
+	{
+		return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+	}
+
+	// Largest color difference, between green and blue, that the FLIP color error is normalized by.
+	float MaxColorDifference()
+	{
+		const float green[3] = { 0.0f, 1.0f, 0.0f };
+		const float blue[3] = { 0.0f, 0.0f, 1.0f };
+		float greenLab[3];
+		float blueLab[3];
+
+		LinearRgbToHuntLab(green, greenLab);
+		LinearRgbToHuntLab(blue, blueLab);
+
+		return std::pow(HyAB(greenLab, blueLab), ColorExponent);
+	}
+
+	const ImageMetricsKernels* SelectKernels(const Simd::InstructionSet instructionSet)
+	{
+		switch (instructionSet)
+		{
+		case Simd::InstructionSet::Avx2:
+			return ImageMetricsAvx2Kernels();
+#if defined(UTILITIES_SIMD_SSE2)
+		case Simd::InstructionSet::Sse2:
+		{
+			static constexpr ImageMetricsKernels sse2 = MakeKernels<__m128>();
+			return &sse2;
+		}
+#endif
+		default:
+			return nullptr;
+		}
+	}
+
+	void Validate(const Image& image, const Image& reference)
+	{
+		if (image.Width != reference.Width || image.Height != reference.Height)
+		{
+			Throw(std::invalid_argument("compared image sizes differ"));
+		}
+
+		for (const auto* current : { &image, &reference })
+		{
+			if (current->Channels != 3 && current->Channels != 4)
+			{
+				Throw(std::invalid_argument("compared images must have three or four channels"));
+			}
+		}
+	}
+}
+
+ImageMetrics::ImageMetrics(const uint32_t threadCount, const Simd::InstructionSet instructionSet) :
+	threadCount_(threadCount != 0 ? threadCount : std::max(std::thread::hardware_concurrency(), 1u)),
+	instructionSet_(Simd::Supported(instructionSet)),
+	vectors_(SelectKernels(instructionSet_))
+{
+}
+
+double ImageMetrics::MeanSquaredError(const Image& image, const Image& reference) const
+{
+	Validate(image, reference);
+
+	struct State {};
+
+	const double sum = SumBands<State>(image.Height, [&](State&, const uint32_t begin, const uint32_t end)
+	{
+		double bandSum = 0;
+
+		for (uint32_t y = begin; y != end; ++y)
+		{
+			const float* a = ImageRow(image, y);
+			const float* b = ImageRow(reference, y);
+			float rowSum = 0;
+
+			if (image.Channels == reference.Channels)
+			{
+				const int channels = static_cast<int>(image.Channels);
+				const int count = static_cast<int>(image.Width) * channels;
+				int i = vectors_ != nullptr ? vectors_->SquaredErrors(a, b, channels, count, rowSum) : 0;
+
+				for (; i < count; ++i)
+				{
+					const float difference = a[i] - b[i];
+					rowSum += i % channels == 3 ? 0.0f : difference * difference;
+				}
+			}
+			else
+			{
+				for (uint32_t x = 0; x != image.Width; ++x)
+				{
+					for (uint32_t c = 0; c != 3; ++c)
+					{
+						const float difference = a[x * image.Channels + c] - b[x * reference.Channels + c];
+						rowSum += difference * difference;
+					}
+				}
+			}
+
+			bandSum += rowSum;
+		}
+
+		return bandSum;
+	});
+
+	return sum / (3.0 * image.Width * image.Height);
+}
+
+double ImageMetrics::StructuralSimilarity(const Image& image, const Image& reference) const
+{
+	Validate(image, reference);
+
+	const int width = static_cast<int>(image.Width);
+	const Kernel kernel = MakeKernel(SsimSigma, 0);
+	const int halo = kernel.Radius;
+
+	// Horizontally filtered luminance, squares and product of the band and its halo, and one vertically filtered row of each.
+	struct State
+	{
+		std::array<std::vector<float>, 5> Moments;
+		std::array<std::vector<float>, 5> Rows;
+		std::array<std::vector<float>, 5> Filtered;
+	};
+
+	const double sum = SumBands<State>(image.Height, [&](State& state, const uint32_t begin, const uint32_t end)
+	{
+		const int rowCount = static_cast<int>(end - begin) + 2 * halo;
+
+		for (size_t i = 0; i != state.Moments.size(); ++i)
+		{
+			state.Moments[i].resize(static_cast<size_t>(BandRows + 2 * halo) * width);
+			state.Rows[i].resize(width);
+			state.Filtered[i].resize(width);
+		}
+
+		for (int row = 0; row != rowCount; ++row)
+		{
+			const float* a = ImageRow(image, static_cast<int>(begin) - halo + row);
+			const float* b = ImageRow(reference, static_cast<int>(begin) - halo + row);
+
+			for (int x = 0; x != width; ++x)
+			{
+				const float la = Luminance(a + x * image.Channels);
+				const float lb = Luminance(b + x * reference.Channels);
+
+				state.Rows[0][x] = la;
+				state.Rows[1][x] = lb;
+				state.Rows[2][x] = la * la;
+				state.Rows[3][x] = lb * lb;
+				state.Rows[4][x] = la * lb;
+			}
+
+			for (size_t i = 0; i != state.Moments.size(); ++i)
+			{
+				ConvolveRow<1>(vectors_, state.Rows[i].data(), { state.Moments[i].data() + static_cast<size_t>(row) * width }, { &kernel }, width);
+			}
+		}
+
+		double bandSum = 0;
+
+		for (uint32_t y = 0; y != end - begin; ++y)
+		{
+			for (size_t i = 0; i != state.Moments.size(); ++i)
+			{
+				ConvolveColumn<1>(vectors_, state.Moments[i].data() + static_cast<size_t>(y) * width, width, { state.Filtered[i].data() }, { &kernel }, width);
+			}
+
+			float rowSum = 0;
+
+			for (int x = 0; x != width; ++x)
+			{
+				const float ma = state.Filtered[0][x];
+				const float mb = state.Filtered[1][x];
+				const float va = state.Filtered[2][x] - ma * ma;
+				const float vb = state.Filtered[3][x] - mb * mb;
+				const float covariance = state.Filtered[4][x] - ma * mb;
+
+				rowSum += ((2.0f * ma * mb + SsimC1) * (2.0f * covariance + SsimC2)) / ((ma * ma + mb * mb + SsimC1) * (va + vb + SsimC2));
+			}
+
+			bandSum += rowSum;
+		}
+
+		return bandSum;
+	});
+
+	return sum / (static_cast<double>(image.Width) * image.Height);
+}
+
+double ImageMetrics::Flip(const Image& image, const Image& reference) const
+{
+	Validate(image, reference);
+
+	const int width = static_cast<int>(image.Width);
+	const std::array<Kernel, 3> colorKernels = { MakeKernel(AchromaticSigma, 0), MakeKernel(RedGreenSigma, 0), MakeKernel(BlueYellowSigma, 0) };
+	const std::array<Kernel, 3> featureKernels = { MakeKernel(FeatureSigma, 0), MakeKernel(FeatureSigma, 1), MakeKernel(FeatureSigma, 2) };
+	const int halo = std::max(colorKernels[2].Radius, featureKernels[0].Radius);
+	const float maxColorDifference = MaxColorDifference();
+
+	// Horizontally filtered YCxCz and luminance (with the Gaussian and its derivatives) of the band and its halo,
+	// and the vertically filtered rows (see FilteredRow).
+	struct Signals
+	{
+		std::array<std::vector<float>, 3> Colors;
+		std::array<std::vector<float>, 3> Features;
+		std::array<std::vector<float>, FilteredRowCount> Filtered;
+	};
+
+	struct State
+	{
+		std::array<Signals, 2> Images;
+		std::array<std::vector<float>, InputRowCount> Rows;
+	};
+
+	const auto filterBand = [&](const Image& source, Signals& signals, std::array<std::vector<float>, InputRowCount>& scratch, const uint32_t begin, const uint32_t end)
+	{
+		const int rowCount = static_cast<int>(end - begin) + 2 * halo;
+		const size_t planeSize = static_cast<size_t>(BandRows + 2 * halo) * width;
+
+		for (auto& plane : signals.Colors) plane.resize(planeSize);
+		for (auto& plane : signals.Features) plane.resize(planeSize);
+		for (auto& row : signals.Filtered) row.resize(width);
+		for (auto& row : scratch) row.resize(width);
+
+		const std::array<float*, InputRowCount> rows = { scratch[0].data(), scratch[1].data(), scratch[2].data(), scratch[3].data() };
+
+		for (int row = 0; row != rowCount; ++row)
+		{
+			const float* pixels = ImageRow(source, static_cast<int>(begin) - halo + row);
+			const size_t offset = static_cast<size_t>(row) * width;
+
+			// Deinterleave the channels, then convert whole vectors of pixels.
+			for (int x = 0; x != width; ++x)
+			{
+				for (int c = 0; c != 3; ++c)
+				{
+					rows[c][x] = pixels[x * source.Channels + c];
+				}
+			}
+
+			int x = vectors_ != nullptr ? vectors_->ConvertToYCxCz(rows.data(), width) : 0;
+
+			for (; x < width; ++x)
+			{
+				ConvertToYCxCz<float>(rows.data(), x);
+			}
+
+			for (size_t c = 0; c != 3; ++c)
+			{
+				ConvolveRow<1>(vectors_, rows[c], { signals.Colors[c].data() + offset }, { &colorKernels[c] }, width);
+			}
+
+			ConvolveRow<3>(vectors_, rows[InputLuminance],
+				{ signals.Features[0].data() + offset, signals.Features[1].data() + offset, signals.Features[2].data() + offset },
+				{ &featureKernels[0], &featureKernels[1], &featureKernels[2] }, width);
+		}
+	};
+
+	// Vertical filters of one output row, each kernel starts its taps at its own distance from the halo.
+	const auto filterRow = [&](Signals& signals, const uint32_t y)
+	{
+		const auto taps = [&](const std::vector<float>& plane, const Kernel& kernel)
+		{
+			return plane.data() + static_cast<size_t>(halo - kernel.Radius + static_cast<int>(y)) * width;
+		};
+
+		auto& filtered = signals.Filtered;
+
+		for (size_t c = 0; c != 3; ++c)
+		{
+			ConvolveColumn<1>(vectors_, taps(signals.Colors[c], colorKernels[c]), width, { filtered[c].data() }, { &colorKernels[c] }, width);
+		}
+
+		// The edges and points along x are the derivatives of the rows smoothed along y, and conversely.
+		ConvolveColumn<1>(vectors_, taps(signals.Features[1], featureKernels[0]), width, { filtered[EdgeX].data() }, { &featureKernels[0] }, width);
+		ConvolveColumn<1>(vectors_, taps(signals.Features[2], featureKernels[0]), width, { filtered[PointX].data() }, { &featureKernels[0] }, width);
+		ConvolveColumn<2>(vectors_, taps(signals.Features[0], featureKernels[1]), width,
+			{ filtered[EdgeY].data(), filtered[PointY].data() }, { &featureKernels[1], &featureKernels[2] }, width);
+	};
+
+	const double sum = SumBands<State>(image.Height, [&](State& state, const uint32_t begin, const uint32_t end)
+	{
+		filterBand(image, state.Images[0], state.Rows, begin, end);
+		filterBand(reference, state.Images[1], state.Rows, begin, end);
+
+		std::array<const float*, 2 * FilteredRowCount> rows;
+
+		for (size_t i = 0; i != 2; ++i)
+		{
+			for (size_t row = 0; row != FilteredRowCount; ++row)
+			{
+				rows[i * FilteredRowCount + row] = state.Images[i].Filtered[row].data();
+			}
+		}
+
+		double bandSum = 0;
+
+		for (uint32_t y = 0; y != end - begin; ++y)
+		{
+			filterRow(state.Images[0], y);
+			filterRow(state.Images[1], y);
+
+			float rowSum = 0;
+			int x = vectors_ != nullptr ? vectors_->FlipErrors(rows.data(), width, maxColorDifference, rowSum) : 0;
+
+			for (; x < width; ++x)
+			{
+				rowSum += FlipError<float>(rows.data(), x, maxColorDifference);
+			}
+
+			bandSum += rowSum;
+		}
+
+		return bandSum;
+	});
+
+	return sum / (static_cast<double>(image.Width) * image.Height);
+}
+
+ImageMetrics::Scores ImageMetrics::Compare(const Image& image, const Image& reference) const
+{
+	Scores scores = {};
+	scores.Mse = MeanSquaredError(image, reference);
+	scores.Psnr = PeakSignalToNoiseRatio(scores.Mse);
+	scores.Ssim = StructuralSimilarity(image, reference);
+	scores.Flip = Flip(image, reference);
+
+	return scores;
+}
+
+double ImageMetrics::PeakSignalToNoiseRatio(const double mse)
+{
+	return mse > 0 ? std::min(10.0 * std::log10(1.0 / mse), MaxPsnr) : MaxPsnr;
+}
+
+std::vector<float> ImageMetrics::ReadImage(const std::string& filename, uint32_t& width, uint32_t& height)
+{
+	std::string extension = filename.substr(filename.find_last_of('.') + 1);
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](const unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+	std::vector<float> pixels;
+
+	if (extension == "exr")
+	{
+		float* rgba = nullptr;
+		int exrWidth = 0;
+		int exrHeight = 0;
+		const char* error = nullptr;
+
+		if (LoadEXR(&rgba, &exrWidth, &exrHeight, filename.c_str(), &error) != TINYEXR_SUCCESS)
+		{
+			const std::string message = error != nullptr ? error : "unknown error";
+			FreeEXRErrorMessage(error);
+
+			Throw(std::runtime_error("failed to load image '" + filename + "': " + message));
+		}
+
+		pixels.assign(rgba, rgba + 4 * static_cast<size_t>(exrWidth) * exrHeight);
+		std::free(rgba);
+
+		for (size_t i = 0; i != pixels.size(); ++i)
+		{
+			pixels[i] = i % 4 == 3 ? pixels[i] : LinearToSrgb(std::clamp(pixels[i], 0.0f, 1.0f));
+		}
+
+		width = static_cast<uint32_t>(exrWidth);
+		height = static_cast<uint32_t>(exrHeight);
+		return pixels;
+	}
+
+	int imageWidth = 0;
+	int imageHeight = 0;
+	int channels = 0;
+	stbi_uc* const data = stbi_load(filename.c_str(), &imageWidth, &imageHeight, &channels, STBI_rgb_alpha);
+
+	if (data == nullptr)
+	{
+		Throw(std::runtime_error("failed to load image '" + filename + "': " + stbi_failure_reason()));
+	}
+
+	pixels.resize(4 * static_cast<size_t>(imageWidth) * imageHeight);
+
+	for (size_t i = 0; i != pixels.size(); ++i)
+	{
+		pixels[i] = data[i] / 255.0f;
+	}
+
+	stbi_image_free(data);
+
+	width = static_cast<uint32_t>(imageWidth);
+	height = static_cast<uint32_t>(imageHeight);
+	return pixels;
+}
+
+template <class State, class Function>
+double ImageMetrics::SumBands(const uint32_t height, Function function) const
+{
+	const uint32_t bandCount = (height + BandRows - 1) / BandRows;
+	std::vector<double> sums(bandCount);
+	std::atomic<uint32_t> nextBand{};
+
+	const auto worker = [&]()
+	{
+		State state;
+
+		for (uint32_t band; (band = nextBand.fetch_add(1)) < bandCount;)
+		{
+			const uint32_t begin = band * BandRows;
+			sums[band] = function(state, begin, std::min(begin + BandRows, height));
+		}
+	};
+
+	// The calling thread takes its share of the bands.
+	std::vector<std::thread> threads;
+
+	for (uint32_t i = 1; i < std::min(threadCount_, bandCount); ++i)
+	{
+		threads.emplace_back(worker);
+	}
+
+	worker();
+
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+
+	// Summed in band order, so that the result does not depend on the scheduling.
+	return std::accumulate(sums.begin(), sums.end(), 0.0);
+}
+
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "Simd.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Utilities
+{
+	struct ImageMetricsKernels;
+
+	// Objective quality metrics of an image against a reference, to check that a performance change of the tracer or
+	// of the denoiser did not cost quality: mean squared error and PSNR of the color channels, SSIM of the luminance
+	// (11x11 Gaussian window, as Wang et al.) and a FLIP style perceptual error. The latter follows LDR-FLIP at 67 pixels
+	// per degree, with single Gaussians approximating its contrast sensitivity filters: the HyAB distance of the filtered
+	// colors in Hunt adjusted L*a*b*, raised to the power of one minus the difference of the edges and points.
+	// Values are display encoded, in [0, 1]. Bands of rows are spread over worker threads, the convolutions and the
+	// per pixel math use AVX2 or SSE2, picked at run time.
+	class ImageMetrics final
+	{
+	public:
+
+		// Rows of interleaved RGB or RGBA channels with no padding, the alpha channel is ignored.
+		struct Image
+		{
+			const float* Pixels;
+			uint32_t Width;
+			uint32_t Height;
+			uint32_t Channels;
+		};
+
+		struct Scores
+		{
+			double Mse;
+			double Psnr;
+			double Ssim;
+			double Flip;
+		};
+
+		ImageMetrics(const ImageMetrics&) = delete;
+		ImageMetrics(ImageMetrics&&) = delete;
+		ImageMetrics& operator = (const ImageMetrics&) = delete;
+		ImageMetrics& operator = (ImageMetrics&&) = delete;
+
+		// A thread count of zero uses all the hardware threads. The instruction set is lowered to the best one the CPU supports.
+		explicit ImageMetrics(uint32_t threadCount = 0, Simd::InstructionSet instructionSet = Simd::InstructionSet::Avx2);
+		~ImageMetrics() = default;
+
+		uint32_t ThreadCount() const { return threadCount_; }
+
+		// Instruction set used by the vectorized kernels.
+		Simd::InstructionSet InstructionSet() const { return instructionSet_; }
+
+		double MeanSquaredError(const Image& image, const Image& reference) const;
+		double StructuralSimilarity(const Image& image, const Image& reference) const;
+		double Flip(const Image& image, const Image& reference) const;
+		Scores Compare(const Image& image, const Image& reference) const;
+
+		// PSNR in decibels of the mean squared error of [0, 1] values, capped for identical images.
+		static double PeakSignalToNoiseRatio(double mse);
+
+		// Loads an OpenEXR file, or a PNG or another 8 bits format supported by stb_image, as display encoded RGBA floats.
+		// OpenEXR colors are linear, they are clamped and sRGB encoded.
+		static std::vector<float> ReadImage(const std::string& filename, uint32_t& width, uint32_t& height);
+
+	private:
+
+		// Sums the values the function returns for the bands of rows [begin, end). Each worker passes its own
+		// State to the function, to keep its scratch buffers from one band to the next.
+		template <class State, class Function>
+		double SumBands(uint32_t height, Function function) const;
+
+		const uint32_t threadCount_;
+		const Simd::InstructionSet instructionSet_;
+		const ImageMetricsKernels* const vectors_;
+	};
+}
@@ -0,0 +1,23 @@
+#include "ImageMetricsKernels.hpp"
+
+// Compiled with AVX2 code generation when DENOISER_CPU_AVX2 is set, see src/CMakeLists.txt.
+
+namespace Utilities {
+
+namespace
+{
+#if defined(UTILITIES_SIMD_AVX2)
+	constexpr ImageMetricsKernels Avx2Kernels = MetricsVectors::MakeKernels<__m256>();
+#endif
+}
+
+const ImageMetricsKernels* ImageMetricsAvx2Kernels()
+{
+#if defined(UTILITIES_SIMD_AVX2)
+	return &Avx2Kernels;
+#else
+	return nullptr;
+#endif
+}
+
+}
@@ -0,0 +1,437 @@
+#pragma once
+
+#include "Simd.hpp"
+#include <cstddef>
+
+namespace Utilities
+{
+	// Vectorized loops of ImageMetrics for one instruction set. Each one goes over whole vectors of pixels from its first
+	// pixel on, and returns the first pixel left to the scalar path.
+	struct ImageMetricsKernels
+	{
+		// Number of kernels a convolution can apply at once, the convolutions are indexed by that number minus one.
+		static const int MaxConvolutions = 3;
+
+		// Sum of the squared differences of the color channels of count interleaved floats with three or four channels.
+		int (*SquaredErrors)(const float* a, const float* b, int channels, int count, float& sum);
+
+		// Horizontal convolution of the pixels [x, last) of a row, whose taps all fall inside it. The weights of each kernel
+		// run from -radius to +radius.
+		int (*ConvolveRow[MaxConvolutions])(const float* in, float* const* out, const float* const* weights, int radius, int x, int last);
+
+		// Vertical convolution of a row, the taps are the tapCount rows stride floats apart starting at in.
+		int (*ConvolveColumn[MaxConvolutions])(const float* in, size_t stride, float* const* out, const float* const* weights, int tapCount, int width);
+
+		// Converts in place display encoded RGB rows to the YCxCz and luminance rows of the same pixels (see InputRow).
+		int (*ConvertToYCxCz)(float* const* rows, int width);
+
+		// Sum of the FLIP errors of the filtered rows of both images (see FilteredRow and FlipError()).
+		int (*FlipErrors)(const float* const* rows, int width, float maxColorDifference, float& sum);
+	};
+
+	// The AVX2 kernels (ImageMetricsAvx2.cpp), null when the compiler could not build them. Only use them after checking
+	// that the CPU supports AVX2, see Simd::Supported().
+	const ImageMetricsKernels* ImageMetricsAvx2Kernels();
+
+	namespace
+	{
+		// FLIP exponent of the color differences (the feature differences take a square root) and the color error
+		// remapping (cutoff and its target).
+		const float ColorExponent = 0.7f;
+		const float ColorCutoff = 0.4f;
+		const float ColorCutoffTarget = 0.95f;
+
+		// D65 white point.
+		const float WhiteX = 0.950428545f;
+		const float WhiteZ = 1.088900371f;
+
+		// The per pixel math is written once for scalars and for SIMD vectors, on top of the Simd wrappers.
+		namespace MetricsVectors
+		{
+			using namespace Simd;
+
+			// The per pixel math of FLIP is dominated by cube roots and powers, the approximations below are accurate
+			// to about 1e-6 relative, far below what the metric can resolve, and vectorize.
+
+			// Cube root of a positive value: exponent divided by three in the bits, then two Newton iterations.
+			template <class V>
+			V FastCbrt(const V x)
+			{
+				const V third = Set<V>(1.0f / 3.0f);
+				V y = AsFloat(AddInt(ToInt(Mul(ToFloat(AsInt(x)), third)), 0x2a5137a0));
+
+				y = Mul(Add(Add(y, y), Div(x, Mul(y, y))), third);
+				y = Mul(Add(Add(y, y), Div(x, Mul(y, y))), third);
+
+				return y;
+			}
+
+			// Base two logarithm of a positive normal value: exponent plus the atanh series of the mantissa.
+			template <class V>
+			V FastLog2(const V x)
+			{
+				const auto bits = AsInt(x);
+				const V exponent = Sub(ToFloat(ShiftRightExponent(bits)), Set<V>(127.0f));
+				const V mantissa = AsFloat(OrInt(AndInt(bits, 0x007fffff), 0x3f800000));
+
+				const V one = Set<V>(1.0f);
+				const V t = Div(Sub(mantissa, one), Add(mantissa, one));
+				const V t2 = Mul(t, t);
+
+				V series = Set<V>(2.0f / 9.0f);
+				series = Add(Mul(series, t2), Set<V>(2.0f / 7.0f));
+				series = Add(Mul(series, t2), Set<V>(2.0f / 5.0f));
+				series = Add(Mul(series, t2), Set<V>(2.0f / 3.0f));
+				series = Add(Mul(series, t2), Set<V>(2.0f));
+
+				return Add(exponent, Mul(Mul(series, t), Set<V>(1.44269504f)));
+			}
+
+			// Two to the power of the value: the rounded integer part in the exponent bits, the Taylor series of the rest.
+			template <class V>
+			V FastExp2(V x)
+			{
+				x = Min(Max(x, Set<V>(-126.0f)), Set<V>(126.0f));
+
+				// Truncating a positive value rounds it down, without a call to the rounding functions.
+				const auto integer = AddInt(ToInt(Add(x, Set<V>(126.5f))), -126);
+				const V f = Mul(Sub(x, ToFloat(integer)), Set<V>(0.693147181f));
+
+				V series = Set<V>(1.0f / 720.0f);
+				series = Add(Mul(series, f), Set<V>(1.0f / 120.0f));
+				series = Add(Mul(series, f), Set<V>(1.0f / 24.0f));
+				series = Add(Mul(series, f), Set<V>(1.0f / 6.0f));
+				series = Add(Mul(series, f), Set<V>(1.0f / 2.0f));
+				series = Add(Mul(series, f), Set<V>(1.0f));
+				series = Add(Mul(series, f), Set<V>(1.0f));
+
+				return Mul(series, AsFloat(ShiftLeftExponent(AddInt(integer, 127))));
+			}
+
+			template <class V>
+			V FastPow(const V x, const V y)
+			{
+				return Select(Greater(x, Set<V>(1e-30f)), FastExp2(Mul(y, FastLog2(Max(x, Set<V>(1e-30f))))), Set<V>(0.0f));
+			}
+
+			// The sRGB transfer function of the [0, 1] clamped value.
+			template <class V>
+			V SrgbToLinear(V value)
+			{
+				value = Min(Max(value, Set<V>(0.0f)), Set<V>(1.0f));
+
+				const V curve = FastPow(Mul(Add(value, Set<V>(0.055f)), Set<V>(1.0f / 1.055f)), Set<V>(2.4f));
+				return Select(Greater(value, Set<V>(0.04045f)), curve, Mul(value, Set<V>(1.0f / 12.92f)));
+			}
+
+			template <class V>
+			void LinearRgbToXyz(const V* rgb, V* xyz)
+			{
+				const auto dot = [&](const float r, const float g, const float b)
+				{
+					return Add(Add(Mul(rgb[0], Set<V>(r)), Mul(rgb[1], Set<V>(g))), Mul(rgb[2], Set<V>(b)));
+				};
+
+				xyz[0] = dot(0.4124564f, 0.3575761f, 0.1804375f);
+				xyz[1] = dot(0.2126729f, 0.7151522f, 0.0721750f);
+				xyz[2] = dot(0.0193339f, 0.1191920f, 0.9503041f);
+			}
+
+			template <class V>
+			void XyzToLinearRgb(const V* xyz, V* rgb)
+			{
+				const auto dot = [&](const float x, const float y, const float z)
+				{
+					return Add(Add(Mul(xyz[0], Set<V>(x)), Mul(xyz[1], Set<V>(y))), Mul(xyz[2], Set<V>(z)));
+				};
+
+				rgb[0] = dot(3.2404542f, -1.5371385f, -0.4985314f);
+				rgb[1] = dot(-0.9692660f, 1.8760108f, 0.0415560f);
+				rgb[2] = dot(0.0556434f, -0.2040259f, 1.0572252f);
+			}
+
+			// Opponent space in which FLIP applies its contrast sensitivity filters, a linearized L*a*b*.
+			template <class V>
+			void XyzToYCxCz(const V* xyz, V* ycxcz)
+			{
+				ycxcz[0] = Sub(Mul(xyz[1], Set<V>(116.0f)), Set<V>(16.0f));
+				ycxcz[1] = Mul(Sub(Mul(xyz[0], Set<V>(1.0f / WhiteX)), xyz[1]), Set<V>(500.0f));
+				ycxcz[2] = Mul(Sub(xyz[1], Mul(xyz[2], Set<V>(1.0f / WhiteZ))), Set<V>(200.0f));
+			}
+
+			template <class V>
+			void YCxCzToXyz(const V* ycxcz, V* xyz)
+			{
+				xyz[1] = Mul(Add(ycxcz[0], Set<V>(16.0f)), Set<V>(1.0f / 116.0f));
+				xyz[0] = Mul(Add(Mul(ycxcz[1], Set<V>(1.0f / 500.0f)), xyz[1]), Set<V>(WhiteX));
+				xyz[2] = Mul(Sub(xyz[1], Mul(ycxcz[2], Set<V>(1.0f / 200.0f))), Set<V>(WhiteZ));
+			}
+
+			template <class V>
+			V LabCurve(const V t)
+			{
+				const float delta = 6.0f / 29.0f;
+				const V linear = Add(Mul(t, Set<V>(1.0f / (3.0f * delta * delta))), Set<V>(4.0f / 29.0f));
+
+				return Select(Greater(t, Set<V>(delta * delta * delta)), FastCbrt(Max(t, Set<V>(delta * delta * delta))), linear);
+			}
+
+			// L*a*b* of a linear color clamped to [0, 1], with the chroma scaled by the lightness (Hunt effect).
+			template <class V>
+			void LinearRgbToHuntLab(const V* rgb, V* lab)
+			{
+				const V zero = Set<V>(0.0f);
+				const V one = Set<V>(1.0f);
+				const V clamped[3] = { Min(Max(rgb[0], zero), one), Min(Max(rgb[1], zero), one), Min(Max(rgb[2], zero), one) };
+
+				V xyz[3];
+				LinearRgbToXyz(clamped, xyz);
+
+				const V fx = LabCurve(Mul(xyz[0], Set<V>(1.0f / WhiteX)));
+				const V fy = LabCurve(xyz[1]);
+				const V fz = LabCurve(Mul(xyz[2], Set<V>(1.0f / WhiteZ)));
+
+				lab[0] = Sub(Mul(fy, Set<V>(116.0f)), Set<V>(16.0f));
+				lab[1] = Mul(Mul(lab[0], Sub(fx, fy)), Set<V>(0.01f * 500.0f));
+				lab[2] = Mul(Mul(lab[0], Sub(fy, fz)), Set<V>(0.01f * 200.0f));
+			}
+
+			template <class V>
+			V HyAB(const V* lab0, const V* lab1)
+			{
+				const V da = Sub(lab0[1], lab1[1]);
+				const V db = Sub(lab0[2], lab1[2]);
+
+				return Add(Abs(Sub(lab0[0], lab1[0])), Sqrt(Add(Mul(da, da), Mul(db, db))));
+			}
+
+			// Rows of one image converted for FLIP, before the horizontal filters.
+			enum InputRow { InputY, InputCx, InputCz, InputLuminance, InputRowCount };
+
+			// Rows of one image after both filters: YCxCz, then the edges and the points along x and y.
+			enum FilteredRow { FilteredY, FilteredCx, FilteredCz, EdgeX, EdgeY, PointX, PointY, FilteredRowCount };
+
+			// Converts in place display encoded RGB rows to the YCxCz and luminance rows of the same pixels.
+			template <class V>
+			void ConvertToYCxCz(float* const* rows, const int x)
+			{
+				V rgb[3];
+				V xyz[3];
+				V ycxcz[3];
+
+				for (int c = 0; c != 3; ++c)
+				{
+					rgb[c] = SrgbToLinear(Load<V>(rows[c] + x));
+				}
+
+				LinearRgbToXyz(rgb, xyz);
+				XyzToYCxCz(xyz, ycxcz);
+
+				Store(rows[InputY] + x, ycxcz[0]);
+				Store(rows[InputCx] + x, ycxcz[1]);
+				Store(rows[InputCz] + x, ycxcz[2]);
+				Store(rows[InputLuminance] + x, xyz[1]);
+			}
+
+			// FLIP error of the pixels from the filtered rows of both images, the rows of the second image follow the ones of the first.
+			template <class V>
+			V FlipError(const float* const* rows, const int x, const float maxColorDifference)
+			{
+				V labs[2][3];
+				V edges[2];
+				V points[2];
+
+				for (int i = 0; i != 2; ++i)
+				{
+					const V ycxcz[3] = { Load<V>(rows[i * FilteredRowCount + FilteredY] + x), Load<V>(rows[i * FilteredRowCount + FilteredCx] + x), Load<V>(rows[i * FilteredRowCount + FilteredCz] + x) };
+					V xyz[3];
+					V rgb[3];
+
+					YCxCzToXyz(ycxcz, xyz);
+					XyzToLinearRgb(xyz, rgb);
+					LinearRgbToHuntLab(rgb, labs[i]);
+
+					const V edgeX = Load<V>(rows[i * FilteredRowCount + EdgeX] + x);
+					const V edgeY = Load<V>(rows[i * FilteredRowCount + EdgeY] + x);
+					const V pointX = Load<V>(rows[i * FilteredRowCount + PointX] + x);
+					const V pointY = Load<V>(rows[i * FilteredRowCount + PointY] + x);
+
+					edges[i] = Sqrt(Add(Mul(edgeX, edgeX), Mul(edgeY, edgeY)));
+					points[i] = Sqrt(Add(Mul(pointX, pointX), Mul(pointY, pointY)));
+				}
+
+				// Color differences under the cutoff are compressed, the ones above it stretched to reach one at the maximum.
+				const float cutoff = ColorCutoff * maxColorDifference;
+				const V colorDifference = FastPow(HyAB(labs[0], labs[1]), Set<V>(ColorExponent));
+				const V compressed = Mul(colorDifference, Set<V>(ColorCutoffTarget / cutoff));
+				const V stretched = Add(Mul(Sub(colorDifference, Set<V>(cutoff)), Set<V>((1.0f - ColorCutoffTarget) / (maxColorDifference - cutoff))), Set<V>(ColorCutoffTarget));
+				const V colorError = Min(Select(Greater(colorDifference, Set<V>(cutoff)), stretched, compressed), Set<V>(1.0f));
+
+				const V featureDifference = Max(Abs(Sub(edges[0], edges[1])), Abs(Sub(points[0], points[1])));
+				const V featureError = Sqrt(Min(Mul(featureDifference, Set<V>(0.707106781f)), Set<V>(1.0f)));
+
+				return FastPow(colorError, Sub(Set<V>(1.0f), featureError));
+			}
+
+			template <class V>
+			int SquaredErrorVectors(const float* a, const float* b, const int channels, const int count, float& sum)
+			{
+				// Interleaved channels map to the lanes in a fixed pattern, the alpha lanes are masked out.
+				const int laneCount = static_cast<int>(sizeof(V) / sizeof(float));
+				float masks[sizeof(V) / sizeof(float)];
+				float sums[sizeof(V) / sizeof(float)];
+
+				for (int lane = 0; lane != laneCount; ++lane)
+				{
+					masks[lane] = lane % channels == 3 ? 0.0f : 1.0f;
+				}
+
+				const V mask = Load<V>(masks);
+				V vectorSum = Set<V>(0.0f);
+				int i = 0;
+
+				for (; channels == 4 && i + laneCount <= count; i += laneCount)
+				{
+					const V difference = Sub(Load<V>(a + i), Load<V>(b + i));
+					vectorSum = Add(vectorSum, Mul(Mul(difference, difference), mask));
+				}
+
+				for (; channels == 3 && i + laneCount <= count; i += laneCount)
+				{
+					const V difference = Sub(Load<V>(a + i), Load<V>(b + i));
+					vectorSum = Add(vectorSum, Mul(difference, difference));
+				}
+
+				Store(sums, vectorSum);
+				sum = 0.0f;
+
+				for (int lane = 0; lane != laneCount; ++lane)
+				{
+					sum += sums[lane];
+				}
+
+				return i;
+			}
+
+			// The kernels share the loads of the taps.
+			template <int N, class V>
+			int ConvolveRowVectors(const float* in, float* const* out, const float* const* weights, const int radius, int x, const int last)
+			{
+				const int laneCount = static_cast<int>(sizeof(V) / sizeof(float));
+
+				for (; x + laneCount <= last; x += laneCount)
+				{
+					V sums[N];
+
+					for (int n = 0; n != N; ++n)
+					{
+						sums[n] = Set<V>(0.0f);
+					}
+
+					for (int k = -radius; k <= radius; ++k)
+					{
+						const V tap = Load<V>(in + x + k);
+
+						for (int n = 0; n != N; ++n)
+						{
+							sums[n] = Add(sums[n], Mul(Set<V>(weights[n][k + radius]), tap));
+						}
+					}
+
+					for (int n = 0; n != N; ++n)
+					{
+						Store(out[n] + x, sums[n]);
+					}
+				}
+
+				return x;
+			}
+
+			template <int N, class V>
+			int ConvolveColumnVectors(const float* in, const size_t stride, float* const* out, const float* const* weights, const int tapCount, const int width)
+			{
+				const int laneCount = static_cast<int>(sizeof(V) / sizeof(float));
+				int x = 0;
+
+				for (; x + laneCount <= width; x += laneCount)
+				{
+					V sums[N];
+
+					for (int n = 0; n != N; ++n)
+					{
+						sums[n] = Set<V>(0.0f);
+					}
+
+					for (int t = 0; t != tapCount; ++t)
+					{
+						const V tap = Load<V>(in + t * stride + x);
+
+						for (int n = 0; n != N; ++n)
+						{
+							sums[n] = Add(sums[n], Mul(Set<V>(weights[n][t]), tap));
+						}
+					}
+
+					for (int n = 0; n != N; ++n)
+					{
+						Store(out[n] + x, sums[n]);
+					}
+				}
+
+				return x;
+			}
+
+			template <class V>
+			int ConvertToYCxCzVectors(float* const* rows, const int width)
+			{
+				const int laneCount = static_cast<int>(sizeof(V) / sizeof(float));
+				int x = 0;
+
+				for (; x + laneCount <= width; x += laneCount)
+				{
+					ConvertToYCxCz<V>(rows, x);
+				}
+
+				return x;
+			}
+
+			template <class V>
+			int FlipErrorVectors(const float* const* rows, const int width, const float maxColorDifference, float& sum)
+			{
+				const int laneCount = static_cast<int>(sizeof(V) / sizeof(float));
+				float sums[sizeof(V) / sizeof(float)];
+				V vectorSum = Set<V>(0.0f);
+				int x = 0;
+
+				for (; x + laneCount <= width; x += laneCount)
+				{
+					vectorSum = Add(vectorSum, FlipError<V>(rows, x, maxColorDifference));
+				}
+
+				Store(sums, vectorSum);
+				sum = 0.0f;
+
+				for (int lane = 0; lane != laneCount; ++lane)
+				{
+					sum += sums[lane];
+				}
+
+				return x;
+			}
+
+			// Constant so that the tables need no initialization code, which would run for AVX2 on any CPU.
+			template <class V>
+			constexpr ImageMetricsKernels MakeKernels()
+			{
+				return
+				{
+					&SquaredErrorVectors<V>,
+					{ &ConvolveRowVectors<1, V>, &ConvolveRowVectors<2, V>, &ConvolveRowVectors<3, V> },
+					{ &ConvolveColumnVectors<1, V>, &ConvolveColumnVectors<2, V>, &ConvolveColumnVectors<3, V> },
+					&ConvertToYCxCzVectors<V>,
+					&FlipErrorVectors<V>
+				};
+			}
+		}
+	}
+}
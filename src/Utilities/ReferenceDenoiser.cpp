@@ -0,0 +1,629 @@
+#include "ReferenceDenoiser.hpp"
+#include "ReferenceDenoiserKernels.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace Utilities {
+
+namespace
+{
+	using Parameters = DenoiserParameters;
+
+	// Plane indices of the guide images.
+	enum GuidePlane { NormalX, NormalY, NormalZ, Depth, DepthGradient };
+
+	// Rows handed to a worker thread at a time.
+	const uint32_t RowsPerTask = 8;
+
+	// Smallest total weight of the consistent history taps for the history to be used, as in Denoiser.Temporal.comp.
+	const float MinHistoryWeight = 0.01f;
+
+	float Luminance(const float r, const float g, const float b)
+	{
+		return r * 0.2126f + g * 0.7152f + b * 0.0722f;
+	}
+
+	float Mix(const float x, const float y, const float a)
+	{
+		return x * (1.0f - a) + y * a;
+	}
+
+	bool IsInside(const int x, const int y, const int width, const int height)
+	{
+		return x >= 0 && y >= 0 && x < width && y < height;
+	}
+
+	// Same as DecodeNormal() in Octahedral.glsl.
+	void DecodeNormal(const float ex, const float ey, float& nx, float& ny, float& nz)
+	{
+		nx = ex;
+		ny = ey;
+		nz = 1.0f - std::abs(ex) - std::abs(ey);
+
+		const float t = std::clamp(-nz, 0.0f, 1.0f);
+		nx += nx >= 0.0f ? -t : t;
+		ny += ny >= 0.0f ? -t : t;
+
+		const float length = std::sqrt(nx * nx + ny * ny + nz * nz);
+		nx /= length;
+		ny /= length;
+		nz /= length;
+	}
+
+	// Smallest absolute depth difference to the two neighbours along one axis, ignoring background neighbours.
+	float DepthDelta(const float center, const float previous, const float next)
+	{
+		const float deltaPrevious = previous > 0.0f ? std::abs(center - previous) : 1e30f;
+		const float deltaNext = next > 0.0f ? std::abs(next - center) : 1e30f;
+		const float delta = std::min(deltaPrevious, deltaNext);
+
+		return delta < 1e30f ? delta : 0.0f;
+	}
+
+	ATrousKernel SelectATrousKernel(const Simd::InstructionSet instructionSet)
+	{
+		switch (instructionSet)
+		{
+		case Simd::InstructionSet::Avx2:
+			return ReferenceDenoiserAvx2Kernel();
+#if defined(UTILITIES_SIMD_SSE2)
+		case Simd::InstructionSet::Sse2:
+			return &ATrousVectors::Filter<__m128>;
+#endif
+		default:
+			return nullptr;
+		}
+	}
+}
+
+ReferenceDenoiser::ReferenceDenoiser(const uint32_t width, const uint32_t height, const uint32_t threadCount, const Simd::InstructionSet instructionSet) :
+	width_(width),
+	height_(height),
+	instructionSet_(Simd::Supported(instructionSet)),
+	aTrousKernel_(SelectATrousKernel(instructionSet_)),
+	threadPool_(threadCount)
+{
+	for (size_t i = 0; i != 2; ++i)
+	{
+		Allocate(guides_[i]);
+		instances_[i].assign(static_cast<size_t>(width_) * height_, 0);
+	}
+
+	for (auto& signal : signals_)
+	{
+		for (size_t i = 0; i != 2; ++i)
+		{
+			Allocate(signal.ColorHistories[i]);
+			Allocate(signal.Moments[i]);
+			Allocate(signal.Filters[i]);
+		}
+
+		Allocate(signal.Illumination);
+	}
+}
+
+void ReferenceDenoiser::Denoise(const Frame& frame, const Parameters& parameters, float* const output)
+{
+	const auto& diffuse = signals_[0];
+	const auto& specular = signals_[1];
+
+	if (!parameters.Enabled)
+	{
+		// Without filtering the noisy signals are remodulated as is, and history is discarded on the next filtered frame.
+		ForEachRow([&](const uint32_t y) { Composite(frame, true, diffuse.Filters[0], specular.Filters[0], output, y); });
+
+		historyValid_ = false;
+		return;
+	}
+
+	const bool resetHistory = !historyValid_;
+	const uint32_t iterations = std::max(parameters.ATrousIterations, 1u);
+
+	// Every pass reads its neighbours in the output of the previous one, so passes are separated by a join.
+	// The geometry guide is shared, the diffuse and specular signals then go through the same passes.
+	ForEachRow([&](const uint32_t y) { Geometry(frame, y); });
+
+	for (size_t s = 0; s != signals_.size(); ++s)
+	{
+		auto& signal = signals_[s];
+		const float* const noisy = s == 0 ? frame.Diffuse : frame.Specular;
+
+		ForEachRow([&](const uint32_t y) { Temporal(frame, noisy, signal, parameters, resetHistory, y); });
+		ForEachRow([&](const uint32_t y) { Variance(parameters, signal, y); });
+
+		for (uint32_t i = 0; i != iterations; ++i)
+		{
+			// The output of the first iteration becomes the color history of the next frame.
+			const auto& source = signal.Filters[i % 2];
+			auto& target = signal.Filters[1 - i % 2];
+
+			ForEachRow([&](const uint32_t y) { ATrous(parameters, signal, 1 << i, i == 0, source, target, y); });
+		}
+	}
+
+	ForEachRow([&](const uint32_t y) { Composite(frame, false, diffuse.Filters[iterations % 2], specular.Filters[iterations % 2], output, y); });
+
+	historyValid_ = true;
+	frameIndex_++;
+}
+
+template <size_t N>
+void ReferenceDenoiser::Allocate(Planes<N>& planes) const
+{
+	// Start from zero like the cleared GPU images.
+	for (auto& plane : planes)
+	{
+		plane.assign(static_cast<size_t>(width_) * height_, 0.0f);
+	}
+}
+
+void ReferenceDenoiser::Geometry(const Frame& frame, const uint32_t y)
+{
+	const int width = static_cast<int>(width_);
+	const int height = static_cast<int>(height_);
+	const int row = static_cast<int>(y);
+	auto& guide = guides_[frameIndex_ % 2];
+
+	// The shader stages the depth with its apron clamped to the image.
+	const auto depthAt = [&](const int sampleX, const int sampleY)
+	{
+		return frame.Depth[std::clamp(sampleY, 0, height - 1) * width + std::clamp(sampleX, 0, width - 1)];
+	};
+
+	for (int x = 0; x != width; ++x)
+	{
+		const size_t i = static_cast<size_t>(row) * width + x;
+		const float depth = frame.Depth[i];
+
+		instances_[frameIndex_ % 2][i] = frame.InstanceId[i];
+
+		if (depth <= 0.0f)
+		{
+			// An empty guide, whose zero octahedral normal decodes to +Z.
+			guide[NormalX][i] = 0.0f;
+			guide[NormalY][i] = 0.0f;
+			guide[NormalZ][i] = 1.0f;
+			guide[Depth][i] = 0.0f;
+			guide[DepthGradient][i] = 0.0f;
+			continue;
+		}
+
+		const float dx = DepthDelta(depth, depthAt(x - 1, row), depthAt(x + 1, row));
+		const float dy = DepthDelta(depth, depthAt(x, row - 1), depthAt(x, row + 1));
+
+		DecodeNormal(frame.NormalMotion[4 * i + 0], frame.NormalMotion[4 * i + 1], guide[NormalX][i], guide[NormalY][i], guide[NormalZ][i]);
+		guide[Depth][i] = depth;
+		guide[DepthGradient][i] = std::max(dx, dy);
+	}
+}
+
+void ReferenceDenoiser::Temporal(const Frame& frame, const float* const noisy, Signal& signal, const Parameters& parameters, const bool resetHistory, const uint32_t y)
+{
+	const int width = static_cast<int>(width_);
+	const int height = static_cast<int>(height_);
+	const int row = static_cast<int>(y);
+	const uint32_t current = frameIndex_ % 2;
+	const uint32_t previous = 1 - current;
+
+	const auto& guide = guides_[current];
+	const auto& previousGuide = guides_[previous];
+	const auto& previousColor = signal.ColorHistories[previous];
+	const auto& previousMoments = signal.Moments[previous];
+	const auto& previousInstances = instances_[previous];
+	auto& moments = signal.Moments[current];
+
+	const auto isHistoryValid = [&](const int previousX, const int previousY, const size_t i)
+	{
+		if (!IsInside(previousX, previousY, width, height))
+		{
+			return false;
+		}
+
+		const size_t j = static_cast<size_t>(previousY) * width + previousX;
+
+		if (previousGuide[Depth][j] <= 0.0f || previousInstances[j] != frame.InstanceId[i])
+		{
+			return false;
+		}
+
+		const float depthTolerance = 0.1f * guide[Depth][i] + 2.0f * guide[DepthGradient][i];
+		const bool depthMatch = std::abs(previousGuide[Depth][j] - guide[Depth][i]) < depthTolerance;
+		const float normalDot =
+			previousGuide[NormalX][j] * guide[NormalX][i] +
+			previousGuide[NormalY][j] * guide[NormalY][i] +
+			previousGuide[NormalZ][j] * guide[NormalZ][i];
+
+		return depthMatch && normalDot > 0.9f;
+	};
+
+	for (int x = 0; x != width; ++x)
+	{
+		const size_t i = static_cast<size_t>(row) * width + x;
+		const float* color = noisy + 4 * i;
+		const float luminance = Luminance(color[0], color[1], color[2]);
+
+		float integratedColor[3] = { color[0], color[1], color[2] };
+		float moment1 = luminance;
+		float moment2 = luminance * luminance;
+		float historyLength = 1.0f;
+
+		float historyColor[3] = {};
+		float historyMoments[3] = {};
+		float weightSum = 0.0f;
+
+		const auto addHistory = [&](const int previousX, const int previousY, const float weight)
+		{
+			const size_t j = static_cast<size_t>(previousY) * width + previousX;
+
+			for (size_t c = 0; c != 3; ++c)
+			{
+				historyColor[c] += previousColor[c][j] * weight;
+				historyMoments[c] += previousMoments[c][j] * weight;
+			}
+
+			weightSum += weight;
+		};
+
+		if (!resetHistory && guide[Depth][i] > 0.0f)
+		{
+			// Motion vectors are stored as the NDC displacement from the previous frame.
+			const float* motion = frame.NormalMotion + 4 * i + 2;
+			const float previousPositionX = static_cast<float>(x) + 0.5f - motion[0] * 0.5f * static_cast<float>(width);
+			const float previousPositionY = static_cast<float>(row) + 0.5f - motion[1] * 0.5f * static_cast<float>(height);
+
+			// Bilinear footprint of the previous pixel centers around the reprojected position.
+			const float positionX = previousPositionX - 0.5f;
+			const float positionY = previousPositionY - 0.5f;
+			const int originX = static_cast<int>(std::floor(positionX));
+			const int originY = static_cast<int>(std::floor(positionY));
+			const float fractionX = positionX - static_cast<float>(originX);
+			const float fractionY = positionY - static_cast<float>(originY);
+
+			for (int tap = 0; tap != 4; ++tap)
+			{
+				const int offsetX = tap & 1;
+				const int offsetY = tap >> 1;
+				const float weight = (offsetX != 0 ? fractionX : 1.0f - fractionX) * (offsetY != 0 ? fractionY : 1.0f - fractionY);
+
+				if (weight > 0.0f && isHistoryValid(originX + offsetX, originY + offsetY, i))
+				{
+					addHistory(originX + offsetX, originY + offsetY, weight);
+				}
+			}
+
+			// Disocclusion fallback: average the consistent pixels around the reprojected one.
+			if (weightSum < MinHistoryWeight)
+			{
+				const int nearestX = static_cast<int>(std::floor(previousPositionX));
+				const int nearestY = static_cast<int>(std::floor(previousPositionY));
+
+				std::fill(std::begin(historyColor), std::end(historyColor), 0.0f);
+				std::fill(std::begin(historyMoments), std::end(historyMoments), 0.0f);
+				weightSum = 0.0f;
+
+				for (int dy = -1; dy <= 1; ++dy)
+				{
+					for (int dx = -1; dx <= 1; ++dx)
+					{
+						if (isHistoryValid(nearestX + dx, nearestY + dy, i))
+						{
+							addHistory(nearestX + dx, nearestY + dy, 1.0f);
+						}
+					}
+				}
+			}
+		}
+
+		if (weightSum >= MinHistoryWeight)
+		{
+			for (size_t c = 0; c != 3; ++c)
+			{
+				historyColor[c] /= weightSum;
+				historyMoments[c] /= weightSum;
+			}
+
+			historyLength = std::min(historyMoments[2] + 1.0f, 255.0f);
+
+			// Plain average until enough samples have been gathered, then an exponential moving average.
+			const float colorAlpha = std::max(parameters.ColorAlpha, 1.0f / historyLength);
+			const float momentsAlpha = std::max(parameters.MomentsAlpha, 1.0f / historyLength);
+
+			for (size_t c = 0; c != 3; ++c)
+			{
+				integratedColor[c] = Mix(historyColor[c], color[c], colorAlpha);
+			}
+
+			moment1 = Mix(historyMoments[0], moment1, momentsAlpha);
+			moment2 = Mix(historyMoments[1], moment2, momentsAlpha);
+		}
+
+		moments[0][i] = moment1;
+		moments[1][i] = moment2;
+		moments[2][i] = historyLength;
+
+		for (size_t c = 0; c != 3; ++c)
+		{
+			signal.Illumination[c][i] = integratedColor[c];
+		}
+
+		signal.Illumination[3][i] = std::max(0.0f, moment2 - moment1 * moment1);
+	}
+}
+
+void ReferenceDenoiser::Variance(const Parameters& parameters, Signal& signal, const uint32_t y)
+{
+	const int radius = 3;
+	const int width = static_cast<int>(width_);
+	const int height = static_cast<int>(height_);
+	const int row = static_cast<int>(y);
+	const auto& guide = guides_[frameIndex_ % 2];
+	const auto& moments = signal.Moments[frameIndex_ % 2];
+	const auto& illumination = signal.Illumination;
+	auto& target = signal.Filters[0];
+
+	for (int x = 0; x != width; ++x)
+	{
+		const size_t i = static_cast<size_t>(row) * width + x;
+		const float historyLength = moments[2][i];
+
+		if (historyLength >= 4.0f || guide[Depth][i] <= 0.0f)
+		{
+			for (size_t c = 0; c != 4; ++c)
+			{
+				target[c][i] = illumination[c][i];
+			}
+
+			continue;
+		}
+
+		const float luminance = Luminance(illumination[0][i], illumination[1][i], illumination[2][i]);
+
+		float colorSum[3] = {};
+		float momentsSum[2] = {};
+		float weightSum = 0.0f;
+
+		for (int dy = -radius; dy <= radius; ++dy)
+		{
+			for (int dx = -radius; dx <= radius; ++dx)
+			{
+				// Samples outside of the image have an empty guide and are skipped like background pixels.
+				if (!IsInside(x + dx, row + dy, width, height))
+				{
+					continue;
+				}
+
+				const size_t j = static_cast<size_t>(row + dy) * width + x + dx;
+
+				if (guide[Depth][j] <= 0.0f)
+				{
+					continue;
+				}
+
+				const float sampleLuminance = Luminance(illumination[0][j], illumination[1][j], illumination[2][j]);
+				const float length = std::sqrt(static_cast<float>(dx * dx + dy * dy));
+				const float normalDot =
+					guide[NormalX][i] * guide[NormalX][j] +
+					guide[NormalY][i] * guide[NormalY][j] +
+					guide[NormalZ][i] * guide[NormalZ][j];
+
+				const float depthWeight = std::abs(guide[Depth][j] - guide[Depth][i]) / (parameters.PhiDepth * guide[DepthGradient][i] * length + 1e-4f);
+				const float normalWeight = std::pow(std::max(0.0f, normalDot), parameters.PhiNormal);
+				const float colorWeight = std::abs(sampleLuminance - luminance) / parameters.PhiColor;
+				const float weight = std::exp(-depthWeight - colorWeight) * normalWeight;
+
+				for (size_t c = 0; c != 3; ++c)
+				{
+					colorSum[c] += illumination[c][j] * weight;
+				}
+
+				momentsSum[0] += moments[0][j] * weight;
+				momentsSum[1] += moments[1][j] * weight;
+				weightSum += weight;
+			}
+		}
+
+		weightSum = std::max(weightSum, 1e-6f);
+
+		for (size_t c = 0; c != 3; ++c)
+		{
+			target[c][i] = colorSum[c] / weightSum;
+		}
+
+		momentsSum[0] /= weightSum;
+		momentsSum[1] /= weightSum;
+
+		// Boost the variance of young history to favour stronger spatial filtering.
+		target[3][i] = std::max(0.0f, momentsSum[1] - momentsSum[0] * momentsSum[0]) * (4.0f / historyLength);
+	}
+}
+
+void ReferenceDenoiser::ATrous(
+	const Parameters& parameters,
+	Signal& signal,
+	const int stepSize,
+	const bool writeHistory,
+	const Planes<4>& source,
+	Planes<4>& target,
+	const uint32_t y)
+{
+	const int width = static_cast<int>(width_);
+	const int height = static_cast<int>(height_);
+	const int row = static_cast<int>(y);
+	const auto& guide = guides_[frameIndex_ % 2];
+	auto& history = signal.ColorHistories[frameIndex_ % 2];
+
+	// 3x3 gaussian blur of the variance, with the neighbours clamped to the image.
+	const auto filteredVariance = [&](const int x)
+	{
+		float sum = 0.0f;
+
+		for (int dy = -1; dy <= 1; ++dy)
+		{
+			for (int dx = -1; dx <= 1; ++dx)
+			{
+				const size_t j = static_cast<size_t>(std::clamp(row + dy, 0, height - 1)) * width + std::clamp(x + dx, 0, width - 1);
+				sum += source[3][j] * VarianceWeights[std::abs(dx)] * VarianceWeights[std::abs(dy)];
+			}
+		}
+
+		return sum;
+	};
+
+	const auto filterPixel = [&](const int x)
+	{
+		const size_t i = static_cast<size_t>(row) * width + x;
+		float result[4] = { source[0][i], source[1][i], source[2][i], source[3][i] };
+
+		if (guide[Depth][i] > 0.0f)
+		{
+			const float luminance = Luminance(result[0], result[1], result[2]);
+			const float colorScale = parameters.PhiColor * std::sqrt(std::max(0.0f, filteredVariance(x))) + 1e-4f;
+
+			float colorSum[3] = { result[0], result[1], result[2] };
+			float varianceSum = result[3];
+			float weightSum = 1.0f;
+
+			for (int dy = -ATrousRadius; dy <= ATrousRadius; ++dy)
+			{
+				for (int dx = -ATrousRadius; dx <= ATrousRadius; ++dx)
+				{
+					const int sampleX = x + dx * stepSize;
+					const int sampleY = row + dy * stepSize;
+
+					if ((dx == 0 && dy == 0) || !IsInside(sampleX, sampleY, width, height))
+					{
+						continue;
+					}
+
+					const size_t j = static_cast<size_t>(sampleY) * width + sampleX;
+
+					if (guide[Depth][j] <= 0.0f)
+					{
+						continue;
+					}
+
+					const float length = std::sqrt(static_cast<float>(dx * dx + dy * dy)) * static_cast<float>(stepSize);
+					const float normalDot =
+						guide[NormalX][i] * guide[NormalX][j] +
+						guide[NormalY][i] * guide[NormalY][j] +
+						guide[NormalZ][i] * guide[NormalZ][j];
+
+					const float depthWeight = std::abs(guide[Depth][j] - guide[Depth][i]) / (parameters.PhiDepth * guide[DepthGradient][i] * length + 1e-4f);
+					const float normalWeight = std::pow(std::max(0.0f, normalDot), parameters.PhiNormal);
+					const float colorWeight = std::abs(Luminance(source[0][j], source[1][j], source[2][j]) - luminance) / colorScale;
+					const float weight = std::exp(-depthWeight - colorWeight) * normalWeight * ATrousWeights[std::abs(dx)] * ATrousWeights[std::abs(dy)];
+
+					for (size_t c = 0; c != 3; ++c)
+					{
+						colorSum[c] += source[c][j] * weight;
+					}
+
+					varianceSum += source[3][j] * weight * weight;
+					weightSum += weight;
+				}
+			}
+
+			// The center tap contributes with a weight of one.
+			for (size_t c = 0; c != 3; ++c)
+			{
+				result[c] = colorSum[c] / weightSum;
+			}
+
+			result[3] = varianceSum / (weightSum * weightSum);
+		}
+
+		for (size_t c = 0; c != 4; ++c)
+		{
+			target[c][i] = result[c];
+		}
+
+		if (writeHistory)
+		{
+			for (size_t c = 0; c != 3; ++c)
+			{
+				history[c][i] = result[c];
+			}
+		}
+	};
+
+	int x = 0;
+
+	if (aTrousKernel_ != nullptr)
+	{
+		// Lanes whose horizontal taps all fall inside the image are filtered together, the borders by the scalar path.
+		const int first = std::min(ATrousRadius * stepSize, width);
+
+		for (; x < first; ++x)
+		{
+			filterPixel(x);
+		}
+
+		ATrousRow kernelRow{};
+		kernelRow.Width = width;
+		kernelRow.Height = height;
+		kernelRow.Row = row;
+		kernelRow.StepSize = stepSize;
+		kernelRow.PhiColor = parameters.PhiColor;
+		kernelRow.PhiNormal = parameters.PhiNormal;
+		kernelRow.PhiDepth = parameters.PhiDepth;
+
+		for (size_t c = 0; c != 4; ++c)
+		{
+			kernelRow.Source[c] = source[c].data();
+			kernelRow.Target[c] = target[c].data();
+		}
+
+		for (size_t c = 0; c != 3; ++c)
+		{
+			kernelRow.History[c] = writeHistory ? history[c].data() : nullptr;
+		}
+
+		for (size_t c = 0; c != 5; ++c)
+		{
+			kernelRow.Guide[c] = guide[c].data();
+		}
+
+		x = aTrousKernel_(kernelRow, x);
+	}
+
+	for (; x < width; ++x)
+	{
+		filterPixel(x);
+	}
+}
+
+void ReferenceDenoiser::Composite(const Frame& frame, const bool bypass, const Planes<4>& diffuse, const Planes<4>& specular, float* const output, const uint32_t y) const
+{
+	for (uint32_t x = 0; x != width_; ++x)
+	{
+		const size_t i = static_cast<size_t>(y) * width_ + x;
+
+		// Remodulate by the albedo, then apply raytracing-in-one-weekend gamma correction.
+		for (size_t c = 0; c != 3; ++c)
+		{
+			const float diffuseColor = bypass ? frame.Diffuse[4 * i + c] : diffuse[c][i];
+			const float specularColor = bypass ? frame.Specular[4 * i + c] : specular[c][i];
+			const float color = (diffuseColor + specularColor) * frame.Albedo[4 * i + c];
+			output[4 * i + c] = std::sqrt(std::max(color, 0.0f));
+		}
+
+		output[4 * i + 3] = 1.0f;
+	}
+}
+
+template <class Function>
+void ReferenceDenoiser::ForEachRow(Function function)
+{
+	threadPool_.ParallelFor((height_ + RowsPerTask - 1) / RowsPerTask, [&](const uint32_t task)
+	{
+		const uint32_t begin = task * RowsPerTask;
+		const uint32_t end = std::min(begin + RowsPerTask, height_);
+
+		for (uint32_t y = begin; y != end; ++y)
+		{
+			function(y);
+		}
+	});
+}
+
+}
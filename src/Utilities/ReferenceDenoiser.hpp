@@ -0,0 +1,103 @@
+#pragma once
+
+#include "DenoiserParameters.hpp"
+#include "Simd.hpp"
+#include "ThreadPool.hpp"
+#include <array>
+#include <cstddef>
+#include <vector>
+
+namespace Utilities
+{
+	struct ATrousRow;
+
+	// CPU implementation of the SVGF filter chain of Vulkan::RayTracing::Denoiser (geometry guide, temporal
+	// accumulation, variance estimation, a-trous iterations and composite), following the compute shaders
+	// operation for operation so that it can serve as their golden model and to denoise dumped frames offline.
+	// Results match the GPU within floating point tolerance: the vectorized a-trous pass uses polynomial
+	// exp/log approximations, the rest of the math is evaluated in the same order as in the shaders.
+	// Rows are spread over a pool of worker threads, the a-trous inner loops use AVX2 or SSE2, picked at run time.
+	// Temporal gradients are not modelled, they need the replayed paths of the ray generation shader.
+	// Neither are the adaptive a-trous tiles, every pixel runs all the iterations.
+	class ReferenceDenoiser final
+	{
+	public:
+
+		// Inputs of one frame, laid out like the GPU images (rows of interleaved channels, no padding).
+		// The illumination signals have the first hit albedo divided out, the composite multiplies it back.
+		struct Frame
+		{
+			const float* Diffuse;       // RGBA linear diffuse illumination.
+			const float* Specular;      // RGBA linear specular illumination.
+			const float* Albedo;        // RGBA first hit albedo, one on misses and emitters.
+			const float* Depth;         // Linear view depth, zero on misses.
+			const float* NormalMotion;  // Octahedral normal (xy) and NDC motion (zw).
+			const uint32_t* InstanceId; // Instance index plus one, zero on misses.
+		};
+
+		ReferenceDenoiser(const ReferenceDenoiser&) = delete;
+		ReferenceDenoiser(ReferenceDenoiser&&) = delete;
+		ReferenceDenoiser& operator = (const ReferenceDenoiser&) = delete;
+		ReferenceDenoiser& operator = (ReferenceDenoiser&&) = delete;
+
+		// A thread count of zero uses all the hardware threads. The instruction set is lowered to the best one the CPU supports.
+		ReferenceDenoiser(uint32_t width, uint32_t height, uint32_t threadCount = 0, Simd::InstructionSet instructionSet = Simd::InstructionSet::Avx2);
+		~ReferenceDenoiser() = default;
+
+		uint32_t Width() const { return width_; }
+		uint32_t Height() const { return height_; }
+		uint32_t ThreadCount() const { return threadPool_.ThreadCount(); }
+
+		// Instruction set used by the vectorized passes.
+		Simd::InstructionSet InstructionSet() const { return instructionSet_; }
+
+		// Filters both signals of one frame and remodulates them into the RGBA output (width * height * 4 floats), gamma corrected like the GPU output
+		// image before its conversion to 8 bits. History carries over from the previous call, as on the GPU.
+		void Denoise(const Frame& frame, const DenoiserParameters& parameters, float* output);
+
+		// Discards the history, the next filtered frame starts the temporal accumulation over.
+		void ResetHistory() { historyValid_ = false; }
+
+	private:
+
+		// Images are stored as planes of single channels so that consecutive pixels map to SIMD lanes.
+		template <size_t N>
+		using Planes = std::array<std::vector<float>, N>;
+
+		template <size_t N>
+		void Allocate(Planes<N>& planes) const;
+
+		void Geometry(const Frame& frame, uint32_t y);
+		// History and filter images of one of the illumination signals.
+		struct Signal
+		{
+			std::array<Planes<3>, 2> ColorHistories;
+			std::array<Planes<3>, 2> Moments;
+			Planes<4> Illumination;
+			std::array<Planes<4>, 2> Filters;
+		};
+
+		void Temporal(const Frame& frame, const float* noisy, Signal& signal, const DenoiserParameters& parameters, bool resetHistory, uint32_t y);
+		void Variance(const DenoiserParameters& parameters, Signal& signal, uint32_t y);
+		void ATrous(const DenoiserParameters& parameters, Signal& signal, int stepSize, bool writeHistory, const Planes<4>& source, Planes<4>& target, uint32_t y);
+		void Composite(const Frame& frame, bool bypass, const Planes<4>& diffuse, const Planes<4>& specular, float* output, uint32_t y) const;
+
+		template <class Function>
+		void ForEachRow(Function function);
+
+		const uint32_t width_;
+		const uint32_t height_;
+		const Simd::InstructionSet instructionSet_;
+		int (* const aTrousKernel_)(const ATrousRow& row, int x);
+		ThreadPool threadPool_;
+
+		// Guides hold the decoded normal (xyz), the linear depth and its screen space gradient.
+		// Images written every frame alternate their role (current/previous), like on the GPU.
+		std::array<Planes<5>, 2> guides_;
+		std::array<std::vector<uint32_t>, 2> instances_;
+		std::array<Signal, 2> signals_;
+
+		uint32_t frameIndex_{};
+		bool historyValid_{};
+	};
+}
@@ -0,0 +1,16 @@
+#include "ReferenceDenoiserKernels.hpp"
+
+// Compiled with AVX2 code generation when DENOISER_CPU_AVX2 is set, see src/CMakeLists.txt.
+
+namespace Utilities {
+
+ATrousKernel ReferenceDenoiserAvx2Kernel()
+{
+#if defined(UTILITIES_SIMD_AVX2)
+	return &ATrousVectors::Filter<__m256>;
+#else
+	return nullptr;
+#endif
+}
+
+}
@@ -0,0 +1,236 @@
+#pragma once
+
+#include "Simd.hpp"
+#include <cfloat>
+
+namespace Utilities
+{
+	// One row of an a-trous iteration of ReferenceDenoiser, as plain pointers to the full planes.
+	struct ATrousRow
+	{
+		const float* Source[4];
+		float* Target[4];
+		float* History[3]; // Null unless the iteration writes the color history of the next frame.
+		const float* Guide[5]; // Normal (xyz), depth and depth gradient.
+		int Width;
+		int Height;
+		int Row;
+		int StepSize;
+		float PhiColor;
+		float PhiNormal;
+		float PhiDepth;
+	};
+
+	// Filters the pixels of the row from x on, whole vectors at a time while all their horizontal taps fall inside the image.
+	// Returns the first pixel left to the scalar path.
+	using ATrousKernel = int (*)(const ATrousRow& row, int x);
+
+	// The AVX2 kernel (ReferenceDenoiserAvx2.cpp), null when the compiler could not build it. Only call it after checking
+	// that the CPU supports AVX2, see Simd::Supported().
+	ATrousKernel ReferenceDenoiserAvx2Kernel();
+
+	namespace
+	{
+		const int ATrousRadius = 2;
+
+		const float ATrousWeights[3] = { 3.0f / 8.0f, 1.0f / 4.0f, 1.0f / 16.0f };
+		const float VarianceWeights[2] = { 1.0f / 4.0f, 1.0f / 8.0f };
+
+		namespace ATrousVectors
+		{
+			using namespace Simd;
+
+			// Cephes single precision exp(), accurate to a couple of ulps over the clamped range.
+			template <class V>
+			V Exp(V x)
+			{
+				x = Min(Max(x, Set<V>(-88.3762626647949f)), Set<V>(88.3762626647949f));
+
+				const V fx = Floor(Add(Mul(x, Set<V>(1.44269504088896341f)), Set<V>(0.5f)));
+
+				x = Sub(x, Mul(fx, Set<V>(0.693359375f)));
+				x = Sub(x, Mul(fx, Set<V>(-2.12194440e-4f)));
+
+				const V z = Mul(x, x);
+
+				V y = Set<V>(1.9875691500e-4f);
+				y = Add(Mul(y, x), Set<V>(1.3981999507e-3f));
+				y = Add(Mul(y, x), Set<V>(8.3334519073e-3f));
+				y = Add(Mul(y, x), Set<V>(4.1665795894e-2f));
+				y = Add(Mul(y, x), Set<V>(1.6666665459e-1f));
+				y = Add(Mul(y, x), Set<V>(5.0000001201e-1f));
+				y = Add(Add(Mul(y, z), x), Set<V>(1.0f));
+
+				return Mul(y, AsFloat(ShiftLeftExponent(AddInt(ToInt(fx), 127))));
+			}
+
+			// Cephes single precision log(), non-positive inputs are clamped to the smallest normal number.
+			template <class V>
+			V Log(V x)
+			{
+				x = Max(x, Set<V>(FLT_MIN));
+
+				const auto exponent = ShiftRightExponent(AsInt(x));
+
+				x = AsFloat(OrInt(AndInt(AsInt(x), ~0x7f800000), 0x3f000000));
+
+				V e = Add(ToFloat(AddInt(exponent, -127)), Set<V>(1.0f));
+
+				const V mask = Less(x, Set<V>(0.707106781186547524f));
+				const V tmp = And(x, mask);
+
+				x = Sub(x, Set<V>(1.0f));
+				e = Sub(e, And(Set<V>(1.0f), mask));
+				x = Add(x, tmp);
+
+				const V z = Mul(x, x);
+
+				V y = Set<V>(7.0376836292e-2f);
+				y = Add(Mul(y, x), Set<V>(-1.1514610310e-1f));
+				y = Add(Mul(y, x), Set<V>(1.1676998740e-1f));
+				y = Add(Mul(y, x), Set<V>(-1.2420140846e-1f));
+				y = Add(Mul(y, x), Set<V>(1.4249322787e-1f));
+				y = Add(Mul(y, x), Set<V>(-1.6668057665e-1f));
+				y = Add(Mul(y, x), Set<V>(2.0000714765e-1f));
+				y = Add(Mul(y, x), Set<V>(-2.4999993993e-1f));
+				y = Add(Mul(y, x), Set<V>(3.3333331174e-1f));
+				y = Mul(Mul(y, x), z);
+				y = Add(y, Mul(e, Set<V>(-2.12194440e-4f)));
+				y = Sub(y, Mul(z, Set<V>(0.5f)));
+
+				return Add(Add(x, y), Mul(e, Set<V>(0.693359375f)));
+			}
+
+			// pow() for the normal weights, zero for non-positive bases.
+			template <class V>
+			V Pow(const V x, const V p)
+			{
+				return And(Greater(x, Set<V>(0.0f)), Exp(Mul(p, Log(x))));
+			}
+
+			template <class V>
+			V Luminance(const V r, const V g, const V b)
+			{
+				return Add(Add(Mul(r, Set<V>(0.2126f)), Mul(g, Set<V>(0.7152f))), Mul(b, Set<V>(0.0722f)));
+			}
+
+			template <class V>
+			int Filter(const ATrousRow& row, int x)
+			{
+				enum GuidePlane { NormalX, NormalY, NormalZ, Depth, DepthGradient };
+
+				const int laneCount = static_cast<int>(sizeof(V) / sizeof(float));
+				const int width = row.Width;
+				const int height = row.Height;
+				const int stepSize = row.StepSize;
+				const int last = width - ATrousRadius * stepSize;
+				const float* const* source = row.Source;
+				const float* const* guide = row.Guide;
+
+				const V zero = Set<V>(0.0f);
+				const V one = Set<V>(1.0f);
+				const V phiColor = Set<V>(row.PhiColor);
+				const V phiNormal = Set<V>(row.PhiNormal);
+				const V phiDepth = Set<V>(row.PhiDepth);
+				const V epsilon = Set<V>(1e-4f);
+
+				for (; x + laneCount <= last; x += laneCount)
+				{
+					const size_t i = static_cast<size_t>(row.Row) * width + x;
+
+					const V depth = Load<V>(guide[Depth] + i);
+					const V gradient = Load<V>(guide[DepthGradient] + i);
+					const V normalX = Load<V>(guide[NormalX] + i);
+					const V normalY = Load<V>(guide[NormalY] + i);
+					const V normalZ = Load<V>(guide[NormalZ] + i);
+					const V center[4] = { Load<V>(source[0] + i), Load<V>(source[1] + i), Load<V>(source[2] + i), Load<V>(source[3] + i) };
+					const V luminance = Luminance(center[0], center[1], center[2]);
+
+					// 3x3 gaussian blur of the variance, with the neighbour rows clamped to the image.
+					V variance = zero;
+
+					for (int dy = -1; dy <= 1; ++dy)
+					{
+						const int sampleY = row.Row + dy < 0 ? 0 : row.Row + dy >= height ? height - 1 : row.Row + dy;
+						const float* sourceRow = source[3] + static_cast<size_t>(sampleY) * width + x;
+
+						for (int dx = -1; dx <= 1; ++dx)
+						{
+							variance = Add(variance, Mul(Mul(Load<V>(sourceRow + dx), Set<V>(VarianceWeights[dx < 0 ? -dx : dx])), Set<V>(VarianceWeights[dy < 0 ? -dy : dy])));
+						}
+					}
+
+					const V colorScale = Add(Mul(phiColor, Sqrt(Max(zero, variance))), epsilon);
+
+					V colorSum[3] = { center[0], center[1], center[2] };
+					V varianceSum = center[3];
+					V weightSum = one;
+
+					for (int dy = -ATrousRadius; dy <= ATrousRadius; ++dy)
+					{
+						const int sampleY = row.Row + dy * stepSize;
+
+						if (sampleY < 0 || sampleY >= height)
+						{
+							continue;
+						}
+
+						for (int dx = -ATrousRadius; dx <= ATrousRadius; ++dx)
+						{
+							if (dx == 0 && dy == 0)
+							{
+								continue;
+							}
+
+							const size_t j = static_cast<size_t>(sampleY) * width + x + dx * stepSize;
+							const V length = Set<V>(sqrtf(static_cast<float>(dx * dx + dy * dy)) * static_cast<float>(stepSize));
+
+							const V sampleDepth = Load<V>(guide[Depth] + j);
+							const V sample[4] = { Load<V>(source[0] + j), Load<V>(source[1] + j), Load<V>(source[2] + j), Load<V>(source[3] + j) };
+							const V normalDot = Add(Add(
+								Mul(normalX, Load<V>(guide[NormalX] + j)),
+								Mul(normalY, Load<V>(guide[NormalY] + j))),
+								Mul(normalZ, Load<V>(guide[NormalZ] + j)));
+
+							const V depthWeight = Div(Abs(Sub(sampleDepth, depth)), Add(Mul(Mul(phiDepth, gradient), length), epsilon));
+							const V normalWeight = Pow(Max(zero, normalDot), phiNormal);
+							const V colorWeight = Div(Abs(Sub(Luminance(sample[0], sample[1], sample[2]), luminance)), colorScale);
+							const V kernel = Mul(Set<V>(ATrousWeights[dx < 0 ? -dx : dx]), Set<V>(ATrousWeights[dy < 0 ? -dy : dy]));
+
+							// Background samples get a zero weight.
+							V weight = Mul(Mul(Exp(Sub(Sub(zero, depthWeight), colorWeight)), normalWeight), kernel);
+							weight = And(Greater(sampleDepth, zero), weight);
+
+							for (size_t c = 0; c != 3; ++c)
+							{
+								colorSum[c] = Add(colorSum[c], Mul(sample[c], weight));
+							}
+
+							varianceSum = Add(varianceSum, Mul(Mul(sample[3], weight), weight));
+							weightSum = Add(weightSum, weight);
+						}
+					}
+
+					// Background pixels keep their value.
+					const V foreground = Greater(depth, zero);
+
+					for (size_t c = 0; c != 3; ++c)
+					{
+						const V result = Select(foreground, Div(colorSum[c], weightSum), center[c]);
+
+						Store(row.Target[c] + i, result);
+
+						if (row.History[c] != nullptr)
+						{
+							Store(row.History[c] + i, result);
+						}
+					}
+
+					Store(row.Target[3] + i, Select(foreground, Div(varianceSum, Mul(weightSum, weightSum)), center[3]));
+				}
+
+				return x;
+			}
+		}
+	}
+}
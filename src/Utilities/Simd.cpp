@@ -0,0 +1,81 @@
+#include "Simd.hpp"
+
+#if defined(DENOISER_CPU_AVX2) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace Utilities::Simd {
+
+namespace
+{
+	// AVX2 needs the OS to save the upper halves of the vector registers as well (OSXSAVE and XCR0 bits 1 and 2).
+	bool CpuSupportsAvx2()
+	{
+#if !defined(DENOISER_CPU_AVX2)
+		return false;
+#elif defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 0);
+
+		if (info[0] < 7)
+		{
+			return false;
+		}
+
+		__cpuid(info, 1);
+
+		const bool osxsave = (info[2] & (1 << 27)) != 0;
+		const bool avx = (info[2] & (1 << 28)) != 0;
+
+		if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6)
+		{
+			return false;
+		}
+
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+#else
+		// Also checks the OS support of the AVX registers.
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx2");
+#endif
+	}
+}
+
+InstructionSet Supported()
+{
+	static const InstructionSet supported = []()
+	{
+		if (CpuSupportsAvx2())
+		{
+			return InstructionSet::Avx2;
+		}
+
+#if defined(UTILITIES_SIMD_SSE2)
+		return InstructionSet::Sse2;
+#else
+		return InstructionSet::Scalar;
+#endif
+	}();
+
+	return supported;
+}
+
+InstructionSet Supported(const InstructionSet requested)
+{
+	return static_cast<int>(requested) < static_cast<int>(Supported()) ? requested : Supported();
+}
+
+const char* Name(const InstructionSet instructionSet)
+{
+	switch (instructionSet)
+	{
+	case InstructionSet::Scalar: return "scalar";
+	case InstructionSet::Sse2: return "SSE2";
+	case InstructionSet::Avx2: return "AVX2";
+	}
+
+	return "unknown";
+}
+
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <cstdint>
+#include <string.h>
+#include <math.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define UTILITIES_SIMD_AVX2
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define UTILITIES_SIMD_SSE2
+#endif
+
+namespace Utilities::Simd
+{
+	// Instruction sets of the vectorized CPU kernels, the best one supported is picked at run time.
+	enum class InstructionSet
+	{
+		Scalar,
+		Sse2,
+		Avx2
+	};
+
+	// Best instruction set the kernels were compiled for that the CPU (and the OS, for the AVX registers) supports.
+	InstructionSet Supported();
+
+	// The requested instruction set, lowered to the best supported one.
+	InstructionSet Supported(InstructionSet requested);
+
+	const char* Name(InstructionSet instructionSet);
+
+	// Wrappers of float and of the SSE2 and AVX2 float vectors under the same names, so that a kernel written once as a
+	// template of the vector type compiles for each instruction set. The AVX2 kernels are compiled in translation units of
+	// their own with AVX2 code generation (the *Avx2.cpp files), that are only called once Supported() allows it. Everything
+	// such a unit compiles has internal linkage, and calls no inline function of the standard library: an out of line copy
+	// of it compiled for AVX2 could otherwise be the one the linker keeps for the rest of the program.
+	namespace
+	{
+		template <class V> V Load(const float* p);
+		template <class V> V Set(float v);
+
+		template <> inline float Load<float>(const float* p) { return *p; }
+		template <> inline float Set<float>(const float v) { return v; }
+		inline void Store(float* p, const float v) { *p = v; }
+		inline float Add(const float a, const float b) { return a + b; }
+		inline float Sub(const float a, const float b) { return a - b; }
+		inline float Mul(const float a, const float b) { return a * b; }
+		inline float Div(const float a, const float b) { return a / b; }
+		inline float Min(const float a, const float b) { return b < a ? b : a; }
+		inline float Max(const float a, const float b) { return a < b ? b : a; }
+		inline float Sqrt(const float a) { return sqrtf(a); }
+		inline float Abs(const float a) { return fabsf(a); }
+		inline bool Greater(const float a, const float b) { return a > b; }
+		inline float Select(const bool mask, const float a, const float b) { return mask ? a : b; }
+		inline int32_t AsInt(const float a) { int32_t i; memcpy(&i, &a, sizeof(i)); return i; }
+		inline float AsFloat(const int32_t a) { float f; memcpy(&f, &a, sizeof(f)); return f; }
+		inline int32_t ToInt(const float a) { return static_cast<int32_t>(a); }
+		inline float ToFloat(const int32_t a) { return static_cast<float>(a); }
+		inline int32_t AddInt(const int32_t a, const int32_t b) { return a + b; }
+		inline int32_t AndInt(const int32_t a, const int32_t b) { return a & b; }
+		inline int32_t OrInt(const int32_t a, const int32_t b) { return a | b; }
+		inline int32_t ShiftLeftExponent(const int32_t a) { return static_cast<int32_t>(static_cast<uint32_t>(a) << 23); }
+		inline int32_t ShiftRightExponent(const int32_t a) { return static_cast<int32_t>(static_cast<uint32_t>(a) >> 23); }
+
+#if defined(UTILITIES_SIMD_SSE2)
+
+		template <> inline __m128 Load<__m128>(const float* p) { return _mm_loadu_ps(p); }
+		template <> inline __m128 Set<__m128>(const float v) { return _mm_set1_ps(v); }
+		inline void Store(float* p, const __m128 v) { _mm_storeu_ps(p, v); }
+		inline __m128 Add(const __m128 a, const __m128 b) { return _mm_add_ps(a, b); }
+		inline __m128 Sub(const __m128 a, const __m128 b) { return _mm_sub_ps(a, b); }
+		inline __m128 Mul(const __m128 a, const __m128 b) { return _mm_mul_ps(a, b); }
+		inline __m128 Div(const __m128 a, const __m128 b) { return _mm_div_ps(a, b); }
+		inline __m128 Min(const __m128 a, const __m128 b) { return _mm_min_ps(a, b); }
+		inline __m128 Max(const __m128 a, const __m128 b) { return _mm_max_ps(a, b); }
+		inline __m128 Sqrt(const __m128 a) { return _mm_sqrt_ps(a); }
+		inline __m128 Abs(const __m128 a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+		inline __m128 And(const __m128 a, const __m128 b) { return _mm_and_ps(a, b); }
+		inline __m128 Less(const __m128 a, const __m128 b) { return _mm_cmplt_ps(a, b); }
+		inline __m128 Greater(const __m128 a, const __m128 b) { return _mm_cmpgt_ps(a, b); }
+		inline __m128 Select(const __m128 mask, const __m128 a, const __m128 b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+		inline __m128i AsInt(const __m128 a) { return _mm_castps_si128(a); }
+		inline __m128 AsFloat(const __m128i a) { return _mm_castsi128_ps(a); }
+		inline __m128i ToInt(const __m128 a) { return _mm_cvttps_epi32(a); }
+		inline __m128 ToFloat(const __m128i a) { return _mm_cvtepi32_ps(a); }
+		inline __m128i AddInt(const __m128i a, const int32_t b) { return _mm_add_epi32(a, _mm_set1_epi32(b)); }
+		inline __m128i AndInt(const __m128i a, const int32_t b) { return _mm_and_si128(a, _mm_set1_epi32(b)); }
+		inline __m128i OrInt(const __m128i a, const int32_t b) { return _mm_or_si128(a, _mm_set1_epi32(b)); }
+		inline __m128i ShiftLeftExponent(const __m128i a) { return _mm_slli_epi32(a, 23); }
+		inline __m128i ShiftRightExponent(const __m128i a) { return _mm_srli_epi32(a, 23); }
+
+		// SSE2 has no rounding instruction, truncate and correct the negative values.
+		inline __m128 Floor(const __m128 a)
+		{
+			const __m128 truncated = ToFloat(ToInt(a));
+			return Sub(truncated, And(Greater(truncated, a), _mm_set1_ps(1.0f)));
+		}
+
+#endif
+
+#if defined(UTILITIES_SIMD_AVX2)
+
+		template <> inline __m256 Load<__m256>(const float* p) { return _mm256_loadu_ps(p); }
+		template <> inline __m256 Set<__m256>(const float v) { return _mm256_set1_ps(v); }
+		inline void Store(float* p, const __m256 v) { _mm256_storeu_ps(p, v); }
+		inline __m256 Add(const __m256 a, const __m256 b) { return _mm256_add_ps(a, b); }
+		inline __m256 Sub(const __m256 a, const __m256 b) { return _mm256_sub_ps(a, b); }
+		inline __m256 Mul(const __m256 a, const __m256 b) { return _mm256_mul_ps(a, b); }
+		inline __m256 Div(const __m256 a, const __m256 b) { return _mm256_div_ps(a, b); }
+		inline __m256 Min(const __m256 a, const __m256 b) { return _mm256_min_ps(a, b); }
+		inline __m256 Max(const __m256 a, const __m256 b) { return _mm256_max_ps(a, b); }
+		inline __m256 Sqrt(const __m256 a) { return _mm256_sqrt_ps(a); }
+		inline __m256 Abs(const __m256 a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+		inline __m256 Floor(const __m256 a) { return _mm256_floor_ps(a); }
+		inline __m256 And(const __m256 a, const __m256 b) { return _mm256_and_ps(a, b); }
+		inline __m256 Less(const __m256 a, const __m256 b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+		inline __m256 Greater(const __m256 a, const __m256 b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+		inline __m256 Select(const __m256 mask, const __m256 a, const __m256 b) { return _mm256_blendv_ps(b, a, mask); }
+		inline __m256i AsInt(const __m256 a) { return _mm256_castps_si256(a); }
+		inline __m256 AsFloat(const __m256i a) { return _mm256_castsi256_ps(a); }
+		inline __m256i ToInt(const __m256 a) { return _mm256_cvttps_epi32(a); }
+		inline __m256 ToFloat(const __m256i a) { return _mm256_cvtepi32_ps(a); }
+		inline __m256i AddInt(const __m256i a, const int32_t b) { return _mm256_add_epi32(a, _mm256_set1_epi32(b)); }
+		inline __m256i AndInt(const __m256i a, const int32_t b) { return _mm256_and_si256(a, _mm256_set1_epi32(b)); }
+		inline __m256i OrInt(const __m256i a, const int32_t b) { return _mm256_or_si256(a, _mm256_set1_epi32(b)); }
+		inline __m256i ShiftLeftExponent(const __m256i a) { return _mm256_slli_epi32(a, 23); }
+		inline __m256i ShiftRightExponent(const __m256i a) { return _mm256_srli_epi32(a, 23); }
+
+#endif
+	}
+}
@@ -0,0 +1,103 @@
+#include "ThreadPool.hpp"
+#include <algorithm>
+
+namespace Utilities {
+
+ThreadPool::ThreadPool(const uint32_t threadCount)
+{
+	const uint32_t count = threadCount != 0 ? threadCount : std::max(std::thread::hardware_concurrency(), 1u);
+
+	for (uint32_t i = 1; i < count; ++i)
+	{
+		threads_.emplace_back(&ThreadPool::Work, this);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stop_ = true;
+	}
+
+	started_.notify_all();
+
+	for (auto& thread : threads_)
+	{
+		thread.join();
+	}
+}
+
+void ThreadPool::ParallelFor(const uint32_t taskCount, const std::function<void(uint32_t)>& function)
+{
+	if (threads_.empty() || taskCount <= 1)
+	{
+		for (uint32_t i = 0; i != taskCount; ++i)
+		{
+			function(i);
+		}
+
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		function_ = &function;
+		taskCount_ = taskCount;
+		nextTask_ = 0;
+		busyThreads_ = static_cast<uint32_t>(threads_.size());
+		loop_++;
+	}
+
+	started_.notify_all();
+
+	RunTasks();
+
+	// The function must outlive the last call, wait for every worker to leave the loop.
+	std::unique_lock<std::mutex> lock(mutex_);
+	finished_.wait(lock, [this]() { return busyThreads_ == 0; });
+	function_ = nullptr;
+}
+
+void ThreadPool::Work()
+{
+	uint32_t loop = 0;
+
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			started_.wait(lock, [&]() { return stop_ || loop_ != loop; });
+
+			if (stop_)
+			{
+				return;
+			}
+
+			loop = loop_;
+		}
+
+		RunTasks();
+
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+
+			if (--busyThreads_ != 0)
+			{
+				continue;
+			}
+		}
+
+		finished_.notify_one();
+	}
+}
+
+void ThreadPool::RunTasks()
+{
+	for (uint32_t task; (task = nextTask_.fetch_add(1)) < taskCount_;)
+	{
+		(*function_)(task);
+	}
+}
+
+}
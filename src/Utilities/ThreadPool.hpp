@@ -0,0 +1,53 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Utilities
+{
+	// Worker threads kept alive between parallel loops, so that a loop only pays for waking them up rather than
+	// for creating and joining threads. The calling thread takes its share of every loop.
+	class ThreadPool final
+	{
+	public:
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool(ThreadPool&&) = delete;
+		ThreadPool& operator = (const ThreadPool&) = delete;
+		ThreadPool& operator = (ThreadPool&&) = delete;
+
+		// A thread count of zero uses all the hardware threads, the calling thread included.
+		explicit ThreadPool(uint32_t threadCount = 0);
+		~ThreadPool();
+
+		uint32_t ThreadCount() const { return static_cast<uint32_t>(threads_.size()) + 1; }
+
+		// Calls the function once for each task index in [0, taskCount), spread over the threads, and returns once all
+		// the calls have returned. Loops must not be nested nor started from several threads at once.
+		void ParallelFor(uint32_t taskCount, const std::function<void(uint32_t)>& function);
+
+	private:
+
+		void Work();
+		void RunTasks();
+
+		std::vector<std::thread> threads_;
+
+		std::mutex mutex_;
+		std::condition_variable started_;
+		std::condition_variable finished_;
+
+		// State of the current loop, guarded by the mutex except for the task counter.
+		const std::function<void(uint32_t)>* function_{};
+		uint32_t taskCount_{};
+		std::atomic<uint32_t> nextTask_{};
+		uint32_t loop_{};
+		uint32_t busyThreads_{};
+		bool stop_{};
+	};
+}
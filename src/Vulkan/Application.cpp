@@ -5,26 +5,34 @@
 #include "DebugUtilsMessenger.hpp"
 #include "DepthBuffer.hpp"
 #include "Device.hpp"
+#include "Enumerate.hpp"
 #include "Fence.hpp"
 #include "FrameBuffer.hpp"
+#include "FrameContext.hpp"
 #include "GraphicsPipeline.hpp"*
 #include "Instance.hpp"
+#include "PipelineCache.hpp"
 #include "PipelineLayout.hpp"
 #include "RenderPass.hpp"
 #include "Semaphore.hpp"
 #include "Surface.hpp"
 #include "SwapChain.hpp"
+#include "UniformBufferArena.hpp"
+#include "Uploader.hpp"
 #include "Window.hpp"
 #include "Assets/Model.hpp"
 #include "Assets/Scene.hpp"
 #include "Assets/UniformBuffer.hpp"
 #include "Utilities/Exception.hpp"
+#include <algorithm>
 #include <array>
+#include <cstring>
 
 namespace Vulkan {
 
-Application::Application(const WindowConfig& windowConfig, const VkPresentModeKHR presentMode, const bool enableValidationLayers) :
-	presentMode_(presentMode)//presentModeչʾͼ񵽴ڣչʾֱͬ
+Application::Application(const WindowConfig& windowConfig, const VkPresentModeKHR presentMode, const uint32_t framesInFlight, const bool enableValidationLayers) :
+	presentMode_(presentMode),//presentModeչʾͼ񵽴ڣչʾֱͬ
+	framesInFlight_(framesInFlight)
 	//ֱͬȾ֡ʾˢƵֹֻͬ˺
 {
 	const auto validationLayers = enableValidationLayers
@@ -45,6 +53,15 @@ Application::~Application()
 {
 	Application::DeleteSwapChain();
 
+	uniformBufferArena_.reset();
+
+	if (pipelineCache_)
+	{
+		pipelineCache_->Save();
+	}
+
+	pipelineCache_.reset();
+	uploader_.reset();
 	commandPool_.reset();
 	device_.reset();
 	surface_.reset();
@@ -122,8 +139,29 @@ void Application::SetPhysicalDevice(
 	VkPhysicalDeviceFeatures& deviceFeatures,
 	void* nextDeviceFeatures)
 {
-	device_.reset(new class Device(physicalDevice, *surface_, requiredExtensions, deviceFeatures, nextDeviceFeatures));
+	// Optional, lets the memory allocator report the actual budget of the device local heaps.
+	const auto availableExtensions = GetEnumerateVector(physicalDevice, static_cast<const char*>(nullptr), vkEnumerateDeviceExtensionProperties);
+	const bool hasMemoryBudget = std::any_of(availableExtensions.begin(), availableExtensions.end(), [](const VkExtensionProperties& extension)
+	{
+		return std::strcmp(extension.extensionName, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) == 0;
+	});
+
+	if (hasMemoryBudget)
+	{
+		requiredExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+	}
+
+	device_.reset(new class Device(physicalDevice, *surface_, requiredExtensions, deviceFeatures, nextDeviceFeatures, UseDedicatedTransferQueue()));
 	commandPool_.reset(new class CommandPool(*device_, device_->GraphicsFamilyIndex(), true));
+
+	// Staging ring for the scene uploads, larger resources go through it in several pieces.
+	const size_t uploadRingSize = 32 * 1024 * 1024;
+	uploader_.reset(new class Uploader(*device_, uploadRingSize));
+	pipelineCache_.reset(new class PipelineCache(*device_, "PipelineCache.bin"));
+
+	// Room for the frame globals and per-pass constants of one frame, a multiple of any offset alignment.
+	const size_t uniformBufferArenaFrameSize = 64 * 1024;
+	uniformBufferArena_.reset(new UniformBufferArena(*device_, framesInFlight_, uniformBufferArenaFrameSize));
 }
 
 void Application::OnDeviceSet()
@@ -143,104 +181,65 @@ void Application::CreateSwapChain()
 
 	depthBuffer_.reset(new class DepthBuffer(*commandPool_, swapChain_->Extent()));
 
-	for (size_t i = 0; i != swapChain_->ImageViews().size(); ++i)
+	// The number of frames in flight is independent of the number of swap chain images.
+	for (uint32_t i = 0; i != framesInFlight_; ++i)
 	{
-		imageAvailableSemaphores_.emplace_back(*device_);
-		renderFinishedSemaphores_.emplace_back(*device_);
-		inFlightFences_.emplace_back(*device_, true);
-		uniformBuffers_.emplace_back(*device_);
+		frameContexts_.emplace_back(new FrameContext(*device_, i));
 	}
-	// ȡͼĳߴ͸ʽ
-	VkExtent2D imageExtent = swapChain_->Extent();
-	VkFormat imageFormat = swapChain_->Format();
 
-	// ͼģʽʹ÷ʽ
-	VkImageTiling tiling = VK_IMAGE_TILING_OPTIMAL;
-	VkImageUsageFlags usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT;
+	asyncCompute_ = UseAsyncCompute();
+	computeFramePending_ = false;
 
 	//ͼڴ
 	VkMemoryPropertyFlags properties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
 
-	//Ȼͼ
-	depthImage_.reset(new Vulkan::Image(*device_, swapChain_->Extent(), VK_FORMAT_D32_SFLOAT, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT));
-	depthImageMemory_.reset(new Vulkan::DeviceMemory(depthImage_->AllocateMemory(properties)));
-	depthImageView_.reset(new Vulkan::ImageView(*device_, depthImage_->Handle(), VK_FORMAT_D32_SFLOAT, VK_IMAGE_ASPECT_DEPTH_BIT));
-	depthSampler_.reset(new Vulkan::Sampler(*device_, Vulkan::SamplerConfig()));
-
 	//motion vectorͼ
 	motionVectorImage_.reset(new Vulkan::Image(*device_, swapChain_->Extent(), VK_FORMAT_R32G32_SFLOAT, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT));
-	motionVectorImageMemory_.reset(new Vulkan::DeviceMemory(motionVectorImage_->AllocateMemory(properties)));
+	motionVectorImageMemory_.reset(new Vulkan::DeviceMemory(motionVectorImage_->AllocateMemory(properties, MemoryAllocator::Category::RenderTargets)));
 	motionVectorImage_->TransitionImageLayout(*commandPool_, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, false);
 	motionVectorImageView_.reset(new Vulkan::ImageView(*device_, motionVectorImage_->Handle(), VK_FORMAT_R32G32_SFLOAT, VK_IMAGE_ASPECT_COLOR_BIT));
 	motionVectorSampler_.reset(new Vulkan::Sampler(*device_, Vulkan::SamplerConfig()));
 
-	//  saveImage_ ͷڴ
-	saveImage_.reset(new Vulkan::Image(*device_, imageExtent, imageFormat, tiling, usage));
-	saveImageMemory_.reset(new Vulkan::DeviceMemory(saveImage_->AllocateMemory(properties)));
-
-	//ͼͼΪհףΪָ
-	first_saveImageview_ = new Vulkan::ImageView(*device_, saveImage_->Handle(), imageFormat, VK_IMAGE_ASPECT_COLOR_BIT, true);
-	first_depthImageview_ = new Vulkan::ImageView(*device_, depthImage_->Handle(), VK_FORMAT_D32_SFLOAT, VK_IMAGE_ASPECT_DEPTH_BIT, true);
-
-	//֡ͼûһ֡ͼͼΪ
-	saveImageView_.reset(first_saveImageview_);
-	depthImageView_.reset(first_depthImageview_);
-
-	//֡ͼ񲼾תʹ
-	depthImage_->TransitionImageLayout(*commandPool_, VK_IMAGE_LAYOUT_GENERAL, true);
-	saveImage_->TransitionImageLayout(*commandPool_, VK_IMAGE_LAYOUT_GENERAL, false);
-
 	//ͼι
-	graphicsPipeline_.reset(new class GraphicsPipeline(*swapChain_, *depthBuffer_, uniformBuffers_, GetScene(), *depthImageView_, *depthSampler_, isWireFrame_));
+	graphicsPipeline_.reset(new class GraphicsPipeline(*swapChain_, *depthBuffer_, *uniformBufferArena_, GetScene(), isWireFrame_));
 
 	//涨ɫɫȺmotion vector棩
 	for (const auto& imageView : swapChain_->ImageViews())
 	{
 		swapChainFramebuffers_.emplace_back(*imageView, graphicsPipeline_->RenderPass(), *motionVectorImageView_);
 	}
-
-	commandBuffers_.reset(new CommandBuffers(*commandPool_, static_cast<uint32_t>(swapChainFramebuffers_.size())));
 }
 
 void Application::DeleteSwapChain()
 {
-	commandBuffers_.reset();//ֱcommandBuffers󣬶
 	swapChainFramebuffers_.clear();
 	graphicsPipeline_.reset();
-	uniformBuffers_.clear();
-	inFlightFences_.clear();
-	renderFinishedSemaphores_.clear();
-	imageAvailableSemaphores_.clear();
+	frameContexts_.clear();
 	depthBuffer_.reset();
 	swapChain_.reset();
-	saveImage_.reset();
-	saveImageMemory_.reset();
-	saveImageView_.reset();
 	motionVectorImage_.reset();
 	motionVectorImageMemory_.reset();
 	motionVectorImageView_.reset();
 	motionVectorSampler_.reset();
-	depthImage_.reset();
-	depthImageMemory_.reset();
-	depthImageView_.reset();
-	depthSampler_.reset();
 }
 
 void Application::DrawFrame()
 {
 	const auto noTimeout = std::numeric_limits<uint64_t>::max();
 
-	auto& inFlightFence = inFlightFences_[currentFrame_];
-	const auto imageAvailableSemaphore = imageAvailableSemaphores_[currentFrame_].Handle();
-	const auto renderFinishedSemaphore = renderFinishedSemaphores_[currentFrame_].Handle();
+	auto& frame = *frameContexts_[currentFrame_];
+	auto& inFlightFence = frame.InFlightFence();
+	const auto imageAvailableSemaphore = frame.ImageAvailableSemaphore().Handle();
+	const auto renderFinishedSemaphore = frame.RenderFinishedSemaphore().Handle();
 
 	inFlightFence.Wait(noTimeout);
+	frame.ComputeFence().Wait(noTimeout);
 
 	//ȡһ֡ͼ
 	uint32_t imageIndex;
 	auto result = vkAcquireNextImageKHR(device_->Handle(), swapChain_->Handle(), noTimeout, imageAvailableSemaphore, nullptr, &imageIndex);
 
-	if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || isWireFrame_ != graphicsPipeline_->IsWireFrame())
+	if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || isWireFrame_ != graphicsPipeline_->IsWireFrame() || asyncCompute_ != UseAsyncCompute() || IsSwapChainOutdated())
 	{
 		RecreateSwapChain();
 		return;
@@ -251,86 +250,34 @@ void Application::DrawFrame()
 		Throw(std::runtime_error(std::string("failed to acquire next image (") + ToString(result) + ")"));
 	}
 
-	// ȡͼĳߴ͸ʽ
-	VkExtent2D imageExtent = swapChain_->Extent();
-	VkFormat imageFormat = swapChain_->Format();
+	// The frame globals are written once recording is done, but their offset must be known while recording.
+	uniformBufferArena_->BeginFrame(frame.Index());
+	uniformBufferOffset_ = uniformBufferArena_->Allocate(sizeof(Assets::UniformBufferObject));
 
-	// ͼģʽʹ÷ʽ
-	VkImageTiling tiling = VK_IMAGE_TILING_OPTIMAL;
-	VkImageUsageFlags usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
-
-	const auto commandBuffer = commandBuffers_->Begin(imageIndex);
+	const auto commandBuffer = frame.BeginCommandBuffer();
 	Render(commandBuffer, imageIndex);
-	commandBuffers_->End(imageIndex); 
-
-	UpdateUniformBuffer(imageIndex);
-
-	VkSubmitInfo submitInfo = {};
-	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-
-	VkCommandBuffer commandBuffers[]{ commandBuffer };
-	VkSemaphore waitSemaphores[] = { imageAvailableSemaphore };
-	VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-	VkSemaphore signalSemaphores[] = { renderFinishedSemaphore };
-
-	submitInfo.waitSemaphoreCount = 1;
-	submitInfo.pWaitSemaphores = waitSemaphores;
-	submitInfo.pWaitDstStageMask = waitStages;
-	submitInfo.commandBufferCount = 1;
-	submitInfo.pCommandBuffers = commandBuffers;
-	submitInfo.signalSemaphoreCount = 1;
-	submitInfo.pSignalSemaphores = signalSemaphores;
-
-	inFlightFence.Reset();
-
-	Check(vkQueueSubmit(device_->GraphicsQueue(), 1, &submitInfo, inFlightFence.Handle()),
-		"submit draw command buffer");
-
-	// ȡеǰ֡ͼ
-	const auto& images = swapChain_->Images();
-	VkImage saveImageHandle = images[currentFrame_];
-	auto currentFrameImage = std::make_unique<Vulkan::Image>(*device_, imageExtent, imageFormat, tiling, usage, saveImageHandle, true);
+	frame.EndCommandBuffer();
 
-	// ȡеǰ֡ͼ
-	const Vulkan::Image& depthImage = DepthBuffer().Image();
-	VkImage depthImageHandle = depthImage.Handle();
-	auto currentDepthImage = std::make_unique<Vulkan::Image>(*device_, imageExtent, VK_FORMAT_D32_SFLOAT, tiling, usage, depthImageHandle, true);
-
-	//һ֡ͼ
-	if (depthImage_)
+	if (asyncCompute_)
 	{
-		currentDepthImage->TransitionImageLayout(*commandPool_, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, true);
-
-		depthImage_->TransitionImageLayout(*commandPool_, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, true);
+		const auto presentCommandBuffer = frame.BeginPresentCommandBuffer();
+		RenderPresent(presentCommandBuffer, imageIndex);
+		frame.EndPresentCommandBuffer();
 
-		CopyDepthImage(*currentDepthImage, *depthImage_);
+		const auto computeCommandBuffer = frame.BeginComputeCommandBuffer();
+		RenderCompute(computeCommandBuffer);
+		frame.EndComputeCommandBuffer();
 
-		currentDepthImage->TransitionImageLayout(*commandPool_, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, false);
-
-		depthImage_->TransitionImageLayout(*commandPool_, VK_IMAGE_LAYOUT_GENERAL, true);
+		UpdateUniformBuffer();
+		SubmitAsyncCompute(frame, commandBuffer, presentCommandBuffer, computeCommandBuffer);
 	}
-
-	//һ֡ͼ
-	if (saveImage_)
+	else
 	{
-		// Step 1: Transition srcImage to VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL
-		currentFrameImage->TransitionImageLayout(*commandPool_, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, false);
-
-		// Step 2: Transition dstImage to VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
-		saveImage_->TransitionImageLayout(*commandPool_, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, false);
-
-		CopyImage(*currentFrameImage, *saveImage_);
-
-		// Step 4: Transition srcImage back to VK_IMAGE_LAYOUT_PRESENT_SRC_KHR
-		currentFrameImage->TransitionImageLayout(*commandPool_, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, false);
-
-		// Step 5: Transition dstImage to VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-		saveImage_->TransitionImageLayout(*commandPool_, VK_IMAGE_LAYOUT_GENERAL, false);
+		UpdateUniformBuffer();
+		Submit(frame, commandBuffer);
 	}
 
-	//Imageview
-	saveImageView_.reset(new Vulkan::ImageView(*device_, saveImage_->Handle(), imageFormat, VK_IMAGE_ASPECT_COLOR_BIT));
-	depthImageView_.reset(new Vulkan::ImageView(*device_, depthImage_->Handle(), VK_FORMAT_D32_SFLOAT, VK_IMAGE_ASPECT_DEPTH_BIT));
+	VkSemaphore signalSemaphores[] = { renderFinishedSemaphore };
 
 	VkSwapchainKHR swapChains[] = { swapChain_->Handle() };
 	VkPresentInfoKHR presentInfo = {};
@@ -355,7 +302,7 @@ void Application::DrawFrame()
 		Throw(std::runtime_error(std::string("failed to present next image (") + ToString(result) + ")"));
 	}
 
-	currentFrame_ = (currentFrame_ + 1) % inFlightFences_.size();
+	currentFrame_ = (currentFrame_ + 1) % frameContexts_.size();
 }
 
 void Application::Render(VkCommandBuffer commandBuffer, const uint32_t imageIndex)
@@ -378,13 +325,13 @@ void Application::Render(VkCommandBuffer commandBuffer, const uint32_t imageInde
 	{
 		const auto& scene = GetScene();
 
-		VkDescriptorSet descriptorSets[] = { graphicsPipeline_->DescriptorSet(imageIndex) };
+		VkDescriptorSet descriptorSets[] = { graphicsPipeline_->DescriptorSet(0) };
 		VkBuffer vertexBuffers[] = { scene.VertexBuffer().Handle() };
 		const VkBuffer indexBuffer = scene.IndexBuffer().Handle();
 		VkDeviceSize offsets[] = { 0 };
 
 		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline_->Handle());
-		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline_->PipelineLayout().Handle(), 0, 1, descriptorSets, 0, nullptr);
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline_->PipelineLayout().Handle(), 0, 1, descriptorSets, 1, &uniformBufferOffset_);
 		vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
 		vkCmdBindIndexBuffer(commandBuffer, indexBuffer, 0, VK_INDEX_TYPE_UINT32);
 
@@ -405,10 +352,8 @@ void Application::Render(VkCommandBuffer commandBuffer, const uint32_t imageInde
 	vkCmdEndRenderPass(commandBuffer);
 }
 
-void Application::UpdateUniformBuffer(const uint32_t imageIndex)
+void Application::UpdateUniformBuffer()
 {
-	//uniformBuffers_[imageIndex].SetValue(GetUniformBufferObject(swapChain_->Extent()));
-
 	Assets::UniformBufferObject ubo = GetUniformBufferObject(swapChain_->Extent());
 
 	// 洢һ֡ModelViewProjectionubo
@@ -419,7 +364,7 @@ void Application::UpdateUniformBuffer(const uint32_t imageIndex)
 	lastFrameModelView = ubo.ModelView;
 	lastFrameProjection = ubo.Projection;
 
-	uniformBuffers_[imageIndex].SetValue(ubo);
+	uniformBufferArena_->Write(uniformBufferOffset_, &ubo, sizeof(ubo));
 }
 
 void Application::RecreateSwapChain()
@@ -429,89 +374,87 @@ void Application::RecreateSwapChain()
 	CreateSwapChain();
 }
 
-//ƺ
-void Application::CopyImage(Vulkan::Image& srcImage, Vulkan::Image& dstImage)
+void Application::Submit(FrameContext& frame, VkCommandBuffer commandBuffer)
 {
-	// Step 3: Copy srcImage to dstImage
-	VkCommandBuffer commandBuffer = commandBuffers_->Begin(0);
-
-	// Define image copy region
-	VkImageCopy copyRegion{};
-	copyRegion.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	copyRegion.srcSubresource.layerCount = 1;
-	copyRegion.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	copyRegion.dstSubresource.layerCount = 1;
-	copyRegion.extent.width = srcImage.Extent().width;
-	copyRegion.extent.height = srcImage.Extent().height;
-	copyRegion.extent.depth = 1;
-
-	// Perform copy operation
-	vkCmdCopyImage(
-		commandBuffer,
-		srcImage.Handle(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-		dstImage.Handle(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-		1, &copyRegion
-	);
-
-	commandBuffers_->End(0);
-
-	// Submit command buffer
-	VkSubmitInfo submitInfo{};
+	VkSubmitInfo submitInfo = {};
 	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-	submitInfo.commandBufferCount = 1;
-	submitInfo.pCommandBuffers = &commandBuffer;
 
-	VkFenceCreateInfo fenceInfo{};
-	fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-	VkFence fence;
-	vkCreateFence(device_->Handle(), &fenceInfo, nullptr, &fence);
-
-	vkQueueSubmit(device_->GraphicsQueue(), 1, &submitInfo, fence);
-	vkWaitForFences(device_->Handle(), 1, &fence, VK_TRUE, UINT64_MAX);
-
-	vkDestroyFence(device_->Handle(), fence, nullptr);
-}
+	VkCommandBuffer commandBuffers[]{ commandBuffer };
+	VkSemaphore waitSemaphores[] = { frame.ImageAvailableSemaphore().Handle() };
+	VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
+	VkSemaphore signalSemaphores[] = { frame.RenderFinishedSemaphore().Handle() };
 
-void Application::CopyDepthImage(Vulkan::Image& srcImage, Vulkan::Image& dstImage)
-{
-	// Step 3: Copy srcImage to dstImage
-	VkCommandBuffer commandBuffer = commandBuffers_->Begin(0);
-
-	// Define image copy region
-	VkImageCopy copyRegion{};
-	copyRegion.srcSubresource.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
-	copyRegion.srcSubresource.layerCount = 1;
-	copyRegion.dstSubresource.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
-	copyRegion.dstSubresource.layerCount = 1;
-	copyRegion.extent.width = srcImage.Extent().width;
-	copyRegion.extent.height = srcImage.Extent().height;
-	copyRegion.extent.depth = 1;
-
-	// Perform copy operation
-	vkCmdCopyImage(
-		commandBuffer,
-		srcImage.Handle(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-		dstImage.Handle(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-		1, &copyRegion
-	);
-
-	commandBuffers_->End(0);
-
-	// Submit command buffer
-	VkSubmitInfo submitInfo{};
-	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.waitSemaphoreCount = 1;
+	submitInfo.pWaitSemaphores = waitSemaphores;
+	submitInfo.pWaitDstStageMask = waitStages;
 	submitInfo.commandBufferCount = 1;
-	submitInfo.pCommandBuffers = &commandBuffer;
+	submitInfo.pCommandBuffers = commandBuffers;
+	submitInfo.signalSemaphoreCount = 1;
+	submitInfo.pSignalSemaphores = signalSemaphores;
 
-	VkFenceCreateInfo fenceInfo{};
-	fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-	VkFence fence;
-	vkCreateFence(device_->Handle(), &fenceInfo, nullptr, &fence);
+	frame.InFlightFence().Reset();
 
-	vkQueueSubmit(device_->GraphicsQueue(), 1, &submitInfo, fence);
-	vkWaitForFences(device_->Handle(), 1, &fence, VK_TRUE, UINT64_MAX);
+	Check(vkQueueSubmit(device_->GraphicsQueue(), 1, &submitInfo, frame.InFlightFence().Handle()),
+		"submit draw command buffer");
+}
 
-	vkDestroyFence(device_->Handle(), fence, nullptr);
+void Application::SubmitAsyncCompute(
+	FrameContext& frame,
+	VkCommandBuffer commandBuffer,
+	VkCommandBuffer presentCommandBuffer,
+	VkCommandBuffer computeCommandBuffer)
+{
+	// The graphics work of this frame hands over to the compute queue. The presentation waits for the compute work
+	// of the previous frame, which has been running on the compute queue while this frame's graphics work executes.
+	const auto& previousFrame = *frameContexts_[(currentFrame_ + frameContexts_.size() - 1) % frameContexts_.size()];
+
+	VkSemaphore graphicsSignalSemaphores[] = { frame.GraphicsFinishedSemaphore().Handle() };
+	VkSemaphore presentWaitSemaphores[] = { frame.ImageAvailableSemaphore().Handle(), previousFrame.ComputeFinishedSemaphore().Handle() };
+	VkPipelineStageFlags presentWaitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT };
+	VkSemaphore presentSignalSemaphores[] = { frame.RenderFinishedSemaphore().Handle() };
+
+	std::array<VkSubmitInfo, 2> submitInfos = {};
+
+	submitInfos[0].sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfos[0].commandBufferCount = 1;
+	submitInfos[0].pCommandBuffers = &commandBuffer;
+	submitInfos[0].signalSemaphoreCount = 1;
+	submitInfos[0].pSignalSemaphores = graphicsSignalSemaphores;
+
+	submitInfos[1].sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfos[1].waitSemaphoreCount = computeFramePending_ ? 2 : 1;
+	submitInfos[1].pWaitSemaphores = presentWaitSemaphores;
+	submitInfos[1].pWaitDstStageMask = presentWaitStages;
+	submitInfos[1].commandBufferCount = 1;
+	submitInfos[1].pCommandBuffers = &presentCommandBuffer;
+	submitInfos[1].signalSemaphoreCount = 1;
+	submitInfos[1].pSignalSemaphores = presentSignalSemaphores;
+
+	frame.InFlightFence().Reset();
+
+	Check(vkQueueSubmit(device_->GraphicsQueue(), static_cast<uint32_t>(submitInfos.size()), submitInfos.data(), frame.InFlightFence().Handle()),
+		"submit draw command buffers");
+
+	VkSemaphore computeWaitSemaphores[] = { frame.GraphicsFinishedSemaphore().Handle() };
+	VkPipelineStageFlags computeWaitStages[] = { VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT };
+	VkSemaphore computeSignalSemaphores[] = { frame.ComputeFinishedSemaphore().Handle() };
+
+	VkSubmitInfo computeSubmitInfo = {};
+	computeSubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	computeSubmitInfo.waitSemaphoreCount = 1;
+	computeSubmitInfo.pWaitSemaphores = computeWaitSemaphores;
+	computeSubmitInfo.pWaitDstStageMask = computeWaitStages;
+	computeSubmitInfo.commandBufferCount = 1;
+	computeSubmitInfo.pCommandBuffers = &computeCommandBuffer;
+	computeSubmitInfo.signalSemaphoreCount = 1;
+	computeSubmitInfo.pSignalSemaphores = computeSignalSemaphores;
+
+	frame.ComputeFence().Reset();
+
+	Check(vkQueueSubmit(device_->ComputeQueue(), 1, &computeSubmitInfo, frame.ComputeFence().Handle()),
+		"submit compute command buffer");
+
+	computeFramePending_ = true;
 }
 
 }
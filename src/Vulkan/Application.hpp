@@ -7,13 +7,13 @@
 #include "Image.hpp"
 #include "ImageView.hpp"
 #include "DepthBuffer.hpp"
+#include "FrameContext.hpp"
 #include "Utilities/Glm.hpp"
 
 namespace Assets
 {
 	class Scene;
 	class UniformBufferObject;
-	class UniformBuffer;
 }
 
 namespace Vulkan 
@@ -41,14 +41,24 @@ namespace Vulkan
 
 	protected:
 
-		Application(const WindowConfig& windowConfig, VkPresentModeKHR presentMode, bool enableValidationLayers);
+		Application(const WindowConfig& windowConfig, VkPresentModeKHR presentMode, uint32_t framesInFlight, bool enableValidationLayers);
 
 		const class Device& Device() const { return *device_; }
 		class CommandPool& CommandPool() { return *commandPool_; }
+		class Uploader& Uploader() { return *uploader_; }
+		const class PipelineCache& PipelineCache() const { return *pipelineCache_; }
 		const class DepthBuffer& DepthBuffer() const { return *depthBuffer_; }
-		const std::vector<Assets::UniformBuffer>& UniformBuffers() const { return uniformBuffers_; }
+		const std::vector<std::unique_ptr<FrameContext>>& FrameContexts() const { return frameContexts_; }
+		const FrameContext& CurrentFrame() const { return *frameContexts_[currentFrame_]; }
+		class UniformBufferArena& UniformBufferArena() { return *uniformBufferArena_; }
+		const class UniformBufferArena& UniformBufferArena() const { return *uniformBufferArena_; }
+
+		// Dynamic offset of the frame globals of the frame being recorded.
+		uint32_t UniformBufferOffset() const { return uniformBufferOffset_; }
 		const class GraphicsPipeline& GraphicsPipeline() const { return *graphicsPipeline_; }
 		const class FrameBuffer& SwapChainFrameBuffer(const size_t i) const { return swapChainFramebuffers_[i]; }
+		// Whether the frames of the current swap chain are split between the graphics and compute queues.
+		bool AsyncCompute() const { return asyncCompute_; }
 
 		virtual const Assets::Scene& GetScene() const = 0;
 		virtual Assets::UniformBufferObject GetUniformBufferObject(VkExtent2D extent) const = 0;
@@ -65,6 +75,19 @@ namespace Vulkan
 		virtual void DrawFrame();
 		virtual void Render(VkCommandBuffer commandBuffer, uint32_t imageIndex);
 
+		// With async compute, Render() only records the graphics work of the frame. RenderCompute() records the work
+		// submitted to the compute queue, overlapping the next frame's graphics work, and RenderPresent() records the
+		// presentation of the previous frame's compute result. Changing UseAsyncCompute() recreates the swap chain.
+		virtual bool UseAsyncCompute() const { return false; }
+		virtual void RenderCompute(VkCommandBuffer commandBuffer) { }
+		virtual void RenderPresent(VkCommandBuffer commandBuffer, uint32_t imageIndex) { }
+
+		// Whether the uploads go through a transfer-only queue family when the device has one, read once on device creation.
+		virtual bool UseDedicatedTransferQueue() const { return false; }
+
+		// Whether resources created along with the swap chain no longer match the settings, which recreates it.
+		virtual bool IsSwapChainOutdated() const { return false; }
+
 		virtual void OnKey(int key, int scancode, int action, int mods) { }
 		virtual void OnCursorPosition(double xpos, double ypos) { }
 		virtual void OnMouseButton(int button, int action, int mods) { }
@@ -75,21 +98,19 @@ namespace Vulkan
 		size_t currentFrame_{};
 
 		//Ҫڹ׷ٹʹõԴ
-		std::unique_ptr<class Vulkan::ImageView> saveImageView_;
 		std::unique_ptr<class Vulkan::ImageView> motionVectorImageView_;
 
 		std::unique_ptr<Vulkan::Sampler> motionVectorSampler_;
-		std::unique_ptr<Vulkan::Sampler> depthSampler_;
-
-		Vulkan::ImageView* first_depthImageview_;
-		Vulkan::ImageView* first_saveImageview_;
 
 	private:
 
-		void UpdateUniformBuffer(uint32_t imageIndex);
+		void UpdateUniformBuffer();
 		void RecreateSwapChain();
+		void Submit(FrameContext& frame, VkCommandBuffer commandBuffer);
+		void SubmitAsyncCompute(FrameContext& frame, VkCommandBuffer commandBuffer, VkCommandBuffer presentCommandBuffer, VkCommandBuffer computeCommandBuffer);
 
 		const VkPresentModeKHR presentMode_;
+		const uint32_t framesInFlight_;
 		
 		std::unique_ptr<class Window> window_;
 		std::unique_ptr<class Instance> instance_;
@@ -97,25 +118,17 @@ namespace Vulkan
 		std::unique_ptr<class Surface> surface_;
 		std::unique_ptr<class Device> device_;
 		std::unique_ptr<class SwapChain> swapChain_;
-		std::vector<Assets::UniformBuffer> uniformBuffers_;
 		std::unique_ptr<class DepthBuffer> depthBuffer_;
 		std::unique_ptr<class GraphicsPipeline> graphicsPipeline_;
 		std::vector<class FrameBuffer> swapChainFramebuffers_;
 		std::unique_ptr<class CommandPool> commandPool_;
-		std::unique_ptr<class CommandBuffers> commandBuffers_;
-		std::vector<class Semaphore> imageAvailableSemaphores_;
-		std::vector<class Semaphore> renderFinishedSemaphores_;
-		std::vector<class Fence> inFlightFences_;
-
-		void Application::CopyImage(Vulkan::Image& srcImage, Vulkan::Image& dstImage);
-		void Application::CopyDepthImage(Vulkan::Image& srcImage, Vulkan::Image& dstImage);
-
- 		std::unique_ptr<class Vulkan::Image> saveImage_;
-		std::unique_ptr<Vulkan::DeviceMemory> saveImageMemory_;
-
-		std::unique_ptr<class Vulkan::Image> depthImage_;
-		std::unique_ptr<Vulkan::DeviceMemory> depthImageMemory_;
-		std::unique_ptr<class Vulkan::ImageView> depthImageView_;
+		std::unique_ptr<class Uploader> uploader_;
+		std::unique_ptr<class PipelineCache> pipelineCache_;
+		std::unique_ptr<class UniformBufferArena> uniformBufferArena_;
+		std::vector<std::unique_ptr<FrameContext>> frameContexts_;
+		uint32_t uniformBufferOffset_{};
+		bool asyncCompute_{};
+		bool computeFramePending_{};
 
 		std::unique_ptr<class Vulkan::Image> motionVectorImage_;
 		std::unique_ptr<Vulkan::DeviceMemory> motionVectorImageMemory_;
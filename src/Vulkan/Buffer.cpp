@@ -1,4 +1,5 @@
 #include "Buffer.hpp"
+#include "Device.hpp"
 #include "SingleTimeCommands.hpp"
 
 namespace Vulkan {
@@ -25,17 +26,31 @@ Buffer::~Buffer()
 	}
 }
 
-DeviceMemory Buffer::AllocateMemory(const VkMemoryPropertyFlags propertyFlags)
+DeviceMemory Buffer::AllocateMemory(const VkMemoryPropertyFlags propertyFlags, const MemoryAllocator::Category category)
 {
-	return AllocateMemory(0, propertyFlags);
+	return AllocateMemory(0, propertyFlags, category);
 }
 
-DeviceMemory Buffer::AllocateMemory(const VkMemoryAllocateFlags allocateFlags, const VkMemoryPropertyFlags propertyFlags)
+DeviceMemory Buffer::AllocateMemory(const VkMemoryAllocateFlags allocateFlags, const VkMemoryPropertyFlags propertyFlags, const MemoryAllocator::Category category)
+{
+	return AllocateMemory(MemoryAllocator::Strategy::General, category, allocateFlags, propertyFlags);
+}
+
+DeviceMemory Buffer::AllocateTransientMemory(const VkMemoryPropertyFlags propertyFlags)
+{
+	return AllocateMemory(MemoryAllocator::Strategy::Linear, MemoryAllocator::Category::Staging, 0, propertyFlags);
+}
+
+DeviceMemory Buffer::AllocateMemory(
+	const MemoryAllocator::Strategy strategy,
+	const MemoryAllocator::Category category,
+	const VkMemoryAllocateFlags allocateFlags,
+	const VkMemoryPropertyFlags propertyFlags)
 {
 	const auto requirements = GetMemoryRequirements();
-	DeviceMemory memory(device_, requirements.size, requirements.memoryTypeBits, allocateFlags, propertyFlags);
+	DeviceMemory memory(device_, device_.Allocator().Allocate(requirements, MemoryAllocator::ResourceKind::Buffer, strategy, category, false, allocateFlags, propertyFlags));
 
-	Check(vkBindBufferMemory(device_.Handle(), buffer_, memory.Handle(), 0),
+	Check(vkBindBufferMemory(device_.Handle(), buffer_, memory.Handle(), memory.Offset()),
 		"bind buffer memory");
 
 	return memory;
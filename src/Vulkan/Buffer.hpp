@@ -20,8 +20,13 @@ namespace Vulkan
 
 		const class Device& Device() const { return device_; }
 
-		DeviceMemory AllocateMemory(VkMemoryPropertyFlags propertyFlags);
-		DeviceMemory AllocateMemory(VkMemoryAllocateFlags allocateFlags, VkMemoryPropertyFlags propertyFlags);
+		// The category only tags the memory for the per subsystem accounting.
+		DeviceMemory AllocateMemory(VkMemoryPropertyFlags propertyFlags, MemoryAllocator::Category category = MemoryAllocator::Category::Other);
+		DeviceMemory AllocateMemory(VkMemoryAllocateFlags allocateFlags, VkMemoryPropertyFlags propertyFlags, MemoryAllocator::Category category = MemoryAllocator::Category::Other);
+
+		// Memory from the linear pools, for staging and readback buffers released shortly after use.
+		DeviceMemory AllocateTransientMemory(VkMemoryPropertyFlags propertyFlags);
+
 		VkMemoryRequirements GetMemoryRequirements() const;
 		VkDeviceAddress GetDeviceAddress() const;
 
@@ -29,6 +34,8 @@ namespace Vulkan
 
 	private:
 
+		DeviceMemory AllocateMemory(MemoryAllocator::Strategy strategy, MemoryAllocator::Category category, VkMemoryAllocateFlags allocateFlags, VkMemoryPropertyFlags propertyFlags);
+
 		const class Device& device_;
 
 		VULKAN_HANDLE(VkBuffer, buffer_)
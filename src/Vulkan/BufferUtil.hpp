@@ -4,6 +4,7 @@
 #include "CommandPool.hpp"
 #include "Device.hpp"
 #include "DeviceMemory.hpp"
+#include "Uploader.hpp"
 #include <cstring>
 #include <memory>
 #include <string>
@@ -19,6 +20,7 @@ namespace Vulkan
 		template <class T>
 		static void CopyFromStagingBuffer(CommandPool& commandPool, Buffer& dstBuffer, const std::vector<T>& content);
 
+		// Device local buffers holding the given content, accounted as scene geometry unless told otherwise.
 		template <class T>
 		static void CreateDeviceBuffer(
 			CommandPool& commandPool,
@@ -26,7 +28,30 @@ namespace Vulkan
 			VkBufferUsageFlags usage,
 			const std::vector<T>& content,
 			std::unique_ptr<Buffer>& buffer,
-			std::unique_ptr<DeviceMemory>& memory);
+			std::unique_ptr<DeviceMemory>& memory,
+			MemoryAllocator::Category category = MemoryAllocator::Category::Geometry);
+
+		// Records the upload into the batch, the content is on the device once the uploader has been flushed.
+		template <class T>
+		static void CreateDeviceBuffer(
+			Uploader& uploader,
+			const char* name,
+			VkBufferUsageFlags usage,
+			const std::vector<T>& content,
+			std::unique_ptr<Buffer>& buffer,
+			std::unique_ptr<DeviceMemory>& memory,
+			MemoryAllocator::Category category = MemoryAllocator::Category::Geometry);
+
+	private:
+
+		static void CreateDeviceBuffer(
+			const Device& device,
+			const char* name,
+			VkBufferUsageFlags usage,
+			size_t size,
+			std::unique_ptr<Buffer>& buffer,
+			std::unique_ptr<DeviceMemory>& memory,
+			MemoryAllocator::Category category);
 	};
 
 	template <class T>
@@ -37,7 +62,7 @@ namespace Vulkan
 		
 		// Create a temporary host-visible staging buffer.
 		auto stagingBuffer = std::make_unique<Buffer>(device, contentSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
-		auto stagingBufferMemory = stagingBuffer->AllocateMemory(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		auto stagingBufferMemory = stagingBuffer->AllocateTransientMemory(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
 
 		// Copy the host data into the staging buffer.
 		const auto data = stagingBufferMemory.Map(0, contentSize);
@@ -58,21 +83,45 @@ namespace Vulkan
 		const VkBufferUsageFlags usage, 
 		const std::vector<T>& content,
 		std::unique_ptr<Buffer>& buffer,
-		std::unique_ptr<DeviceMemory>& memory)
+		std::unique_ptr<DeviceMemory>& memory,
+		const MemoryAllocator::Category category)
+	{
+		CreateDeviceBuffer(commandPool.Device(), name, usage, sizeof(content[0]) * content.size(), buffer, memory, category);
+		CopyFromStagingBuffer(commandPool, *buffer, content);
+	}
+
+	template <class T>
+	void BufferUtil::CreateDeviceBuffer(
+		Uploader& uploader,
+		const char* const name,
+		const VkBufferUsageFlags usage,
+		const std::vector<T>& content,
+		std::unique_ptr<Buffer>& buffer,
+		std::unique_ptr<DeviceMemory>& memory,
+		const MemoryAllocator::Category category)
+	{
+		CreateDeviceBuffer(uploader.Device(), name, usage, sizeof(content[0]) * content.size(), buffer, memory, category);
+		uploader.UploadBuffer(*buffer, content);
+	}
+
+	inline void BufferUtil::CreateDeviceBuffer(
+		const Device& device,
+		const char* const name,
+		const VkBufferUsageFlags usage,
+		const size_t size,
+		std::unique_ptr<Buffer>& buffer,
+		std::unique_ptr<DeviceMemory>& memory,
+		const MemoryAllocator::Category category)
 	{
-		const auto& device = commandPool.Device();
 		const auto& debugUtils = device.DebugUtils();
-		const auto contentSize = sizeof(content[0]) * content.size();
 		const VkMemoryAllocateFlags allocateFlags = usage & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT
 			? VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT
 			: 0;
 
-		buffer.reset(new Buffer(device, contentSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | usage));
-		memory.reset(new DeviceMemory(buffer->AllocateMemory(allocateFlags, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)));
+		buffer.reset(new Buffer(device, size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | usage));
+		memory.reset(new DeviceMemory(buffer->AllocateMemory(allocateFlags, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, category)));
 
 		debugUtils.SetObjectName(buffer->Handle(), (name + std::string(" Buffer")).c_str());
 		debugUtils.SetObjectName(memory->Handle(), (name + std::string(" Memory")).c_str());
-
-		CopyFromStagingBuffer(commandPool, *buffer, content);
 	}
 }
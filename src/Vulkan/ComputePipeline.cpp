@@ -0,0 +1,40 @@
+#include "ComputePipeline.hpp"
+#include "Device.hpp"
+#include "PipelineCache.hpp"
+#include "PipelineLayout.hpp"
+#include "ShaderModule.hpp"
+#include "SpecializationConstants.hpp"
+
+namespace Vulkan {
+
+ComputePipeline::ComputePipeline(
+	const PipelineCache& pipelineCache,
+	const class PipelineLayout& pipelineLayout,
+	const std::string& shaderFilename,
+	const SpecializationConstants& specializationConstants) :
+	device_(pipelineCache.Device()),
+	pipelineLayout_(pipelineLayout)
+{
+	const ShaderModule computeShader(device_, shaderFilename);
+
+	VkComputePipelineCreateInfo pipelineInfo = {};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipelineInfo.stage = computeShader.CreateShaderStage(VK_SHADER_STAGE_COMPUTE_BIT, specializationConstants.Info());
+	pipelineInfo.layout = pipelineLayout.Handle();
+	pipelineInfo.basePipelineHandle = nullptr;
+	pipelineInfo.basePipelineIndex = -1;
+
+	Check(vkCreateComputePipelines(device_.Handle(), pipelineCache.Handle(), 1, &pipelineInfo, nullptr, &pipeline_),
+		"create compute pipeline");
+}
+
+ComputePipeline::~ComputePipeline()
+{
+	if (pipeline_ != nullptr)
+	{
+		vkDestroyPipeline(device_.Handle(), pipeline_, nullptr);
+		pipeline_ = nullptr;
+	}
+}
+
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "Vulkan.hpp"
+#include <string>
+
+namespace Vulkan
+{
+	class Device;
+	class PipelineCache;
+	class PipelineLayout;
+	class SpecializationConstants;
+
+	class ComputePipeline final
+	{
+	public:
+
+		VULKAN_NON_COPIABLE(ComputePipeline)
+
+		ComputePipeline(
+			const PipelineCache& pipelineCache,
+			const PipelineLayout& pipelineLayout,
+			const std::string& shaderFilename,
+			const SpecializationConstants& specializationConstants);
+		~ComputePipeline();
+
+		const class Device& Device() const { return device_; }
+		const class PipelineLayout& PipelineLayout() const { return pipelineLayout_; }
+
+	private:
+
+		const class Device& device_;
+		const class PipelineLayout& pipelineLayout_;
+
+		VULKAN_HANDLE(VkPipeline, pipeline_)
+	};
+
+}
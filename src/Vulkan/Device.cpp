@@ -1,9 +1,11 @@
 #include "Device.hpp"
 #include "Enumerate.hpp"
 #include "Instance.hpp"
+#include "MemoryAllocator.hpp"
 #include "Surface.hpp"
 #include "Utilities/Exception.hpp"
 #include <algorithm>
+#include <cstring>
 #include <set>
 
 namespace Vulkan {
@@ -38,7 +40,8 @@ Device::Device(
 	const class Surface& surface, 
 	const std::vector<const char*>& requiredExtensions,
 	const VkPhysicalDeviceFeatures& deviceFeatures,
-	const void* nextDeviceFeatures) :
+	const void* nextDeviceFeatures,
+	const bool dedicatedTransferQueue) :
 	physicalDevice_(physicalDevice),
 	surface_(surface),
 	debugUtils_(surface.Instance().Handle())
@@ -51,9 +54,15 @@ Device::Device(
 	const auto graphicsFamily = FindQueue(queueFamilies, "graphics", VK_QUEUE_GRAPHICS_BIT, 0);
 	const auto computeFamily = FindQueue(queueFamilies, "compute", VK_QUEUE_COMPUTE_BIT, VK_QUEUE_GRAPHICS_BIT);
 
-	//Commented out the dedicated transfer queue, as it's never used (relic from Vulkan tutorial) 
-	//and causes problems with RADV (see https://github.com/NVIDIA/Q2RTX/issues/147).
-	//const auto transferFamily = FindQueue(queueFamilies, "transfer", VK_QUEUE_TRANSFER_BIT, VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT);
+	// The dedicated transfer queue is opt-in as it causes problems with RADV (see https://github.com/NVIDIA/Q2RTX/issues/147).
+	// Without it, or without a transfer-only family, the transfers go through the graphics queue.
+	const auto transferFamily = std::find_if(queueFamilies.begin(), queueFamilies.end(), [](const VkQueueFamilyProperties& queueFamily)
+	{
+		return
+			queueFamily.queueCount > 0 &&
+			queueFamily.queueFlags & VK_QUEUE_TRANSFER_BIT &&
+			!(queueFamily.queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT));
+	});
 
 	// Find the presentation queue (usually the same as graphics queue).
 	const auto presentFamily = std::find_if(queueFamilies.begin(), queueFamilies.end(), [&](const VkQueueFamilyProperties& queueFamily)
@@ -72,7 +81,11 @@ Device::Device(
 	graphicsFamilyIndex_ = static_cast<uint32_t>(graphicsFamily - queueFamilies.begin());
 	computeFamilyIndex_ = static_cast<uint32_t>(computeFamily - queueFamilies.begin());
 	presentFamilyIndex_ = static_cast<uint32_t>(presentFamily - queueFamilies.begin());
-	//transferFamilyIndex_ = static_cast<uint32_t>(transferFamily - queueFamilies.begin());
+	transferFamilyIndex_ = dedicatedTransferQueue && transferFamily != queueFamilies.end()
+		? static_cast<uint32_t>(transferFamily - queueFamilies.begin())
+		: graphicsFamilyIndex_;
+
+	transferImageGranularity_ = queueFamilies[transferFamilyIndex_].minImageTransferGranularity;
 
 	// Queues can be the same
 	const std::set<uint32_t> uniqueQueueFamilies =
@@ -80,7 +93,7 @@ Device::Device(
 		graphicsFamilyIndex_,
 		computeFamilyIndex_,
 		presentFamilyIndex_,
-		//transferFamilyIndex_
+		transferFamilyIndex_
 	};
 
 	// Create queues
@@ -118,11 +131,20 @@ Device::Device(
 	vkGetDeviceQueue(device_, graphicsFamilyIndex_, 0, &graphicsQueue_);
 	vkGetDeviceQueue(device_, computeFamilyIndex_, 0, &computeQueue_);
 	vkGetDeviceQueue(device_, presentFamilyIndex_, 0, &presentQueue_);
-	//vkGetDeviceQueue(device_, transferFamilyIndex_, 0, &transferQueue_);
+	vkGetDeviceQueue(device_, transferFamilyIndex_, 0, &transferQueue_);
+
+	const bool memoryBudget = std::any_of(requiredExtensions.begin(), requiredExtensions.end(), [](const char* extension)
+	{
+		return std::strcmp(extension, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) == 0;
+	});
+
+	allocator_.reset(new MemoryAllocator(*this, memoryBudget));
 }
 
 Device::~Device()
 {
+	allocator_.reset();
+
 	if (device_ != nullptr)
 	{
 		vkDestroyDevice(device_, nullptr);
@@ -2,10 +2,12 @@
 
 #include "DebugUtils.hpp"
 #include "Vulkan.hpp"
+#include <memory>
 #include <vector>
 
 namespace Vulkan
 {
+	class MemoryAllocator;
 	class Surface;
 
 	class Device final
@@ -19,7 +21,8 @@ namespace Vulkan
 			const Surface& surface, 
 			const std::vector<const char*>& requiredExtensionsconst,
 			const VkPhysicalDeviceFeatures& deviceFeatures,
-			const void* nextDeviceFeatures);
+			const void* nextDeviceFeatures,
+			bool dedicatedTransferQueue);
 		
 		~Device();
 
@@ -27,16 +30,23 @@ namespace Vulkan
 		const class Surface& Surface() const { return surface_; }
 
 		const class DebugUtils& DebugUtils() const { return debugUtils_; }
+		class MemoryAllocator& Allocator() const { return *allocator_; }
 
 		uint32_t GraphicsFamilyIndex() const { return graphicsFamilyIndex_; }
 		uint32_t ComputeFamilyIndex() const { return computeFamilyIndex_; }
 		uint32_t PresentFamilyIndex() const { return presentFamilyIndex_; }
-		//uint32_t TransferFamilyIndex() const { return transferFamilyIndex_; }
+		uint32_t TransferFamilyIndex() const { return transferFamilyIndex_; }
 		
 		VkQueue GraphicsQueue() const { return graphicsQueue_; }
 		VkQueue ComputeQueue() const { return computeQueue_; }
 		VkQueue PresentQueue() const { return presentQueue_; }
-		//VkQueue TransferQueue() const { return transferQueue_; }
+		VkQueue TransferQueue() const { return transferQueue_; }
+
+		// Whether the transfer queue belongs to a transfer-only family, otherwise it is the graphics queue.
+		bool HasDedicatedTransferQueue() const { return transferFamilyIndex_ != graphicsFamilyIndex_; }
+
+		// Granularity of the image copies on the transfer queue, (0, 0, 0) when only whole images can be copied.
+		const VkExtent3D& TransferImageGranularity() const { return transferImageGranularity_; }
 
 		void WaitIdle() const;
 
@@ -50,16 +60,19 @@ namespace Vulkan
 		VULKAN_HANDLE(VkDevice, device_)
 
 		class DebugUtils debugUtils_;
+		std::unique_ptr<class MemoryAllocator> allocator_;
 
 		uint32_t graphicsFamilyIndex_ {};
 		uint32_t computeFamilyIndex_{};
 		uint32_t presentFamilyIndex_{};
-		//uint32_t transferFamilyIndex_{};
+		uint32_t transferFamilyIndex_{};
 
 		VkQueue graphicsQueue_{};
 		VkQueue computeQueue_{};
 		VkQueue presentQueue_{};
-		//VkQueue transferQueue_{};
+		VkQueue transferQueue_{};
+
+		VkExtent3D transferImageGranularity_{};
 	};
 
 }
@@ -4,73 +4,58 @@
 
 namespace Vulkan {
 
-DeviceMemory::DeviceMemory(
-	const class Device& device, 
-	const size_t size, 
-	const uint32_t memoryTypeBits,
-	const VkMemoryAllocateFlags allocateFLags,
-	const VkMemoryPropertyFlags propertyFlags) :
-	device_(device)
+DeviceMemory::DeviceMemory(const class Device& device, const MemoryAllocator::Allocation& allocation) :
+	device_(device),
+	allocation_(allocation)
 {
-	VkMemoryAllocateFlagsInfo flagsInfo = {};
-	flagsInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO;
-	flagsInfo.pNext = nullptr;
-	flagsInfo.flags = allocateFLags;
-	
-	VkMemoryAllocateInfo allocInfo = {};
-	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	allocInfo.pNext = &flagsInfo;
-	allocInfo.allocationSize = size;
-	allocInfo.memoryTypeIndex = FindMemoryType(memoryTypeBits, propertyFlags);
-
-	Check(vkAllocateMemory(device.Handle(), &allocInfo, nullptr, &memory_),
-		"allocate memory");
 }
 
 DeviceMemory::DeviceMemory(DeviceMemory&& other) noexcept :
 	device_(other.device_),
-	memory_(other.memory_)
+	allocation_(other.allocation_),
+	mapped_(other.mapped_)
 {
-	other.memory_ = nullptr;
+	other.allocation_ = {};
+	other.mapped_ = false;
 }
 
 DeviceMemory::~DeviceMemory()
 {
-	if (memory_ != nullptr)
+	if (allocation_.Owner != nullptr)
 	{
-		vkFreeMemory(device_.Handle(), memory_, nullptr);
-		memory_ = nullptr;
+		Unmap();
+		device_.Allocator().Free(allocation_);
+		allocation_ = {};
 	}
 }
 
 void* DeviceMemory::Map(const size_t offset, const size_t size)
 {
-	void* data;
-	Check(vkMapMemory(device_.Handle(), memory_, offset, size, 0, &data),
-		"map memory");
+	if (offset + size > allocation_.Size)
+	{
+		Throw(std::out_of_range("mapped range exceeds the memory allocation"));
+	}
 
-	return data;
-}
+	// The allocator keeps the whole block mapped, only count one mapping per allocation.
+	void* const data = device_.Allocator().Map(allocation_);
 
-void DeviceMemory::Unmap()
-{
-	vkUnmapMemory(device_.Handle(), memory_);
+	if (mapped_)
+	{
+		device_.Allocator().Unmap(allocation_);
+	}
+
+	mapped_ = true;
+
+	return static_cast<uint8_t*>(data) + offset;
 }
 
-uint32_t DeviceMemory::FindMemoryType(const uint32_t typeFilter, const VkMemoryPropertyFlags propertyFlags) const
+void DeviceMemory::Unmap()
 {
-	VkPhysicalDeviceMemoryProperties memProperties;
-	vkGetPhysicalDeviceMemoryProperties(device_.PhysicalDevice(), &memProperties);
-
-	for (uint32_t i = 0; i != memProperties.memoryTypeCount; ++i)
+	if (mapped_)
 	{
-		if ((typeFilter & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & propertyFlags) == propertyFlags)
-		{
-			return i;
-		}
+		device_.Allocator().Unmap(allocation_);
+		mapped_ = false;
 	}
-
-	Throw(std::runtime_error("failed to find suitable memory type"));
 }
 
 }
@@ -1,11 +1,13 @@
 #pragma once
 
 #include "Vulkan.hpp"
+#include "MemoryAllocator.hpp"
 
 namespace Vulkan
 {
 	class Device;
 
+	// Owns a range of memory sub-allocated by the device's MemoryAllocator, returned to it on destruction.
 	class DeviceMemory final
 	{
 	public:
@@ -14,22 +16,26 @@ namespace Vulkan
 		DeviceMemory& operator = (const DeviceMemory&) = delete;
 		DeviceMemory& operator = (DeviceMemory&&) = delete;
 
-		DeviceMemory(const Device& device, size_t size, uint32_t memoryTypeBits, VkMemoryAllocateFlags allocateFLags, VkMemoryPropertyFlags propertyFlags);
+		DeviceMemory(const Device& device, const MemoryAllocator::Allocation& allocation);
 		DeviceMemory(DeviceMemory&& other) noexcept;
 		~DeviceMemory();
 
 		const class Device& Device() const { return device_; }
 
+		// Memory object holding the range, shared with other resources unless the allocation is dedicated.
+		VkDeviceMemory Handle() const { return allocation_.Memory; }
+		VkDeviceSize Offset() const { return allocation_.Offset; }
+		VkDeviceSize Size() const { return allocation_.Size; }
+
+		// Offset is relative to the start of the range.
 		void* Map(size_t offset, size_t size);
 		void Unmap();
 
 	private:
 
-		uint32_t FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
-
 		const class Device& device_;
-
-		VULKAN_HANDLE(VkDeviceMemory, memory_)
+		MemoryAllocator::Allocation allocation_;
+		bool mapped_{};
 	};
 
 }
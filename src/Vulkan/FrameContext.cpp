@@ -0,0 +1,69 @@
+#include "FrameContext.hpp"
+#include "CommandBuffers.hpp"
+#include "CommandPool.hpp"
+#include "Device.hpp"
+#include "Fence.hpp"
+#include "Semaphore.hpp"
+
+namespace Vulkan {
+
+FrameContext::FrameContext(const class Device& device, const uint32_t index) :
+	index_(index)
+{
+	commandPool_.reset(new class CommandPool(device, device.GraphicsFamilyIndex(), true));
+	commandBuffers_.reset(new CommandBuffers(*commandPool_, 2));
+	computeCommandPool_.reset(new class CommandPool(device, device.ComputeFamilyIndex(), true));
+	computeCommandBuffers_.reset(new CommandBuffers(*computeCommandPool_, 1));
+	imageAvailableSemaphore_.reset(new Semaphore(device));
+	renderFinishedSemaphore_.reset(new Semaphore(device));
+	graphicsFinishedSemaphore_.reset(new Semaphore(device));
+	computeFinishedSemaphore_.reset(new Semaphore(device));
+	inFlightFence_.reset(new Fence(device, true));
+	computeFence_.reset(new Fence(device, true));
+}
+
+FrameContext::~FrameContext()
+{
+	computeFence_.reset();
+	inFlightFence_.reset();
+	computeFinishedSemaphore_.reset();
+	graphicsFinishedSemaphore_.reset();
+	renderFinishedSemaphore_.reset();
+	imageAvailableSemaphore_.reset();
+	computeCommandBuffers_.reset();
+	computeCommandPool_.reset();
+	commandBuffers_.reset();
+	commandPool_.reset();
+}
+
+VkCommandBuffer FrameContext::BeginCommandBuffer()
+{
+	return commandBuffers_->Begin(0);
+}
+
+void FrameContext::EndCommandBuffer()
+{
+	commandBuffers_->End(0);
+}
+
+VkCommandBuffer FrameContext::BeginPresentCommandBuffer()
+{
+	return commandBuffers_->Begin(1);
+}
+
+void FrameContext::EndPresentCommandBuffer()
+{
+	commandBuffers_->End(1);
+}
+
+VkCommandBuffer FrameContext::BeginComputeCommandBuffer()
+{
+	return computeCommandBuffers_->Begin(0);
+}
+
+void FrameContext::EndComputeCommandBuffer()
+{
+	computeCommandBuffers_->End(0);
+}
+
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "Vulkan.hpp"
+#include <memory>
+
+namespace Vulkan
+{
+	class CommandBuffers;
+	class CommandPool;
+	class Device;
+	class Fence;
+	class Semaphore;
+
+	// Everything needed to record and submit one frame while other frames are still in flight.
+	// The application cycles through a small ring of contexts, independently of the number of swap chain images,
+	// and waits for a context's fence before reusing it. The context index also selects its slice of the
+	// uniform buffer arena.
+	// With async compute a frame is submitted in three parts: the graphics work, the compute work on the compute queue,
+	// and the presentation of the previous frame's compute result back on the graphics queue.
+	class FrameContext final
+	{
+	public:
+
+		VULKAN_NON_COPIABLE(FrameContext)
+
+		FrameContext(const Device& device, uint32_t index);
+		~FrameContext();
+
+		uint32_t Index() const { return index_; }
+
+		const Semaphore& ImageAvailableSemaphore() const { return *imageAvailableSemaphore_; }
+		const Semaphore& RenderFinishedSemaphore() const { return *renderFinishedSemaphore_; }
+		Fence& InFlightFence() { return *inFlightFence_; }
+
+		// Async compute synchronisation: graphics work to compute work, compute work to the next frame's presentation.
+		const Semaphore& GraphicsFinishedSemaphore() const { return *graphicsFinishedSemaphore_; }
+		const Semaphore& ComputeFinishedSemaphore() const { return *computeFinishedSemaphore_; }
+		Fence& ComputeFence() { return *computeFence_; }
+
+		// The command buffers are implicitly reset when recording begins, the caller must have waited on the fences.
+		VkCommandBuffer BeginCommandBuffer();
+		void EndCommandBuffer();
+		VkCommandBuffer BeginPresentCommandBuffer();
+		void EndPresentCommandBuffer();
+		VkCommandBuffer BeginComputeCommandBuffer();
+		void EndComputeCommandBuffer();
+
+	private:
+
+		const uint32_t index_;
+
+		std::unique_ptr<class CommandPool> commandPool_;
+		std::unique_ptr<CommandBuffers> commandBuffers_;
+		std::unique_ptr<class CommandPool> computeCommandPool_;
+		std::unique_ptr<CommandBuffers> computeCommandBuffers_;
+		std::unique_ptr<Semaphore> imageAvailableSemaphore_;
+		std::unique_ptr<Semaphore> renderFinishedSemaphore_;
+		std::unique_ptr<Semaphore> graphicsFinishedSemaphore_;
+		std::unique_ptr<Semaphore> computeFinishedSemaphore_;
+		std::unique_ptr<Fence> inFlightFence_;
+		std::unique_ptr<Fence> computeFence_;
+	};
+
+}
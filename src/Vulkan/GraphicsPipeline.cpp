@@ -8,6 +8,7 @@
 #include "RenderPass.hpp"
 #include "ShaderModule.hpp"
 #include "SwapChain.hpp"
+#include "UniformBufferArena.hpp"
 #include "Assets/Scene.hpp"
 #include "Assets/UniformBuffer.hpp"
 #include "Assets/Vertex.hpp"
@@ -17,10 +18,8 @@ namespace Vulkan {
 GraphicsPipeline::GraphicsPipeline(
 	const SwapChain& swapChain, 
 	const DepthBuffer& depthBuffer,
-	const std::vector<Assets::UniformBuffer>& uniformBuffers,
+	const UniformBufferArena& uniformBufferArena,
 	const Assets::Scene& scene,
-	const ImageView& depthImageView,
-	const Sampler& depthSampler,
 	const bool isWireFrame) :
 	swapChain_(swapChain),
 	isWireFrame_(isWireFrame)
@@ -121,56 +120,45 @@ GraphicsPipeline::GraphicsPipeline(
 	// Create descriptor pool/sets.
 	std::vector<DescriptorBinding> descriptorBindings =
 	{
-		{0, 1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT},
+		{0, 1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT},
 		{1, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT},
-		{2, static_cast<uint32_t>(scene.TextureSamplers().size()), VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT},
-		{3, 1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT}
+		{2, static_cast<uint32_t>(scene.TextureSamplers().size()), VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT}
 	};
 
-	descriptorSetManager_.reset(new DescriptorSetManager(device, descriptorBindings, uniformBuffers.size()));
+	descriptorSetManager_.reset(new DescriptorSetManager(device, descriptorBindings, 1));
 
 	auto& descriptorSets = descriptorSetManager_->DescriptorSets();
 
-	for (uint32_t i = 0; i != swapChain.Images().size(); ++i)
+	// Uniform buffer
+	VkDescriptorBufferInfo uniformBufferInfo = {};
+	uniformBufferInfo.buffer = uniformBufferArena.Buffer().Handle();
+	uniformBufferInfo.range = sizeof(Assets::UniformBufferObject);
+
+	// Material buffer
+	VkDescriptorBufferInfo materialBufferInfo = {};
+	materialBufferInfo.buffer = scene.MaterialBuffer().Handle();
+	materialBufferInfo.range = VK_WHOLE_SIZE;
+
+	// Image and texture samplers
+	std::vector<VkDescriptorImageInfo> imageInfos(scene.TextureSamplers().size());
+
+	for (size_t t = 0; t != imageInfos.size(); ++t)
 	{
-		// Uniform buffer
-		VkDescriptorBufferInfo uniformBufferInfo = {};
-		uniformBufferInfo.buffer = uniformBuffers[i].Buffer().Handle();
-		uniformBufferInfo.range = VK_WHOLE_SIZE;
-
-		// Material buffer
-		VkDescriptorBufferInfo materialBufferInfo = {};
-		materialBufferInfo.buffer = scene.MaterialBuffer().Handle();
-		materialBufferInfo.range = VK_WHOLE_SIZE;
-
-		//DepthImage buffer
-		VkDescriptorImageInfo depthImageInfo = {};
-		depthImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
-		depthImageInfo.imageView = depthImageView.Handle();
-		depthImageInfo.sampler = depthSampler.Handle();
-
-		// Image and texture samplers
-		std::vector<VkDescriptorImageInfo> imageInfos(scene.TextureSamplers().size());
-
-		for (size_t t = 0; t != imageInfos.size(); ++t)
-		{
-			auto& imageInfo = imageInfos[t];
-			imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-			imageInfo.imageView = scene.TextureImageViews()[t];
-			imageInfo.sampler = scene.TextureSamplers()[t];
-		}
-
-		const std::vector<VkWriteDescriptorSet> descriptorWrites =
-		{
-			descriptorSets.Bind(i, 0, uniformBufferInfo),
-			descriptorSets.Bind(i, 1, materialBufferInfo),
-			descriptorSets.Bind(i, 2, *imageInfos.data(), static_cast<uint32_t>(imageInfos.size())),
-			descriptorSets.Bind(i, 3, depthImageInfo)
-		};
-
-		descriptorSets.UpdateDescriptors(i, descriptorWrites);
+		auto& imageInfo = imageInfos[t];
+		imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		imageInfo.imageView = scene.TextureImageViews()[t];
+		imageInfo.sampler = scene.TextureSamplers()[t];
 	}
 
+	const std::vector<VkWriteDescriptorSet> descriptorWrites =
+	{
+		descriptorSets.Bind(0, 0, uniformBufferInfo),
+		descriptorSets.Bind(0, 1, materialBufferInfo),
+		descriptorSets.Bind(0, 2, *imageInfos.data(), static_cast<uint32_t>(imageInfos.size()))
+	};
+
+	descriptorSets.UpdateDescriptors(0, descriptorWrites);
+
 	// Create pipeline layout and render pass.
 	pipelineLayout_.reset(new class PipelineLayout(device, descriptorSetManager_->DescriptorSetLayout()));
 	renderPass_.reset(new class RenderPass(swapChain, depthBuffer, VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_LOAD_OP_CLEAR));
@@ -9,7 +9,6 @@
 namespace Assets
 {
 	class Scene;
-	class UniformBuffer;
 }
 
 namespace Vulkan
@@ -18,6 +17,7 @@ namespace Vulkan
 	class PipelineLayout;
 	class RenderPass;
 	class SwapChain;
+	class UniformBufferArena;
 	class Sampler;
 	class ImageView;
 
@@ -30,10 +30,8 @@ namespace Vulkan
 		GraphicsPipeline(
 			const SwapChain& swapChain, 
 			const DepthBuffer& depthBuffer,
-			const std::vector<Assets::UniformBuffer>& uniformBuffers,
+			const UniformBufferArena& uniformBufferArena,
 			const Assets::Scene& scene,
-			const ImageView& depthImageView,
-			const Sampler& depthSampler,
 			bool isWireFrame);
 		~GraphicsPipeline();
 
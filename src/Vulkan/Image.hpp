@@ -19,8 +19,6 @@ namespace Vulkan
 
 		Image(const Device& device, VkExtent2D extent, VkFormat format);
 		Image(const Device& device, VkExtent2D extent, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage);
-		Image(const Device& device, VkExtent2D extent, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, bool isManaged_);
-		Image(const Device& device, const VkExtent2D extent, const VkFormat format, const VkImageTiling tiling, const VkImageUsageFlags usage, const VkImage image, bool isManaged_);
 		Image(Image&& other) noexcept;
 		~Image();
 
@@ -28,15 +26,23 @@ namespace Vulkan
 		VkExtent2D Extent() const { return extent_; }
 		VkFormat Format() const { return format_; }
 
-		DeviceMemory AllocateMemory(VkMemoryPropertyFlags properties) const;
+		DeviceMemory AllocateMemory(VkMemoryPropertyFlags properties, MemoryAllocator::Category category = MemoryAllocator::Category::Other) const;
 		VkMemoryRequirements GetMemoryRequirements() const;
 
+		// Binds memory owned elsewhere, offset from the start of its range.
+		void BindMemory(const DeviceMemory& memory, VkDeviceSize offset) const;
+
 		void TransitionImageLayout(CommandPool& commandPool, VkImageLayout newLayout, bool depth);//תͼʽ
 		void CopyFrom(CommandPool& commandPool, const Buffer& buffer);//һݸƵͼ
 
-	private:
+		//ڸм¼ύ
+		void TransitionImageLayout(VkCommandBuffer commandBuffer, VkImageLayout newLayout, bool depth);
+		void CopyFrom(VkCommandBuffer commandBuffer, const Buffer& buffer, VkDeviceSize bufferOffset, uint32_t firstRow, uint32_t rowCount);
 
-		bool isManaged_;
+		//ֱ任ڱ𴦼¼ʱȨתƣͬ¼Ĳ
+		void SetLayout(VkImageLayout layout) { imageLayout_ = layout; }
+
+	private:
 
 		const class Device& device_;
 		const VkExtent2D extent_;
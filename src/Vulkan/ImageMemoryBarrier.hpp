@@ -33,6 +33,36 @@ namespace Vulkan
 				VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0, nullptr, 1,
 				&barrier);
 		}
+
+		// Queue family ownership transfer of an image kept in the general layout. The same barrier must be recorded
+		// on the releasing queue and then on the acquiring queue. Degenerates into a plain barrier within one family.
+		static void InsertQueueTransfer(
+			const VkCommandBuffer commandBuffer,
+			const VkImage image,
+			const VkImageSubresourceRange subresourceRange,
+			const VkAccessFlags srcAccessMask,
+			const VkAccessFlags dstAccessMask,
+			const uint32_t srcQueueFamilyIndex,
+			const uint32_t dstQueueFamilyIndex)
+		{
+			const bool transfer = srcQueueFamilyIndex != dstQueueFamilyIndex;
+
+			VkImageMemoryBarrier barrier;
+			barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			barrier.pNext = nullptr;
+			barrier.srcAccessMask = srcAccessMask;
+			barrier.dstAccessMask = dstAccessMask;
+			barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+			barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+			barrier.srcQueueFamilyIndex = transfer ? srcQueueFamilyIndex : VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = transfer ? dstQueueFamilyIndex : VK_QUEUE_FAMILY_IGNORED;
+			barrier.image = image;
+			barrier.subresourceRange = subresourceRange;
+
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+				VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0, nullptr, 1,
+				&barrier);
+		}
 	};
 
 }
@@ -0,0 +1,489 @@
+#include "MemoryAllocator.hpp"
+#include "Device.hpp"
+#include "Utilities/Exception.hpp"
+#include <algorithm>
+#include <set>
+
+namespace Vulkan {
+
+namespace
+{
+	// Smallest allocation of the buddy system, order zero.
+	const VkDeviceSize MinBuddySize = 256;
+
+	// Largest block, smaller heaps get blocks of an eighth of their size.
+	const VkDeviceSize MaxBlockSize = 64 * 1024 * 1024;
+	const VkDeviceSize MinBlockSize = 1024 * 1024;
+
+	VkDeviceSize AlignUp(const VkDeviceSize value, const VkDeviceSize alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	uint32_t BuddyOrder(const VkDeviceSize size)
+	{
+		uint32_t order = 0;
+
+		while ((MinBuddySize << order) < size)
+		{
+			++order;
+		}
+
+		return order;
+	}
+
+	// Only the device address flag makes a difference to the pooled allocations.
+	uint32_t PoolKey(const uint32_t memoryType, const MemoryAllocator::ResourceKind kind, const MemoryAllocator::Strategy strategy, const VkMemoryAllocateFlags allocateFlags)
+	{
+		return
+			(memoryType << 3) |
+			(static_cast<uint32_t>(kind) << 2) |
+			(static_cast<uint32_t>(strategy) << 1) |
+			((allocateFlags & VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT) != 0 ? 1u : 0u);
+	}
+}
+
+class MemoryAllocator::Block final
+{
+public:
+
+	VkDeviceMemory Memory{};
+	VkDeviceSize Size{};
+	Strategy BlockStrategy{};
+	uint32_t MemoryType{};
+	uint32_t AllocationCount{};
+	VkDeviceSize AllocatedBytes{};
+
+	// General strategy: free offsets of each buddy order, the last order being the whole block.
+	std::vector<std::set<VkDeviceSize>> FreeLists;
+
+	// Linear strategy: end of the last allocation.
+	VkDeviceSize Top{};
+
+	void* Mapped{};
+	uint32_t MapCount{};
+
+	bool TryAllocate(const VkMemoryRequirements& requirements, Allocation& allocation)
+	{
+		if (BlockStrategy == Strategy::Linear)
+		{
+			const VkDeviceSize offset = AlignUp(Top, requirements.alignment);
+
+			if (offset + requirements.size > Size)
+			{
+				return false;
+			}
+
+			Top = offset + requirements.size;
+			allocation = { Memory, offset, requirements.size, this, 0, Category::Other };
+			return true;
+		}
+
+		// Buddies are aligned on their size, which covers the power of two alignment.
+		const uint32_t order = BuddyOrder(std::max(requirements.size, requirements.alignment));
+		uint32_t freeOrder = order;
+
+		while (freeOrder < FreeLists.size() && FreeLists[freeOrder].empty())
+		{
+			++freeOrder;
+		}
+
+		if (freeOrder >= FreeLists.size())
+		{
+			return false;
+		}
+
+		const VkDeviceSize offset = *FreeLists[freeOrder].begin();
+		FreeLists[freeOrder].erase(FreeLists[freeOrder].begin());
+
+		// Split down to the requested order, the upper halves become free.
+		while (freeOrder != order)
+		{
+			--freeOrder;
+			FreeLists[freeOrder].insert(offset + (MinBuddySize << freeOrder));
+		}
+
+		allocation = { Memory, offset, requirements.size, this, order, Category::Other };
+		return true;
+	}
+
+	void Free(const Allocation& allocation)
+	{
+		if (BlockStrategy == Strategy::Linear)
+		{
+			// Rewind once all the allocations are gone.
+			if (AllocationCount == 0)
+			{
+				Top = 0;
+			}
+
+			return;
+		}
+
+		// Merge with the free buddies.
+		VkDeviceSize offset = allocation.Offset;
+		uint32_t order = allocation.Order;
+
+		while (order + 1 < FreeLists.size())
+		{
+			const auto buddy = FreeLists[order].find(offset ^ (MinBuddySize << order));
+
+			if (buddy == FreeLists[order].end())
+			{
+				break;
+			}
+
+			offset = std::min(offset, *buddy);
+			FreeLists[order].erase(buddy);
+			++order;
+		}
+
+		FreeLists[order].insert(offset);
+	}
+};
+
+MemoryAllocator::MemoryAllocator(const class Device& device, const bool memoryBudget) :
+	device_(device),
+	memoryBudget_(memoryBudget)
+{
+	vkGetPhysicalDeviceMemoryProperties(device.PhysicalDevice(), &memoryProperties_);
+}
+
+MemoryAllocator::~MemoryAllocator()
+{
+	for (auto& block : dedicated_)
+	{
+		DestroyBlock(*block);
+	}
+
+	for (auto& pool : pools_)
+	{
+		for (auto& block : pool.second)
+		{
+			DestroyBlock(*block);
+		}
+	}
+}
+
+MemoryAllocator::Allocation MemoryAllocator::Allocate(
+	const VkMemoryRequirements& requirements,
+	const ResourceKind kind,
+	const Strategy strategy,
+	const Category category,
+	const bool prefersDedicated,
+	const VkMemoryAllocateFlags allocateFlags,
+	const VkMemoryPropertyFlags propertyFlags,
+	const VkImage dedicatedImage)
+{
+	const uint32_t memoryType = FindMemoryType(requirements.memoryTypeBits, propertyFlags);
+	const VkDeviceSize blockSize = BlockSize(memoryType);
+
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	if (prefersDedicated || dedicatedImage != VK_NULL_HANDLE || requirements.size > blockSize / 2)
+	{
+		// A dedicated block is filled by its single allocation.
+		dedicated_.push_back(CreateBlock(memoryType, requirements.size, Strategy::Linear, allocateFlags, dedicatedImage));
+
+		auto& block = *dedicated_.back();
+		block.Top = requirements.size;
+		block.AllocationCount = 1;
+		block.AllocatedBytes = requirements.size;
+		categoryBytes_[static_cast<uint32_t>(category)] += requirements.size;
+
+		return { block.Memory, 0, requirements.size, &block, 0, category };
+	}
+
+	auto& pool = pools_[PoolKey(memoryType, kind, strategy, allocateFlags)];
+	Allocation allocation = {};
+
+	const auto available = std::find_if(pool.begin(), pool.end(), [&](const std::unique_ptr<Block>& block)
+	{
+		return block->TryAllocate(requirements, allocation);
+	});
+
+	if (available == pool.end())
+	{
+		pool.push_back(CreateBlock(memoryType, blockSize, strategy, allocateFlags, VK_NULL_HANDLE));
+
+		if (!pool.back()->TryAllocate(requirements, allocation))
+		{
+			Throw(std::runtime_error("failed to sub-allocate memory"));
+		}
+	}
+
+	allocation.Owner->AllocationCount++;
+	allocation.Owner->AllocatedBytes += allocation.Size;
+	allocation.Category = category;
+	categoryBytes_[static_cast<uint32_t>(category)] += allocation.Size;
+
+	return allocation;
+}
+
+void MemoryAllocator::Free(const Allocation& allocation)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	Block* const owner = allocation.Owner;
+
+	categoryBytes_[static_cast<uint32_t>(allocation.Category)] -= allocation.Size;
+
+	const auto dedicated = std::find_if(dedicated_.begin(), dedicated_.end(), [owner](const std::unique_ptr<Block>& block)
+	{
+		return block.get() == owner;
+	});
+
+	if (dedicated != dedicated_.end())
+	{
+		DestroyBlock(**dedicated);
+		dedicated_.erase(dedicated);
+		return;
+	}
+
+	owner->AllocationCount--;
+	owner->AllocatedBytes -= allocation.Size;
+	owner->Free(allocation);
+
+	if (owner->AllocationCount != 0)
+	{
+		return;
+	}
+
+	// Keep one empty block per pool for the next allocations, release the others.
+	for (auto& pool : pools_)
+	{
+		auto& blocks = pool.second;
+		const auto block = std::find_if(blocks.begin(), blocks.end(), [owner](const std::unique_ptr<Block>& b) { return b.get() == owner; });
+
+		if (block == blocks.end())
+		{
+			continue;
+		}
+
+		const auto emptyCount = std::count_if(blocks.begin(), blocks.end(), [](const std::unique_ptr<Block>& b) { return b->AllocationCount == 0; });
+
+		if (emptyCount > 1)
+		{
+			DestroyBlock(**block);
+			blocks.erase(block);
+		}
+
+		return;
+	}
+}
+
+void* MemoryAllocator::Map(const Allocation& allocation)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	auto& block = *allocation.Owner;
+
+	if (block.MapCount++ == 0)
+	{
+		Check(vkMapMemory(device_.Handle(), block.Memory, 0, VK_WHOLE_SIZE, 0, &block.Mapped),
+			"map memory");
+	}
+
+	return static_cast<uint8_t*>(block.Mapped) + allocation.Offset;
+}
+
+void MemoryAllocator::Unmap(const Allocation& allocation)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	auto& block = *allocation.Owner;
+
+	if (block.MapCount != 0 && --block.MapCount == 0)
+	{
+		vkUnmapMemory(device_.Handle(), block.Memory);
+		block.Mapped = nullptr;
+	}
+}
+
+const char* MemoryAllocator::CategoryName(const Category category)
+{
+	switch (category)
+	{
+	case Category::Other: return "other";
+	case Category::Geometry: return "geometry";
+	case Category::Textures: return "textures";
+	case Category::AccelerationStructures: return "acceleration structures";
+	case Category::Scratch: return "scratch";
+	case Category::RenderTargets: return "render targets";
+	case Category::DenoiserHistory: return "denoiser history";
+	case Category::Staging: return "staging";
+	}
+
+	return "unknown";
+}
+
+uint32_t MemoryAllocator::FindMemoryType(const uint32_t typeFilter, const VkMemoryPropertyFlags propertyFlags) const
+{
+	for (uint32_t i = 0; i != memoryProperties_.memoryTypeCount; ++i)
+	{
+		if ((typeFilter & (1 << i)) && (memoryProperties_.memoryTypes[i].propertyFlags & propertyFlags) == propertyFlags)
+		{
+			return i;
+		}
+	}
+
+	Throw(std::runtime_error("failed to find suitable memory type"));
+}
+
+MemoryAllocator::Statistics MemoryAllocator::GetStatistics() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	Statistics statistics = {};
+
+	for (const auto& pool : pools_)
+	{
+		for (const auto& block : pool.second)
+		{
+			statistics.BlockCount++;
+			statistics.BlockBytes += block->Size;
+			statistics.AllocationCount += block->AllocationCount;
+			statistics.AllocatedBytes += block->AllocatedBytes;
+		}
+	}
+
+	for (const auto& block : dedicated_)
+	{
+		statistics.DedicatedCount++;
+		statistics.DedicatedBytes += block->Size;
+		statistics.AllocationCount++;
+		statistics.AllocatedBytes += block->Size;
+	}
+
+	statistics.MemoryObjectCount = statistics.BlockCount + statistics.DedicatedCount;
+	statistics.AllocateCallCount = allocateCallCount_;
+	statistics.CategoryBytes = categoryBytes_;
+
+	const auto isDeviceLocal = [this](const uint32_t heapIndex)
+	{
+		return (memoryProperties_.memoryHeaps[heapIndex].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+	};
+
+	if (memoryBudget_)
+	{
+		VkPhysicalDeviceMemoryBudgetPropertiesEXT budget = {};
+		budget.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+
+		VkPhysicalDeviceMemoryProperties2 properties = {};
+		properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+		properties.pNext = &budget;
+
+		vkGetPhysicalDeviceMemoryProperties2(device_.PhysicalDevice(), &properties);
+
+		for (uint32_t i = 0; i != memoryProperties_.memoryHeapCount; ++i)
+		{
+			if (isDeviceLocal(i))
+			{
+				statistics.DeviceLocalBudget += budget.heapBudget[i];
+				statistics.DeviceLocalUsage += budget.heapUsage[i];
+			}
+		}
+	}
+	else
+	{
+		for (uint32_t i = 0; i != memoryProperties_.memoryHeapCount; ++i)
+		{
+			if (isDeviceLocal(i))
+			{
+				statistics.DeviceLocalBudget += memoryProperties_.memoryHeaps[i].size;
+			}
+		}
+
+		const auto addUsage = [&](const Block& block)
+		{
+			if (isDeviceLocal(memoryProperties_.memoryTypes[block.MemoryType].heapIndex))
+			{
+				statistics.DeviceLocalUsage += block.Size;
+			}
+		};
+
+		for (const auto& pool : pools_)
+		{
+			for (const auto& block : pool.second)
+			{
+				addUsage(*block);
+			}
+		}
+
+		for (const auto& block : dedicated_)
+		{
+			addUsage(*block);
+		}
+	}
+
+	return statistics;
+}
+
+std::unique_ptr<MemoryAllocator::Block> MemoryAllocator::CreateBlock(
+	const uint32_t memoryType,
+	const VkDeviceSize size,
+	const Strategy strategy,
+	const VkMemoryAllocateFlags allocateFlags,
+	const VkImage dedicatedImage)
+{
+	VkMemoryDedicatedAllocateInfo dedicatedInfo = {};
+	dedicatedInfo.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO;
+	dedicatedInfo.pNext = nullptr;
+	dedicatedInfo.image = dedicatedImage;
+	dedicatedInfo.buffer = VK_NULL_HANDLE;
+
+	VkMemoryAllocateFlagsInfo flagsInfo = {};
+	flagsInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO;
+	flagsInfo.pNext = dedicatedImage != VK_NULL_HANDLE ? &dedicatedInfo : nullptr;
+	flagsInfo.flags = allocateFlags;
+
+	VkMemoryAllocateInfo allocInfo = {};
+	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocInfo.pNext = &flagsInfo;
+	allocInfo.allocationSize = size;
+	allocInfo.memoryTypeIndex = memoryType;
+
+	std::unique_ptr<Block> block(new Block());
+	block->Size = size;
+	block->BlockStrategy = strategy;
+	block->MemoryType = memoryType;
+
+	Check(vkAllocateMemory(device_.Handle(), &allocInfo, nullptr, &block->Memory),
+		"allocate memory");
+
+	allocateCallCount_++;
+
+	// Block sizes are powers of two, the whole block starts free.
+	if (strategy == Strategy::General)
+	{
+		block->FreeLists.resize(BuddyOrder(size) + 1);
+		block->FreeLists.back().insert(0);
+	}
+
+	return block;
+}
+
+void MemoryAllocator::DestroyBlock(Block& block) const
+{
+	if (block.Memory != nullptr)
+	{
+		vkFreeMemory(device_.Handle(), block.Memory, nullptr);
+		block.Memory = nullptr;
+	}
+}
+
+VkDeviceSize MemoryAllocator::BlockSize(const uint32_t memoryType) const
+{
+	const VkDeviceSize heapSize = memoryProperties_.memoryHeaps[memoryProperties_.memoryTypes[memoryType].heapIndex].size;
+
+	VkDeviceSize size = MaxBlockSize;
+
+	while (size > MinBlockSize && size > heapSize / 8)
+	{
+		size /= 2;
+	}
+
+	return size;
+}
+
+}
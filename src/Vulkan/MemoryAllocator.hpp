@@ -0,0 +1,134 @@
+#pragma once
+
+#include "Vulkan.hpp"
+#include <array>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Vulkan
+{
+	class Device;
+
+	// Sub-allocates the memory of buffers and images from large blocks, so that the number of memory objects stays far
+	// below maxMemoryAllocationCount and creating a resource rarely reaches the driver. Blocks are pooled per memory
+	// type, resource kind (buffers and images never share a block, which keeps bufferImageGranularity out of the way),
+	// allocate flags and strategy:
+	// - General: power of two blocks split by a buddy system, allocations of any lifetime.
+	// - Linear: an offset bumped by each allocation and rewound once the block is empty, for short lived staging and
+	//   readback buffers.
+	// Resources larger than half a block, and images the driver prefers to be dedicated, get a memory object of their own.
+	// The memory objects of those images name them (VkMemoryDedicatedAllocateInfo), which the driver needs to apply the
+	// optimizations it asked for, and to allocate at all for the images that require dedicated memory.
+	// Host visible blocks are mapped once and stay mapped while any of their allocations is.
+	// Allocations are tagged with the subsystem they belong to for the memory accounting, and the device local usage is
+	// checked against the budget reported by VK_EXT_memory_budget when the device supports it.
+	class MemoryAllocator final
+	{
+	public:
+
+		// Memory object the allocations are carved from, opaque outside of the allocator.
+		class Block;
+
+		enum class Strategy : uint32_t
+		{
+			General,
+			Linear
+		};
+
+		enum class ResourceKind : uint32_t
+		{
+			Buffer,
+			Image
+		};
+
+		enum class Category : uint32_t
+		{
+			Other,
+			Geometry,
+			Textures,
+			AccelerationStructures,
+			Scratch,
+			RenderTargets,
+			DenoiserHistory,
+			Staging
+		};
+
+		static const uint32_t CategoryCount = 8;
+		static const char* CategoryName(Category category);
+
+		struct Allocation
+		{
+			VkDeviceMemory Memory;
+			VkDeviceSize Offset;
+			VkDeviceSize Size;
+			Block* Owner;
+			uint32_t Order; // Buddy order of the general strategy allocations.
+			MemoryAllocator::Category Category;
+		};
+
+		struct Statistics
+		{
+			uint32_t BlockCount;
+			VkDeviceSize BlockBytes;
+			uint32_t DedicatedCount;
+			VkDeviceSize DedicatedBytes;
+			uint32_t AllocationCount; // Including the dedicated ones.
+			VkDeviceSize AllocatedBytes;
+			uint32_t MemoryObjectCount; // Live memory objects, blocks and dedicated allocations.
+			uint32_t AllocateCallCount; // vkAllocateMemory calls since the creation.
+			std::array<VkDeviceSize, CategoryCount> CategoryBytes; // Allocated bytes of each category.
+
+			// Over all the device local heaps. Without VK_EXT_memory_budget, the heap sizes and the memory allocated here.
+			VkDeviceSize DeviceLocalBudget;
+			VkDeviceSize DeviceLocalUsage;
+		};
+
+		VULKAN_NON_COPIABLE(MemoryAllocator)
+
+		MemoryAllocator(const Device& device, bool memoryBudget);
+		~MemoryAllocator();
+
+		// A dedicated image gets a memory object allocated for it alone, to be bound at offset zero.
+		Allocation Allocate(
+			const VkMemoryRequirements& requirements,
+			ResourceKind kind,
+			Strategy strategy,
+			Category category,
+			bool prefersDedicated,
+			VkMemoryAllocateFlags allocateFlags,
+			VkMemoryPropertyFlags propertyFlags,
+			VkImage dedicatedImage = VK_NULL_HANDLE);
+		void Free(const Allocation& allocation);
+
+		// Also queries the device local budget, which depends on the other processes too, call it once per frame at most.
+		Statistics GetStatistics() const;
+
+		// Host address of the start of the allocation, which must be in a host visible memory type.
+		void* Map(const Allocation& allocation);
+		void Unmap(const Allocation& allocation);
+
+		uint32_t FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags propertyFlags) const;
+		const VkPhysicalDeviceMemoryProperties& MemoryProperties() const { return memoryProperties_; }
+
+	private:
+
+		std::unique_ptr<Block> CreateBlock(uint32_t memoryType, VkDeviceSize size, Strategy strategy, VkMemoryAllocateFlags allocateFlags, VkImage dedicatedImage);
+		void DestroyBlock(Block& block) const;
+		VkDeviceSize BlockSize(uint32_t memoryType) const;
+
+		const class Device& device_;
+		const bool memoryBudget_;
+		VkPhysicalDeviceMemoryProperties memoryProperties_{};
+
+		// Blocks of each pool, keyed by memory type, resource kind, strategy and allocate flags.
+		std::map<uint32_t, std::vector<std::unique_ptr<Block>>> pools_;
+		std::vector<std::unique_ptr<Block>> dedicated_;
+		uint32_t allocateCallCount_{};
+		std::array<VkDeviceSize, CategoryCount> categoryBytes_{};
+
+		mutable std::mutex mutex_;
+	};
+
+}
@@ -0,0 +1,99 @@
+#include "PipelineCache.hpp"
+#include "Device.hpp"
+#include <cstring>
+#include <fstream>
+
+namespace Vulkan {
+
+PipelineCache::PipelineCache(const class Device& device, const std::string& filename) :
+	device_(device),
+	filename_(filename)
+{
+	auto data = ReadFile(filename);
+
+	if (!IsCompatible(data))
+	{
+		data.clear();
+	}
+
+	VkPipelineCacheCreateInfo createInfo = {};
+	createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	createInfo.initialDataSize = data.size();
+	createInfo.pInitialData = data.data();
+
+	Check(vkCreatePipelineCache(device.Handle(), &createInfo, nullptr, &pipelineCache_),
+		"create pipeline cache");
+}
+
+PipelineCache::~PipelineCache()
+{
+	if (pipelineCache_ != nullptr)
+	{
+		vkDestroyPipelineCache(device_.Handle(), pipelineCache_, nullptr);
+		pipelineCache_ = nullptr;
+	}
+}
+
+void PipelineCache::Save() const
+{
+	size_t size = 0;
+
+	if (vkGetPipelineCacheData(device_.Handle(), pipelineCache_, &size, nullptr) != VK_SUCCESS || size == 0)
+	{
+		return;
+	}
+
+	std::vector<char> data(size);
+
+	if (vkGetPipelineCacheData(device_.Handle(), pipelineCache_, &size, data.data()) != VK_SUCCESS)
+	{
+		return;
+	}
+
+	std::ofstream file(filename_, std::ios::binary | std::ios::trunc);
+	file.write(data.data(), static_cast<std::streamsize>(size));
+}
+
+std::vector<char> PipelineCache::ReadFile(const std::string& filename)
+{
+	std::ifstream file(filename, std::ios::ate | std::ios::binary);
+
+	if (!file.is_open())
+	{
+		return {};
+	}
+
+	const auto fileSize = static_cast<size_t>(file.tellg());
+	std::vector<char> buffer(fileSize);
+
+	file.seekg(0);
+	file.read(buffer.data(), fileSize);
+
+	return file ? buffer : std::vector<char>();
+}
+
+bool PipelineCache::IsCompatible(const std::vector<char>& data) const
+{
+	// Header version one: length, version, vendor id, device id and pipeline cache UUID.
+	const size_t headerSize = 4 * sizeof(uint32_t) + VK_UUID_SIZE;
+
+	if (data.size() < headerSize)
+	{
+		return false;
+	}
+
+	uint32_t header[4];
+	std::memcpy(header, data.data(), sizeof(header));
+
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(device_.PhysicalDevice(), &properties);
+
+	return
+		header[0] >= headerSize &&
+		header[1] == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+		header[2] == properties.vendorID &&
+		header[3] == properties.deviceID &&
+		std::memcmp(data.data() + sizeof(header), properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+}
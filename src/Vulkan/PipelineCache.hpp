@@ -0,0 +1,39 @@
+#pragma once
+
+#include "Vulkan.hpp"
+#include <string>
+#include <vector>
+
+namespace Vulkan
+{
+	class Device;
+
+	// Pipeline cache shared by all the pipelines of the device, so that the shader permutations created on the fly
+	// (see SpecializationConstants) are compiled once. Its content can be kept on disk between runs.
+	class PipelineCache final
+	{
+	public:
+
+		VULKAN_NON_COPIABLE(PipelineCache)
+
+		// Starts from the content of the given file when it exists and was written for the same device and driver.
+		PipelineCache(const Device& device, const std::string& filename);
+		~PipelineCache();
+
+		const class Device& Device() const { return device_; }
+
+		// Writes the current content to the file the cache was loaded from, failures are ignored.
+		void Save() const;
+
+	private:
+
+		static std::vector<char> ReadFile(const std::string& filename);
+		bool IsCompatible(const std::vector<char>& data) const;
+
+		const class Device& device_;
+		const std::string filename_;
+
+		VULKAN_HANDLE(VkPipelineCache, pipelineCache_)
+	};
+
+}
@@ -5,6 +5,11 @@
 namespace Vulkan {
 
 PipelineLayout::PipelineLayout(const Device & device, const DescriptorSetLayout& descriptorSetLayout) :
+	PipelineLayout(device, descriptorSetLayout, {})
+{
+}
+
+PipelineLayout::PipelineLayout(const Device& device, const DescriptorSetLayout& descriptorSetLayout, const std::vector<VkPushConstantRange>& pushConstantRanges) :
 	device_(device)
 {
 	VkDescriptorSetLayout descriptorSetLayouts[] = { descriptorSetLayout.Handle() };
@@ -13,8 +18,8 @@ PipelineLayout::PipelineLayout(const Device & device, const DescriptorSetLayout&
 	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
 	pipelineLayoutInfo.setLayoutCount = 1;
 	pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts;
-	pipelineLayoutInfo.pushConstantRangeCount = 0; // Optional
-	pipelineLayoutInfo.pPushConstantRanges = nullptr; // Optional
+	pipelineLayoutInfo.pushConstantRangeCount = static_cast<uint32_t>(pushConstantRanges.size()); // Optional
+	pipelineLayoutInfo.pPushConstantRanges = pushConstantRanges.empty() ? nullptr : pushConstantRanges.data(); // Optional
 
 	Check(vkCreatePipelineLayout(device_.Handle(), &pipelineLayoutInfo, nullptr, &pipelineLayout_),
 		"create pipeline layout");
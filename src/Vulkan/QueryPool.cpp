@@ -0,0 +1,53 @@
+#include "QueryPool.hpp"
+#include "Device.hpp"
+
+namespace Vulkan {
+
+QueryPool::QueryPool(const class Device& device, const VkQueryType type, const uint32_t queryCount) :
+	device_(device),
+	queryCount_(queryCount)
+{
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(device.PhysicalDevice(), &properties);
+	timestampPeriod_ = properties.limits.timestampPeriod;
+
+	VkQueryPoolCreateInfo queryPoolInfo = {};
+	queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	queryPoolInfo.queryType = type;
+	queryPoolInfo.queryCount = queryCount;
+
+	Check(vkCreateQueryPool(device.Handle(), &queryPoolInfo, nullptr, &queryPool_),
+		"create query pool");
+}
+
+QueryPool::~QueryPool()
+{
+	if (queryPool_ != nullptr)
+	{
+		vkDestroyQueryPool(device_.Handle(), queryPool_, nullptr);
+		queryPool_ = nullptr;
+	}
+}
+
+void QueryPool::Reset(VkCommandBuffer commandBuffer, const uint32_t firstQuery, const uint32_t queryCount) const
+{
+	vkCmdResetQueryPool(commandBuffer, queryPool_, firstQuery, queryCount);
+}
+
+void QueryPool::WriteTimestamp(VkCommandBuffer commandBuffer, const VkPipelineStageFlagBits stage, const uint32_t query) const
+{
+	vkCmdWriteTimestamp(commandBuffer, stage, queryPool_, query);
+}
+
+std::vector<uint64_t> QueryPool::GetResults(const uint32_t firstQuery, const uint32_t queryCount) const
+{
+	std::vector<uint64_t> results(queryCount);
+
+	Check(vkGetQueryPoolResults(device_.Handle(), queryPool_, firstQuery, queryCount,
+		results.size() * sizeof(uint64_t), results.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT),
+		"get query pool results");
+
+	return results;
+}
+
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "Vulkan.hpp"
+#include <vector>
+
+namespace Vulkan
+{
+	class Device;
+
+	class QueryPool final
+	{
+	public:
+
+		VULKAN_NON_COPIABLE(QueryPool)
+
+		QueryPool(const Device& device, VkQueryType type, uint32_t queryCount);
+		~QueryPool();
+
+		const class Device& Device() const { return device_; }
+		uint32_t QueryCount() const { return queryCount_; }
+
+		// Duration of one timestamp tick, in nanoseconds.
+		float TimestampPeriod() const { return timestampPeriod_; }
+
+		void Reset(VkCommandBuffer commandBuffer, uint32_t firstQuery, uint32_t queryCount) const;
+		void WriteTimestamp(VkCommandBuffer commandBuffer, VkPipelineStageFlagBits stage, uint32_t query) const;
+
+		// Blocks until the requested queries are available.
+		std::vector<uint64_t> GetResults(uint32_t firstQuery, uint32_t queryCount) const;
+
+	private:
+
+		const class Device& device_;
+		const uint32_t queryCount_;
+		float timestampPeriod_{};
+
+		VULKAN_HANDLE(VkQueryPool, queryPool_)
+	};
+
+}
@@ -1,30 +1,89 @@
 #include "Application.hpp"
 #include "BottomLevelAccelerationStructure.hpp"
+#include "Denoiser.hpp"
+#include "DenoiserBenchmark.hpp"
 #include "DeviceProcedures.hpp"
+#include "GBuffer.hpp"
 #include "RayTracingPipeline.hpp"
 #include "ShaderBindingTable.hpp"
+#include "TemporalUpscaler.hpp"
 #include "TopLevelAccelerationStructure.hpp"
 #include "Assets/Model.hpp"
 #include "Assets/Scene.hpp"
+#include "Utilities/ImageMetrics.hpp"
 #include "Utilities/Glm.hpp"
+#include <glm/gtc/packing.hpp>
 #include "Vulkan/Buffer.hpp"
 #include "Vulkan/BufferUtil.hpp"
+#include "Vulkan/Device.hpp"
 #include "Vulkan/Image.hpp"
 #include "Vulkan/ImageMemoryBarrier.hpp"
 #include "Vulkan/ImageView.hpp"
 #include "Vulkan/PipelineLayout.hpp"
+#include "Vulkan/RenderTarget.hpp"
 #include "Vulkan/SingleTimeCommands.hpp"
 #include "Vulkan/SwapChain.hpp"
-#include <Vulkan/ShaderModule.hpp>
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <numeric>
+#include <utility>
 
 
 namespace Vulkan::RayTracing {
 
 namespace
 {
+	const char* PrecisionName(const Denoiser::Precision precision)
+	{
+		switch (precision)
+		{
+		case Denoiser::Precision::Float32: return "fp32";
+		case Denoiser::Precision::Float16Storage: return "fp16 storage";
+		case Denoiser::Precision::Float16: return "fp16";
+		}
+
+		return "unknown";
+	}
+
+	// RGBA8 image as [0, 1] floats, for the image metrics.
+	std::vector<float> ToFloats(const std::vector<uint8_t>& pixels)
+	{
+		std::vector<float> floats(pixels.size());
+		std::transform(pixels.begin(), pixels.end(), floats.begin(), [](const uint8_t value) { return value / 255.0f; });
+		return floats;
+	}
+
+	// The extent traced at the given fraction of the display resolution, at least one pixel wide.
+	VkExtent2D ScaledExtent(const VkExtent2D extent, const float scale)
+	{
+		const auto scaled = [scale](const uint32_t size)
+		{
+			return std::min(std::max(static_cast<uint32_t>(std::lround(size * scale)), 1u), size);
+		};
+
+		return { scaled(extent.width), scaled(extent.height) };
+	}
+
+	// Largest absolute difference between the color channels of two RGBA8 images.
+	int MaxDifference(const std::vector<uint8_t>& reference, const std::vector<uint8_t>& output)
+	{
+		int maxDifference = 0;
+
+		for (size_t i = 0; i != reference.size(); ++i)
+		{
+			if (i % 4 != 3)
+			{
+				maxDifference = std::max(maxDifference, std::abs(static_cast<int>(reference[i]) - static_cast<int>(output[i])));
+			}
+		}
+
+		return maxDifference;
+	}
+
 	//ṩһķʽͨһٽṹ
 	//ԵõЩṹԴڴСʱ洢ռȣ
 	template <class TAccelerationStructure>
@@ -43,8 +102,8 @@ namespace
 	}
 }
 
-Application::Application(const WindowConfig& windowConfig, const VkPresentModeKHR presentMode, const bool enableValidationLayers) :
-	Vulkan::Application(windowConfig, presentMode, enableValidationLayers)
+Application::Application(const WindowConfig& windowConfig, const VkPresentModeKHR presentMode, const uint32_t framesInFlight, const bool enableValidationLayers) :
+	Vulkan::Application(windowConfig, presentMode, framesInFlight, enableValidationLayers)
 {
 }
 
@@ -78,9 +137,14 @@ void Application::SetPhysicalDevice(
 	bufferDeviceAddressFeatures.pNext = nextDeviceFeatures;
 	bufferDeviceAddressFeatures.bufferDeviceAddress = true;
 
+	VkPhysicalDeviceTimelineSemaphoreFeatures timelineSemaphoreFeatures = {};
+	timelineSemaphoreFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+	timelineSemaphoreFeatures.pNext = &bufferDeviceAddressFeatures;
+	timelineSemaphoreFeatures.timelineSemaphore = true;
+
 	VkPhysicalDeviceDescriptorIndexingFeatures indexingFeatures = {};
 	indexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
-	indexingFeatures.pNext = &bufferDeviceAddressFeatures;
+	indexingFeatures.pNext = &timelineSemaphoreFeatures;
 	indexingFeatures.runtimeDescriptorArray = true;
 	indexingFeatures.shaderSampledImageArrayNonUniformIndexing = true;
 
@@ -94,7 +158,23 @@ void Application::SetPhysicalDevice(
 	rayTracingFeatures.pNext = &accelerationStructureFeatures;
 	rayTracingFeatures.rayTracingPipeline = true;
 
-	Vulkan::Application::SetPhysicalDevice(physicalDevice, requiredExtensions, deviceFeatures, &rayTracingFeatures);
+	// Optional device features.
+	VkPhysicalDeviceShaderFloat16Int8Features supportedFloat16Features = {};
+	supportedFloat16Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_FLOAT16_INT8_FEATURES;
+
+	VkPhysicalDeviceFeatures2 supportedFeatures = {};
+	supportedFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+	supportedFeatures.pNext = &supportedFloat16Features;
+	vkGetPhysicalDeviceFeatures2(physicalDevice, &supportedFeatures);
+
+	shaderFloat16_ = supportedFloat16Features.shaderFloat16;
+
+	VkPhysicalDeviceShaderFloat16Int8Features float16Features = {};
+	float16Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_FLOAT16_INT8_FEATURES;
+	float16Features.pNext = &rayTracingFeatures;
+	float16Features.shaderFloat16 = shaderFloat16_;
+
+	Vulkan::Application::SetPhysicalDevice(physicalDevice, requiredExtensions, deviceFeatures, &float16Features);
 }
 
 //Ϊ׷רųʼ豸̺͹׷
@@ -147,59 +227,232 @@ void Application::CreateSwapChain()
 {
 	Vulkan::Application::CreateSwapChain();
 
+	renderScale_ = GetRenderScale();
+	renderExtent_ = ScaledExtent(SwapChain().Extent(), renderScale_);
+
 	//׷ٵͼ
 	CreateOutputImage();
 
-	//׷ٹ
-	rayTracingPipeline_.reset(new RayTracingPipeline(*deviceProcedures_, SwapChain(), topAs_[0], *accumulationImageView_, *outputImageView_, *saveImageView_, *motionVectorImageView_, *motionVectorSampler_, UniformBuffers(), GetScene()));
-	
-	//ɫ󶨱Ŀ
-	const std::vector<ShaderBindingTable::Entry> rayGenPrograms = { {rayTracingPipeline_->RayGenShaderIndex(), {}} };//ɳб
-	const std::vector<ShaderBindingTable::Entry> missPrograms = { {rayTracingPipeline_->MissShaderIndex(), {}} };//ûлκʱõɫ
-	const std::vector<ShaderBindingTable::Entry> hitGroups = { {rayTracingPipeline_->TriangleHitGroupIndex(), {}}, {rayTracingPipeline_->ProceduralHitGroupIndex(), {}} };//˹彻ʱӦδĳб˴Ϊλͳ򻯼λ顣
+	// Reconstruct the display resolution from the jittered frames traced at a lower one.
+	const auto extent = SwapChain().Extent();
 
-	//ɫ󶨱
-	shaderBindingTable_.reset(new ShaderBindingTable(*deviceProcedures_, *rayTracingPipeline_, *rayTracingProperties_, rayGenPrograms, missPrograms, hitGroups));
+	if (renderExtent_.width != extent.width || renderExtent_.height != extent.height)
+	{
+		upscaler_.reset(new TemporalUpscaler(CommandPool(), PipelineCache(), renderExtent_, extent, SwapChain().Format(),
+			{ gBuffers_[0].get(), gBuffers_[1].get() },
+			{ &denoisedImages_[0]->ImageView(), &denoisedImages_[1]->ImageView() }));
+	}
 
-	CreatePostProcessing();
+	//׷ٹߣøıʱ贴
+	GetTracePipeline(GetTracePermutation());
+
+	//SVGF
+	denoiser_.reset(new Denoiser(CommandPool(), PipelineCache(), renderExtent_, GetDenoiserPrecision(UseHalfPrecisionDenoiser()),
+		static_cast<uint32_t>(FrameContexts().size()),
+		{ gBuffers_[0].get(), gBuffers_[1].get() },
+		{ &outputImages_[0]->ImageView(), &outputImages_[1]->ImageView() },
+		{ &specularImages_[0]->ImageView(), &specularImages_[1]->ImageView() },
+		{ &denoisedImages_[0]->ImageView(), &denoisedImages_[1]->ImageView() }));
+
+	frameSlot_ = 0;
+	denoisedFramePending_ = false;
+	gBufferReleased_ = {};
+	denoisedImageCached_ = {};
 }
 
 void Application::DeleteSwapChain()
 {
-	shaderBindingTable_.reset();
-	rayTracingPipeline_.reset();
-	outputImageView_.reset();
-	outputImage_.reset();
-	outputImageMemory_.reset();
-	outputImageSampler_.reset();
+	upscaler_.reset();
+	denoiser_.reset();
+	tracePipelines_.clear();
+	for (auto& image : sampleHistoryImages_) image.reset();
+	for (auto& image : denoisedImages_) image.reset();
+	for (auto& gBuffer : gBuffers_) gBuffer.reset();
+	for (auto& image : specularImages_) image.reset();
+	for (auto& image : outputImages_) image.reset();
+	specularAccumulationImage_.reset();
 	accumulationImageView_.reset();
 	accumulationImage_.reset();
 	accumulationImageMemory_.reset();
-	myOutputImage_.reset();
-	myOutputImageMemory_.reset();
-	myOutputImageView_.reset();
 
-	// 
-	vkDestroyDescriptorSetLayout(Device().Handle(), descriptorSetLayout, nullptr);
+	Vulkan::Application::DeleteSwapChain();
+}
 
-	// 
-	vkDestroyDescriptorPool(Device().Handle(), descriptorPool, nullptr);
+//׷Ⱦ
+void Application::Render(VkCommandBuffer commandBuffer, const uint32_t imageIndex)
+{
+	if (IsIdle())
+	{
+		// With async compute the previous image is presented in RenderPresent().
+		if (!AsyncCompute())
+		{
+			PresentDenoisedImage(commandBuffer, frameSlot_, imageIndex);
+		}
 
-	// ٹ
-	vkDestroyPipeline(Device().Handle(), computePipeline, nullptr);
+		return;
+	}
 
-	// ٹ߲
-	vkDestroyPipelineLayout(Device().Handle(), pipelineLayout, nullptr);
+	const auto& device = Device();
+	const uint32_t slot = frameSlot_ = 1 - frameSlot_;
 
-	Vulkan::Application::DeleteSwapChain();
+	VkImageSubresourceRange subresourceRange = {};
+	subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	subresourceRange.baseMipLevel = 0;
+	subresourceRange.levelCount = 1;
+	subresourceRange.baseArrayLayer = 0;
+	subresourceRange.layerCount = 1;
+
+	TraceRays(commandBuffer);
+
+	if (AsyncCompute())
+	{
+		// Hand the noisy images and the G-buffer over to the compute queue, the denoiser runs in RenderCompute().
+		for (const auto* image : { outputImages_[slot].get(), specularImages_[slot].get() })
+		{
+			ImageMemoryBarrier::InsertQueueTransfer(commandBuffer, image->Image().Handle(), subresourceRange,
+				VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT, device.GraphicsFamilyIndex(), device.ComputeFamilyIndex());
+		}
+
+		gBuffers_[slot]->TransferOwnership(commandBuffer, device.GraphicsFamilyIndex(), device.ComputeFamilyIndex());
+		return;
+	}
+
+	Denoise(commandBuffer, slot);
+
+	CopyToSwapChain(commandBuffer, slot, imageIndex);
+	denoisedImageCached_[slot] = true;
 }
 
-//׷Ⱦ
-void Application::Render(VkCommandBuffer commandBuffer, const uint32_t imageIndex)
+void Application::RenderCompute(VkCommandBuffer commandBuffer)
 {
-	const auto extent = SwapChain().Extent();
+	if (IsIdle())
+	{
+		return;
+	}
+
+	const auto& device = Device();
+	const uint32_t slot = frameSlot_;
+
+	VkImageSubresourceRange subresourceRange = {};
+	subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	subresourceRange.baseMipLevel = 0;
+	subresourceRange.levelCount = 1;
+	subresourceRange.baseArrayLayer = 0;
+	subresourceRange.layerCount = 1;
+
+	// Acquire the images released by the ray tracing pass of this frame.
+	for (const auto* image : { outputImages_[slot].get(), specularImages_[slot].get() })
+	{
+		ImageMemoryBarrier::InsertQueueTransfer(commandBuffer, image->Image().Handle(), subresourceRange,
+			VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT, device.GraphicsFamilyIndex(), device.ComputeFamilyIndex());
+	}
+
+	gBuffers_[slot]->TransferOwnership(commandBuffer, device.GraphicsFamilyIndex(), device.ComputeFamilyIndex());
+
+	Denoise(commandBuffer, slot);
+
+	// Release the result to the presentation of the next frame. The G-buffer goes back too, as it is kept when no samples are traced.
+	ImageMemoryBarrier::InsertQueueTransfer(commandBuffer, PresentedImage(slot).Image().Handle(), subresourceRange,
+		VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT, device.ComputeFamilyIndex(), device.GraphicsFamilyIndex());
+
+	gBuffers_[slot]->TransferOwnership(commandBuffer, device.ComputeFamilyIndex(), device.GraphicsFamilyIndex());
+
+	gBufferReleased_[slot] = true;
+	denoisedFramePending_ = true;
+	denoisedImageCached_[slot] = false;
+}
+
+void Application::RenderPresent(VkCommandBuffer commandBuffer, const uint32_t imageIndex)
+{
+	// Idle frames do not switch slots, the last denoised image is in the current one.
+	PresentDenoisedImage(commandBuffer, IsIdle() ? frameSlot_ : 1 - frameSlot_, imageIndex);
+}
+
+bool Application::IsSwapChainOutdated() const
+{
+	return
+		denoiser_->FilterPrecision() != GetDenoiserPrecision(UseHalfPrecisionDenoiser()) ||
+		renderScale_ != GetRenderScale();
+}
+
+glm::vec2 Application::PixelJitter() const
+{
+	return upscaler_ ? upscaler_->Jitter() : glm::vec2(0.0f);
+}
+
+RayTracingPipeline::Permutation Application::GetTracePermutation() const
+{
+	auto permutation = GetRayTracingPermutation();
+	permutation.Jitter = upscaler_ != nullptr;
+
+	return permutation;
+}
 
-	VkDescriptorSet descriptorSets[] = { rayTracingPipeline_->DescriptorSet(imageIndex) };
+Denoiser::Precision Application::GetDenoiserPrecision(const bool halfPrecision) const
+{
+	if (!halfPrecision)
+	{
+		return Denoiser::Precision::Float32;
+	}
+
+	return shaderFloat16_ ? Denoiser::Precision::Float16 : Denoiser::Precision::Float16Storage;
+}
+
+void Application::PresentDenoisedImage(VkCommandBuffer commandBuffer, const uint32_t slot, const uint32_t imageIndex)
+{
+	const auto& device = Device();
+
+	VkImageSubresourceRange subresourceRange = {};
+	subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	subresourceRange.baseMipLevel = 0;
+	subresourceRange.levelCount = 1;
+	subresourceRange.baseArrayLayer = 0;
+	subresourceRange.layerCount = 1;
+
+	if (denoisedFramePending_)
+	{
+		// Acquire the previous frame's denoised image, the semaphore wait guarantees the compute queue is done with it.
+		ImageMemoryBarrier::InsertQueueTransfer(commandBuffer, PresentedImage(slot).Image().Handle(), subresourceRange,
+			VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT, device.ComputeFamilyIndex(), device.GraphicsFamilyIndex());
+
+		denoisedFramePending_ = false;
+	}
+	else if (denoisedImageCached_[slot])
+	{
+		// Still in the layout of its last copy, CopyToSwapChain() expects the layout the denoiser leaves.
+		ImageMemoryBarrier::Insert(commandBuffer, PresentedImage(slot).Image().Handle(), subresourceRange,
+			0, VK_ACCESS_TRANSFER_READ_BIT, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_GENERAL);
+	}
+	else
+	{
+		// The first frame after the swap chain creation has nothing to present yet.
+		const VkImage swapChainImage = SwapChain().Images()[imageIndex];
+		const VkClearColorValue clearColor = { {0.0f, 0.0f, 0.0f, 1.0f} };
+
+		ImageMemoryBarrier::Insert(commandBuffer, swapChainImage, subresourceRange, 0,
+			VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+
+		vkCmdClearColorImage(commandBuffer, swapChainImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &clearColor, 1, &subresourceRange);
+
+		ImageMemoryBarrier::Insert(commandBuffer, swapChainImage, subresourceRange, VK_ACCESS_TRANSFER_WRITE_BIT,
+			0, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+		return;
+	}
+
+	CopyToSwapChain(commandBuffer, slot, imageIndex);
+	denoisedImageCached_[slot] = true;
+}
+
+void Application::TraceRays(VkCommandBuffer commandBuffer)
+{
+	const auto& device = Device();
+	const auto extent = renderExtent_;
+	const uint32_t slot = frameSlot_;
+	const auto& tracePipeline = GetTracePipeline(GetTracePermutation());
+	const auto& rayTracingPipeline = *tracePipeline.Pipeline;
+	const auto& shaderBindingTable = *tracePipeline.BindingTable;
+
+	VkDescriptorSet descriptorSets[] = { rayTracingPipeline.DescriptorSet(slot) };
 
 	VkImageSubresourceRange subresourceRange = {};
 	subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
@@ -212,31 +465,52 @@ void Application::Render(VkCommandBuffer commandBuffer, const uint32_t imageInde
 	ImageMemoryBarrier::Insert(commandBuffer, accumulationImage_->Handle(), subresourceRange, 0,
 		VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
 
-	ImageMemoryBarrier::Insert(commandBuffer, outputImage_->Handle(), subresourceRange, 0,
+	ImageMemoryBarrier::Insert(commandBuffer, specularAccumulationImage_->Image().Handle(), subresourceRange, 0,
 		VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
 
-	ImageMemoryBarrier::Insert(commandBuffer, myOutputImage_->Handle(), subresourceRange,
-		0, VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+	ImageMemoryBarrier::Insert(commandBuffer, outputImages_[slot]->Image().Handle(), subresourceRange, 0,
+		VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+
+	ImageMemoryBarrier::Insert(commandBuffer, specularImages_[slot]->Image().Handle(), subresourceRange, 0,
+		VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+
+	// The previous frame wrote the history this one reads, and read the one it overwrites.
+	for (const auto& image : sampleHistoryImages_)
+	{
+		ImageMemoryBarrier::Insert(commandBuffer, image->Image().Handle(), subresourceRange,
+			VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+			VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL);
+	}
+
+	// The G-buffer content must survive frames that trace no samples, take it back from the compute queue.
+	if (gBufferReleased_[slot])
+	{
+		gBuffers_[slot]->TransferOwnership(commandBuffer, device.ComputeFamilyIndex(), device.GraphicsFamilyIndex());
+		gBufferReleased_[slot] = false;
+	}
+
+	gBuffers_[slot]->AcquireForWrite(commandBuffer);
 
 	// Bind ray tracing pipeline.󶨹׷ٹ
-	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR, rayTracingPipeline_->Handle());
-	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR, rayTracingPipeline_->PipelineLayout().Handle(), 0, 1, descriptorSets, 0, nullptr);
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR, rayTracingPipeline.Handle());
+	const uint32_t uniformBufferOffset = UniformBufferOffset();
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR, rayTracingPipeline.PipelineLayout().Handle(), 0, 1, descriptorSets, 1, &uniformBufferOffset);
 
 	// Describe the shader binding table.ɫ󶨱
 	VkStridedDeviceAddressRegionKHR raygenShaderBindingTable = {};
-	raygenShaderBindingTable.deviceAddress = shaderBindingTable_->RayGenDeviceAddress();
-	raygenShaderBindingTable.stride = shaderBindingTable_->RayGenEntrySize();
-	raygenShaderBindingTable.size = shaderBindingTable_->RayGenSize();
+	raygenShaderBindingTable.deviceAddress = shaderBindingTable.RayGenDeviceAddress();
+	raygenShaderBindingTable.stride = shaderBindingTable.RayGenEntrySize();
+	raygenShaderBindingTable.size = shaderBindingTable.RayGenSize();
 
 	VkStridedDeviceAddressRegionKHR missShaderBindingTable = {};
-	missShaderBindingTable.deviceAddress = shaderBindingTable_->MissDeviceAddress();
-	missShaderBindingTable.stride = shaderBindingTable_->MissEntrySize();
-	missShaderBindingTable.size = shaderBindingTable_->MissSize();
+	missShaderBindingTable.deviceAddress = shaderBindingTable.MissDeviceAddress();
+	missShaderBindingTable.stride = shaderBindingTable.MissEntrySize();
+	missShaderBindingTable.size = shaderBindingTable.MissSize();
 
 	VkStridedDeviceAddressRegionKHR hitShaderBindingTable = {};
-	hitShaderBindingTable.deviceAddress = shaderBindingTable_->HitGroupDeviceAddress();
-	hitShaderBindingTable.stride = shaderBindingTable_->HitGroupEntrySize();
-	hitShaderBindingTable.size = shaderBindingTable_->HitGroupSize();
+	hitShaderBindingTable.deviceAddress = shaderBindingTable.HitGroupDeviceAddress();
+	hitShaderBindingTable.stride = shaderBindingTable.HitGroupEntrySize();
+	hitShaderBindingTable.size = shaderBindingTable.HitGroupSize();
 
 	VkStridedDeviceAddressRegionKHR callableShaderBindingTable = {};
 
@@ -244,29 +518,81 @@ void Application::Render(VkCommandBuffer commandBuffer, const uint32_t imageInde
 	deviceProcedures_->vkCmdTraceRaysKHR(commandBuffer,
 		&raygenShaderBindingTable, &missShaderBindingTable, &hitShaderBindingTable, &callableShaderBindingTable,
 		extent.width, extent.height, 1);
+}
+
+const Application::TracePipeline& Application::GetTracePipeline(const RayTracingPipeline::Permutation& permutation)
+{
+	auto& tracePipeline = tracePipelines_[permutation.Key()];
+
+	if (tracePipeline.Pipeline)
+	{
+		return tracePipeline;
+	}
+
+	tracePipeline.Pipeline.reset(new RayTracingPipeline(*deviceProcedures_, SwapChain(), topAs_[0], *accumulationImageView_,
+		{ &outputImages_[0]->ImageView(), &outputImages_[1]->ImageView() },
+		specularAccumulationImage_->ImageView(),
+		{ &specularImages_[0]->ImageView(), &specularImages_[1]->ImageView() },
+		{ gBuffers_[0].get(), gBuffers_[1].get() },
+		{ &sampleHistoryImages_[0]->ImageView(), &sampleHistoryImages_[1]->ImageView() },
+		UniformBufferArena(), GetScene(), PipelineCache(), permutation));
+
+	const auto& rayTracingPipeline = *tracePipeline.Pipeline;
+
+	//ɫ󶨱Ŀ
+	const std::vector<ShaderBindingTable::Entry> rayGenPrograms = { {rayTracingPipeline.RayGenShaderIndex(), {}} };//ɳб
+	const std::vector<ShaderBindingTable::Entry> missPrograms = { {rayTracingPipeline.MissShaderIndex(), {}} };//ûлκʱõɫ
+	const std::vector<ShaderBindingTable::Entry> hitGroups = { {rayTracingPipeline.TriangleHitGroupIndex(), {}}, {rayTracingPipeline.ProceduralHitGroupIndex(), {}} };//˹彻ʱӦδĳб˴Ϊλͳ򻯼λ顣
+
+	//ɫ󶨱
+	tracePipeline.BindingTable.reset(new ShaderBindingTable(*deviceProcedures_, rayTracingPipeline, *rayTracingProperties_, rayGenPrograms, missPrograms, hitGroups));
 
-	//ִкߵĺ
-	VkImageSubresourceRange depthSubresourceRange = {};
-	depthSubresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;  // עDEPTH_BIT
-	depthSubresourceRange.baseMipLevel = 0;
-	depthSubresourceRange.levelCount = 1;
-	depthSubresourceRange.baseArrayLayer = 0;
-	depthSubresourceRange.layerCount = 1;
+	return tracePipeline;
+}
 
-	//  VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL  VK_IMAGE_LAYOUT_GENERAL
-	ImageMemoryBarrier::Insert(commandBuffer, DepthBuffer().Image().Handle(), depthSubresourceRange,
-		VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
-		VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_GENERAL);
+void Application::Denoise(VkCommandBuffer commandBuffer, const uint32_t slot)
+{
+	VkImageSubresourceRange subresourceRange = {};
+	subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	subresourceRange.baseMipLevel = 0;
+	subresourceRange.levelCount = 1;
+	subresourceRange.baseArrayLayer = 0;
+	subresourceRange.layerCount = 1;
 
-	PerformPostProcessing(commandBuffer);
+	ImageMemoryBarrier::Insert(commandBuffer, denoisedImages_[slot]->Image().Handle(), subresourceRange,
+		0, VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+
+	//ִнߣԹɫдG-bufferΪ
+	denoiser_->Render(commandBuffer, slot, GetDenoiserParameters(renderExtent_));
 
-	//  VK_IMAGE_LAYOUT_GENERAL ת VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
-	ImageMemoryBarrier::Insert(commandBuffer, DepthBuffer().Image().Handle(), depthSubresourceRange,
-		VK_ACCESS_SHADER_READ_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
-		VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+	if (upscaler_)
+	{
+		ImageMemoryBarrier::Insert(commandBuffer, upscaler_->Output(slot).Image().Handle(), subresourceRange,
+			0, VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+
+		upscaler_->Render(commandBuffer, slot);
+	}
+}
+
+const RenderTarget& Application::PresentedImage(const uint32_t slot) const
+{
+	return upscaler_ ? upscaler_->Output(slot) : *denoisedImages_[slot];
+}
+
+void Application::CopyToSwapChain(VkCommandBuffer commandBuffer, const uint32_t slot, const uint32_t imageIndex)
+{
+	const auto extent = SwapChain().Extent();
+	const VkImage denoisedImage = PresentedImage(slot).Image().Handle();
+
+	VkImageSubresourceRange subresourceRange = {};
+	subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	subresourceRange.baseMipLevel = 0;
+	subresourceRange.levelCount = 1;
+	subresourceRange.baseArrayLayer = 0;
+	subresourceRange.layerCount = 1;
 
 	// Acquire output image and swap-chain image for copying. ޸ͼͽͼĲ֣׼Ʋ
-	ImageMemoryBarrier::Insert(commandBuffer, myOutputImage_->Handle(), subresourceRange,
+	ImageMemoryBarrier::Insert(commandBuffer, denoisedImage, subresourceRange,
 		VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
 
 	ImageMemoryBarrier::Insert(commandBuffer, SwapChain().Images()[imageIndex], subresourceRange, 0,
@@ -281,7 +607,7 @@ void Application::Render(VkCommandBuffer commandBuffer, const uint32_t imageInde
 	copyRegion.extent = { extent.width, extent.height, 1 };
 
 	vkCmdCopyImage(commandBuffer,
-		myOutputImage_->Handle(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+		denoisedImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
 		SwapChain().Images()[imageIndex], VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
 		1, &copyRegion);
 
@@ -290,152 +616,189 @@ void Application::Render(VkCommandBuffer commandBuffer, const uint32_t imageInde
 		0, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
 }
 
-void Application::CreatePostProcessing() {
-
-	// 1.----------------------------------------------------
-	VkDescriptorSetLayoutBinding bindings[3] = {};
-	bindings[0].binding = 0;
-	bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	bindings[0].descriptorCount = 1;
-	bindings[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
-
-	bindings[1].binding = 1;
-	bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	bindings[1].descriptorCount = 1;
-	bindings[1].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
-
-	bindings[2].binding = 2;
-	bindings[2].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-	bindings[2].descriptorCount = 1;
-	bindings[2].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
-
-	VkDescriptorSetLayoutCreateInfo layoutInfo = {};
-	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-	layoutInfo.bindingCount = 3;
-	layoutInfo.pBindings = bindings;
-
-	//VkDescriptorSetLayout descriptorSetLayout;
-	vkCreateDescriptorSetLayout(Device().Handle(), &layoutInfo, nullptr, &descriptorSetLayout);
-
-	// 2.---------------------------------------------
-	VkDescriptorPoolSize poolSizes[3] = {};
-	poolSizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	poolSizes[0].descriptorCount = 1;
-	poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	poolSizes[1].descriptorCount = 1;
-	poolSizes[2].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-	poolSizes[2].descriptorCount = 1;
-
-	VkDescriptorPoolCreateInfo poolInfo = {};
-	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-	poolInfo.poolSizeCount = 3;
-	poolInfo.pPoolSizes = poolSizes;
-	poolInfo.maxSets = 1;
-
-	//VkDescriptorPool descriptorPool;
-	vkCreateDescriptorPool(Device().Handle(), &poolInfo, nullptr, &descriptorPool);
-
-	// 3.------------------------------------------------
-	VkDescriptorSetAllocateInfo allocInfo = {};
-	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-	allocInfo.descriptorPool = descriptorPool;
-	allocInfo.descriptorSetCount = 1;
-	allocInfo.pSetLayouts = &descriptorSetLayout;
-
-	//VkDescriptorSet descriptorSet;
-	vkAllocateDescriptorSets(Device().Handle(), &allocInfo, &descriptorSet);
-
-	VkDescriptorImageInfo imageInfos[3] = {};
-	// ͼ
-	imageInfos[0].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
-	imageInfos[0].imageView = outputImageView_->Handle();
-	imageInfos[0].sampler = outputImageSampler_->Handle();
-
-	// 
-	imageInfos[1].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
-	imageInfos[1].imageView = DepthBuffer().ImageView().Handle();
-	imageInfos[1].sampler = depthSampler_->Handle();
-
-	// ͼעûвΪдͼ
-	imageInfos[2].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
-	imageInfos[2].imageView = myOutputImageView_->Handle();
-	imageInfos[2].sampler = VK_NULL_HANDLE;
-
-	VkWriteDescriptorSet descriptorWrites[3] = {};
-
-	descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-	descriptorWrites[0].dstSet = descriptorSet;
-	descriptorWrites[0].dstBinding = 0;
-	descriptorWrites[0].dstArrayElement = 0;
-	descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	descriptorWrites[0].descriptorCount = 1;
-	descriptorWrites[0].pImageInfo = &imageInfos[0];
-
-	// for Depth Texture
-	descriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-	descriptorWrites[1].dstSet = descriptorSet;
-	descriptorWrites[1].dstBinding = 1;
-	descriptorWrites[1].dstArrayElement = 0;
-	descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	descriptorWrites[1].descriptorCount = 1;
-	descriptorWrites[1].pImageInfo = &imageInfos[1];  // 
-
-	// for Output Image
-	descriptorWrites[2].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-	descriptorWrites[2].dstSet = descriptorSet;
-	descriptorWrites[2].dstBinding = 2;
-	descriptorWrites[2].dstArrayElement = 0;
-	descriptorWrites[2].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-	descriptorWrites[2].descriptorCount = 1;
-	descriptorWrites[2].pImageInfo = &imageInfos[2];  // ͼ
-
-	// 
-	vkUpdateDescriptorSets(Device().Handle(), 3, descriptorWrites, 0, nullptr);
-
-	// 4.------------------------------------------------------------
-	const ShaderModule BFShader(Device(), "../assets/shaders/BF.comp.spv");
-
-	// ù߽׶
-	VkPipelineShaderStageCreateInfo shaderStageInfo = {};
-	shaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-	shaderStageInfo.stage = VK_SHADER_STAGE_COMPUTE_BIT;
-	shaderStageInfo.module = BFShader.Handle();
-	shaderStageInfo.pName = "main";
-
-	// ߲
-	VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
-	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-	pipelineLayoutInfo.setLayoutCount = 1;
-	pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;
-
-	//VkPipelineLayout pipelineLayout;
-	vkCreatePipelineLayout(Device().Handle(), &pipelineLayoutInfo, nullptr, &pipelineLayout);
-
-	// 
-	VkComputePipelineCreateInfo pipelineInfo = {};
-	pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
-	pipelineInfo.stage = shaderStageInfo;
-	pipelineInfo.layout = pipelineLayout;
-
-	//VkPipeline computePipeline;
-	vkCreateComputePipelines(Device().Handle(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &computePipeline);
+void Application::RunDenoiserBenchmark(const std::vector<VkExtent2D>& extents, const uint32_t frameCount)
+{
+	std::cout << std::endl;
+
+	// The half precision outputs are compared to the single precision one on the same inputs.
+	std::vector<Denoiser::Precision> precisions = { Denoiser::Precision::Float32, Denoiser::Precision::Float16Storage };
+
+	if (shaderFloat16_)
+	{
+		precisions.push_back(Denoiser::Precision::Float16);
+	}
+
+	const Utilities::ImageMetrics metrics;
+
+	for (const auto extent : extents)
+	{
+		auto parameters = GetDenoiserParameters(extent);
+		parameters.Enabled = true;
+
+		std::vector<uint8_t> reference;
+		std::vector<float> referenceFloats;
+
+		for (const auto precision : precisions)
+		{
+			DenoiserBenchmark benchmark(CommandPool(), PipelineCache(), extent, precision);
+			const double milliseconds = benchmark.Run(parameters, frameCount);
+			const auto output = benchmark.ReadOutput();
+
+			std::cout << "Denoiser Benchmark: " << extent.width << "x" << extent.height << ", "
+				<< parameters.ATrousIterations << " a-trous iterations, " << PrecisionName(precision) << ": " << milliseconds << " ms";
+
+			if (precision == Denoiser::Precision::Float32)
+			{
+				reference = output;
+				referenceFloats = ToFloats(output);
+			}
+			else
+			{
+				const auto outputFloats = ToFloats(output);
+				const auto scores = metrics.Compare(
+					{ outputFloats.data(), extent.width, extent.height, 4 },
+					{ referenceFloats.data(), extent.width, extent.height, 4 });
+
+				std::cout << " (PSNR " << scores.Psnr << " dB, SSIM " << scores.Ssim << ", FLIP " << scores.Flip
+					<< ", max difference " << MaxDifference(reference, output) << ")";
+			}
+
+			std::cout << std::endl;
+		}
+	}
+}
+
+Utilities::DenoiserFrame Application::ReadDenoiserInputs()
+{
+	const auto extent = renderExtent_;
+	const size_t pixelCount = static_cast<size_t>(extent.width) * extent.height;
+	const uint32_t slot = frameSlot_;
+	const auto& gBuffer = *gBuffers_[slot];
+
+	// Images in the order of the readback buffer, with their texel sizes.
+	const std::array<std::pair<const RenderTarget*, size_t>, 6> images =
+	{{
+		{ outputImages_[slot].get(), 16 },
+		{ specularImages_[slot].get(), 16 },
+		{ &gBuffer.Albedo(), 4 },
+		{ &gBuffer.Depth(), 4 },
+		{ &gBuffer.NormalMotion(), 8 },
+		{ &gBuffer.InstanceId(), 4 }
+	}};
+
+	std::array<size_t, 7> offsets = {};
+
+	for (size_t i = 0; i != images.size(); ++i)
+	{
+		offsets[i + 1] = offsets[i] + images[i].second * pixelCount;
+	}
+
+	Buffer readbackBuffer(Device(), offsets.back(), VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+	DeviceMemory readbackBufferMemory = readbackBuffer.AllocateTransientMemory(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+	Device().WaitIdle();
+
+	SingleTimeCommands::Submit(CommandPool(), [&](VkCommandBuffer commandBuffer)
+	{
+		VkImageSubresourceRange colorRange = {};
+		colorRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		colorRange.baseMipLevel = 0;
+		colorRange.levelCount = 1;
+		colorRange.baseArrayLayer = 0;
+		colorRange.layerCount = 1;
+
+		for (size_t i = 0; i != images.size(); ++i)
+		{
+			const VkImage image = images[i].first->Image().Handle();
+
+			ImageMemoryBarrier::Insert(commandBuffer, image, colorRange, VK_ACCESS_SHADER_WRITE_BIT,
+				VK_ACCESS_TRANSFER_READ_BIT, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL);
+
+			VkBufferImageCopy region = {};
+			region.bufferOffset = offsets[i];
+			region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			region.imageSubresource.layerCount = 1;
+			region.imageExtent = { extent.width, extent.height, 1 };
+
+			vkCmdCopyImageToBuffer(commandBuffer, image, VK_IMAGE_LAYOUT_GENERAL, readbackBuffer.Handle(), 1, &region);
+
+			ImageMemoryBarrier::Insert(commandBuffer, image, colorRange, VK_ACCESS_TRANSFER_READ_BIT,
+				VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL);
+		}
+	});
+
+	const auto* data = static_cast<const uint8_t*>(readbackBufferMemory.Map(0, offsets.back()));
+	const auto* albedo = data + offsets[2];
+	const auto* normalMotion = reinterpret_cast<const uint16_t*>(data + offsets[4]);
+
+	Utilities::DenoiserFrame frame;
+	frame.Resize(extent.width, extent.height);
+
+	std::memcpy(frame.Diffuse.data(), data + offsets[0], offsets[1] - offsets[0]);
+	std::memcpy(frame.Specular.data(), data + offsets[1], offsets[2] - offsets[1]);
+	std::memcpy(frame.Depth.data(), data + offsets[3], offsets[4] - offsets[3]);
+	std::memcpy(frame.InstanceId.data(), data + offsets[5], offsets[6] - offsets[5]);
+
+	// The reference denoiser takes every input in single precision floats.
+	for (size_t i = 0; i != 4 * pixelCount; ++i)
+	{
+		frame.Albedo[i] = albedo[i] / 255.0f;
+		frame.NormalMotion[i] = glm::unpackHalf1x16(normalMotion[i]);
+	}
+
+	readbackBufferMemory.Unmap();
+
+	return frame;
 }
 
-void Application::PerformPostProcessing(VkCommandBuffer commandBuffer)
+std::vector<uint8_t> Application::ReadDenoisedOutput()
 {
+	const auto extent = renderExtent_;
+	const size_t size = 4 * static_cast<size_t>(extent.width) * extent.height;
+	const VkImage image = denoisedImages_[frameSlot_]->Image().Handle();
 
-	// 󶨼
-	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipeline);
+	// Without upscaling, the denoised image was last copied to the swap chain.
+	const VkImageLayout layout = upscaler_ ? VK_IMAGE_LAYOUT_GENERAL : VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
 
-	// 
-	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &descriptorSet, 0, nullptr);
+	Buffer readbackBuffer(Device(), size, VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+	DeviceMemory readbackBufferMemory = readbackBuffer.AllocateTransientMemory(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
 
-	// 㹤
-	uint32_t workGroupX = SwapChain().Extent().width;
-	uint32_t workGroupY = SwapChain().Extent().height;
+	Device().WaitIdle();
+
+	SingleTimeCommands::Submit(CommandPool(), [&](VkCommandBuffer commandBuffer)
+	{
+		VkImageSubresourceRange colorRange = {};
+		colorRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		colorRange.baseMipLevel = 0;
+		colorRange.levelCount = 1;
+		colorRange.baseArrayLayer = 0;
+		colorRange.layerCount = 1;
 
-	// ַ
-	vkCmdDispatch(commandBuffer, workGroupX, workGroupY, 1);
+		ImageMemoryBarrier::Insert(commandBuffer, image, colorRange, VK_ACCESS_SHADER_WRITE_BIT,
+			VK_ACCESS_TRANSFER_READ_BIT, layout, layout);
+
+		VkBufferImageCopy region = {};
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.layerCount = 1;
+		region.imageExtent = { extent.width, extent.height, 1 };
+
+		vkCmdCopyImageToBuffer(commandBuffer, image, layout, readbackBuffer.Handle(), 1, &region);
+
+		ImageMemoryBarrier::Insert(commandBuffer, image, colorRange, VK_ACCESS_TRANSFER_READ_BIT,
+			VK_ACCESS_SHADER_READ_BIT, layout, layout);
+	});
+
+	std::vector<uint8_t> output(size);
+	std::memcpy(output.data(), readbackBufferMemory.Map(0, size), size);
+	readbackBufferMemory.Unmap();
+
+	// The swap chain format is BGRA (see SwapChain::ChooseSwapSurfaceFormat()).
+	for (size_t i = 0; i != size; i += 4)
+	{
+		std::swap(output[i + 0], output[i + 2]);
+	}
+
+	return output;
 }
 
 void Application::CreateBottomLevelStructures(VkCommandBuffer commandBuffer)
@@ -470,9 +833,9 @@ void Application::CreateBottomLevelStructures(VkCommandBuffer commandBuffer)
 	const auto total = GetTotalRequirements(bottomAs_);
 
 	bottomBuffer_.reset(new Buffer(Device(), total.accelerationStructureSize, VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_STORAGE_BIT_KHR));
-	bottomBufferMemory_.reset(new DeviceMemory(bottomBuffer_->AllocateMemory(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)));
+	bottomBufferMemory_.reset(new DeviceMemory(bottomBuffer_->AllocateMemory(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryAllocator::Category::AccelerationStructures)));
 	bottomScratchBuffer_.reset(new Buffer(Device(), total.buildScratchSize, VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_STORAGE_BIT_KHR | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT));
-	bottomScratchBufferMemory_.reset(new DeviceMemory(bottomScratchBuffer_->AllocateMemory(VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)));
+	bottomScratchBufferMemory_.reset(new DeviceMemory(bottomScratchBuffer_->AllocateMemory(VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryAllocator::Category::Scratch)));
 
 	debugUtils.SetObjectName(bottomBuffer_->Handle(), "BLAS Buffer");
 	debugUtils.SetObjectName(bottomBufferMemory_->Handle(), "BLAS Memory");
@@ -514,7 +877,7 @@ void Application::CreateTopLevelStructures(VkCommandBuffer commandBuffer)
 	}
 
 	// Create and copy instances buffer (do it in a separate one-time synchronous command buffer).
-	BufferUtil::CreateDeviceBuffer(CommandPool(), "TLAS Instances", VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT, instances, instancesBuffer_, instancesBufferMemory_);
+	BufferUtil::CreateDeviceBuffer(CommandPool(), "TLAS Instances", VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT, instances, instancesBuffer_, instancesBufferMemory_, MemoryAllocator::Category::AccelerationStructures);
 
 	// Memory barrier for the bottom level acceleration structure builds.
 	AccelerationStructure::MemoryBarrier(commandBuffer);
@@ -525,10 +888,10 @@ void Application::CreateTopLevelStructures(VkCommandBuffer commandBuffer)
 	const auto total = GetTotalRequirements(topAs_);
 
 	topBuffer_.reset(new Buffer(Device(), total.accelerationStructureSize, VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_STORAGE_BIT_KHR));
-	topBufferMemory_.reset(new DeviceMemory(topBuffer_->AllocateMemory(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)));
+	topBufferMemory_.reset(new DeviceMemory(topBuffer_->AllocateMemory(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryAllocator::Category::AccelerationStructures)));
 
 	topScratchBuffer_.reset(new Buffer(Device(), total.buildScratchSize, VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_STORAGE_BIT_KHR | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT));
-	topScratchBufferMemory_.reset(new DeviceMemory(topScratchBuffer_->AllocateMemory(VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)));
+	topScratchBufferMemory_.reset(new DeviceMemory(topScratchBuffer_->AllocateMemory(VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryAllocator::Category::Scratch)));
 
 	
 	debugUtils.SetObjectName(topBuffer_->Handle(), "TLAS Buffer");
@@ -546,32 +909,51 @@ void Application::CreateTopLevelStructures(VkCommandBuffer commandBuffer)
 
 void Application::CreateOutputImage()
 {
-	const auto extent = SwapChain().Extent();
+	const auto extent = renderExtent_;
 	const auto format = SwapChain().Format();
-	const auto tiling = VK_IMAGE_TILING_OPTIMAL;
 
 	accumulationImage_.reset(new Image(Device(), extent, VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_STORAGE_BIT));
-	accumulationImageMemory_.reset(new DeviceMemory(accumulationImage_->AllocateMemory(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)));
+	accumulationImageMemory_.reset(new DeviceMemory(accumulationImage_->AllocateMemory(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryAllocator::Category::RenderTargets)));
 	accumulationImageView_.reset(new ImageView(Device(), accumulationImage_->Handle(), VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_ASPECT_COLOR_BIT));
+	specularAccumulationImage_.reset(new RenderTarget(Device(), extent, VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_USAGE_STORAGE_BIT, "Specular Accumulation"));
+
+	//׷ԿռͼɽдdenoisedImages_
+	// The primary hit attributes are written by the ray generation shader, no raster pass is needed in ray tracing mode.
+	for (size_t i = 0; i != outputImages_.size(); ++i)
+	{
+		outputImages_[i].reset(new RenderTarget(Device(), extent, VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, "Output"));
+		specularImages_[i].reset(new RenderTarget(Device(), extent, VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, "Specular Output"));
+		gBuffers_[i].reset(new GBuffer(CommandPool(), extent));
+		denoisedImages_[i].reset(new RenderTarget(Device(), extent, format, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, "Denoised Output"));
+		sampleHistoryImages_[i].reset(new RenderTarget(Device(), extent, VK_FORMAT_R32G32B32A32_UINT, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT, "Sample History"));
+	}
+
+	// An empty sample history has no instance, the first frame replays no path.
+	SingleTimeCommands::Submit(CommandPool(), [this](VkCommandBuffer commandBuffer)
+	{
+		VkImageSubresourceRange subresourceRange = {};
+		subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		subresourceRange.baseMipLevel = 0;
+		subresourceRange.levelCount = 1;
+		subresourceRange.baseArrayLayer = 0;
+		subresourceRange.layerCount = 1;
 
-	outputImage_.reset(new Image(Device(), extent, format, tiling, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_SAMPLED_BIT));
-	outputImageMemory_.reset(new DeviceMemory(outputImage_->AllocateMemory(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)));
-	outputImageView_.reset(new ImageView(Device(), outputImage_->Handle(), format, VK_IMAGE_ASPECT_COLOR_BIT));
-	outputImageSampler_.reset(new Vulkan::Sampler(Device(), Vulkan::SamplerConfig()));
+		const VkClearColorValue clearColor = {};
 
-	myOutputImage_.reset(new Image(Device(), extent, format, tiling, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT));
-	myOutputImageMemory_.reset(new DeviceMemory(myOutputImage_->AllocateMemory(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)));
-	myOutputImageView_.reset(new ImageView(Device(), myOutputImage_->Handle(), format, VK_IMAGE_ASPECT_COLOR_BIT));
+		for (const auto& image : sampleHistoryImages_)
+		{
+			ImageMemoryBarrier::Insert(commandBuffer, image->Image().Handle(), subresourceRange, 0,
+				VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+
+			vkCmdClearColorImage(commandBuffer, image->Image().Handle(), VK_IMAGE_LAYOUT_GENERAL, &clearColor, 1, &subresourceRange);
+		}
+	});
 
 	const auto& debugUtils = Device().DebugUtils();
 	
 	debugUtils.SetObjectName(accumulationImage_->Handle(), "Accumulation Image");
 	debugUtils.SetObjectName(accumulationImageMemory_->Handle(), "Accumulation Image Memory");
 	debugUtils.SetObjectName(accumulationImageView_->Handle(), "Accumulation ImageView");
-	
-	debugUtils.SetObjectName(outputImage_->Handle(), "Output Image");
-	debugUtils.SetObjectName(outputImageMemory_->Handle(), "Output Image Memory");
-	debugUtils.SetObjectName(outputImageView_->Handle(), "Output ImageView");
 }
 
 }
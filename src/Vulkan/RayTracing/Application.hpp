@@ -1,7 +1,12 @@
 #pragma once
 
 #include "Vulkan/Application.hpp"
+#include "Denoiser.hpp"
+#include "RayTracingPipeline.hpp"
 #include "RayTracingProperties.hpp"
+#include "Utilities/DenoiserFrame.hpp"
+#include <array>
+#include <map>
 
 namespace Vulkan
 {
@@ -10,19 +15,25 @@ namespace Vulkan
 	class DeviceMemory;
 	class Image;
 	class ImageView;
+	class RenderTarget;
 }
 
 namespace Vulkan::RayTracing
 {
+	class TemporalUpscaler;
+
 	class Application : public Vulkan::Application
 	{
 	public:
 
 		VULKAN_NON_COPIABLE(Application);
+
+		// Times the denoiser alone on synthetic inputs at each of the given resolutions and prints the results.
+		void RunDenoiserBenchmark(const std::vector<VkExtent2D>& extents, uint32_t frameCount);
 		
 	protected:
 
-		Application(const WindowConfig& windowConfig, VkPresentModeKHR presentMode, bool enableValidationLayers);
+		Application(const WindowConfig& windowConfig, VkPresentModeKHR presentMode, uint32_t framesInFlight, bool enableValidationLayers);
 		~Application();
 
 		void SetPhysicalDevice(VkPhysicalDevice physicalDevice,
@@ -36,23 +47,68 @@ namespace Vulkan::RayTracing
 		void CreateSwapChain() override;
 		void DeleteSwapChain() override;
 		void Render(VkCommandBuffer commandBuffer, uint32_t imageIndex) override;
+		void RenderCompute(VkCommandBuffer commandBuffer) override;
+		void RenderPresent(VkCommandBuffer commandBuffer, uint32_t imageIndex) override;
+		bool IsSwapChainOutdated() const override;
+
+		virtual Denoiser::Parameters GetDenoiserParameters(VkExtent2D extent) const = 0;
+		// Half precision filter images, with half float arithmetic as well where the device supports it.
+		virtual bool UseHalfPrecisionDenoiser() const = 0;
+		virtual RayTracingPipeline::Permutation GetRayTracingPermutation() const = 0;
+		// Fraction of the display resolution that is traced, the temporal upscaler reconstructs the display image below one.
+		virtual float GetRenderScale() const = 0;
+
+		// An idle frame neither traces nor denoises, it presents the last denoised image again.
+		virtual bool IsIdle() const { return false; }
+
+		// Remaining error of the denoised output a few frames back, negative when unknown (see Denoiser::ErrorEstimate()).
+		float ErrorEstimate() const { return denoiser_->ErrorEstimate(); }
+
+		// Processed and total tiles of each a-trous iteration of the same frame (see Denoiser::ATrousTileCounts()).
+		std::vector<std::pair<uint32_t, uint32_t>> ATrousTileCounts() const { return denoiser_->ATrousTileCounts(); }
+
+		// Waits for the device and reads back the noisy illumination and the G-buffer of the last traced frame, for offline
+		// denoising (see Utilities::DenoiserTuner). Requires the images to be owned by the graphics queue (no async compute).
+		Utilities::DenoiserFrame ReadDenoiserInputs();
+
+		// Waits for the device and reads back the denoised image of the same frame, before any upscaling, as 8 bit RGBA.
+		// The golden data of the CPU reference denoiser (see DenoiserTool --check-denoiser-frames).
+		std::vector<uint8_t> ReadDenoisedOutput();
 
-		VkDescriptorSet descriptorSet;
-		VkDescriptorSetLayout descriptorSetLayout;
-		VkDescriptorPool descriptorPool;
-		VkPipelineLayout pipelineLayout;
-		VkPipeline computePipeline;
+		// Resolution of the trace and of the denoiser, the swap chain extent scaled by GetRenderScale().
+		VkExtent2D RenderExtent() const { return renderExtent_; }
+
+		// Sub-pixel offset of the first path of each pixel in the frame being rendered, zero without upscaling.
+		glm::vec2 PixelJitter() const;
 			   
 	private:
 
-		void CreatePostProcessing();
-		void PerformPostProcessing(VkCommandBuffer commandBuffer);
+		// A ray tracing pipeline permutation and its shader binding table, the group handles are specific to the pipeline.
+		struct TracePipeline
+		{
+			std::unique_ptr<RayTracingPipeline> Pipeline;
+			std::unique_ptr<class ShaderBindingTable> BindingTable;
+		};
+
+		// Creates the permutation on first use, the pipelines are kept until the swap chain is recreated.
+		const TracePipeline& GetTracePipeline(const RayTracingPipeline::Permutation& permutation);
+
+		// The requested permutation, jittered when the frames are upscaled.
+		RayTracingPipeline::Permutation GetTracePermutation() const;
+
 		void CreateBottomLevelStructures(VkCommandBuffer commandBuffer);
 		void CreateTopLevelStructures(VkCommandBuffer commandBuffer);
 		void CreateOutputImage();
+		void TraceRays(VkCommandBuffer commandBuffer);
+		void Denoise(VkCommandBuffer commandBuffer, uint32_t slot);
+		const RenderTarget& PresentedImage(uint32_t slot) const;
+		void CopyToSwapChain(VkCommandBuffer commandBuffer, uint32_t slot, uint32_t imageIndex);
+		void PresentDenoisedImage(VkCommandBuffer commandBuffer, uint32_t slot, uint32_t imageIndex);
+		Denoiser::Precision GetDenoiserPrecision(bool halfPrecision) const;
 
 		std::unique_ptr<class DeviceProcedures> deviceProcedures_;
 		std::unique_ptr<class RayTracingProperties> rayTracingProperties_;
+		bool shaderFloat16_{};
 
 		std::vector<class BottomLevelAccelerationStructure> bottomAs_;
 		std::unique_ptr<Buffer> bottomBuffer_;
@@ -70,19 +126,37 @@ namespace Vulkan::RayTracing
 		std::unique_ptr<Image> accumulationImage_;
 		std::unique_ptr<DeviceMemory> accumulationImageMemory_;
 		std::unique_ptr<ImageView> accumulationImageView_;
+		std::unique_ptr<RenderTarget> specularAccumulationImage_;
 
-		std::unique_ptr<Image> outputImage_;
-		std::unique_ptr<DeviceMemory> outputImageMemory_;
-		std::unique_ptr<ImageView> outputImageView_;
-		std::unique_ptr<Sampler> outputImageSampler_;
+		// The images written by the trace of a frame and read by its denoising alternate between two slots,
+		// so that with async compute the denoiser can filter one frame while the next one is traced.
+		// The outputs hold the demodulated diffuse and specular illumination, remodulated by the denoiser.
+		std::array<std::unique_ptr<RenderTarget>, 2> outputImages_;
+		std::array<std::unique_ptr<RenderTarget>, 2> specularImages_;
+		std::array<std::unique_ptr<class GBuffer>, 2> gBuffers_;
+		std::array<std::unique_ptr<RenderTarget>, 2> denoisedImages_;
+
+		// First path of every pixel (random seed, luminance, instance and depth) for the temporal gradients. Only
+		// the ray generation shader reads and writes them, they stay on the graphics queue.
+		std::array<std::unique_ptr<RenderTarget>, 2> sampleHistoryImages_;
 		
-		std::unique_ptr<class RayTracingPipeline> rayTracingPipeline_;
-		std::unique_ptr<class ShaderBindingTable> shaderBindingTable_;
+		std::map<uint32_t, TracePipeline> tracePipelines_;
+		std::unique_ptr<Denoiser> denoiser_;
+
+		// Only below a render scale of one, it then writes the presented images from the denoised ones.
+		std::unique_ptr<TemporalUpscaler> upscaler_;
+		VkExtent2D renderExtent_{};
+		float renderScale_{};
+
+		// Slot of the frame being recorded, the other one holds the previous frame.
+		uint32_t frameSlot_{};
 
-		std::unique_ptr<Image> myOutputImage_;
-		std::unique_ptr<DeviceMemory> myOutputImageMemory_;
-		std::unique_ptr<ImageView> myOutputImageView_;
+		// Async compute state: a denoised frame waits to be presented, a G-buffer has been released by the compute queue.
+		bool denoisedFramePending_{};
+		std::array<bool, 2> gBufferReleased_{};
 
+		// The denoised image of the slot has been presented and can be presented again by idle frames.
+		std::array<bool, 2> denoisedImageCached_{};
 	};
 
 }
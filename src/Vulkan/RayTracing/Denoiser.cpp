@@ -0,0 +1,879 @@
+#include "Denoiser.hpp"
+#include "GBuffer.hpp"
+#include "Vulkan/Buffer.hpp"
+#include "Vulkan/CommandPool.hpp"
+#include "Vulkan/ComputePipeline.hpp"
+#include "Vulkan/DescriptorBinding.hpp"
+#include "Vulkan/DescriptorSetManager.hpp"
+#include "Vulkan/DescriptorSets.hpp"
+#include "Vulkan/Device.hpp"
+#include "Vulkan/Image.hpp"
+#include "Vulkan/ImageMemoryBarrier.hpp"
+#include "Vulkan/ImageView.hpp"
+#include "Vulkan/PipelineCache.hpp"
+#include "Vulkan/PipelineLayout.hpp"
+#include "Vulkan/RenderTarget.hpp"
+#include "Vulkan/SingleTimeCommands.hpp"
+#include "Vulkan/SpecializationConstants.hpp"
+#include "Vulkan/TransientRenderTargets.hpp"
+#include <algorithm>
+#include <initializer_list>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace Vulkan::RayTracing {
+
+namespace
+{
+	// Must match the push constant block in Denoiser.glsl.
+	struct Constants
+	{
+		glm::ivec2 Extent;
+		float PhiColor;
+		float PhiNormal;
+		float PhiDepth;
+		float ColorAlpha;
+		float MomentsAlpha;
+		int32_t StepSize;
+		uint32_t SampleBudget;
+		uint32_t ATrousIterations;
+		float TileThreshold;
+		uint32_t TileListOffset;
+	};
+
+	// Specialization constants of the pass permutations, bit i sets constant_id i in Denoiser.glsl.
+	const uint32_t SpecializeWriteHistory = 1u << 0;
+	const uint32_t SpecializeBypass = 1u << 1;
+	const uint32_t SpecializeResetHistory = 1u << 2;
+	const uint32_t SpecializeTemporalGradient = 1u << 3;
+	const uint32_t SpecializeIndirectTiles = 1u << 4;
+	const uint32_t SpecializationConstantCount = 5;
+
+	// Stages of a frame in the order Render() runs them, the passes of the frame-local images (see TransientRenderTargets).
+	enum Stage : uint32_t
+	{
+		GeometryStage,
+		TemporalStage,
+		VarianceStage,
+		ATrousStage,
+		CompositeStage
+	};
+
+	struct PassShader
+	{
+		const char* Name;
+		const char* Filename;
+		Stage Stage;
+	};
+
+	// Indexed by Denoiser::Pass.
+	const PassShader PassShaders[] =
+	{
+		{ "Geometry", "../assets/shaders/Denoiser.Geometry", GeometryStage },
+		{ "Temporal", "../assets/shaders/Denoiser.Temporal", TemporalStage },
+		{ "Variance", "../assets/shaders/Denoiser.Variance", VarianceStage },
+		{ "A-Trous", "../assets/shaders/Denoiser.ATrous", ATrousStage },
+		{ "Composite", "../assets/shaders/Denoiser.Composite", CompositeStage },
+		{ "Sample Weight", "../assets/shaders/Denoiser.SampleWeight", CompositeStage },
+		{ "Sample Map", "../assets/shaders/Denoiser.SampleMap", CompositeStage },
+		{ "Gradient", "../assets/shaders/Denoiser.Gradient", GeometryStage },
+		{ "Tile Classify", "../assets/shaders/Denoiser.TileClassify", VarianceStage },
+		{ "Tile List", "../assets/shaders/Denoiser.TileList", ATrousStage }
+	};
+
+	// Compiled shader suffix of each precision variant, indexed by Denoiser::Precision (see assets/CMakeLists.txt).
+	const char* const PrecisionSuffixes[] = { ".comp.spv", ".Float16Storage.comp.spv", ".Float16.comp.spv" };
+
+	// Must match Denoiser.glsl, the weight sum holds the workgroup averages in fixed point.
+	const float SampleWeightScale = 1024.0f;
+	const uint32_t SampleWeightGroupSize = 16 * 16;
+
+	// Readback value of the frames that did not estimate their error.
+	const uint32_t NoErrorEstimate = ~0u;
+
+	// Workgroup sizes of the passes, must match the local_size declarations in the shaders.
+	// The neighbourhood filters use smaller groups to keep their shared memory tiles (group plus apron) small.
+	const uint32_t PointLocalSize = 16;
+	const uint32_t TileLocalSize = 8;
+
+	// Iterations of the gradient reconstruction, odd so that the result ends in the target of the even directions
+	// the temporal pass reads it from.
+	const uint32_t GradientIterations = 3;
+	const VkFormat GradientFormat = VK_FORMAT_R16G16B16A16_SFLOAT;
+
+	uint32_t GroupCount(const uint32_t size, const uint32_t localSize)
+	{
+		return (size + localSize - 1) / localSize;
+	}
+
+	// Each a-trous workgroup filters an 8x8 lattice of pixels spaced by the step size, so that all the taps of
+	// the group fall into its shared memory tile. There are stepSize^2 interleaved lattices to cover.
+	VkExtent2D ATrousGroupCount(const VkExtent2D extent, const uint32_t stepSize)
+	{
+		return
+		{
+			stepSize * GroupCount(GroupCount(extent.width, stepSize), TileLocalSize),
+			stepSize * GroupCount(GroupCount(extent.height, stepSize), TileLocalSize)
+		};
+	}
+
+	// Tiles of the adaptive a-trous iterations, must match Denoiser.glsl.
+	const uint32_t ClassificationTileSize = 16;
+
+	// Layout of an indirect dispatch in the tile dispatch buffer, padded to a uvec4 which keeps the list length last.
+	const VkDeviceSize TileDispatchStride = 4 * sizeof(uint32_t);
+
+	// The guide keeps full precision whatever the filter precision, the depth tests and weights are sensitive to it.
+	const VkFormat GuideFormat = VK_FORMAT_R32G32B32A32_SFLOAT;
+
+	// History, moments and filter images. The moments also hold the history length, hence four channels.
+	VkFormat FilterFormat(const Denoiser::Precision precision)
+	{
+		return precision == Denoiser::Precision::Float32 ? VK_FORMAT_R32G32B32A32_SFLOAT : VK_FORMAT_R16G16B16A16_SFLOAT;
+	}
+
+	// Descriptor sets are indexed by (slot, frame parity, signal, filter direction).
+	uint32_t DescriptorSetIndex(const uint32_t slot, const uint32_t parity, const uint32_t signal, const uint32_t direction)
+	{
+		return ((slot * 2 + parity) * 2 + signal) * 2 + direction;
+	}
+
+	// Make the result of the previous compute pass visible to the next one.
+	void InsertComputeBarrier(VkCommandBuffer commandBuffer, const VkPipelineStageFlags srcStageMask)
+	{
+		VkMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+		vkCmdPipelineBarrier(commandBuffer, srcStageMask, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+	}
+
+	// Make the indirect dispatches and tile lists written by a compute pass visible to the dispatches that use them.
+	void InsertIndirectBarrier(VkCommandBuffer commandBuffer)
+	{
+		VkMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+	}
+
+	// Zero a buffer the compute passes accumulate into, once the previous frame's passes are done reading it.
+	void ClearComputeBuffer(VkCommandBuffer commandBuffer, const Buffer& buffer)
+	{
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 0, nullptr);
+		vkCmdFillBuffer(commandBuffer, buffer.Handle(), 0, VK_WHOLE_SIZE, 0);
+		InsertComputeBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT);
+	}
+}
+
+Denoiser::Denoiser(
+	CommandPool& commandPool,
+	const PipelineCache& pipelineCache,
+	const VkExtent2D extent,
+	const Precision precision,
+	const uint32_t framesInFlight,
+	const std::array<const GBuffer*, 2>& gBuffers,
+	const std::array<const ImageView*, 2>& diffuseImageViews,
+	const std::array<const ImageView*, 2>& specularImageViews,
+	const std::array<const ImageView*, 2>& outputImageViews) :
+	device_(commandPool.Device()),
+	pipelineCache_(pipelineCache),
+	extent_(extent),
+	precision_(precision),
+	readbackCount_(framesInFlight + 1),
+	tileReadbackFrames_(framesInFlight + 1)
+{
+	const auto& device = device_;
+
+	sampleWeightSumBuffer_.reset(new Buffer(device, sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT));
+	sampleWeightSumBufferMemory_.reset(new DeviceMemory(sampleWeightSumBuffer_->AllocateMemory(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)));
+
+	errorReadbackBuffer_.reset(new Buffer(device, readbackCount_ * sizeof(uint32_t), VK_BUFFER_USAGE_TRANSFER_DST_BIT));
+	errorReadbackBufferMemory_.reset(new DeviceMemory(errorReadbackBuffer_->AllocateMemory(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)));
+	errorReadback_ = static_cast<uint32_t*>(errorReadbackBufferMemory_->Map(0, readbackCount_ * sizeof(uint32_t)));
+	std::fill_n(errorReadback_, readbackCount_, NoErrorEstimate);
+
+	// The tile lists of all the iterations but the first, which always runs in full, share one buffer.
+	const uint32_t tileCount = GroupCount(extent.width, ClassificationTileSize) * GroupCount(extent.height, ClassificationTileSize);
+	uint32_t tileListSize = 0;
+
+	for (uint32_t i = 1; i != MaxATrousIterations; ++i)
+	{
+		const auto groupCount = ATrousGroupCount(extent, 1u << i);
+
+		tileListOffsets_[i] = tileListSize;
+		tileListSize += groupCount.width * groupCount.height;
+	}
+
+	const VkDeviceSize tileDispatchSize = MaxATrousIterations * TileDispatchStride;
+
+	tileDispatchBuffer_.reset(new Buffer(device, tileDispatchSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT));
+	tileDispatchBufferMemory_.reset(new DeviceMemory(tileDispatchBuffer_->AllocateMemory(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)));
+	tileIterationBuffer_.reset(new Buffer(device, tileCount * sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT));
+	tileIterationBufferMemory_.reset(new DeviceMemory(tileIterationBuffer_->AllocateMemory(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)));
+	tileListBuffer_.reset(new Buffer(device, tileListSize * sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT));
+	tileListBufferMemory_.reset(new DeviceMemory(tileListBuffer_->AllocateMemory(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)));
+
+	tileReadbackBuffer_.reset(new Buffer(device, readbackCount_ * tileDispatchSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT));
+	tileReadbackBufferMemory_.reset(new DeviceMemory(tileReadbackBuffer_->AllocateMemory(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)));
+	tileReadback_ = static_cast<uint32_t*>(tileReadbackBufferMemory_->Map(0, readbackCount_ * tileDispatchSize));
+
+	CreateImages(commandPool);
+	CreateDescriptorSets(gBuffers, diffuseImageViews, specularImageViews, outputImageViews);
+
+	VkPushConstantRange pushConstantRange = {};
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	pushConstantRange.offset = 0;
+	pushConstantRange.size = sizeof(Constants);
+
+	pipelineLayout_.reset(new class PipelineLayout(device, descriptorSetManager_->DescriptorSetLayout(), { pushConstantRange }));
+
+	const auto& debugUtils = device.DebugUtils();
+
+	debugUtils.SetObjectName(sampleWeightSumBuffer_->Handle(), "Denoiser Sample Weight Sum Buffer");
+	debugUtils.SetObjectName(sampleWeightSumBufferMemory_->Handle(), "Denoiser Sample Weight Sum Buffer Memory");
+	debugUtils.SetObjectName(errorReadbackBuffer_->Handle(), "Denoiser Error Readback Buffer");
+	debugUtils.SetObjectName(errorReadbackBufferMemory_->Handle(), "Denoiser Error Readback Buffer Memory");
+	debugUtils.SetObjectName(tileDispatchBuffer_->Handle(), "Denoiser Tile Dispatch Buffer");
+	debugUtils.SetObjectName(tileDispatchBufferMemory_->Handle(), "Denoiser Tile Dispatch Buffer Memory");
+	debugUtils.SetObjectName(tileIterationBuffer_->Handle(), "Denoiser Tile Iteration Buffer");
+	debugUtils.SetObjectName(tileIterationBufferMemory_->Handle(), "Denoiser Tile Iteration Buffer Memory");
+	debugUtils.SetObjectName(tileListBuffer_->Handle(), "Denoiser Tile List Buffer");
+	debugUtils.SetObjectName(tileListBufferMemory_->Handle(), "Denoiser Tile List Buffer Memory");
+	debugUtils.SetObjectName(tileReadbackBuffer_->Handle(), "Denoiser Tile Readback Buffer");
+	debugUtils.SetObjectName(tileReadbackBufferMemory_->Handle(), "Denoiser Tile Readback Buffer Memory");
+}
+
+Denoiser::~Denoiser()
+{
+	pipelines_.clear();
+	pipelineLayout_.reset();
+	descriptorSetManager_.reset();
+	tileReadbackBufferMemory_->Unmap();
+	tileReadbackBuffer_.reset();
+	tileReadbackBufferMemory_.reset();
+	tileListBuffer_.reset();
+	tileListBufferMemory_.reset();
+	tileIterationBuffer_.reset();
+	tileIterationBufferMemory_.reset();
+	tileDispatchBuffer_.reset();
+	tileDispatchBufferMemory_.reset();
+	errorReadbackBufferMemory_->Unmap();
+	errorReadbackBuffer_.reset();
+	errorReadbackBufferMemory_.reset();
+	sampleWeightSumBuffer_.reset();
+	sampleWeightSumBufferMemory_.reset();
+
+	for (auto& signal : signals_)
+	{
+		for (auto& image : signal.MomentsImages) image.reset();
+		for (auto& image : signal.ColorHistoryImages) image.reset();
+	}
+
+	transientImages_.reset();
+	for (auto& image : instanceImages_) image.reset();
+	for (auto& image : guideImages_) image.reset();
+}
+
+void Denoiser::Render(VkCommandBuffer commandBuffer, const uint32_t slot, const Parameters& parameters)
+{
+	const uint32_t parity = frameIndex_ % 2;
+	const auto setIndex = [slot, parity](const uint32_t signal, const uint32_t direction)
+	{
+		return DescriptorSetIndex(slot, parity, signal, direction);
+	};
+
+	const SignalIndex signals[] = { Diffuse, Specular };
+	const uint32_t iterations = std::min(std::max(parameters.ATrousIterations, 1u), MaxATrousIterations);
+	const bool adaptiveTiles = parameters.ATrousTileThreshold > 0 && iterations > 1;
+
+	Constants constants = {};
+	constants.Extent = glm::ivec2(extent_.width, extent_.height);
+	constants.PhiColor = parameters.PhiColor;
+	constants.PhiNormal = parameters.PhiNormal;
+	constants.PhiDepth = parameters.PhiDepth;
+	constants.ColorAlpha = parameters.ColorAlpha;
+	constants.MomentsAlpha = parameters.MomentsAlpha;
+	constants.StepSize = 1;
+	constants.SampleBudget = parameters.SampleBudget;
+	constants.ATrousIterations = iterations;
+	constants.TileThreshold = parameters.ATrousTileThreshold;
+
+	const uint32_t pointGroupsX = GroupCount(extent_.width, PointLocalSize);
+	const uint32_t pointGroupsY = GroupCount(extent_.height, PointLocalSize);
+	const uint32_t tileGroupsX = GroupCount(extent_.width, TileLocalSize);
+	const uint32_t tileGroupsY = GroupCount(extent_.height, TileLocalSize);
+
+	// Wait for the ray tracing pass that produced our inputs.
+	InsertComputeBarrier(commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+
+	if (!parameters.Enabled)
+	{
+		// Without filtering the noisy signals are remodulated as is, and history is discarded on the next filtered frame.
+		Dispatch(commandBuffer, CompositePass, SpecializeBypass, setIndex(Diffuse, 0), &constants, pointGroupsX, pointGroupsY);
+
+		historyValid_ = false;
+		return;
+	}
+
+	// The geometry guide is shared by both signals, whose passes are independent and share barriers.
+	// So is the temporal gradient, whose first iteration overlaps the geometry pass.
+	transientImages_->BeginFrame();
+	transientImages_->BeginPass(commandBuffer, GeometryStage);
+
+	Dispatch(commandBuffer, GeometryPass, 0, setIndex(Diffuse, 0), &constants, pointGroupsX, pointGroupsY);
+
+	if (parameters.TemporalGradient)
+	{
+		const uint32_t gradientGroupsX = GroupCount(GroupCount(extent_.width, GBuffer::GradientStratumSize), TileLocalSize);
+		const uint32_t gradientGroupsY = GroupCount(GroupCount(extent_.height, GBuffer::GradientStratumSize), TileLocalSize);
+
+		for (uint32_t i = 0; i != GradientIterations; ++i)
+		{
+			constants.StepSize = static_cast<int32_t>(1u << i);
+
+			Dispatch(commandBuffer, GradientPass, 0, setIndex(Diffuse, i % 2), &constants, gradientGroupsX, gradientGroupsY);
+
+			if (i + 1 != GradientIterations)
+			{
+				InsertComputeBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+			}
+		}
+
+		constants.StepSize = 1;
+	}
+
+	InsertComputeBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+	transientImages_->BeginPass(commandBuffer, TemporalStage);
+
+	const uint32_t temporalPermutation =
+		(historyValid_ ? 0 : SpecializeResetHistory) |
+		(parameters.TemporalGradient ? SpecializeTemporalGradient : 0);
+
+	for (const auto signal : signals)
+	{
+		Dispatch(commandBuffer, TemporalPass, temporalPermutation, setIndex(signal, 0), &constants, pointGroupsX, pointGroupsY);
+	}
+
+	InsertComputeBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+	transientImages_->BeginPass(commandBuffer, VarianceStage);
+
+	// The variance pass writes into the first filter image, which is the target of the odd descriptor sets.
+	for (const auto signal : signals)
+	{
+		Dispatch(commandBuffer, VariancePass, 0, setIndex(signal, 1), &constants, tileGroupsX, tileGroupsY);
+	}
+
+	InsertComputeBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+
+	// The tiles are classified on the variance pass output, which is the source of the first iteration, alongside it.
+	if (adaptiveTiles)
+	{
+		Dispatch(commandBuffer, TileClassifyPass, 0, setIndex(Diffuse, 1), &constants,
+			GroupCount(extent_.width, ClassificationTileSize), GroupCount(extent_.height, ClassificationTileSize));
+	}
+
+	transientImages_->BeginPass(commandBuffer, ATrousStage);
+
+	for (uint32_t i = 0; i != iterations; ++i)
+	{
+		// The output of the first iteration becomes the color history of the next frame.
+		// It always runs in full, the later ones only on the workgroups the tile lists hold when adaptive.
+		const uint32_t stepSize = 1u << i;
+		const bool indirect = adaptiveTiles && i != 0;
+
+		constants.StepSize = static_cast<int32_t>(stepSize);
+		constants.TileListOffset = tileListOffsets_[i];
+
+		const uint32_t aTrousPermutation = (i == 0 ? SpecializeWriteHistory : 0) | (indirect ? SpecializeIndirectTiles : 0);
+		const auto groupCount = ATrousGroupCount(extent_, stepSize);
+
+		for (const auto signal : signals)
+		{
+			if (indirect)
+			{
+				DispatchIndirect(commandBuffer, ATrousPass, aTrousPermutation, setIndex(signal, i % 2), &constants, i * TileDispatchStride);
+			}
+			else
+			{
+				Dispatch(commandBuffer, ATrousPass, aTrousPermutation, setIndex(signal, i % 2), &constants, groupCount.width, groupCount.height);
+			}
+		}
+
+		InsertComputeBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+
+		// One invocation per workgroup of each later iteration.
+		if (adaptiveTiles && i == 0)
+		{
+			for (uint32_t j = 1; j != iterations; ++j)
+			{
+				const auto listGroupCount = ATrousGroupCount(extent_, 1u << j);
+
+				constants.StepSize = static_cast<int32_t>(1u << j);
+				constants.TileListOffset = tileListOffsets_[j];
+
+				Dispatch(commandBuffer, TileListPass, 0, setIndex(Diffuse, 0), &constants,
+					GroupCount(listGroupCount.width, TileLocalSize), GroupCount(listGroupCount.height, TileLocalSize));
+			}
+
+			InsertIndirectBarrier(commandBuffer);
+		}
+	}
+
+	transientImages_->BeginPass(commandBuffer, CompositeStage);
+
+	// The diffuse sets also bind the specular filter target of the same direction.
+	const uint32_t outputSet = setIndex(Diffuse, (iterations - 1) % 2);
+
+	// Spread the paths of the next frame traced in this slot after the remaining variance of the filtered signals.
+	// Without new samples (converged accumulation) the previous sample counts are kept.
+	// The weight sum doubles as the error estimate, copied to the readback entry of this frame.
+	const uint32_t readbackIndex = frameIndex_ % readbackCount_;
+	const VkDeviceSize readbackOffset = readbackIndex * sizeof(uint32_t);
+
+	if ((parameters.AdaptiveSampling || parameters.EstimateError) && parameters.SampleBudget != 0)
+	{
+		ClearComputeBuffer(commandBuffer, *sampleWeightSumBuffer_);
+
+		Dispatch(commandBuffer, SampleWeightPass, 0, outputSet, &constants, pointGroupsX, pointGroupsY);
+		InsertComputeBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+
+		if (parameters.AdaptiveSampling)
+		{
+			Dispatch(commandBuffer, SampleMapPass, 0, outputSet, &constants, pointGroupsX, pointGroupsY);
+		}
+
+		VkMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+		VkBufferCopy copyRegion = {};
+		copyRegion.dstOffset = readbackOffset;
+		copyRegion.size = sizeof(uint32_t);
+
+		vkCmdCopyBuffer(commandBuffer, sampleWeightSumBuffer_->Handle(), errorReadbackBuffer_->Handle(), 1, &copyRegion);
+	}
+	else
+	{
+		vkCmdFillBuffer(commandBuffer, errorReadbackBuffer_->Handle(), readbackOffset, sizeof(uint32_t), NoErrorEstimate);
+	}
+
+	// The tile counts of the listed iterations are the list lengths kept in their indirect dispatches.
+	tileReadbackFrames_[readbackIndex] = { iterations, adaptiveTiles };
+
+	if (adaptiveTiles)
+	{
+		VkMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+		VkBufferCopy copyRegion = {};
+		copyRegion.dstOffset = readbackIndex * MaxATrousIterations * TileDispatchStride;
+		copyRegion.size = MaxATrousIterations * TileDispatchStride;
+
+		vkCmdCopyBuffer(commandBuffer, tileDispatchBuffer_->Handle(), tileReadbackBuffer_->Handle(), 1, &copyRegion);
+	}
+
+	VkMemoryBarrier readbackBarrier = {};
+	readbackBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	readbackBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	readbackBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &readbackBarrier, 0, nullptr, 0, nullptr);
+
+	Dispatch(commandBuffer, CompositePass, 0, outputSet, &constants, pointGroupsX, pointGroupsY);
+
+	historyValid_ = true;
+	frameIndex_++;
+}
+
+float Denoiser::ErrorEstimate() const
+{
+	// The entry the next frame overwrites was written framesInFlight + 1 frames ago.
+	const uint32_t weightSum = errorReadback_[frameIndex_ % readbackCount_];
+
+	if (weightSum == NoErrorEstimate)
+	{
+		return -1.0f;
+	}
+
+	const float pixelCount = static_cast<float>(extent_.width) * static_cast<float>(extent_.height);
+	return static_cast<float>(weightSum) * SampleWeightGroupSize / (SampleWeightScale * pixelCount);
+}
+
+std::vector<std::pair<uint32_t, uint32_t>> Denoiser::ATrousTileCounts() const
+{
+	// Same frame as the error estimate.
+	const uint32_t readbackIndex = frameIndex_ % readbackCount_;
+	const auto& frame = tileReadbackFrames_[readbackIndex];
+	const uint32_t* const dispatches = tileReadback_ + readbackIndex * MaxATrousIterations * (TileDispatchStride / sizeof(uint32_t));
+
+	std::vector<std::pair<uint32_t, uint32_t>> counts;
+
+	for (uint32_t i = 0; i != frame.Iterations; ++i)
+	{
+		const auto groupCount = ATrousGroupCount(extent_, 1u << i);
+		const uint32_t total = groupCount.width * groupCount.height;
+		const uint32_t processed = frame.Adaptive && i != 0 ? dispatches[i * (TileDispatchStride / sizeof(uint32_t)) + 3] : total;
+
+		counts.emplace_back(processed, total);
+	}
+
+	return counts;
+}
+
+void Denoiser::CreateImages(CommandPool& commandPool)
+{
+	const auto& device = commandPool.Device();
+	const auto extent = extent_;
+	const auto usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+	const auto filterFormat = FilterFormat(precision_);
+	const auto category = MemoryAllocator::Category::DenoiserHistory;
+	const VkExtent2D gradientExtent =
+	{
+		(extent.width + GBuffer::GradientStratumSize - 1) / GBuffer::GradientStratumSize,
+		(extent.height + GBuffer::GradientStratumSize - 1) / GBuffer::GradientStratumSize
+	};
+
+	for (size_t i = 0; i != 2; ++i)
+	{
+		guideImages_[i].reset(new RenderTarget(device, extent, GuideFormat, usage, "Denoiser Guide", category));
+		instanceImages_[i].reset(new RenderTarget(device, extent, VK_FORMAT_R32_UINT, usage, "Denoiser Instance", category));
+	}
+
+	std::vector<const RenderTarget*> images =
+	{
+		guideImages_[0].get(), guideImages_[1].get(),
+		instanceImages_[0].get(), instanceImages_[1].get()
+	};
+
+	// The gradient is read by the temporal pass only. The temporally integrated illumination is read by the variance
+	// pass only, whose output is the first filter image. The second one is first written by the a-trous iterations,
+	// so it takes the place of the illumination, and the gradient the place of either filter image.
+	transientImages_.reset(new TransientRenderTargets(device, category));
+	transientImageUses_.assign(std::size(PassShaders), {});
+
+	// Records the passes whose shaders access the image, its lifetime runs from the stage of the first to the last.
+	const auto use = [this](const uint32_t image, const std::initializer_list<Pass> passes)
+	{
+		for (const auto pass : passes)
+		{
+			transientImages_->Use(image, PassShaders[pass].Stage);
+			transientImageUses_[pass].push_back(image);
+		}
+	};
+
+	std::array<uint32_t, 2> gradientIndices = {};
+	std::array<std::array<uint32_t, 3>, 2> signalIndices = {};
+
+	for (size_t i = 0; i != 2; ++i)
+	{
+		gradientIndices[i] = transientImages_->Add(gradientExtent, GradientFormat, VK_IMAGE_USAGE_STORAGE_BIT, "Denoiser Gradient");
+		use(gradientIndices[i], { GradientPass, TemporalPass });
+	}
+
+	for (size_t s = 0; s != signals_.size(); ++s)
+	{
+		auto& signal = signals_[s];
+		const std::string prefix = s == Diffuse ? "Denoiser Diffuse " : "Denoiser Specular ";
+
+		for (size_t i = 0; i != 2; ++i)
+		{
+			signal.ColorHistoryImages[i].reset(new RenderTarget(device, extent, filterFormat, usage, (prefix + "Color History").c_str(), category));
+			signal.MomentsImages[i].reset(new RenderTarget(device, extent, filterFormat, usage, (prefix + "Moments").c_str(), category));
+
+			images.push_back(signal.ColorHistoryImages[i].get());
+			images.push_back(signal.MomentsImages[i].get());
+		}
+
+		auto& indices = signalIndices[s];
+		indices[0] = transientImages_->Add(extent, filterFormat, VK_IMAGE_USAGE_STORAGE_BIT, (prefix + "Filter").c_str());
+		indices[1] = transientImages_->Add(extent, filterFormat, VK_IMAGE_USAGE_STORAGE_BIT, (prefix + "Filter").c_str());
+		indices[2] = transientImages_->Add(extent, filterFormat, VK_IMAGE_USAGE_STORAGE_BIT, (prefix + "Illumination").c_str());
+
+		// The variance pass writes the first filter image, the tiles are classified on it. Either filter image can
+		// hold the final iteration read by the passes after the a-trous ones.
+		use(indices[0], { VariancePass, TileClassifyPass, ATrousPass, SampleWeightPass, SampleMapPass, CompositePass });
+		use(indices[1], { ATrousPass, SampleWeightPass, SampleMapPass, CompositePass });
+		use(indices[2], { TemporalPass, VariancePass });
+	}
+
+	transientImages_->Allocate();
+
+	const auto& transientImages = *transientImages_;
+
+	for (size_t i = 0; i != 2; ++i)
+	{
+		gradientImages_[i] = &transientImages[gradientIndices[i]];
+	}
+
+	for (size_t s = 0; s != signals_.size(); ++s)
+	{
+		auto& signal = signals_[s];
+		const auto& indices = signalIndices[s];
+
+		signal.FilterImages = { &transientImages[indices[0]], &transientImages[indices[1]] };
+		signal.IlluminationImage = &transientImages[indices[2]];
+	}
+
+	// All the denoiser images live in the general layout, start the persistent ones from a known state.
+	SingleTimeCommands::Submit(commandPool, [&images](VkCommandBuffer commandBuffer)
+	{
+		VkImageSubresourceRange subresourceRange = {};
+		subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		subresourceRange.baseMipLevel = 0;
+		subresourceRange.levelCount = 1;
+		subresourceRange.baseArrayLayer = 0;
+		subresourceRange.layerCount = 1;
+
+		const VkClearColorValue clearColor = { {0.0f, 0.0f, 0.0f, 0.0f} };
+
+		for (const auto* image : images)
+		{
+			ImageMemoryBarrier::Insert(commandBuffer, image->Image().Handle(), subresourceRange, 0,
+				VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+
+			vkCmdClearColorImage(commandBuffer, image->Image().Handle(), VK_IMAGE_LAYOUT_GENERAL, &clearColor, 1, &subresourceRange);
+		}
+	});
+}
+
+void Denoiser::CreateDescriptorSets(
+	const std::array<const GBuffer*, 2>& gBuffers,
+	const std::array<const ImageView*, 2>& diffuseImageViews,
+	const std::array<const ImageView*, 2>& specularImageViews,
+	const std::array<const ImageView*, 2>& outputImageViews)
+{
+	const auto& device = device_;
+	const VkShaderStageFlags stage = VK_SHADER_STAGE_COMPUTE_BIT;
+
+	const std::vector<DescriptorBinding> descriptorBindings =
+	{
+		// Inputs: noisy radiance, G-buffer depth, G-buffer normal and motion vectors.
+		{0, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, stage},
+		{1, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, stage},
+		{2, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, stage},
+
+		// Geometry guide (current, previous).
+		{3, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, stage},
+		{4, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, stage},
+
+		// History (previous color, previous moments, current color, current moments).
+		{5, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, stage},
+		{6, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, stage},
+		{7, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, stage},
+		{8, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, stage},
+
+		// Temporally integrated illumination, filter source and target.
+		{9, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, stage},
+		{10, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, stage},
+		{11, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, stage},
+
+		// Output.
+		{12, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, stage},
+
+		// Instance ids (G-buffer, current, previous).
+		{13, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, stage},
+		{14, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, stage},
+		{15, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, stage},
+
+		// Remodulation on composite (G-buffer albedo, noisy specular, specular filter target).
+		{16, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, stage},
+		{17, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, stage},
+		{18, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, stage},
+
+		// Adaptive sampling (G-buffer sample count map, weight sum).
+		{19, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, stage},
+		{20, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, stage},
+
+		// Temporal gradient (G-buffer samples, reconstruction source and target).
+		{21, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, stage},
+		{22, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, stage},
+		{23, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, stage},
+
+		// Adaptive a-trous iterations (indirect dispatches, tile iteration counts, workgroup lists).
+		{24, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, stage},
+		{25, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, stage},
+		{26, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, stage}
+	};
+
+	// One set per (slot, frame parity, signal, filter direction).
+	const uint32_t setCount = 16;
+
+	descriptorSetManager_.reset(new DescriptorSetManager(device, descriptorBindings, setCount));
+
+	auto& descriptorSets = descriptorSetManager_->DescriptorSets();
+
+	const auto storageInfo = [](const ImageView& imageView)
+	{
+		VkDescriptorImageInfo info = {};
+		info.imageView = imageView.Handle();
+		info.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+		return info;
+	};
+
+	const auto bufferInfo = [](const Buffer& buffer)
+	{
+		VkDescriptorBufferInfo info = {};
+		info.buffer = buffer.Handle();
+		info.range = VK_WHOLE_SIZE;
+		return info;
+	};
+
+	const VkDescriptorBufferInfo sampleWeightSumInfo = bufferInfo(*sampleWeightSumBuffer_);
+	const VkDescriptorBufferInfo tileDispatchInfo = bufferInfo(*tileDispatchBuffer_);
+	const VkDescriptorBufferInfo tileIterationInfo = bufferInfo(*tileIterationBuffer_);
+	const VkDescriptorBufferInfo tileListInfo = bufferInfo(*tileListBuffer_);
+
+	for (uint32_t i = 0; i != setCount; ++i)
+	{
+		const uint32_t slot = i / 8;
+		const uint32_t current = (i / 4) % 2;
+		const uint32_t previous = 1 - current;
+		const uint32_t signalIndex = (i / 2) % 2;
+		const uint32_t source = i % 2;
+		const uint32_t target = 1 - source;
+		const auto& gBuffer = *gBuffers[slot];
+		const auto& signal = signals_[signalIndex];
+		const auto& noisyImageViews = signalIndex == Diffuse ? diffuseImageViews : specularImageViews;
+
+		const std::vector<VkDescriptorImageInfo> imageInfos =
+		{
+			storageInfo(*noisyImageViews[slot]),
+			storageInfo(gBuffer.Depth().ImageView()),
+			storageInfo(gBuffer.NormalMotion().ImageView()),
+			storageInfo(guideImages_[current]->ImageView()),
+			storageInfo(guideImages_[previous]->ImageView()),
+			storageInfo(signal.ColorHistoryImages[previous]->ImageView()),
+			storageInfo(signal.MomentsImages[previous]->ImageView()),
+			storageInfo(signal.ColorHistoryImages[current]->ImageView()),
+			storageInfo(signal.MomentsImages[current]->ImageView()),
+			storageInfo(signal.IlluminationImage->ImageView()),
+			storageInfo(signal.FilterImages[source]->ImageView()),
+			storageInfo(signal.FilterImages[target]->ImageView()),
+			storageInfo(*outputImageViews[slot]),
+			storageInfo(gBuffer.InstanceId().ImageView()),
+			storageInfo(instanceImages_[current]->ImageView()),
+			storageInfo(instanceImages_[previous]->ImageView()),
+			storageInfo(gBuffer.Albedo().ImageView()),
+			storageInfo(*specularImageViews[slot]),
+			storageInfo(signals_[Specular].FilterImages[target]->ImageView()),
+			storageInfo(gBuffer.SampleCount().ImageView())
+		};
+
+		std::vector<VkWriteDescriptorSet> descriptorWrites;
+
+		for (uint32_t binding = 0; binding != imageInfos.size(); ++binding)
+		{
+			descriptorWrites.push_back(descriptorSets.Bind(i, binding, imageInfos[binding]));
+		}
+
+		descriptorWrites.push_back(descriptorSets.Bind(i, 20, sampleWeightSumInfo));
+		descriptorWrites.push_back(descriptorSets.Bind(i, 24, tileDispatchInfo));
+		descriptorWrites.push_back(descriptorSets.Bind(i, 25, tileIterationInfo));
+		descriptorWrites.push_back(descriptorSets.Bind(i, 26, tileListInfo));
+
+		const std::vector<VkDescriptorImageInfo> gradientImageInfos =
+		{
+			storageInfo(gBuffer.Gradient().ImageView()),
+			storageInfo(gradientImages_[source]->ImageView()),
+			storageInfo(gradientImages_[target]->ImageView())
+		};
+
+		for (uint32_t g = 0; g != gradientImageInfos.size(); ++g)
+		{
+			descriptorWrites.push_back(descriptorSets.Bind(i, 21 + g, gradientImageInfos[g]));
+		}
+
+		descriptorSets.UpdateDescriptors(i, descriptorWrites);
+	}
+}
+
+const ComputePipeline& Denoiser::Pipeline(const Pass pass, const uint32_t permutation)
+{
+	auto& pipeline = pipelines_[(pass << SpecializationConstantCount) | permutation];
+
+	if (!pipeline)
+	{
+		std::vector<uint32_t> values(SpecializationConstantCount);
+
+		for (uint32_t i = 0; i != SpecializationConstantCount; ++i)
+		{
+			values[i] = (permutation >> i) & 1;
+		}
+
+		const auto& shader = PassShaders[pass];
+		const SpecializationConstants specializationConstants(std::move(values));
+
+		const std::string filename = std::string(shader.Filename) + PrecisionSuffixes[static_cast<uint32_t>(precision_)];
+
+		pipeline.reset(new ComputePipeline(pipelineCache_, *pipelineLayout_, filename, specializationConstants));
+
+		device_.DebugUtils().SetObjectName(pipeline->Handle(),
+			("Denoiser " + std::string(shader.Name) + " Pipeline #" + std::to_string(permutation)).c_str());
+	}
+
+	return *pipeline;
+}
+
+void Denoiser::BindPass(
+	VkCommandBuffer commandBuffer,
+	const Pass pass,
+	const uint32_t permutation,
+	const uint32_t descriptorSetIndex,
+	const void* constants)
+{
+	// The bypass composite only reads the noisy signals.
+	if (!(permutation & SpecializeBypass))
+	{
+		for (const auto image : transientImageUses_[pass])
+		{
+			transientImages_->CheckUse(image);
+		}
+	}
+
+	const auto& pipeline = Pipeline(pass, permutation);
+	VkDescriptorSet descriptorSets[] = { descriptorSetManager_->DescriptorSets().Handle(descriptorSetIndex) };
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.Handle());
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout_->Handle(), 0, 1, descriptorSets, 0, nullptr);
+	vkCmdPushConstants(commandBuffer, pipelineLayout_->Handle(), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(Constants), constants);
+}
+
+void Denoiser::Dispatch(
+	VkCommandBuffer commandBuffer,
+	const Pass pass,
+	const uint32_t permutation,
+	const uint32_t descriptorSetIndex,
+	const void* constants,
+	const uint32_t groupCountX,
+	const uint32_t groupCountY)
+{
+	BindPass(commandBuffer, pass, permutation, descriptorSetIndex, constants);
+	vkCmdDispatch(commandBuffer, groupCountX, groupCountY, 1);
+}
+
+void Denoiser::DispatchIndirect(
+	VkCommandBuffer commandBuffer,
+	const Pass pass,
+	const uint32_t permutation,
+	const uint32_t descriptorSetIndex,
+	const void* constants,
+	const VkDeviceSize dispatchOffset)
+{
+	BindPass(commandBuffer, pass, permutation, descriptorSetIndex, constants);
+	vkCmdDispatchIndirect(commandBuffer, tileDispatchBuffer_->Handle(), dispatchOffset);
+}
+
+}
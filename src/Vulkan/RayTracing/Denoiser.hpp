@@ -0,0 +1,194 @@
+#pragma once
+
+#include "Vulkan/Vulkan.hpp"
+#include "Utilities/DenoiserParameters.hpp"
+#include "Utilities/Glm.hpp"
+#include <array>
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace Vulkan
+{
+	class Buffer;
+	class CommandPool;
+	class ComputePipeline;
+	class DescriptorSetManager;
+	class Device;
+	class DeviceMemory;
+	class ImageView;
+	class PipelineCache;
+	class PipelineLayout;
+	class RenderTarget;
+	class TransientRenderTargets;
+}
+
+namespace Vulkan::RayTracing
+{
+	class GBuffer;
+
+	// Spatio-temporal variance-guided filter (SVGF) running as a chain of compute passes:
+	// geometry guide, temporal accumulation of color and moments, variance estimation,
+	// a number of edge-stopping a-trous wavelet iterations and a final composite into the output image.
+	// The inputs are the diffuse and specular illumination with the first hit albedo divided out. Both signals
+	// are filtered separately, so that textures are not blurred, and remodulated by the G-buffer albedo on composite.
+	// The noisy inputs, G-buffers and outputs come in two slots, so that one slot can be filtered (possibly on the
+	// async compute queue) while the other is being traced. The filter history is shared by both slots.
+	// With temporal gradients, the history is shortened where the lighting changed since the previous frame.
+	// With adaptive sampling, the filtered variance also drives the sample count map of the slot's G-buffer.
+	// Its mean is read back as an estimate of the remaining error, once the frame is known to be complete.
+	// The a-trous iterations can stop early on 16x16 tiles whose variance is already low, see ATrousTileThreshold.
+	class Denoiser final
+	{
+	public:
+
+		using Parameters = Utilities::DenoiserParameters;
+
+		static constexpr uint32_t MaxATrousIterations = Parameters::MaxATrousIterations;
+
+		// Precision of the history, moments and filter images and of the a-trous arithmetic. Half floats halve the
+		// memory traffic of the filter passes, which are bandwidth bound at high resolutions.
+		enum class Precision : uint32_t
+		{
+			Float32,
+			Float16Storage,
+			Float16 // Half float arithmetic as well, requires the shaderFloat16 device feature.
+		};
+
+		VULKAN_NON_COPIABLE(Denoiser)
+
+		Denoiser(
+			CommandPool& commandPool,
+			const PipelineCache& pipelineCache,
+			VkExtent2D extent,
+			Precision precision,
+			uint32_t framesInFlight,
+			const std::array<const GBuffer*, 2>& gBuffers,
+			const std::array<const ImageView*, 2>& diffuseImageViews,
+			const std::array<const ImageView*, 2>& specularImageViews,
+			const std::array<const ImageView*, 2>& outputImageViews);
+		~Denoiser();
+
+		const class Device& Device() const { return device_; }
+		VkExtent2D Extent() const { return extent_; }
+		Precision FilterPrecision() const { return precision_; }
+
+		// Records the whole filter chain on the inputs and output of the given slot.
+		// The noisy images and the G-buffer must be in VK_IMAGE_LAYOUT_GENERAL.
+		void Render(VkCommandBuffer commandBuffer, uint32_t slot, const Parameters& parameters);
+
+		// Mean relative standard deviation of the filtered illumination of the frame filtered framesInFlight + 1 renders ago,
+		// which the host can read without waiting. Negative when that frame did not estimate its error.
+		float ErrorEstimate() const;
+
+		// Processed and total workgroups (8x8 lattice tiles) of each a-trous iteration of the same frame as ErrorEstimate().
+		// Empty when that frame was not filtered.
+		std::vector<std::pair<uint32_t, uint32_t>> ATrousTileCounts() const;
+
+	private:
+
+		enum SignalIndex : uint32_t
+		{
+			Diffuse = 0,
+			Specular = 1
+		};
+
+		enum Pass : uint32_t
+		{
+			GeometryPass,
+			TemporalPass,
+			VariancePass,
+			ATrousPass,
+			CompositePass,
+			SampleWeightPass,
+			SampleMapPass,
+			GradientPass,
+			TileClassifyPass,
+			TileListPass
+		};
+
+		// History and filter images of one of the demodulated illumination signals, the latter in transientImages_.
+		struct Signal
+		{
+			std::array<std::unique_ptr<RenderTarget>, 2> ColorHistoryImages;
+			std::array<std::unique_ptr<RenderTarget>, 2> MomentsImages;
+			const RenderTarget* IlluminationImage{};
+			std::array<const RenderTarget*, 2> FilterImages{};
+		};
+
+		// What the tile readback of a frame holds.
+		struct TileReadback
+		{
+			uint32_t Iterations;
+			bool Adaptive;
+		};
+
+		void CreateImages(CommandPool& commandPool);
+		void CreateDescriptorSets(
+			const std::array<const GBuffer*, 2>& gBuffers,
+			const std::array<const ImageView*, 2>& diffuseImageViews,
+			const std::array<const ImageView*, 2>& specularImageViews,
+			const std::array<const ImageView*, 2>& outputImageViews);
+		// Pipeline of the pass permutation selected by the given specialization bits, created on first use.
+		const ComputePipeline& Pipeline(Pass pass, uint32_t permutation);
+		// Also checks that the frame-local images the pass accesses are within their lifetime.
+		void BindPass(VkCommandBuffer commandBuffer, Pass pass, uint32_t permutation, uint32_t descriptorSetIndex, const void* constants);
+		void Dispatch(VkCommandBuffer commandBuffer, Pass pass, uint32_t permutation, uint32_t descriptorSetIndex, const void* constants, uint32_t groupCountX, uint32_t groupCountY);
+		void DispatchIndirect(VkCommandBuffer commandBuffer, Pass pass, uint32_t permutation, uint32_t descriptorSetIndex, const void* constants, VkDeviceSize dispatchOffset);
+
+		const class Device& device_;
+		const PipelineCache& pipelineCache_;
+		const VkExtent2D extent_;
+		const Precision precision_;
+
+		// Images written every frame alternate their role (current/previous) so that history never needs to be copied.
+		std::array<std::unique_ptr<RenderTarget>, 2> guideImages_;
+		std::array<std::unique_ptr<RenderTarget>, 2> instanceImages_;
+
+		// Dense temporal gradient reconstructed from the slot's G-buffer samples, ping-ponged by the iterations.
+		std::array<const RenderTarget*, 2> gradientImages_{};
+		std::array<Signal, 2> signals_;
+
+		// The images only needed within a frame (gradient, illumination and filter), sharing memory where their
+		// passes allow it. Their lifetimes follow from the images each pass accesses, indexed by Pass.
+		std::unique_ptr<TransientRenderTargets> transientImages_;
+		std::vector<std::vector<uint32_t>> transientImageUses_;
+
+		// Sum of the adaptive sampling weights over the frame.
+		std::unique_ptr<Buffer> sampleWeightSumBuffer_;
+		std::unique_ptr<DeviceMemory> sampleWeightSumBufferMemory_;
+
+		// Host visible copies of the weight sum, one per frame that can still be in flight plus the one read back.
+		std::unique_ptr<Buffer> errorReadbackBuffer_;
+		std::unique_ptr<DeviceMemory> errorReadbackBufferMemory_;
+		uint32_t* errorReadback_{};
+		const uint32_t readbackCount_;
+
+		// Indirect dispatches of the a-trous iterations, iteration count of each classification tile and the lists
+		// of workgroups of each iteration at tileListOffsets_.
+		std::unique_ptr<Buffer> tileDispatchBuffer_;
+		std::unique_ptr<DeviceMemory> tileDispatchBufferMemory_;
+		std::unique_ptr<Buffer> tileIterationBuffer_;
+		std::unique_ptr<DeviceMemory> tileIterationBufferMemory_;
+		std::unique_ptr<Buffer> tileListBuffer_;
+		std::unique_ptr<DeviceMemory> tileListBufferMemory_;
+		std::array<uint32_t, MaxATrousIterations> tileListOffsets_{};
+
+		// Host visible copies of the indirect dispatches, for the statistics, along with the error readback.
+		std::unique_ptr<Buffer> tileReadbackBuffer_;
+		std::unique_ptr<DeviceMemory> tileReadbackBufferMemory_;
+		uint32_t* tileReadback_{};
+		std::vector<TileReadback> tileReadbackFrames_;
+
+		std::unique_ptr<DescriptorSetManager> descriptorSetManager_;
+		std::unique_ptr<class PipelineLayout> pipelineLayout_;
+
+		// Pass permutations, keyed by pass and specialization bits. Only the ones in use get compiled.
+		std::map<uint32_t, std::unique_ptr<ComputePipeline>> pipelines_;
+
+		uint32_t frameIndex_{};
+		bool historyValid_{};
+	};
+
+}
@@ -0,0 +1,206 @@
+#include "DenoiserBenchmark.hpp"
+#include "GBuffer.hpp"
+#include "Vulkan/Buffer.hpp"
+#include "Vulkan/CommandBuffers.hpp"
+#include "Vulkan/CommandPool.hpp"
+#include "Vulkan/Device.hpp"
+#include "Vulkan/DeviceMemory.hpp"
+#include "Vulkan/Image.hpp"
+#include "Vulkan/ImageMemoryBarrier.hpp"
+#include "Vulkan/QueryPool.hpp"
+#include "Vulkan/RenderTarget.hpp"
+#include "Vulkan/SingleTimeCommands.hpp"
+#include "Utilities/Exception.hpp"
+#include <cstring>
+#include <random>
+
+namespace Vulkan::RayTracing {
+
+namespace
+{
+	// The first frames reset the history and take the spatial variance path, keep them out of the measurement.
+	const uint32_t WarmUpFrameCount = 8;
+}
+
+DenoiserBenchmark::DenoiserBenchmark(CommandPool& commandPool, const PipelineCache& pipelineCache, const VkExtent2D extent, const Denoiser::Precision precision) :
+	commandPool_(commandPool),
+	extent_(extent)
+{
+	const auto& device = commandPool.Device();
+
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(device.PhysicalDevice(), &properties);
+
+	if (!properties.limits.timestampComputeAndGraphics)
+	{
+		Throw(std::runtime_error("device does not support timestamp queries on the graphics queue"));
+	}
+
+	noisyImage_.reset(new RenderTarget(device, extent, VK_FORMAT_R32G32B32A32_SFLOAT,
+		VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT, "Denoiser Benchmark Noisy"));
+	gBuffer_.reset(new GBuffer(commandPool, extent));
+	outputImage_.reset(new RenderTarget(device, extent, VK_FORMAT_R8G8B8A8_UNORM,
+		VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, "Denoiser Benchmark Output"));
+
+	InitializeInputs();
+
+	// Both denoiser slots, and both the diffuse and specular signals, share the same synthetic inputs and output.
+	denoiser_.reset(new Denoiser(commandPool, pipelineCache, extent, precision, 1,
+		{ gBuffer_.get(), gBuffer_.get() },
+		{ &noisyImage_->ImageView(), &noisyImage_->ImageView() },
+		{ &noisyImage_->ImageView(), &noisyImage_->ImageView() },
+		{ &outputImage_->ImageView(), &outputImage_->ImageView() }));
+}
+
+DenoiserBenchmark::~DenoiserBenchmark()
+{
+	queryPool_.reset();
+	denoiser_.reset();
+	outputImage_.reset();
+	gBuffer_.reset();
+	noisyImage_.reset();
+}
+
+double DenoiserBenchmark::Run(const Denoiser::Parameters& parameters, const uint32_t frameCount)
+{
+	const auto& device = commandPool_.Device();
+	const uint32_t queryCount = 2 * frameCount;
+
+	queryPool_.reset(new QueryPool(device, VK_QUERY_TYPE_TIMESTAMP, queryCount));
+
+	SingleTimeCommands::Submit(commandPool_, [&](VkCommandBuffer commandBuffer)
+	{
+		queryPool_->Reset(commandBuffer, 0, queryCount);
+
+		for (uint32_t i = 0; i != WarmUpFrameCount; ++i)
+		{
+			denoiser_->Render(commandBuffer, i % 2, parameters);
+		}
+
+		for (uint32_t i = 0; i != frameCount; ++i)
+		{
+			queryPool_->WriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 2 * i);
+			denoiser_->Render(commandBuffer, i % 2, parameters);
+			queryPool_->WriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 2 * i + 1);
+		}
+	});
+
+	const auto timestamps = queryPool_->GetResults(0, queryCount);
+
+	double total = 0;
+
+	for (uint32_t i = 0; i != frameCount; ++i)
+	{
+		total += static_cast<double>(timestamps[2 * i + 1] - timestamps[2 * i]);
+	}
+
+	// Timestamp ticks are in units of TimestampPeriod() nanoseconds.
+	return total * queryPool_->TimestampPeriod() / (frameCount * 1000000.0);
+}
+
+std::vector<uint8_t> DenoiserBenchmark::ReadOutput() const
+{
+	const auto& device = commandPool_.Device();
+	const size_t size = 4 * static_cast<size_t>(extent_.width) * extent_.height;
+
+	Buffer readbackBuffer(device, size, VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+	DeviceMemory readbackBufferMemory = readbackBuffer.AllocateTransientMemory(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+	SingleTimeCommands::Submit(commandPool_, [&](VkCommandBuffer commandBuffer)
+	{
+		VkImageSubresourceRange colorRange = {};
+		colorRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		colorRange.baseMipLevel = 0;
+		colorRange.levelCount = 1;
+		colorRange.baseArrayLayer = 0;
+		colorRange.layerCount = 1;
+
+		ImageMemoryBarrier::Insert(commandBuffer, outputImage_->Image().Handle(), colorRange, VK_ACCESS_SHADER_WRITE_BIT,
+			VK_ACCESS_TRANSFER_READ_BIT, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL);
+
+		VkBufferImageCopy region = {};
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.layerCount = 1;
+		region.imageExtent = { extent_.width, extent_.height, 1 };
+
+		vkCmdCopyImageToBuffer(commandBuffer, outputImage_->Image().Handle(), VK_IMAGE_LAYOUT_GENERAL, readbackBuffer.Handle(), 1, &region);
+
+		ImageMemoryBarrier::Insert(commandBuffer, outputImage_->Image().Handle(), colorRange, VK_ACCESS_TRANSFER_READ_BIT,
+			VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL);
+	});
+
+	std::vector<uint8_t> output(size);
+	std::memcpy(output.data(), readbackBufferMemory.Map(0, size), size);
+	readbackBufferMemory.Unmap();
+
+	return output;
+}
+
+void DenoiserBenchmark::InitializeInputs()
+{
+	const auto& device = commandPool_.Device();
+	const size_t pixelCount = static_cast<size_t>(extent_.width) * extent_.height;
+
+	// Mid grey with a fixed seed uniform noise, the same for every frame and every run.
+	std::vector<float> noisy(4 * pixelCount, 1.0f);
+	std::mt19937 random(42);
+	std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+
+	for (size_t i = 0; i != pixelCount; ++i)
+	{
+		noisy[4 * i + 0] = noisy[4 * i + 1] = noisy[4 * i + 2] = distribution(random);
+	}
+
+	const size_t noisySize = noisy.size() * sizeof(float);
+
+	Buffer stagingBuffer(device, noisySize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+	DeviceMemory stagingBufferMemory = stagingBuffer.AllocateTransientMemory(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+	std::memcpy(stagingBufferMemory.Map(0, noisySize), noisy.data(), noisySize);
+	stagingBufferMemory.Unmap();
+
+	SingleTimeCommands::Submit(commandPool_, [&](VkCommandBuffer commandBuffer)
+	{
+		VkImageSubresourceRange colorRange = {};
+		colorRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		colorRange.baseMipLevel = 0;
+		colorRange.levelCount = 1;
+		colorRange.baseArrayLayer = 0;
+		colorRange.layerCount = 1;
+
+		// A noisy white surface facing the camera ten units away with no motion: every pixel goes through the full filter,
+		// and the composite remodulates it by an albedo of one. The whole surface is a single instance, so that the temporal
+		// pass keeps its history. The G-buffer images are already in the general layout, a zero octahedral normal decodes to +Z.
+		const VkClearColorValue depth = { {10.0f, 0.0f, 0.0f, 0.0f} };
+		const VkClearColorValue normalMotion = { {0.0f, 0.0f, 0.0f, 0.0f} };
+		const VkClearColorValue albedo = { {1.0f, 1.0f, 1.0f, 1.0f} };
+		VkClearColorValue instanceId = {};
+		instanceId.uint32[0] = 1;
+
+		ImageMemoryBarrier::Insert(commandBuffer, noisyImage_->Image().Handle(), colorRange, 0,
+			VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+
+		VkBufferImageCopy region = {};
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.layerCount = 1;
+		region.imageExtent = { extent_.width, extent_.height, 1 };
+
+		vkCmdCopyBufferToImage(commandBuffer, stagingBuffer.Handle(), noisyImage_->Image().Handle(), VK_IMAGE_LAYOUT_GENERAL, 1, &region);
+
+		vkCmdClearColorImage(commandBuffer, gBuffer_->Depth().Image().Handle(), VK_IMAGE_LAYOUT_GENERAL, &depth, 1, &colorRange);
+		vkCmdClearColorImage(commandBuffer, gBuffer_->NormalMotion().Image().Handle(), VK_IMAGE_LAYOUT_GENERAL, &normalMotion, 1, &colorRange);
+		vkCmdClearColorImage(commandBuffer, gBuffer_->Albedo().Image().Handle(), VK_IMAGE_LAYOUT_GENERAL, &albedo, 1, &colorRange);
+		vkCmdClearColorImage(commandBuffer, gBuffer_->InstanceId().Image().Handle(), VK_IMAGE_LAYOUT_GENERAL, &instanceId, 1, &colorRange);
+
+		for (const auto* image : { &gBuffer_->Depth(), &gBuffer_->NormalMotion(), &gBuffer_->Albedo(), &gBuffer_->InstanceId() })
+		{
+			ImageMemoryBarrier::Insert(commandBuffer, image->Image().Handle(), colorRange, VK_ACCESS_TRANSFER_WRITE_BIT,
+				VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL);
+		}
+
+		ImageMemoryBarrier::Insert(commandBuffer, outputImage_->Image().Handle(), colorRange, 0,
+			VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+	});
+}
+
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "Denoiser.hpp"
+#include <memory>
+#include <vector>
+
+namespace Vulkan
+{
+	class CommandPool;
+	class PipelineCache;
+	class QueryPool;
+	class RenderTarget;
+}
+
+namespace Vulkan::RayTracing
+{
+	class GBuffer;
+
+	// Runs the denoiser in isolation on synthetic inputs of a given resolution and measures its GPU time
+	// with timestamp queries, independently of the window size and of the rest of the frame.
+	// The inputs are deterministic, so that the outputs of different filter precisions can be compared.
+	class DenoiserBenchmark final
+	{
+	public:
+
+		VULKAN_NON_COPIABLE(DenoiserBenchmark)
+
+		DenoiserBenchmark(CommandPool& commandPool, const PipelineCache& pipelineCache, VkExtent2D extent, Denoiser::Precision precision);
+		~DenoiserBenchmark();
+
+		// Returns the average GPU time of Denoiser::Render over the given number of frames, in milliseconds.
+		double Run(const Denoiser::Parameters& parameters, uint32_t frameCount);
+
+		// RGBA8 output of the last frame rendered by Run().
+		std::vector<uint8_t> ReadOutput() const;
+
+	private:
+
+		void InitializeInputs();
+
+		CommandPool& commandPool_;
+		const VkExtent2D extent_;
+
+		std::unique_ptr<RenderTarget> noisyImage_;
+		std::unique_ptr<GBuffer> gBuffer_;
+		std::unique_ptr<RenderTarget> outputImage_;
+		std::unique_ptr<Denoiser> denoiser_;
+		std::unique_ptr<QueryPool> queryPool_;
+	};
+
+}
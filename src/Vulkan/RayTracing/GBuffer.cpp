@@ -0,0 +1,101 @@
+#include "GBuffer.hpp"
+#include "Vulkan/CommandPool.hpp"
+#include "Vulkan/Image.hpp"
+#include "Vulkan/ImageMemoryBarrier.hpp"
+#include "Vulkan/RenderTarget.hpp"
+#include "Vulkan/SingleTimeCommands.hpp"
+
+namespace Vulkan::RayTracing {
+
+namespace
+{
+	VkImageSubresourceRange ColorSubresourceRange()
+	{
+		VkImageSubresourceRange subresourceRange = {};
+		subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		subresourceRange.baseMipLevel = 0;
+		subresourceRange.levelCount = 1;
+		subresourceRange.baseArrayLayer = 0;
+		subresourceRange.layerCount = 1;
+		return subresourceRange;
+	}
+}
+
+GBuffer::GBuffer(CommandPool& commandPool, const VkExtent2D extent) :
+	extent_(extent)
+{
+	const auto& device = commandPool.Device();
+	const auto usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+
+	depth_.reset(new RenderTarget(device, extent, VK_FORMAT_R32_SFLOAT, usage, "G-Buffer Depth"));
+	normalMotion_.reset(new RenderTarget(device, extent, VK_FORMAT_R16G16B16A16_SFLOAT, usage, "G-Buffer Normal Motion"));
+	albedo_.reset(new RenderTarget(device, extent, VK_FORMAT_R8G8B8A8_UNORM, usage, "G-Buffer Albedo"));
+	instanceId_.reset(new RenderTarget(device, extent, VK_FORMAT_R32_UINT, usage, "G-Buffer Instance Id"));
+	sampleCount_.reset(new RenderTarget(device, extent, VK_FORMAT_R32_UINT, usage, "G-Buffer Sample Count"));
+	gradient_.reset(new RenderTarget(device, GradientExtent(), VK_FORMAT_R16G16B16A16_SFLOAT, usage, "G-Buffer Gradient"));
+
+	// Start from an empty G-buffer (all misses, no sample count) in the general layout.
+	SingleTimeCommands::Submit(commandPool, [this](VkCommandBuffer commandBuffer)
+	{
+		const auto subresourceRange = ColorSubresourceRange();
+		const VkClearColorValue clearColor = {};
+
+		for (const auto* image : Images())
+		{
+			ImageMemoryBarrier::Insert(commandBuffer, image->Image().Handle(), subresourceRange, 0,
+				VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+
+			vkCmdClearColorImage(commandBuffer, image->Image().Handle(), VK_IMAGE_LAYOUT_GENERAL, &clearColor, 1, &subresourceRange);
+		}
+	});
+}
+
+GBuffer::~GBuffer()
+{
+	gradient_.reset();
+	sampleCount_.reset();
+	instanceId_.reset();
+	albedo_.reset();
+	normalMotion_.reset();
+	depth_.reset();
+}
+
+VkExtent2D GBuffer::GradientExtent() const
+{
+	return
+	{
+		(extent_.width + GradientStratumSize - 1) / GradientStratumSize,
+		(extent_.height + GradientStratumSize - 1) / GradientStratumSize
+	};
+}
+
+void GBuffer::AcquireForWrite(VkCommandBuffer commandBuffer) const
+{
+	const auto subresourceRange = ColorSubresourceRange();
+
+	for (const auto* image : Images())
+	{
+		ImageMemoryBarrier::Insert(commandBuffer, image->Image().Handle(), subresourceRange,
+			VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+			VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL);
+	}
+}
+
+void GBuffer::TransferOwnership(VkCommandBuffer commandBuffer, const uint32_t srcQueueFamilyIndex, const uint32_t dstQueueFamilyIndex) const
+{
+	const auto subresourceRange = ColorSubresourceRange();
+
+	for (const auto* image : Images())
+	{
+		ImageMemoryBarrier::InsertQueueTransfer(commandBuffer, image->Image().Handle(), subresourceRange,
+			VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+			srcQueueFamilyIndex, dstQueueFamilyIndex);
+	}
+}
+
+std::array<const RenderTarget*, 6> GBuffer::Images() const
+{
+	return { depth_.get(), normalMotion_.get(), albedo_.get(), instanceId_.get(), sampleCount_.get(), gradient_.get() };
+}
+
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "Vulkan/Vulkan.hpp"
+#include <array>
+#include <memory>
+
+namespace Vulkan
+{
+	class CommandPool;
+	class RenderTarget;
+}
+
+namespace Vulkan::RayTracing
+{
+	// Primary hit attributes written by the ray generation shader, used as guides by the denoiser, and the sample
+	// count map the denoiser writes back for the ray generation shader. All the images of a slot travel together
+	// between the queues. They are storage images kept in VK_IMAGE_LAYOUT_GENERAL.
+	class GBuffer final
+	{
+	public:
+
+		VULKAN_NON_COPIABLE(GBuffer)
+
+		GBuffer(CommandPool& commandPool, VkExtent2D extent);
+		~GBuffer();
+
+		// Side of the pixel strata that share one temporal gradient sample, must match Gradient.glsl.
+		static constexpr uint32_t GradientStratumSize = 3;
+
+		VkExtent2D Extent() const { return extent_; }
+
+		// One texel per stratum.
+		VkExtent2D GradientExtent() const;
+
+		// Linear view space depth, zero on misses.
+		const RenderTarget& Depth() const { return *depth_; }
+
+		// Octahedral encoded world space normal (xy) and NDC motion since the previous frame (zw).
+		const RenderTarget& NormalMotion() const { return *normalMotion_; }
+
+		// Surface albedo, one for emitters.
+		const RenderTarget& Albedo() const { return *albedo_; }
+
+		// Instance index plus one, zero on misses.
+		const RenderTarget& InstanceId() const { return *instanceId_; }
+
+		// Number of paths to trace per pixel on the next use of this slot, written by the denoiser in adaptive sampling mode.
+		const RenderTarget& SampleCount() const { return *sampleCount_; }
+
+		// Sparse temporal gradient, one texel per stratum: absolute (x) and maximum (y) luminance of the replayed
+		// and of the previous path, and one where they hit the same surface (z).
+		const RenderTarget& Gradient() const { return *gradient_; }
+
+		// Makes the previous frame accesses (and the clears) complete before the ray generation shader accesses the images again.
+		void AcquireForWrite(VkCommandBuffer commandBuffer) const;
+
+		// Queue family ownership transfer of all the images, recorded on the releasing and then on the acquiring queue.
+		void TransferOwnership(VkCommandBuffer commandBuffer, uint32_t srcQueueFamilyIndex, uint32_t dstQueueFamilyIndex) const;
+
+	private:
+
+		std::array<const RenderTarget*, 6> Images() const;
+
+		const VkExtent2D extent_;
+
+		std::unique_ptr<RenderTarget> depth_;
+		std::unique_ptr<RenderTarget> normalMotion_;
+		std::unique_ptr<RenderTarget> albedo_;
+		std::unique_ptr<RenderTarget> instanceId_;
+		std::unique_ptr<RenderTarget> sampleCount_;
+		std::unique_ptr<RenderTarget> gradient_;
+	};
+
+}
@@ -1,5 +1,6 @@
 #include "RayTracingPipeline.hpp"
 #include "DeviceProcedures.hpp"
+#include "GBuffer.hpp"
 #include "TopLevelAccelerationStructure.hpp"
 #include "Assets/Scene.hpp"
 #include "Assets/UniformBuffer.hpp"
@@ -10,9 +11,13 @@
 #include "Vulkan/DescriptorSetManager.hpp"
 #include "Vulkan/DescriptorSets.hpp"
 #include "Vulkan/ImageView.hpp"
+#include "Vulkan/PipelineCache.hpp"
 #include "Vulkan/PipelineLayout.hpp"
+#include "Vulkan/RenderTarget.hpp"
 #include "Vulkan/ShaderModule.hpp"
+#include "Vulkan/SpecializationConstants.hpp"
 #include "Vulkan/SwapChain.hpp"
+#include "Vulkan/UniformBufferArena.hpp"
 
 namespace Vulkan::RayTracing {
 
@@ -21,12 +26,15 @@ RayTracingPipeline::RayTracingPipeline(
 	const SwapChain& swapChain,
 	const TopLevelAccelerationStructure& accelerationStructure,
 	const ImageView& accumulationImageView,
-	const ImageView& outputImageView,
-	const ImageView& saveImageView,
-	const ImageView& motionVectorImageView,
-	const Sampler& motionVectorSampler,
-	const std::vector<Assets::UniformBuffer>& uniformBuffers,
-	const Assets::Scene& scene) :
+	const std::array<const ImageView*, 2>& outputImageViews,
+	const ImageView& specularAccumulationImageView,
+	const std::array<const ImageView*, 2>& specularImageViews,
+	const std::array<const GBuffer*, 2>& gBuffers,
+	const std::array<const ImageView*, 2>& sampleHistoryImageViews,
+	const UniformBufferArena& uniformBufferArena,
+	const Assets::Scene& scene,
+	const PipelineCache& pipelineCache,
+	const Permutation& permutation) :
 	swapChain_(swapChain)
 {
 	// Create descriptor pool/sets.
@@ -40,8 +48,8 @@ RayTracingPipeline::RayTracingPipeline(
 		{1, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_RAYGEN_BIT_KHR},
 		{2, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_RAYGEN_BIT_KHR},
 
-		// Camera information & co
-		{3, 1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_RAYGEN_BIT_KHR | VK_SHADER_STAGE_MISS_BIT_KHR},
+		// Camera information & co, at a per-frame dynamic offset in the uniform buffer arena.
+		{3, 1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_RAYGEN_BIT_KHR | VK_SHADER_STAGE_MISS_BIT_KHR},
 
 		// Vertex buffer, Index buffer, Material buffer, Offset buffer
 		{4, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR},
@@ -55,82 +63,114 @@ RayTracingPipeline::RayTracingPipeline(
 		// The Procedural buffer.
 		{9, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR | VK_SHADER_STAGE_INTERSECTION_BIT_KHR},
 
-		//һ֡ͼ
-		{10, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_RAYGEN_BIT_KHR},
+		// Primary hit G-buffer: depth, normal and motion, albedo, instance id.
+		{11, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_RAYGEN_BIT_KHR},
+		{12, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_RAYGEN_BIT_KHR},
+		{13, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_RAYGEN_BIT_KHR},
+		{14, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_RAYGEN_BIT_KHR},
 
-		//motion vectorͼ
-		{11, 1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_RAYGEN_BIT_KHR}
+		// Specular output & accumulation, the image accumulation & output above hold the diffuse illumination.
+		{15, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_RAYGEN_BIT_KHR},
+		{16, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_RAYGEN_BIT_KHR},
+
+		// Adaptive sampling map of the slot, written by the denoiser.
+		{17, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_RAYGEN_BIT_KHR},
+
+		// Temporal gradient samples of the slot, sample histories of this and of the previous frame.
+		{18, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_RAYGEN_BIT_KHR},
+		{19, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_RAYGEN_BIT_KHR},
+		{20, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_RAYGEN_BIT_KHR}
 	};
 
-	descriptorSetManager_.reset(new DescriptorSetManager(device, descriptorBindings, uniformBuffers.size()));
+	// One set per frame slot, they only differ by their output image and G-buffer.
+	const uint32_t setCount = static_cast<uint32_t>(gBuffers.size());
+
+	descriptorSetManager_.reset(new DescriptorSetManager(device, descriptorBindings, setCount));
 
 	auto& descriptorSets = descriptorSetManager_->DescriptorSets();
 
-	for (uint32_t i = 0; i != swapChain.Images().size(); ++i)
+	// Top level acceleration structure.
+	const auto accelerationStructureHandle = accelerationStructure.Handle();
+	VkWriteDescriptorSetAccelerationStructureKHR structureInfo = {};
+	structureInfo.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET_ACCELERATION_STRUCTURE_KHR;
+	structureInfo.pNext = nullptr;
+	structureInfo.accelerationStructureCount = 1;
+	structureInfo.pAccelerationStructures = &accelerationStructureHandle;
+
+	// Accumulation image
+	VkDescriptorImageInfo accumulationImageInfo = {};
+	accumulationImageInfo.imageView = accumulationImageView.Handle();
+	accumulationImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+	VkDescriptorImageInfo specularAccumulationImageInfo = {};
+	specularAccumulationImageInfo.imageView = specularAccumulationImageView.Handle();
+	specularAccumulationImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+	// Uniform buffer
+	VkDescriptorBufferInfo uniformBufferInfo = {};
+	uniformBufferInfo.buffer = uniformBufferArena.Buffer().Handle();
+	uniformBufferInfo.range = sizeof(Assets::UniformBufferObject);
+
+	// Vertex buffer
+	VkDescriptorBufferInfo vertexBufferInfo = {};
+	vertexBufferInfo.buffer = scene.VertexBuffer().Handle();
+	vertexBufferInfo.range = VK_WHOLE_SIZE;
+
+	// Index buffer
+	VkDescriptorBufferInfo indexBufferInfo = {};
+	indexBufferInfo.buffer = scene.IndexBuffer().Handle();
+	indexBufferInfo.range = VK_WHOLE_SIZE;
+
+	// Material buffer
+	VkDescriptorBufferInfo materialBufferInfo = {};
+	materialBufferInfo.buffer = scene.MaterialBuffer().Handle();
+	materialBufferInfo.range = VK_WHOLE_SIZE;
+
+	// Offsets buffer
+	VkDescriptorBufferInfo offsetsBufferInfo = {};
+	offsetsBufferInfo.buffer = scene.OffsetsBuffer().Handle();
+	offsetsBufferInfo.range = VK_WHOLE_SIZE;
+
+	// Image and texture samplers.
+	std::vector<VkDescriptorImageInfo> imageInfos(scene.TextureSamplers().size());
+
+	for (size_t t = 0; t != imageInfos.size(); ++t)
 	{
-		// Top level acceleration structure.
-		const auto accelerationStructureHandle = accelerationStructure.Handle();
-		VkWriteDescriptorSetAccelerationStructureKHR structureInfo = {};
-		structureInfo.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET_ACCELERATION_STRUCTURE_KHR;
-		structureInfo.pNext = nullptr;
-		structureInfo.accelerationStructureCount = 1;
-		structureInfo.pAccelerationStructures = &accelerationStructureHandle;
-
-		// Accumulation image
-		VkDescriptorImageInfo accumulationImageInfo = {};
-		accumulationImageInfo.imageView = accumulationImageView.Handle();
-		accumulationImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+		auto& imageInfo = imageInfos[t];
+		imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		imageInfo.imageView = scene.TextureImageViews()[t];
+		imageInfo.sampler = scene.TextureSamplers()[t];
+	}
 
+	// Procedural buffer (optional)
+	VkDescriptorBufferInfo proceduralBufferInfo = {};
+	
+	if (scene.HasProcedurals())
+	{
+		proceduralBufferInfo.buffer = scene.ProceduralBuffer().Handle();
+		proceduralBufferInfo.range = VK_WHOLE_SIZE;
+	}
+
+	for (uint32_t i = 0; i != setCount; ++i)
+	{
 		// Output image
 		VkDescriptorImageInfo outputImageInfo = {};
-		outputImageInfo.imageView = outputImageView.Handle();
+		outputImageInfo.imageView = outputImageViews[i]->Handle();
 		outputImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
 
-		// Uniform buffer
-		VkDescriptorBufferInfo uniformBufferInfo = {};
-		uniformBufferInfo.buffer = uniformBuffers[i].Buffer().Handle();
-		uniformBufferInfo.range = VK_WHOLE_SIZE;
-
-		// Vertex buffer
-		VkDescriptorBufferInfo vertexBufferInfo = {};
-		vertexBufferInfo.buffer = scene.VertexBuffer().Handle();
-		vertexBufferInfo.range = VK_WHOLE_SIZE;
-
-		// Index buffer
-		VkDescriptorBufferInfo indexBufferInfo = {};
-		indexBufferInfo.buffer = scene.IndexBuffer().Handle();
-		indexBufferInfo.range = VK_WHOLE_SIZE;
-
-		// Material buffer
-		VkDescriptorBufferInfo materialBufferInfo = {};
-		materialBufferInfo.buffer = scene.MaterialBuffer().Handle();
-		materialBufferInfo.range = VK_WHOLE_SIZE;
-
-		// Offsets buffer
-		VkDescriptorBufferInfo offsetsBufferInfo = {};
-		offsetsBufferInfo.buffer = scene.OffsetsBuffer().Handle();
-		offsetsBufferInfo.range = VK_WHOLE_SIZE;
-
-		//һ֡ͼInfo
-		VkDescriptorImageInfo saveImageInfo = {};
-		saveImageInfo.imageView = saveImageView.Handle();
-		saveImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
-
-		//Motion Vector Info
-		VkDescriptorImageInfo motionVectorImageInfo = {};
-		motionVectorImageInfo.imageView = motionVectorImageView.Handle();
-		motionVectorImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-		motionVectorImageInfo.sampler = motionVectorSampler.Handle();
-
-		// Image and texture samplers.
-		std::vector<VkDescriptorImageInfo> imageInfos(scene.TextureSamplers().size());
-
-		for (size_t t = 0; t != imageInfos.size(); ++t)
+		VkDescriptorImageInfo specularImageInfo = {};
+		specularImageInfo.imageView = specularImageViews[i]->Handle();
+		specularImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+		// G-buffer images
+		const auto& gBuffer = *gBuffers[i];
+		std::array<VkDescriptorImageInfo, 4> gBufferImageInfos = {};
+		const std::array<const RenderTarget*, 4> gBufferImages = { &gBuffer.Depth(), &gBuffer.NormalMotion(), &gBuffer.Albedo(), &gBuffer.InstanceId() };
+
+		for (size_t g = 0; g != gBufferImageInfos.size(); ++g)
 		{
-			auto& imageInfo = imageInfos[t];
-			imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-			imageInfo.imageView = scene.TextureImageViews()[t];
-			imageInfo.sampler = scene.TextureSamplers()[t];
+			gBufferImageInfos[g].imageView = gBufferImages[g]->ImageView().Handle();
+			gBufferImageInfos[g].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
 		}
 
 		std::vector<VkWriteDescriptorSet> descriptorWrites =
@@ -146,21 +186,40 @@ RayTracingPipeline::RayTracingPipeline(
 			descriptorSets.Bind(i, 8, *imageInfos.data(), static_cast<uint32_t>(imageInfos.size()))
 		};
 
-		// Procedural buffer (optional)
-		VkDescriptorBufferInfo proceduralBufferInfo = {};
-		
 		if (scene.HasProcedurals())
 		{
-			proceduralBufferInfo.buffer = scene.ProceduralBuffer().Handle();
-			proceduralBufferInfo.range = VK_WHOLE_SIZE;
-
 			descriptorWrites.push_back(descriptorSets.Bind(i, 9, proceduralBufferInfo));
 		}
 
-		//һ֡ͼbindλΪ10
-		descriptorWrites.push_back(descriptorSets.Bind(i, 10, saveImageInfo));
+		for (uint32_t g = 0; g != gBufferImageInfos.size(); ++g)
+		{
+			descriptorWrites.push_back(descriptorSets.Bind(i, 11 + g, gBufferImageInfos[g]));
+		}
+
+		descriptorWrites.push_back(descriptorSets.Bind(i, 15, specularImageInfo));
+		descriptorWrites.push_back(descriptorSets.Bind(i, 16, specularAccumulationImageInfo));
+
+		VkDescriptorImageInfo sampleCountImageInfo = {};
+		sampleCountImageInfo.imageView = gBuffer.SampleCount().ImageView().Handle();
+		sampleCountImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
 
-		descriptorWrites.push_back(descriptorSets.Bind(i, 11, motionVectorImageInfo));
+		descriptorWrites.push_back(descriptorSets.Bind(i, 17, sampleCountImageInfo));
+
+		VkDescriptorImageInfo gradientImageInfo = {};
+		gradientImageInfo.imageView = gBuffer.Gradient().ImageView().Handle();
+		gradientImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+		VkDescriptorImageInfo sampleHistoryImageInfo = {};
+		sampleHistoryImageInfo.imageView = sampleHistoryImageViews[i]->Handle();
+		sampleHistoryImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+		VkDescriptorImageInfo previousSampleHistoryImageInfo = {};
+		previousSampleHistoryImageInfo.imageView = sampleHistoryImageViews[1 - i]->Handle();
+		previousSampleHistoryImageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+		descriptorWrites.push_back(descriptorSets.Bind(i, 18, gradientImageInfo));
+		descriptorWrites.push_back(descriptorSets.Bind(i, 19, sampleHistoryImageInfo));
+		descriptorWrites.push_back(descriptorSets.Bind(i, 20, previousSampleHistoryImageInfo));
 
 		descriptorSets.UpdateDescriptors(i, descriptorWrites);
 	}
@@ -174,9 +233,12 @@ RayTracingPipeline::RayTracingPipeline(
 	const ShaderModule proceduralClosestHitShader(device, "../assets/shaders/RayTracing.Procedural.rchit.spv");
 	const ShaderModule proceduralIntersectionShader(device, "../assets/shaders/RayTracing.Procedural.rint.spv");
 
+	// Must match the constant ids in RayTracing.rgen.
+	const SpecializationConstants rayGenConstants({ permutation.ShowHeatmap, permutation.AdaptiveSampling, permutation.TemporalGradient, permutation.Jitter });
+
 	std::vector<VkPipelineShaderStageCreateInfo> shaderStages =
 	{
-		rayGenShader.CreateShaderStage(VK_SHADER_STAGE_RAYGEN_BIT_KHR),
+		rayGenShader.CreateShaderStage(VK_SHADER_STAGE_RAYGEN_BIT_KHR, rayGenConstants.Info()),
 		missShader.CreateShaderStage(VK_SHADER_STAGE_MISS_BIT_KHR),
 		closestHitShader.CreateShaderStage(VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR),
 		proceduralClosestHitShader.CreateShaderStage(VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR),
@@ -246,7 +308,7 @@ RayTracingPipeline::RayTracingPipeline(
 	pipelineInfo.basePipelineHandle = nullptr;
 	pipelineInfo.basePipelineIndex = 0;
 
-	Check(deviceProcedures.vkCreateRayTracingPipelinesKHR(device.Handle(), nullptr, nullptr, 1, &pipelineInfo, nullptr, &pipeline_), 
+	Check(deviceProcedures.vkCreateRayTracingPipelinesKHR(device.Handle(), nullptr, pipelineCache.Handle(), 1, &pipelineInfo, nullptr, &pipeline_), 
 		"create ray tracing pipeline");
 }
 
@@ -2,33 +2,47 @@
 
 #include "Vulkan/Vulkan.hpp"
 #include "Vulkan/Sampler.hpp"
+#include <array>
 #include <memory>
 #include <vector>
 
 namespace Assets
 {
 	class Scene;
-	class UniformBuffer;
 }
 
 namespace Vulkan
 {
 	class DescriptorSetManager;
 	class ImageView;
+	class PipelineCache;
 	class PipelineLayout;
 	class SwapChain;
 	class Sampler;
+	class UniformBufferArena;
 }
 
 namespace Vulkan::RayTracing
 {
 	class DeviceProcedures;
+	class GBuffer;
 	class TopLevelAccelerationStructure;
 
 	class RayTracingPipeline final
 	{
 	public:
 
+		// Settings compiled into the ray generation shader as specialization constants, rather than branched on at run time.
+		struct Permutation
+		{
+			bool ShowHeatmap;
+			bool AdaptiveSampling;
+			bool TemporalGradient;
+			bool Jitter; // The first path of each pixel goes through the sub-pixel offset of the frame, for the temporal upscaler.
+
+			uint32_t Key() const { return (ShowHeatmap ? 1u : 0u) | (AdaptiveSampling ? 2u : 0u) | (TemporalGradient ? 4u : 0u) | (Jitter ? 8u : 0u); }
+		};
+
 		VULKAN_NON_COPIABLE(RayTracingPipeline)
 
 		RayTracingPipeline(
@@ -36,12 +50,15 @@ namespace Vulkan::RayTracing
 			const SwapChain& swapChain,
 			const TopLevelAccelerationStructure& accelerationStructure,
 			const ImageView& accumulationImageView,
-			const ImageView& outputImageView,
-			const ImageView& saveImageView,
-			const ImageView& motionVectorImageView,
-			const Sampler& motionVectorSampler,
-			const std::vector<Assets::UniformBuffer>& uniformBuffers,
-			const Assets::Scene& scene);
+			const std::array<const ImageView*, 2>& outputImageViews,
+			const ImageView& specularAccumulationImageView,
+			const std::array<const ImageView*, 2>& specularImageViews,
+			const std::array<const GBuffer*, 2>& gBuffers,
+			const std::array<const ImageView*, 2>& sampleHistoryImageViews,
+			const UniformBufferArena& uniformBufferArena,
+			const Assets::Scene& scene,
+			const PipelineCache& pipelineCache,
+			const Permutation& permutation);
 		~RayTracingPipeline();
 
 		uint32_t RayGenShaderIndex() const { return rayGenIndex_; }
@@ -49,6 +66,7 @@ namespace Vulkan::RayTracing
 		uint32_t TriangleHitGroupIndex() const { return triangleHitGroupIndex_; }
 		uint32_t ProceduralHitGroupIndex() const { return proceduralHitGroupIndex_; }
 
+		// One descriptor set per frame slot, each with its own output image and G-buffer.
 		VkDescriptorSet DescriptorSet(uint32_t index) const;
 		const class PipelineLayout& PipelineLayout() const { return *pipelineLayout_; }
 
@@ -0,0 +1,244 @@
+#include "TemporalUpscaler.hpp"
+#include "GBuffer.hpp"
+#include "Vulkan/CommandPool.hpp"
+#include "Vulkan/ComputePipeline.hpp"
+#include "Vulkan/DescriptorBinding.hpp"
+#include "Vulkan/DescriptorSetManager.hpp"
+#include "Vulkan/DescriptorSets.hpp"
+#include "Vulkan/Device.hpp"
+#include "Vulkan/Image.hpp"
+#include "Vulkan/ImageMemoryBarrier.hpp"
+#include "Vulkan/ImageView.hpp"
+#include "Vulkan/PipelineCache.hpp"
+#include "Vulkan/PipelineLayout.hpp"
+#include "Vulkan/RenderTarget.hpp"
+#include "Vulkan/SingleTimeCommands.hpp"
+#include "Vulkan/SpecializationConstants.hpp"
+#include <cmath>
+#include <string>
+#include <vector>
+
+namespace Vulkan::RayTracing {
+
+namespace
+{
+	// Must match the push constant block in TemporalUpscaler.comp.
+	struct Constants
+	{
+		glm::ivec2 InputExtent;
+		glm::ivec2 OutputExtent;
+		glm::vec2 Jitter;
+	};
+
+	// Must match the local_size declaration in TemporalUpscaler.comp.
+	const uint32_t LocalSize = 16;
+
+	// Color in YCoCg and accumulated sample weight, both signed.
+	const VkFormat HistoryFormat = VK_FORMAT_R16G16B16A16_SFLOAT;
+
+	uint32_t GroupCount(const uint32_t size, const uint32_t localSize)
+	{
+		return (size + localSize - 1) / localSize;
+	}
+
+	// Radical inverse of the index in the given base, in [0, 1).
+	float Halton(uint32_t index, const uint32_t base)
+	{
+		float fraction = 1.0f;
+		float result = 0.0f;
+
+		while (index > 0)
+		{
+			fraction /= static_cast<float>(base);
+			result += fraction * static_cast<float>(index % base);
+			index /= base;
+		}
+
+		return result;
+	}
+
+	// Eight phases per input pixel an output pixel is scaled down from, as each phase lands in a different output pixel.
+	uint32_t JitterPhaseCount(const VkExtent2D inputExtent, const VkExtent2D outputExtent)
+	{
+		const float ratio = static_cast<float>(outputExtent.width) / static_cast<float>(inputExtent.width);
+		return static_cast<uint32_t>(std::ceil(8.0f * ratio * ratio));
+	}
+}
+
+TemporalUpscaler::TemporalUpscaler(
+	CommandPool& commandPool,
+	const PipelineCache& pipelineCache,
+	const VkExtent2D inputExtent,
+	const VkExtent2D outputExtent,
+	const VkFormat outputFormat,
+	const std::array<const GBuffer*, 2>& gBuffers,
+	const std::array<const ImageView*, 2>& inputImageViews) :
+	device_(commandPool.Device()),
+	inputExtent_(inputExtent),
+	outputExtent_(outputExtent),
+	outputFormat_(outputFormat),
+	jitterPhaseCount_(JitterPhaseCount(inputExtent, outputExtent))
+{
+	CreateImages(commandPool);
+	CreateDescriptorSets(gBuffers, inputImageViews);
+
+	VkPushConstantRange pushConstantRange = {};
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	pushConstantRange.offset = 0;
+	pushConstantRange.size = sizeof(Constants);
+
+	pipelineLayout_.reset(new class PipelineLayout(device_, descriptorSetManager_->DescriptorSetLayout(), { pushConstantRange }));
+
+	for (uint32_t reset = 0; reset != pipelines_.size(); ++reset)
+	{
+		const SpecializationConstants specializationConstants({ reset });
+
+		pipelines_[reset].reset(new ComputePipeline(pipelineCache, *pipelineLayout_, "../assets/shaders/TemporalUpscaler.comp.spv", specializationConstants));
+
+		device_.DebugUtils().SetObjectName(pipelines_[reset]->Handle(),
+			("Temporal Upscaler Pipeline #" + std::to_string(reset)).c_str());
+	}
+}
+
+TemporalUpscaler::~TemporalUpscaler()
+{
+	for (auto& pipeline : pipelines_) pipeline.reset();
+	pipelineLayout_.reset();
+	descriptorSetManager_.reset();
+	for (auto& image : outputImages_) image.reset();
+	for (auto& image : historyImages_) image.reset();
+}
+
+glm::vec2 TemporalUpscaler::Jitter() const
+{
+	// Index zero of the sequence is the origin, start at one.
+	const uint32_t phase = frameIndex_ % jitterPhaseCount_ + 1;
+	return glm::vec2(Halton(phase, 2), Halton(phase, 3)) - 0.5f;
+}
+
+void TemporalUpscaler::Render(VkCommandBuffer commandBuffer, const uint32_t slot)
+{
+	// The trace of this frame was recorded before its uniform buffer was written, see Jitter().
+	frameIndex_++;
+
+	const uint32_t current = frameIndex_ % 2;
+
+	Constants constants = {};
+	constants.InputExtent = glm::ivec2(inputExtent_.width, inputExtent_.height);
+	constants.OutputExtent = glm::ivec2(outputExtent_.width, outputExtent_.height);
+	constants.Jitter = Jitter();
+
+	// Wait for the denoiser composite pass that produced our input, and for the previous frame's history writes.
+	VkMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+	const auto& pipeline = *pipelines_[historyValid_ ? 0 : 1];
+	VkDescriptorSet descriptorSets[] = { descriptorSetManager_->DescriptorSets().Handle(slot * 2 + current) };
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.Handle());
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout_->Handle(), 0, 1, descriptorSets, 0, nullptr);
+	vkCmdPushConstants(commandBuffer, pipelineLayout_->Handle(), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(Constants), &constants);
+	vkCmdDispatch(commandBuffer, GroupCount(outputExtent_.width, LocalSize), GroupCount(outputExtent_.height, LocalSize), 1);
+
+	historyValid_ = true;
+}
+
+void TemporalUpscaler::CreateImages(CommandPool& commandPool)
+{
+	const auto& device = commandPool.Device();
+
+	for (size_t i = 0; i != 2; ++i)
+	{
+		historyImages_[i].reset(new RenderTarget(device, outputExtent_, HistoryFormat, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT, "Upscaler History", MemoryAllocator::Category::DenoiserHistory));
+		outputImages_[i].reset(new RenderTarget(device, outputExtent_, outputFormat_, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, "Upscaled Output"));
+	}
+
+	// The history lives in the general layout, start it from a known state. The outputs are transitioned every frame.
+	SingleTimeCommands::Submit(commandPool, [this](VkCommandBuffer commandBuffer)
+	{
+		VkImageSubresourceRange subresourceRange = {};
+		subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		subresourceRange.baseMipLevel = 0;
+		subresourceRange.levelCount = 1;
+		subresourceRange.baseArrayLayer = 0;
+		subresourceRange.layerCount = 1;
+
+		const VkClearColorValue clearColor = { {0.0f, 0.0f, 0.0f, 0.0f} };
+
+		for (const auto& image : historyImages_)
+		{
+			ImageMemoryBarrier::Insert(commandBuffer, image->Image().Handle(), subresourceRange, 0,
+				VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+
+			vkCmdClearColorImage(commandBuffer, image->Image().Handle(), VK_IMAGE_LAYOUT_GENERAL, &clearColor, 1, &subresourceRange);
+		}
+	});
+}
+
+void TemporalUpscaler::CreateDescriptorSets(const std::array<const GBuffer*, 2>& gBuffers, const std::array<const ImageView*, 2>& inputImageViews)
+{
+	const VkShaderStageFlags stage = VK_SHADER_STAGE_COMPUTE_BIT;
+
+	const std::vector<DescriptorBinding> descriptorBindings =
+	{
+		// Inputs: denoised image, G-buffer depth, G-buffer normal and motion vectors.
+		{0, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, stage},
+		{1, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, stage},
+		{2, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, stage},
+
+		// History (previous, current).
+		{3, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, stage},
+		{4, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, stage},
+
+		// Output.
+		{5, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, stage}
+	};
+
+	// One set per (slot, frame parity).
+	const uint32_t setCount = 4;
+
+	descriptorSetManager_.reset(new DescriptorSetManager(device_, descriptorBindings, setCount));
+
+	auto& descriptorSets = descriptorSetManager_->DescriptorSets();
+
+	const auto storageInfo = [](const ImageView& imageView)
+	{
+		VkDescriptorImageInfo info = {};
+		info.imageView = imageView.Handle();
+		info.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+		return info;
+	};
+
+	for (uint32_t i = 0; i != setCount; ++i)
+	{
+		const uint32_t slot = i / 2;
+		const uint32_t current = i % 2;
+		const uint32_t previous = 1 - current;
+		const auto& gBuffer = *gBuffers[slot];
+
+		const std::vector<VkDescriptorImageInfo> imageInfos =
+		{
+			storageInfo(*inputImageViews[slot]),
+			storageInfo(gBuffer.Depth().ImageView()),
+			storageInfo(gBuffer.NormalMotion().ImageView()),
+			storageInfo(historyImages_[previous]->ImageView()),
+			storageInfo(historyImages_[current]->ImageView()),
+			storageInfo(outputImages_[slot]->ImageView())
+		};
+
+		std::vector<VkWriteDescriptorSet> descriptorWrites;
+
+		for (uint32_t binding = 0; binding != imageInfos.size(); ++binding)
+		{
+			descriptorWrites.push_back(descriptorSets.Bind(i, binding, imageInfos[binding]));
+		}
+
+		descriptorSets.UpdateDescriptors(i, descriptorWrites);
+	}
+}
+
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "Vulkan/Vulkan.hpp"
+#include "Utilities/Glm.hpp"
+#include <array>
+#include <memory>
+
+namespace Vulkan
+{
+	class CommandPool;
+	class ComputePipeline;
+	class DescriptorSetManager;
+	class Device;
+	class ImageView;
+	class PipelineCache;
+	class PipelineLayout;
+	class RenderTarget;
+}
+
+namespace Vulkan::RayTracing
+{
+	class GBuffer;
+
+	// Temporal reconstruction of the denoised images traced at a reduced render scale into display resolution images.
+	// The first path of each input pixel goes through a sub-pixel offset that follows a Halton (2, 3) sequence, so that
+	// over a few frames the input samples cover every output pixel. Each frame, the new samples around an output pixel
+	// are blended with its history, reprojected with the G-buffer motion vectors and clamped to the color distribution
+	// of the new samples (in YCoCg) to reject disoccluded and changed content.
+	// The inputs, G-buffers and outputs come in two slots like the denoiser's, the history is shared by both slots.
+	class TemporalUpscaler final
+	{
+	public:
+
+		VULKAN_NON_COPIABLE(TemporalUpscaler)
+
+		TemporalUpscaler(
+			CommandPool& commandPool,
+			const PipelineCache& pipelineCache,
+			VkExtent2D inputExtent,
+			VkExtent2D outputExtent,
+			VkFormat outputFormat,
+			const std::array<const GBuffer*, 2>& gBuffers,
+			const std::array<const ImageView*, 2>& inputImageViews);
+		~TemporalUpscaler();
+
+		const class Device& Device() const { return device_; }
+		VkExtent2D InputExtent() const { return inputExtent_; }
+		VkExtent2D OutputExtent() const { return outputExtent_; }
+
+		// Display resolution result of the slot.
+		const RenderTarget& Output(uint32_t slot) const { return *outputImages_[slot]; }
+
+		// Offset of the first path of each input pixel from its center, in [-0.5, 0.5], for the frame last recorded by
+		// Render(). The uniform buffer of a frame is written once its commands are recorded and picks up the same value.
+		glm::vec2 Jitter() const;
+
+		// Records the reconstruction of the slot's input and advances the jitter sequence. The input, the G-buffer and
+		// the output must be in VK_IMAGE_LAYOUT_GENERAL.
+		void Render(VkCommandBuffer commandBuffer, uint32_t slot);
+
+	private:
+
+		void CreateImages(CommandPool& commandPool);
+		void CreateDescriptorSets(const std::array<const GBuffer*, 2>& gBuffers, const std::array<const ImageView*, 2>& inputImageViews);
+
+		const class Device& device_;
+		const VkExtent2D inputExtent_;
+		const VkExtent2D outputExtent_;
+		const VkFormat outputFormat_;
+
+		// Enough phases of the jitter sequence for each output pixel to receive a few samples.
+		const uint32_t jitterPhaseCount_;
+
+		// Reconstructed color and accumulated sample weight, alternating their role (current/previous) every frame.
+		std::array<std::unique_ptr<RenderTarget>, 2> historyImages_;
+		std::array<std::unique_ptr<RenderTarget>, 2> outputImages_;
+
+		std::unique_ptr<DescriptorSetManager> descriptorSetManager_;
+		std::unique_ptr<class PipelineLayout> pipelineLayout_;
+
+		// Without and with the history reset.
+		std::array<std::unique_ptr<ComputePipeline>, 2> pipelines_;
+
+		uint32_t frameIndex_{};
+		bool historyValid_{};
+	};
+
+}
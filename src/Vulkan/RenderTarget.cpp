@@ -0,0 +1,53 @@
+#include "RenderTarget.hpp"
+#include "Device.hpp"
+#include "DeviceMemory.hpp"
+#include "Image.hpp"
+#include "ImageView.hpp"
+#include <string>
+#include <utility>
+
+namespace Vulkan {
+
+RenderTarget::RenderTarget(
+	const Device& device,
+	const VkExtent2D extent,
+	const VkFormat format,
+	const VkImageUsageFlags usage,
+	const char* const name,
+	const MemoryAllocator::Category category) :
+	format_(format)
+{
+	image_.reset(new class Image(device, extent, format, VK_IMAGE_TILING_OPTIMAL, usage));
+	imageMemory_.reset(new DeviceMemory(image_->AllocateMemory(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, category)));
+	imageView_.reset(new class ImageView(device, image_->Handle(), format, VK_IMAGE_ASPECT_COLOR_BIT));
+
+	const auto& debugUtils = device.DebugUtils();
+
+	debugUtils.SetObjectName(image_->Handle(), (name + std::string(" Image")).c_str());
+	debugUtils.SetObjectName(imageMemory_->Handle(), (name + std::string(" Image Memory")).c_str());
+	debugUtils.SetObjectName(imageView_->Handle(), (name + std::string(" ImageView")).c_str());
+}
+
+RenderTarget::RenderTarget(std::unique_ptr<class Image> image, const DeviceMemory& memory, const VkDeviceSize offset, const char* const name) :
+	format_(image->Format()),
+	image_(std::move(image))
+{
+	const auto& device = image_->Device();
+
+	image_->BindMemory(memory, offset);
+	imageView_.reset(new class ImageView(device, image_->Handle(), format_, VK_IMAGE_ASPECT_COLOR_BIT));
+
+	const auto& debugUtils = device.DebugUtils();
+
+	debugUtils.SetObjectName(image_->Handle(), (name + std::string(" Image")).c_str());
+	debugUtils.SetObjectName(imageView_->Handle(), (name + std::string(" ImageView")).c_str());
+}
+
+RenderTarget::~RenderTarget()
+{
+	imageView_.reset();
+	image_.reset();
+	imageMemory_.reset(); // release memory after bound image has been destroyed
+}
+
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "Vulkan.hpp"
+#include "MemoryAllocator.hpp"
+#include <memory>
+
+namespace Vulkan
+{
+	class Device;
+	class DeviceMemory;
+	class Image;
+	class ImageView;
+
+	// A device local image, its memory (unless shared) and a full view on it, used as an intermediate render target.
+	class RenderTarget final
+	{
+	public:
+
+		VULKAN_NON_COPIABLE(RenderTarget)
+
+		RenderTarget(
+			const Device& device,
+			VkExtent2D extent,
+			VkFormat format,
+			VkImageUsageFlags usage,
+			const char* name,
+			MemoryAllocator::Category category = MemoryAllocator::Category::RenderTargets);
+
+		// Over the given offset of memory owned elsewhere, see TransientRenderTargets.
+		RenderTarget(std::unique_ptr<class Image> image, const DeviceMemory& memory, VkDeviceSize offset, const char* name);
+		~RenderTarget();
+
+		const class Image& Image() const { return *image_; }
+		class Image& Image() { return *image_; }
+		const class ImageView& ImageView() const { return *imageView_; }
+		VkFormat Format() const { return format_; }
+
+	private:
+
+		const VkFormat format_;
+		std::unique_ptr<class Image> image_;
+		std::unique_ptr<DeviceMemory> imageMemory_;
+		std::unique_ptr<class ImageView> imageView_;
+	};
+
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "Vulkan.hpp"
+#include <vector>
+
+namespace Vulkan
+{
+	// Specialization constants of a shader stage, the value at index i sets the 32-bit constant of constant_id i
+	// (booleans are 0 or 1). Each combination of values is a separate pipeline, compiled with the constants folded in.
+	class SpecializationConstants final
+	{
+	public:
+
+		VULKAN_NON_COPIABLE(SpecializationConstants)
+
+		SpecializationConstants() = default;
+
+		explicit SpecializationConstants(std::vector<uint32_t> values) :
+			values_(std::move(values))
+		{
+			for (uint32_t i = 0; i != values_.size(); ++i)
+			{
+				entries_.push_back({ i, static_cast<uint32_t>(i * sizeof(uint32_t)), sizeof(uint32_t) });
+			}
+
+			info_.mapEntryCount = static_cast<uint32_t>(entries_.size());
+			info_.pMapEntries = entries_.data();
+			info_.dataSize = values_.size() * sizeof(uint32_t);
+			info_.pData = values_.data();
+		}
+
+		// Null when there are no constants, as expected by VkPipelineShaderStageCreateInfo.
+		const VkSpecializationInfo* Info() const { return values_.empty() ? nullptr : &info_; }
+
+	private:
+
+		std::vector<uint32_t> values_;
+		std::vector<VkSpecializationMapEntry> entries_;
+		VkSpecializationInfo info_{};
+	};
+
+}
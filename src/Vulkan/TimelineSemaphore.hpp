@@ -0,0 +1,32 @@
+#pragma once
+
+#include "Vulkan.hpp"
+
+namespace Vulkan
+{
+	class Device;
+
+	// Semaphore with a monotonically increasing 64-bit payload, which queue submissions signal and wait on by value
+	// and the host can query or wait on without a fence.
+	class TimelineSemaphore final
+	{
+	public:
+
+		VULKAN_NON_COPIABLE(TimelineSemaphore)
+
+		TimelineSemaphore(const Device& device, uint64_t initialValue);
+		~TimelineSemaphore();
+
+		const class Device& Device() const { return device_; }
+
+		uint64_t Value() const;
+		void Wait(uint64_t value) const;
+
+	private:
+
+		const class Device& device_;
+
+		VULKAN_HANDLE(VkSemaphore, semaphore_)
+	};
+
+}
@@ -0,0 +1,227 @@
+#include "TransientRenderTargets.hpp"
+#include "Device.hpp"
+#include "DeviceMemory.hpp"
+#include "Image.hpp"
+#include "RenderTarget.hpp"
+#include "Utilities/Exception.hpp"
+#include <algorithm>
+#include <utility>
+
+namespace Vulkan {
+
+namespace
+{
+	VkDeviceSize AlignUp(const VkDeviceSize offset, const VkDeviceSize alignment)
+	{
+		return (offset + alignment - 1) / alignment * alignment;
+	}
+}
+
+TransientRenderTargets::TransientRenderTargets(const class Device& device, const MemoryAllocator::Category category) :
+	device_(device),
+	category_(category)
+{
+}
+
+TransientRenderTargets::~TransientRenderTargets()
+{
+	targets_.clear();
+	memory_.reset(); // release memory after the bound images have been destroyed
+}
+
+uint32_t TransientRenderTargets::Add(
+	const VkExtent2D extent,
+	const VkFormat format,
+	const VkImageUsageFlags usage,
+	const char* const name)
+{
+	if (memory_)
+	{
+		Throw(std::logic_error("transient render targets have already been allocated"));
+	}
+
+	Target target = {};
+	target.Image.reset(new class Image(device_, extent, format, VK_IMAGE_TILING_OPTIMAL, usage));
+	target.Name = name;
+	target.FirstPass = NoPass;
+	target.LastPass = 0;
+	target.Requirements = target.Image->GetMemoryRequirements();
+
+	targets_.push_back(std::move(target));
+
+	return static_cast<uint32_t>(targets_.size() - 1);
+}
+
+void TransientRenderTargets::Use(const uint32_t target, const uint32_t pass)
+{
+	if (memory_)
+	{
+		Throw(std::logic_error("transient render targets have already been allocated"));
+	}
+
+	auto& entry = targets_.at(target);
+	entry.FirstPass = std::min(entry.FirstPass, pass);
+	entry.LastPass = std::max(entry.LastPass, pass);
+}
+
+void TransientRenderTargets::Allocate()
+{
+	for (const auto& target : targets_)
+	{
+		if (target.FirstPass == NoPass)
+		{
+			Throw(std::logic_error("transient render target '" + target.Name + "' is not used by any pass"));
+		}
+	}
+
+	// Largest first, the smaller targets then fill the gaps left between them.
+	std::vector<Target*> order;
+
+	for (auto& target : targets_)
+	{
+		order.push_back(&target);
+	}
+
+	std::stable_sort(order.begin(), order.end(), [](const Target* lhs, const Target* rhs)
+	{
+		return lhs->Requirements.size > rhs->Requirements.size;
+	});
+
+	std::vector<const Target*> placed;
+	uint32_t memoryTypeBits = ~0u;
+	VkDeviceSize alignment = 1;
+	VkDeviceSize size = 0;
+
+	for (auto* const target : order)
+	{
+		const auto& requirements = target->Requirements;
+
+		// The placed targets alive during any pass of this one, by offset.
+		std::vector<const Target*> overlapping;
+
+		for (const auto* const other : placed)
+		{
+			if (other->FirstPass <= target->LastPass && target->FirstPass <= other->LastPass)
+			{
+				overlapping.push_back(other);
+			}
+		}
+
+		std::sort(overlapping.begin(), overlapping.end(), [](const Target* lhs, const Target* rhs)
+		{
+			return lhs->Offset < rhs->Offset;
+		});
+
+		VkDeviceSize offset = 0;
+
+		for (const auto* const other : overlapping)
+		{
+			if (AlignUp(offset, requirements.alignment) + requirements.size <= other->Offset)
+			{
+				break;
+			}
+
+			offset = std::max(offset, other->Offset + other->Requirements.size);
+		}
+
+		target->Offset = AlignUp(offset, requirements.alignment);
+		placed.push_back(target);
+
+		memoryTypeBits &= requirements.memoryTypeBits;
+		alignment = std::max(alignment, requirements.alignment);
+		size = std::max(size, target->Offset + requirements.size);
+	}
+
+	if (memoryTypeBits == 0)
+	{
+		Throw(std::runtime_error("failed to find a memory type suitable for all the transient render targets"));
+	}
+
+	VkMemoryRequirements requirements = {};
+	requirements.size = size;
+	requirements.alignment = alignment;
+	requirements.memoryTypeBits = memoryTypeBits;
+
+	// A memory object of its own, so that the start of the allocation meets the alignment of every target.
+	memory_.reset(new DeviceMemory(device_, device_.Allocator().Allocate(requirements, MemoryAllocator::ResourceKind::Image,
+		MemoryAllocator::Strategy::General, category_, true, 0, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)));
+
+	for (auto& target : targets_)
+	{
+		target.RenderTarget.reset(new class RenderTarget(std::move(target.Image), *memory_, target.Offset, target.Name.c_str()));
+	}
+
+	device_.DebugUtils().SetObjectName(memory_->Handle(), "Transient Render Targets Memory");
+}
+
+void TransientRenderTargets::BeginFrame()
+{
+	currentPass_ = NoPass;
+
+	for (auto& target : targets_)
+	{
+		target.Discarded = false;
+	}
+}
+
+void TransientRenderTargets::BeginPass(VkCommandBuffer commandBuffer, const uint32_t pass)
+{
+	if (currentPass_ != NoPass && pass <= currentPass_)
+	{
+		Throw(std::logic_error("transient render target pass " + std::to_string(pass) + " begins after pass " + std::to_string(currentPass_)));
+	}
+
+	currentPass_ = pass;
+
+	std::vector<VkImageMemoryBarrier> barriers;
+
+	for (auto& target : targets_)
+	{
+		if (target.FirstPass != pass)
+		{
+			continue;
+		}
+
+		target.Discarded = true;
+
+		VkImageMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = target.RenderTarget->Image().Handle();
+		barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+
+		barriers.push_back(barrier);
+	}
+
+	if (barriers.empty())
+	{
+		return;
+	}
+
+	// The targets that used the memory before may have been accessed by any stage, and by the previous frame.
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0,
+		0, nullptr, 0, nullptr, static_cast<uint32_t>(barriers.size()), barriers.data());
+}
+
+void TransientRenderTargets::CheckUse(const uint32_t target) const
+{
+	const auto& entry = targets_.at(target);
+
+	// Outside of its lifetime, the memory of the target may belong to another one.
+	if (currentPass_ == NoPass || currentPass_ < entry.FirstPass || currentPass_ > entry.LastPass)
+	{
+		Throw(std::logic_error("transient render target '" + entry.Name + "' is used outside of its passes"));
+	}
+
+	if (!entry.Discarded)
+	{
+		Throw(std::logic_error("transient render target '" + entry.Name + "' is used before the first of its passes began"));
+	}
+}
+
+}
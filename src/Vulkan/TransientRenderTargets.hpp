@@ -0,0 +1,72 @@
+#pragma once
+
+#include "Vulkan.hpp"
+#include "MemoryAllocator.hpp"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Vulkan
+{
+	class Device;
+	class DeviceMemory;
+	class Image;
+	class RenderTarget;
+
+	// Render targets whose content only lives within a frame, from the first to the last of the frame's passes that
+	// use them. Passes are numbered in the order the frame runs them, Use() records each pass accessing a target and
+	// its lifetime spans them. The targets whose lifetimes do not overlap alias the same memory: once all are declared,
+	// Allocate() places them in a single allocation, largest first, each at the lowest offset clear of the targets it
+	// overlaps in time. An aliased target loses its content to the others, BeginPass() discards it before the first use.
+	// The passes a frame begins are checked against the recorded lifetimes, see CheckUse().
+	class TransientRenderTargets final
+	{
+	public:
+
+		VULKAN_NON_COPIABLE(TransientRenderTargets)
+
+		TransientRenderTargets(const Device& device, MemoryAllocator::Category category);
+		~TransientRenderTargets();
+
+		const class Device& Device() const { return device_; }
+
+		// Declares a target, available once allocated. Every target needs at least one Use() before Allocate().
+		uint32_t Add(VkExtent2D extent, VkFormat format, VkImageUsageFlags usage, const char* name);
+		void Use(uint32_t target, uint32_t pass);
+		void Allocate();
+
+		const RenderTarget& operator [] (uint32_t index) const { return *targets_[index].RenderTarget; }
+
+		// The passes of a frame must begin in increasing order. BeginPass() records the transition of the targets first
+		// used by the pass from the undefined layout to VK_IMAGE_LAYOUT_GENERAL, after all the previously recorded
+		// accesses to the memory they share.
+		void BeginFrame();
+		void BeginPass(VkCommandBuffer commandBuffer, uint32_t pass);
+
+		// Throws unless the current pass lies within the lifetime of the target and the frame began its first pass.
+		void CheckUse(uint32_t target) const;
+
+	private:
+
+		struct Target
+		{
+			std::unique_ptr<class Image> Image;
+			std::unique_ptr<class RenderTarget> RenderTarget;
+			std::string Name;
+			uint32_t FirstPass;
+			uint32_t LastPass;
+			VkMemoryRequirements Requirements;
+			VkDeviceSize Offset;
+			bool Discarded; // Whether the current frame began the first pass.
+		};
+
+		static const uint32_t NoPass = ~0u;
+
+		const class Device& device_;
+		const MemoryAllocator::Category category_;
+		std::vector<Target> targets_;
+		std::unique_ptr<DeviceMemory> memory_;
+		uint32_t currentPass_{NoPass};
+	};
+
+}
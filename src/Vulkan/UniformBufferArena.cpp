@@ -0,0 +1,78 @@
+#include "UniformBufferArena.hpp"
+#include "Buffer.hpp"
+#include "Device.hpp"
+#include "Utilities/Exception.hpp"
+#include <cstring>
+
+namespace Vulkan {
+
+namespace
+{
+	size_t AlignUp(const size_t value, const size_t alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+}
+
+UniformBufferArena::UniformBufferArena(const class Device& device, const uint32_t frameCount, const size_t frameSize) :
+	frameSize_(frameSize),
+	frameCount_(frameCount)
+{
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(device.PhysicalDevice(), &properties);
+
+	alignment_ = static_cast<size_t>(properties.limits.minUniformBufferOffsetAlignment);
+
+	if (frameSize_ % alignment_ != 0)
+	{
+		Throw(std::invalid_argument("uniform buffer arena frame size is not a multiple of the offset alignment"));
+	}
+
+	buffer_.reset(new class Buffer(device, frameSize_ * frameCount_, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT));
+	memory_.reset(new DeviceMemory(buffer_->AllocateMemory(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)));
+	mapped_ = static_cast<uint8_t*>(memory_->Map(0, frameSize_ * frameCount_));
+}
+
+UniformBufferArena::~UniformBufferArena()
+{
+	if (mapped_ != nullptr)
+	{
+		memory_->Unmap();
+		mapped_ = nullptr;
+	}
+
+	buffer_.reset();
+	memory_.reset(); // release memory after bound buffer has been destroyed
+}
+
+void UniformBufferArena::BeginFrame(const uint32_t frameIndex)
+{
+	if (frameIndex >= frameCount_)
+	{
+		Throw(std::out_of_range("invalid uniform buffer arena frame index"));
+	}
+
+	frameBegin_ = frameIndex * frameSize_;
+	cursor_ = frameBegin_;
+}
+
+uint32_t UniformBufferArena::Allocate(const size_t size)
+{
+	const auto offset = cursor_;
+
+	if (offset + size > frameBegin_ + frameSize_)
+	{
+		Throw(std::runtime_error("uniform buffer arena frame slice is full"));
+	}
+
+	cursor_ = AlignUp(offset + size, alignment_);
+
+	return static_cast<uint32_t>(offset);
+}
+
+void UniformBufferArena::Write(const uint32_t offset, const void* const data, const size_t size)
+{
+	std::memcpy(mapped_ + offset, data, size);
+}
+
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "Vulkan.hpp"
+#include <memory>
+
+namespace Vulkan
+{
+	class Buffer;
+	class Device;
+	class DeviceMemory;
+
+	// A single host visible uniform buffer split into one slice per frame in flight, persistently mapped.
+	// Every frame suballocates its uniform data (frame globals, per-pass constants) linearly from its own slice
+	// and binds it through VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC descriptors at the returned offsets,
+	// so uploads are plain memcpys without any driver call.
+	class UniformBufferArena final
+	{
+	public:
+
+		VULKAN_NON_COPIABLE(UniformBufferArena)
+
+		UniformBufferArena(const Device& device, uint32_t frameCount, size_t frameSize);
+		~UniformBufferArena();
+
+		const class Buffer& Buffer() const { return *buffer_; }
+
+		// Rewinds the slice of the given frame. The caller must have waited for the frame's previous submission.
+		void BeginFrame(uint32_t frameIndex);
+
+		// Reserves suitably aligned space in the current frame slice and returns its dynamic offset.
+		uint32_t Allocate(size_t size);
+		void Write(uint32_t offset, const void* data, size_t size);
+
+		template <class T>
+		uint32_t Push(const T& value)
+		{
+			const auto offset = Allocate(sizeof(T));
+			Write(offset, &value, sizeof(T));
+			return offset;
+		}
+
+	private:
+
+		const size_t frameSize_;
+		const uint32_t frameCount_;
+		size_t alignment_{};
+		size_t frameBegin_{};
+		size_t cursor_{};
+
+		std::unique_ptr<class Buffer> buffer_;
+		std::unique_ptr<DeviceMemory> memory_;
+		uint8_t* mapped_{};
+	};
+
+}
@@ -0,0 +1,295 @@
+#include "Uploader.hpp"
+#include "Buffer.hpp"
+#include "CommandBuffers.hpp"
+#include "CommandPool.hpp"
+#include "Device.hpp"
+#include "Image.hpp"
+#include "TimelineSemaphore.hpp"
+#include "Utilities/Exception.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace Vulkan {
+
+namespace
+{
+	// Covers the buffer to image copy offset requirements of every format.
+	const size_t CopyAlignment = 16;
+
+	size_t AlignUp(const size_t value, const size_t alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+}
+
+Uploader::Uploader(const class Device& device, const size_t ringSize) :
+	device_(device),
+	segmentSize_(AlignUp(ringSize / SegmentCount, CopyAlignment)),
+	srcQueueFamilyIndex_(device.HasDedicatedTransferQueue() ? device.TransferFamilyIndex() : VK_QUEUE_FAMILY_IGNORED),
+	dstQueueFamilyIndex_(device.HasDedicatedTransferQueue() ? device.GraphicsFamilyIndex() : VK_QUEUE_FAMILY_IGNORED)
+{
+	const auto& debugUtils = device_.DebugUtils();
+
+	buffer_.reset(new class Buffer(device_, segmentSize_ * SegmentCount, VK_BUFFER_USAGE_TRANSFER_SRC_BIT));
+	memory_.reset(new DeviceMemory(buffer_->AllocateMemory(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, MemoryAllocator::Category::Staging)));
+	mapped_ = static_cast<uint8_t*>(memory_->Map(0, segmentSize_ * SegmentCount));
+
+	debugUtils.SetObjectName(buffer_->Handle(), "Staging Ring Buffer");
+
+	transferCommandPool_.reset(new CommandPool(device_, device_.TransferFamilyIndex(), true));
+	transferCommandBuffers_.reset(new CommandBuffers(*transferCommandPool_, SegmentCount));
+
+	if (device_.HasDedicatedTransferQueue())
+	{
+		acquireCommandPool_.reset(new CommandPool(device_, device_.GraphicsFamilyIndex(), true));
+		acquireCommandBuffers_.reset(new CommandBuffers(*acquireCommandPool_, SegmentCount));
+	}
+
+	semaphore_.reset(new TimelineSemaphore(device_, 0));
+
+	debugUtils.SetObjectName(semaphore_->Handle(), "Uploader Timeline Semaphore");
+}
+
+Uploader::~Uploader()
+{
+	// Let the copies in flight complete before releasing their source.
+	Flush();
+
+	semaphore_.reset();
+	acquireCommandBuffers_.reset();
+	acquireCommandPool_.reset();
+	transferCommandBuffers_.reset();
+	transferCommandPool_.reset();
+
+	if (mapped_ != nullptr)
+	{
+		memory_->Unmap();
+		mapped_ = nullptr;
+	}
+
+	buffer_.reset();
+	memory_.reset(); // release memory after bound buffer has been destroyed
+}
+
+void Uploader::UploadBuffer(const Buffer& buffer, const void* const data, const size_t size)
+{
+	const auto* const bytes = static_cast<const uint8_t*>(data);
+
+	for (size_t done = 0; done != size;)
+	{
+		size_t reserved;
+		const size_t offset = Reserve(size - done, 1, reserved);
+
+		std::memcpy(mapped_ + offset, bytes + done, reserved);
+
+		VkBufferCopy copyRegion = {};
+		copyRegion.srcOffset = offset;
+		copyRegion.dstOffset = done;
+		copyRegion.size = reserved;
+
+		vkCmdCopyBuffer(CommandBuffer(), buffer_->Handle(), buffer.Handle(), 1, &copyRegion);
+
+		done += reserved;
+	}
+
+	// Recorded with the last copy, the earlier segments were submitted before to the same queue.
+	VkBufferMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+	barrier.srcQueueFamilyIndex = srcQueueFamilyIndex_;
+	barrier.dstQueueFamilyIndex = dstQueueFamilyIndex_;
+	barrier.buffer = buffer.Handle();
+	barrier.offset = 0;
+	barrier.size = VK_WHOLE_SIZE;
+
+	bufferBarriers_.push_back(barrier);
+}
+
+void Uploader::UploadImage(Image& image, const void* const data, const size_t size)
+{
+	const auto* const bytes = static_cast<const uint8_t*>(data);
+	const uint32_t height = image.Extent().height;
+	const size_t rowSize = size / height;
+
+	// Bands of rows must start on a multiple of the transfer queue granularity, the last one ends at the image edge.
+	const uint32_t granularityRows = device_.TransferImageGranularity().height;
+	const size_t granularity = granularityRows != 0 ? std::min(granularityRows * rowSize, size) : size;
+
+	if (!recording_)
+	{
+		BeginSegment();
+	}
+
+	image.TransitionImageLayout(CommandBuffer(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, false);
+
+	for (uint32_t row = 0; row != height;)
+	{
+		size_t reserved;
+		const size_t offset = Reserve((height - row) * rowSize, granularity, reserved);
+		const auto rowCount = static_cast<uint32_t>(reserved / rowSize);
+
+		std::memcpy(mapped_ + offset, bytes + row * rowSize, reserved);
+
+		image.CopyFrom(CommandBuffer(), *buffer_, offset, row, rowCount);
+
+		row += rowCount;
+	}
+
+	VkImageMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	barrier.srcQueueFamilyIndex = srcQueueFamilyIndex_;
+	barrier.dstQueueFamilyIndex = dstQueueFamilyIndex_;
+	barrier.image = image.Handle();
+	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	barrier.subresourceRange.baseMipLevel = 0;
+	barrier.subresourceRange.levelCount = 1;
+	barrier.subresourceRange.baseArrayLayer = 0;
+	barrier.subresourceRange.layerCount = 1;
+
+	imageBarriers_.push_back(barrier);
+	image.SetLayout(barrier.newLayout);
+}
+
+uint64_t Uploader::Submit()
+{
+	if (recording_)
+	{
+		SubmitSegment();
+	}
+
+	return submittedValue_;
+}
+
+void Uploader::Wait(const uint64_t value) const
+{
+	semaphore_->Wait(value);
+}
+
+void Uploader::Flush()
+{
+	Wait(Submit());
+}
+
+size_t Uploader::Reserve(const size_t size, const size_t granularity, size_t& reserved)
+{
+	if (granularity > segmentSize_)
+	{
+		Throw(std::invalid_argument("upload granule is larger than a staging ring segment"));
+	}
+
+	if (!recording_)
+	{
+		BeginSegment();
+	}
+
+	const size_t segmentEnd = (segment_ + 1) * segmentSize_;
+	size_t offset = AlignUp(cursor_, CopyAlignment);
+
+	if (offset + std::min(size, granularity) > segmentEnd)
+	{
+		SubmitSegment();
+		segment_ = (segment_ + 1) % SegmentCount;
+		BeginSegment();
+
+		return Reserve(size, granularity, reserved);
+	}
+
+	const size_t available = segmentEnd - offset;
+
+	reserved = size <= available ? size : available / granularity * granularity;
+	cursor_ = offset + reserved;
+
+	return offset;
+}
+
+void Uploader::BeginSegment()
+{
+	// The segment's previous copies must be done before its staging memory and command buffers are reused.
+	semaphore_->Wait(segmentValues_[segment_]);
+
+	cursor_ = segment_ * segmentSize_;
+	recording_ = true;
+
+	transferCommandBuffers_->Begin(segment_);
+}
+
+void Uploader::SubmitSegment()
+{
+	const auto commandBuffer = CommandBuffer();
+
+	// Release the ownership of the uploaded resources, or make them available within the graphics queue family.
+	RecordOwnershipBarriers(commandBuffer);
+	transferCommandBuffers_->End(segment_);
+
+	const uint64_t copyValue = submittedValue_ + 1;
+	SubmitCommandBuffer(device_.TransferQueue(), commandBuffer, 0, copyValue);
+	submittedValue_ = copyValue;
+
+	if (acquireCommandBuffers_)
+	{
+		const auto acquireCommandBuffer = acquireCommandBuffers_->Begin(segment_);
+		RecordOwnershipBarriers(acquireCommandBuffer);
+		acquireCommandBuffers_->End(segment_);
+
+		SubmitCommandBuffer(device_.GraphicsQueue(), acquireCommandBuffer, copyValue, copyValue + 1);
+		submittedValue_ = copyValue + 1;
+	}
+
+	segmentValues_[segment_] = submittedValue_;
+	bufferBarriers_.clear();
+	imageBarriers_.clear();
+	recording_ = false;
+}
+
+void Uploader::SubmitCommandBuffer(const VkQueue queue, VkCommandBuffer commandBuffer, const uint64_t waitValue, const uint64_t signalValue)
+{
+	const VkSemaphore semaphore = semaphore_->Handle();
+	const VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+	const uint32_t waitCount = waitValue != 0 ? 1 : 0;
+
+	VkTimelineSemaphoreSubmitInfo timelineInfo = {};
+	timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+	timelineInfo.waitSemaphoreValueCount = waitCount;
+	timelineInfo.pWaitSemaphoreValues = &waitValue;
+	timelineInfo.signalSemaphoreValueCount = 1;
+	timelineInfo.pSignalSemaphoreValues = &signalValue;
+
+	VkSubmitInfo submitInfo = {};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.pNext = &timelineInfo;
+	submitInfo.waitSemaphoreCount = waitCount;
+	submitInfo.pWaitSemaphores = &semaphore;
+	submitInfo.pWaitDstStageMask = &waitStage;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &commandBuffer;
+	submitInfo.signalSemaphoreCount = 1;
+	submitInfo.pSignalSemaphores = &semaphore;
+
+	Check(vkQueueSubmit(queue, 1, &submitInfo, nullptr),
+		"submit upload command buffer");
+}
+
+void Uploader::RecordOwnershipBarriers(VkCommandBuffer commandBuffer) const
+{
+	if (bufferBarriers_.empty() && imageBarriers_.empty())
+	{
+		return;
+	}
+
+	// The same barriers are recorded on both queues, as in ImageMemoryBarrier::InsertQueueTransfer().
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr,
+		static_cast<uint32_t>(bufferBarriers_.size()), bufferBarriers_.data(),
+		static_cast<uint32_t>(imageBarriers_.size()), imageBarriers_.data());
+}
+
+VkCommandBuffer Uploader::CommandBuffer()
+{
+	return (*transferCommandBuffers_)[segment_];
+}
+
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "Vulkan.hpp"
+#include <array>
+#include <memory>
+#include <vector>
+
+namespace Vulkan
+{
+	class Buffer;
+	class CommandBuffers;
+	class CommandPool;
+	class Device;
+	class DeviceMemory;
+	class Image;
+	class TimelineSemaphore;
+
+	// Batches uploads through a persistently mapped staging ring instead of one staging buffer and one
+	// submit-and-wait per resource. The ring is split into segments, each with its own command buffer: the copies
+	// recorded into a segment are submitted once it is full, and filling the next one overlaps with their execution.
+	// Uploads larger than a segment are split across segments (buffers by bytes, images by bands of rows that respect
+	// the image transfer granularity of the transfer queue).
+	// The copies run on the device's transfer queue. With a dedicated transfer queue, each submission releases the
+	// ownership of the uploaded resources and a graphics queue submission acquires it, so that anything submitted to
+	// the graphics queue afterwards sees the uploaded data without further synchronization. Submissions signal a
+	// timeline semaphore, which tells the host (or other queues) when a given batch of uploads is complete.
+	class Uploader final
+	{
+	public:
+
+		VULKAN_NON_COPIABLE(Uploader)
+
+		Uploader(const Device& device, size_t ringSize);
+		~Uploader();
+
+		const class Device& Device() const { return device_; }
+		const TimelineSemaphore& Semaphore() const { return *semaphore_; }
+
+		// Destination buffers are used by the graphics queue once uploaded.
+		void UploadBuffer(const Buffer& buffer, const void* data, size_t size);
+
+		template <class T>
+		void UploadBuffer(const Buffer& buffer, const std::vector<T>& content)
+		{
+			UploadBuffer(buffer, content.data(), sizeof(content[0]) * content.size());
+		}
+
+		// Tightly packed rows covering the whole image, which ends up in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL.
+		void UploadImage(Image& image, const void* data, size_t size);
+
+		// Submits the uploads recorded so far and returns the semaphore value signalled once they are complete.
+		uint64_t Submit();
+		void Wait(uint64_t value) const;
+
+		// Submits and waits for all the uploads.
+		void Flush();
+
+	private:
+
+		static const uint32_t SegmentCount = 2;
+
+		// Reserves up to size bytes of the current segment, in multiples of granularity unless the whole size fits,
+		// moving on to the next segment when less than one granule is left. Returns the ring offset.
+		size_t Reserve(size_t size, size_t granularity, size_t& reserved);
+		void BeginSegment();
+		void SubmitSegment();
+		void SubmitCommandBuffer(VkQueue queue, VkCommandBuffer commandBuffer, uint64_t waitValue, uint64_t signalValue);
+		void RecordOwnershipBarriers(VkCommandBuffer commandBuffer) const;
+		VkCommandBuffer CommandBuffer();
+
+		const class Device& device_;
+		const size_t segmentSize_;
+		const uint32_t srcQueueFamilyIndex_;
+		const uint32_t dstQueueFamilyIndex_;
+
+		std::unique_ptr<class Buffer> buffer_;
+		std::unique_ptr<DeviceMemory> memory_;
+		uint8_t* mapped_{};
+
+		// Copies on the transfer queue, ownership acquisitions on the graphics queue.
+		std::unique_ptr<CommandPool> transferCommandPool_;
+		std::unique_ptr<CommandBuffers> transferCommandBuffers_;
+		std::unique_ptr<CommandPool> acquireCommandPool_;
+		std::unique_ptr<CommandBuffers> acquireCommandBuffers_;
+
+		std::unique_ptr<TimelineSemaphore> semaphore_;
+		std::array<uint64_t, SegmentCount> segmentValues_{};
+		uint64_t submittedValue_{};
+
+		// Barriers making the resources uploaded in the current segment available to the graphics queue.
+		std::vector<VkBufferMemoryBarrier> bufferBarriers_;
+		std::vector<VkImageMemoryBarrier> imageBarriers_;
+
+		uint32_t segment_{};
+		size_t cursor_{};
+		bool recording_{};
+	};
+
+}
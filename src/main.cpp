@@ -4,6 +4,7 @@
 #include "Vulkan/SwapChain.hpp"
 #include "Vulkan/Version.hpp"
 #include "Utilities/Console.hpp"
+#include "Utilities/DenoiserConfig.hpp"
 #include "Utilities/Exception.hpp"
 #include "Options.hpp"
 #include "RayTracer.hpp"
@@ -21,6 +22,9 @@ namespace
 	void PrintVulkanDevices(const Vulkan::Application& application, const std::vector<uint32_t>& visible_devices);
 	void PrintVulkanSwapChainInformation(const Vulkan::Application& application, bool benchmark);
 	void SetVulkanDevice(Vulkan::Application& application, const std::vector<uint32_t>& visible_devices);
+	Vulkan::RayTracing::Denoiser::Parameters GetFilterParameters(const UserSettings& userSettings);
+
+	const std::vector<VkExtent2D> DenoiserBenchmarkExtents = { {1280, 720}, {1920, 1080}, {2560, 1440}, {3840, 2160} };
 }
 
 int main(int argc, const char* argv[]) noexcept
@@ -29,6 +33,7 @@ int main(int argc, const char* argv[]) noexcept
 	{
 		const Options options(argc, argv);
 		const UserSettings userSettings = CreateUserSettings(options);
+
 		const Vulkan::WindowConfig windowConfig
 		{
 			"Vulkan Window",
@@ -39,7 +44,7 @@ int main(int argc, const char* argv[]) noexcept
 			!options.Fullscreen
 		};
 
-		RayTracer application(userSettings, windowConfig, static_cast<VkPresentModeKHR>(options.PresentMode));
+		RayTracer application(userSettings, windowConfig, static_cast<VkPresentModeKHR>(options.PresentMode), options.FramesInFlight);
 
 		PrintVulkanSdkInformation();
 		PrintVulkanInstanceInformation(application, options.Benchmark);
@@ -50,6 +55,12 @@ int main(int argc, const char* argv[]) noexcept
 
 		PrintVulkanSwapChainInformation(application, options.Benchmark);
 
+		if (options.DenoiserBenchmark)
+		{
+			application.RunDenoiserBenchmark(DenoiserBenchmarkExtents, 100);
+			return EXIT_SUCCESS;
+		}
+
 		application.Run();
 
 		return EXIT_SUCCESS;
@@ -96,6 +107,7 @@ namespace
 		userSettings.Benchmark = options.Benchmark;
 		userSettings.BenchmarkNextScenes = options.BenchmarkNextScenes;
 		userSettings.BenchmarkMaxTime = options.BenchmarkMaxTime;
+		userSettings.BenchmarkAsyncCompute = options.Benchmark && options.BenchmarkAsyncCompute;
 		
 		userSettings.SceneIndex = options.SceneIndex;
 
@@ -104,6 +116,55 @@ namespace
 		userSettings.NumberOfSamples = options.Samples;
 		userSettings.NumberOfBounces = options.Bounces;
 		userSettings.MaxNumberOfSamples = options.MaxSamples;
+		userSettings.IdleWhenConverged = !options.NoIdle && !options.Benchmark;
+		userSettings.ConvergenceThreshold = options.ConvergenceThreshold;
+		userSettings.RenderScale = options.RenderScale;
+		userSettings.TransferQueue = options.TransferQueue;
+		userSettings.MemoryBudget = options.MemoryBudget;
+		userSettings.BudgetRenderScale = options.BudgetRenderScale;
+
+		userSettings.Denoise = !options.NoDenoiser;
+		userSettings.AsyncCompute = options.AsyncCompute && !userSettings.BenchmarkAsyncCompute;
+		userSettings.AdaptiveSampling = options.AdaptiveSampling;
+		userSettings.HalfPrecisionDenoiser = options.DenoiserFp16;
+		userSettings.TemporalGradient = !options.NoTemporalGradient;
+		userSettings.ATrousIterations = options.ATrousIterations;
+		userSettings.PhiColor = 4.0f;
+		userSettings.PhiNormal = 128.0f;
+		userSettings.PhiDepth = 1.0f;
+		userSettings.ColorAlpha = 0.2f;
+		userSettings.MomentsAlpha = 0.2f;
+		userSettings.ATrousTileThreshold = options.ATrousTileThreshold;
+
+		if (!options.DenoiserConfig.empty())
+		{
+			auto parameters = GetFilterParameters(userSettings);
+			Utilities::DenoiserConfig::Load(options.DenoiserConfig, parameters);
+
+			userSettings.ATrousIterations = parameters.ATrousIterations;
+			userSettings.PhiColor = parameters.PhiColor;
+			userSettings.PhiNormal = parameters.PhiNormal;
+			userSettings.PhiDepth = parameters.PhiDepth;
+			userSettings.ColorAlpha = parameters.ColorAlpha;
+			userSettings.MomentsAlpha = parameters.MomentsAlpha;
+		}
+
+		// The noisy frames are traced without accumulation, the images are read back on the graphics queue.
+		// The denoised outputs are dumped as well, filtered by what the CPU reference denoiser models: single precision,
+		// all the a-trous tiles and no temporal gradient.
+		userSettings.DumpDenoiserFrames = options.DumpDenoiserFrames;
+		userSettings.DumpFrameCount = options.DumpFrameCount;
+
+		if (!userSettings.DumpDenoiserFrames.empty())
+		{
+			userSettings.AccumulateRays = false;
+			userSettings.AsyncCompute = false;
+			userSettings.IdleWhenConverged = false;
+			userSettings.Denoise = true;
+			userSettings.HalfPrecisionDenoiser = false;
+			userSettings.TemporalGradient = false;
+			userSettings.ATrousTileThreshold = 0.0f;
+		}
 
 		userSettings.ShowSettings = !options.Benchmark;
 		userSettings.ShowOverlay = true;
@@ -270,4 +331,18 @@ namespace
 		std::cout << std::endl;
 	}
 
+	Vulkan::RayTracing::Denoiser::Parameters GetFilterParameters(const UserSettings& userSettings)
+	{
+		Vulkan::RayTracing::Denoiser::Parameters parameters = {};
+		parameters.Enabled = true;
+		parameters.ATrousIterations = userSettings.ATrousIterations;
+		parameters.PhiColor = userSettings.PhiColor;
+		parameters.PhiNormal = userSettings.PhiNormal;
+		parameters.PhiDepth = userSettings.PhiDepth;
+		parameters.ColorAlpha = userSettings.ColorAlpha;
+		parameters.MomentsAlpha = userSettings.MomentsAlpha;
+
+		return parameters;
+	}
+
 }
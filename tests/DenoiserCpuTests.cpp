@@ -0,0 +1,300 @@
+#include "Utilities/ImageMetrics.hpp"
+#include "Utilities/ReferenceDenoiser.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Unit tests of the CPU denoiser library, run by ctest one test per process: DenoiserCpuTests <test name>.
+
+namespace
+{
+	using Utilities::ReferenceDenoiser;
+	using Utilities::Simd::InstructionSet;
+
+	bool failed = false;
+
+	void Expect(const bool condition, const std::string& message)
+	{
+		if (!condition)
+		{
+			std::cerr << "FAILED: " << message << std::endl;
+			failed = true;
+		}
+	}
+
+	Utilities::DenoiserParameters DefaultParameters()
+	{
+		Utilities::DenoiserParameters parameters = {};
+		parameters.Enabled = true;
+		parameters.ATrousIterations = 5;
+		parameters.PhiColor = 4.0f;
+		parameters.PhiNormal = 128.0f;
+		parameters.PhiDepth = 1.0f;
+		parameters.ColorAlpha = 0.2f;
+		parameters.MomentsAlpha = 0.2f;
+
+		return parameters;
+	}
+
+	// Inputs of one frame, stored so that ReferenceDenoiser::Frame can point into them.
+	struct TestFrame
+	{
+		TestFrame(const uint32_t width, const uint32_t height) :
+			Width(width),
+			Height(height),
+			Diffuse(4 * PixelCount()),
+			Specular(4 * PixelCount()),
+			Albedo(4 * PixelCount(), 1.0f),
+			Depth(PixelCount(), 10.0f),
+			NormalMotion(4 * PixelCount(), 0.0f),
+			InstanceId(PixelCount(), 1)
+		{
+		}
+
+		size_t PixelCount() const { return static_cast<size_t>(Width) * Height; }
+
+		ReferenceDenoiser::Frame View() const
+		{
+			return { Diffuse.data(), Specular.data(), Albedo.data(), Depth.data(), NormalMotion.data(), InstanceId.data() };
+		}
+
+		uint32_t Width;
+		uint32_t Height;
+		std::vector<float> Diffuse;
+		std::vector<float> Specular;
+		std::vector<float> Albedo;
+		std::vector<float> Depth;
+		std::vector<float> NormalMotion;
+		std::vector<uint32_t> InstanceId;
+	};
+
+	TestFrame ConstantFrame(const uint32_t width, const uint32_t height, const float diffuse, const float specular)
+	{
+		TestFrame frame(width, height);
+		std::fill(frame.Diffuse.begin(), frame.Diffuse.end(), diffuse);
+		std::fill(frame.Specular.begin(), frame.Specular.end(), specular);
+
+		return frame;
+	}
+
+	// Noisy illumination over two instances at different depths, one of them facing sideways, and a band of misses.
+	// The width is not a multiple of the vector sizes, so that the row remainders are exercised too.
+	TestFrame NoisyFrame(const uint32_t width, const uint32_t height, std::mt19937& random)
+	{
+		std::uniform_real_distribution<float> noise(0.0f, 2.0f);
+		TestFrame frame(width, height);
+
+		for (uint32_t y = 0; y != height; ++y)
+		{
+			for (uint32_t x = 0; x != width; ++x)
+			{
+				const size_t i = static_cast<size_t>(y) * width + x;
+				const bool miss = y < 3;
+				const bool box = x > width / 3 && x < 2 * width / 3 && y > height / 3;
+
+				for (size_t c = 0; c != 3; ++c)
+				{
+					frame.Diffuse[4 * i + c] = (box ? 0.3f : 0.6f + 0.2f * x / width) * noise(random);
+					frame.Specular[4 * i + c] = 0.05f * noise(random) * noise(random);
+					frame.Albedo[4 * i + c] = box ? 0.8f : ((x / 4 + y / 4) % 2 != 0 ? 0.9f : 0.3f);
+				}
+
+				frame.Depth[i] = miss ? 0.0f : box ? 5.0f : 8.0f + 0.05f * y;
+				frame.NormalMotion[4 * i + 0] = box ? 0.5f : 0.0f;
+				frame.InstanceId[i] = miss ? 0 : box ? 2 : 1;
+			}
+		}
+
+		return frame;
+	}
+
+	float MaxDifference(const std::vector<float>& a, const std::vector<float>& b)
+	{
+		float difference = 0.0f;
+
+		for (size_t i = 0; i != a.size(); ++i)
+		{
+			difference = std::max(difference, std::abs(a[i] - b[i]));
+		}
+
+		return difference;
+	}
+
+	// The a-trous weights are normalized, so that a constant image comes out of every pass unchanged, whatever the
+	// edge-stopping functions: the output is the remodulated, gamma corrected input.
+	void ATrousConstantImage()
+	{
+		const uint32_t width = 67;
+		const uint32_t height = 41;
+		const auto frame = ConstantFrame(width, height, 0.3f, 0.2f);
+		const float expected = std::sqrt(0.5f);
+
+		for (const auto instructionSet : { InstructionSet::Scalar, InstructionSet::Sse2, InstructionSet::Avx2 })
+		{
+			ReferenceDenoiser denoiser(width, height, 2, instructionSet);
+			std::vector<float> output(4 * frame.PixelCount());
+
+			for (uint32_t iterations = 1; iterations <= Utilities::DenoiserParameters::MaxATrousIterations; ++iterations)
+			{
+				auto parameters = DefaultParameters();
+				parameters.ATrousIterations = iterations;
+
+				denoiser.Denoise(frame.View(), parameters, output.data());
+
+				float difference = 0.0f;
+
+				for (size_t i = 0; i != frame.PixelCount(); ++i)
+				{
+					for (size_t c = 0; c != 3; ++c)
+					{
+						difference = std::max(difference, std::abs(output[4 * i + c] - expected));
+					}
+				}
+
+				Expect(difference < 1e-5f, std::string(Utilities::Simd::Name(denoiser.InstructionSet())) + ", " + std::to_string(iterations) +
+					" iterations: constant image changed by " + std::to_string(difference));
+			}
+		}
+	}
+
+	// After ResetHistory(), a frame must come out as from a new denoiser, with nothing of the previous frames blended in.
+	void TemporalReset()
+	{
+		const uint32_t width = 45;
+		const uint32_t height = 29;
+		const auto parameters = DefaultParameters();
+		std::mt19937 random(7);
+
+		std::vector<TestFrame> history;
+
+		for (uint32_t i = 0; i != 3; ++i)
+		{
+			history.push_back(NoisyFrame(width, height, random));
+		}
+
+		const auto frame = NoisyFrame(width, height, random);
+		std::vector<float> output(4 * frame.PixelCount());
+		std::vector<float> fresh(4 * frame.PixelCount());
+		std::vector<float> accumulated(4 * frame.PixelCount());
+
+		ReferenceDenoiser first(width, height, 2);
+		first.Denoise(frame.View(), parameters, fresh.data());
+
+		ReferenceDenoiser second(width, height, 2);
+
+		for (const auto& previous : history)
+		{
+			second.Denoise(previous.View(), parameters, output.data());
+		}
+
+		second.Denoise(frame.View(), parameters, accumulated.data());
+
+		for (const auto& previous : history)
+		{
+			second.Denoise(previous.View(), parameters, output.data());
+		}
+
+		second.ResetHistory();
+		second.Denoise(frame.View(), parameters, output.data());
+
+		Expect(MaxDifference(output, fresh) == 0.0f, "reset history: output differs from a new denoiser by " + std::to_string(MaxDifference(output, fresh)));
+		Expect(MaxDifference(accumulated, fresh) > 1e-3f, "kept history: output does not depend on the previous frames");
+
+		// A frame without filtering discards the history as well.
+		auto bypass = parameters;
+		bypass.Enabled = false;
+
+		second.Denoise(history[0].View(), bypass, output.data());
+		second.Denoise(frame.View(), parameters, output.data());
+
+		Expect(MaxDifference(output, fresh) == 0.0f, "unfiltered frame: output differs from a new denoiser by " + std::to_string(MaxDifference(output, fresh)));
+	}
+
+	// The vectorized a-trous pass only differs from the scalar one by its polynomial exp/log approximations.
+	void SimdMatchesScalar()
+	{
+		const uint32_t width = 93;
+		const uint32_t height = 37;
+		const auto parameters = DefaultParameters();
+
+		ReferenceDenoiser scalar(width, height, 2, InstructionSet::Scalar);
+		ReferenceDenoiser sse2(width, height, 2, InstructionSet::Sse2);
+		ReferenceDenoiser avx2(width, height, 2, InstructionSet::Avx2);
+
+		std::cout << "SIMD instruction sets: " << Utilities::Simd::Name(sse2.InstructionSet()) << ", " << Utilities::Simd::Name(avx2.InstructionSet()) << std::endl;
+
+		std::mt19937 random(11);
+		std::vector<float> expected(4 * static_cast<size_t>(width) * height);
+		std::vector<float> output(expected.size());
+
+		for (uint32_t i = 0; i != 6; ++i)
+		{
+			const auto frame = NoisyFrame(width, height, random);
+
+			scalar.Denoise(frame.View(), parameters, expected.data());
+
+			for (auto* denoiser : { &sse2, &avx2 })
+			{
+				denoiser->Denoise(frame.View(), parameters, output.data());
+
+				const float difference = MaxDifference(output, expected);
+				Expect(difference < 1e-4f, std::string(Utilities::Simd::Name(denoiser->InstructionSet())) + ", frame " + std::to_string(i) +
+					": differs from scalar by " + std::to_string(difference));
+			}
+		}
+
+		// Same for the image metrics kernels.
+		const auto frame = NoisyFrame(width, height, random);
+		std::vector<float> image(frame.Diffuse);
+		std::vector<float> reference(frame.Diffuse.size());
+		std::transform(image.begin(), image.end(), reference.begin(), [](const float value) { return std::min(value, 1.0f); });
+		std::transform(image.begin(), image.end(), image.begin(), [](const float value) { return std::min(value * 0.9f, 1.0f); });
+
+		const Utilities::ImageMetrics scalarMetrics(2, InstructionSet::Scalar);
+		const auto expectedScores = scalarMetrics.Compare({ image.data(), width, height, 4 }, { reference.data(), width, height, 4 });
+
+		for (const auto instructionSet : { InstructionSet::Sse2, InstructionSet::Avx2 })
+		{
+			const Utilities::ImageMetrics metrics(2, instructionSet);
+			const auto scores = metrics.Compare({ image.data(), width, height, 4 }, { reference.data(), width, height, 4 });
+			const std::string name = Utilities::Simd::Name(metrics.InstructionSet());
+
+			Expect(std::abs(scores.Mse - expectedScores.Mse) <= 1e-6 * expectedScores.Mse, name + ": MSE differs from scalar");
+			Expect(std::abs(scores.Ssim - expectedScores.Ssim) < 1e-5, name + ": SSIM differs from scalar");
+			Expect(std::abs(scores.Flip - expectedScores.Flip) < 1e-4, name + ": FLIP differs from scalar");
+		}
+	}
+
+	struct Test
+	{
+		const char* Name;
+		void (*Run)();
+	};
+
+	const Test Tests[] =
+	{
+		{ "ATrousConstantImage", ATrousConstantImage },
+		{ "TemporalReset", TemporalReset },
+		{ "SimdMatchesScalar", SimdMatchesScalar },
+	};
+}
+
+int main(const int argc, const char* argv[])
+{
+	for (const auto& test : Tests)
+	{
+		if (argc < 2 || std::strcmp(argv[1], test.Name) == 0)
+		{
+			std::cout << "Running " << test.Name << std::endl;
+			test.Run();
+		}
+	}
+
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
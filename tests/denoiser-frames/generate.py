@@ -0,0 +1,108 @@
+#!/usr/bin/env python3
+# Writes the synthetic denoiser frame sequence of this directory, in the format of RayTracer --dump-denoiser-frames
+# (see Utilities/DenoiserFrame.cpp): a static 32x32 view of a back wall, a checkered floor and a box, four noisy frames
+# (frame-0000.svgf to frame-0003.svgf) and their noise free reference (reference.svgf). Also writes the composite of the
+# first noisy frame and of the reference as 8 bit images (frame-0000.png, reference.png) for DenoiserTool --compare-images.
+# Deterministic, rerun it after changing the frame format.
+
+import math
+import os
+import random
+import struct
+import zlib
+
+Width = 32
+Height = 32
+FrameCount = 4
+Sky = (0.6, 0.7, 0.9)
+
+
+def encode_normal(x, y, z):
+    # Inverse of DecodeNormal() in Octahedral.glsl.
+    length = abs(x) + abs(y) + abs(z)
+    x, y = x / length, y / length
+    if z < 0.0:
+        x, y = (1.0 - abs(y)) * math.copysign(1.0, x), (1.0 - abs(x)) * math.copysign(1.0, y)
+    return x, y
+
+
+def surface(x, y):
+    """Instance id, depth, normal, albedo and noise free diffuse illumination of a pixel."""
+    if 10 <= x < 22 and 8 <= y < 22:
+        return 3, 5.0, (0.0, 0.0, 1.0), (0.8, 0.2, 0.2), 0.6
+    if y < 4:
+        return 0, 0.0, (0.0, 0.0, 1.0), (1.0, 1.0, 1.0), None
+    if y < 14:
+        return 1, 8.0, (0.0, 0.0, 1.0), (0.8, 0.8, 0.8), 0.5 + 0.3 * x / (Width - 1)
+    checker = 0.9 if (x // 4 + y // 4) % 2 == 0 else 0.3
+    t = (y - 14) / (Height - 15)
+    return 2, 8.0 - 5.0 * t, (0.0, 1.0, 0.0), (checker, checker, checker), 0.8 - 0.4 * t
+
+
+def write_png(filename, pixels):
+    # RGB, 8 bits per channel, no filtering.
+    def chunk(kind, data):
+        return struct.pack('>I', len(data)) + kind + data + struct.pack('>I', zlib.crc32(kind + data))
+
+    rows = b''.join(b'\0' + bytes(pixels[y * Width * 3:(y + 1) * Width * 3]) for y in range(Height))
+
+    with open(filename, 'wb') as file:
+        file.write(b'\x89PNG\r\n\x1a\n')
+        file.write(chunk(b'IHDR', struct.pack('>2I5B', Width, Height, 8, 2, 0, 0, 0)))
+        file.write(chunk(b'IDAT', zlib.compress(rows, 9)))
+        file.write(chunk(b'IEND', b''))
+
+
+def write_frame(filename, rng, image):
+    diffuse, specular, albedo, depth, normal_motion, instance_id = [], [], [], [], [], []
+
+    for y in range(Height):
+        for x in range(Width):
+            instance, z, normal, color, illumination = surface(x, y)
+
+            if illumination is None:
+                diffuse += Sky + (1.0,)
+                specular += (0.0, 0.0, 0.0, 1.0)
+            else:
+                # One path per pixel: the estimates are unbiased, with the same noise in every channel.
+                diffuse_noise = 2.0 * rng.random() if rng else 1.0
+                specular_noise = 4.0 * rng.random() ** 3 if rng else 1.0
+                diffuse += (illumination * diffuse_noise,) * 3 + (1.0,)
+                specular += (0.05 * specular_noise,) * 3 + (1.0,)
+
+            albedo += color + (1.0,)
+            depth.append(z)
+            normal_motion += encode_normal(*normal) + (0.0, 0.0)
+            instance_id.append(instance)
+
+    with open(filename, 'wb') as file:
+        file.write(b'SVGF' + struct.pack('<3I', 1, Width, Height))
+        for plane in (diffuse, specular, albedo, depth, normal_motion):
+            file.write(struct.pack('<%df' % len(plane), *plane))
+        file.write(struct.pack('<%dI' % len(instance_id), *instance_id))
+
+    if not image:
+        return
+
+    # Remodulated and gamma corrected, like the denoiser composite.
+    composite = []
+    for i in range(Width * Height):
+        for c in range(3):
+            value = (diffuse[4 * i + c] + specular[4 * i + c]) * albedo[4 * i + c]
+            composite.append(round(255.0 * math.sqrt(min(max(value, 0.0), 1.0))))
+
+    write_png(os.path.splitext(filename)[0] + '.png', composite)
+
+
+def main():
+    directory = os.path.dirname(os.path.abspath(__file__))
+    rng = random.Random(1)
+
+    for i in range(FrameCount):
+        write_frame(os.path.join(directory, 'frame-%04u.svgf' % i), rng, i == 0)
+
+    write_frame(os.path.join(directory, 'reference.svgf'), None, True)
+
+
+if __name__ == '__main__':
+    main()
@@ -14,6 +14,7 @@ vcpkg.exe install ^
 	glm:x64-windows-static ^
 	imgui:x64-windows-static ^
 	stb:x64-windows-static ^
+	tinyexr:x64-windows-static ^
 	tinyobjloader:x64-windows-static ^
 	|| goto :error
 